@@ -30,15 +30,144 @@
 #include "smtparser/smtlib2parserinterface.h"
 #include "smtparser/smtlib2termparser.h"
 #include "smtparser/smtlib2utils.h"
+#include "smtparser/smtlib2stats.h"
+#include "smtparser/smtlib2memo.h"
+#include "smtparser/smtlib2memory.h"
 #include <stdio.h>
 
 typedef struct smtlib2_abstract_parser smtlib2_abstract_parser;
 
+/* the parser uses the allocator current when it is initialised, see
+ * smtlib2allocator.h */
 void smtlib2_abstract_parser_init(smtlib2_abstract_parser *p,
                                   smtlib2_context ctx);
 void smtlib2_abstract_parser_deinit(smtlib2_abstract_parser *p);
 void smtlib2_abstract_parser_parse(smtlib2_abstract_parser *p, FILE *src);
 void smtlib2_abstract_parser_parse_string(smtlib2_abstract_parser *p, const char * str);
+/* parses the commands in the given memory area, without copying it */
+void smtlib2_abstract_parser_parse_buffer(smtlib2_abstract_parser *p,
+                                          const char *data, size_t size);
+
+/**
+ * In lazy mode, the terms of "assert" commands are not parsed: only their
+ * source text is recorded and passed to the assert_lazy_formula callback,
+ * using the paren tracking of the lexer. All the other commands (including
+ * declarations and push/pop) are processed as usual
+ */
+void smtlib2_abstract_parser_set_lazy_asserts(smtlib2_abstract_parser *p,
+                                              bool yes);
+/**
+ * When enabled, the lexer runs on its own thread, ahead of the parser (see
+ * smtlib2_scanner_start_pipeline). The commands are still executed in order
+ * and on the calling thread, and the output is the same; only the reading
+ * of the input overlaps with them. This is ignored if the allocator of the
+ * parser is not the default one, or if threads are not available. It should
+ * not be used for interactive input, since the lexer reads ahead
+ */
+void smtlib2_abstract_parser_set_pipelined(smtlib2_abstract_parser *p,
+                                           bool yes);
+/**
+ * With nthreads > 1, a lazy term that is a big conjunction is parsed by up
+ * to nthreads worker threads when it is forced, and then passed to the
+ * backend as usual (see smtlib2forkjoin.h). The backend is still called
+ * only from the parsing thread. This only applies in lazy mode
+ */
+void smtlib2_abstract_parser_set_fork_join(smtlib2_abstract_parser *p,
+                                           int nthreads);
+/**
+ * Chooses how pop undoes the assertion stack. By default, every change is
+ * recorded in an undo trail, and pop undoes the changes of the popped levels
+ * one by one. With persistent scopes, the tables kept in persistent maps
+ * (the bindings of define-fun, and the tables that the backend registers,
+ * e.g. those of the reference backend) are saved by push and restored by
+ * pop in constant time, however many entries the popped levels have; only
+ * the rest of the state goes through the trail. This has no effect while
+ * push levels are open
+ */
+void smtlib2_abstract_parser_set_persistent_scopes(smtlib2_abstract_parser *p,
+                                                   bool yes);
+/**
+ * Parses the given lazy term in the current scope. Returns NULL on errors
+ */
+smtlib2_term smtlib2_abstract_parser_force_term(smtlib2_abstract_parser *p,
+                                                smtlib2_lazy_term *t);
+/**
+ * Parses all the lazy terms in the "terms" vector (e.g. the terms of a
+ * get-value command) in the current scope, with a single pass of the parser,
+ * and pushes the results to "out". Returns false on errors
+ */
+bool smtlib2_abstract_parser_force_terms(smtlib2_abstract_parser *p,
+                                         smtlib2_vector *terms,
+                                         smtlib2_vector *out);
+/**
+ * Parses the given "n" strings as terms in the current scope, storing the
+ * results in "out" (which must have room for "n" terms). All the strings are
+ * parsed with a single pass of a scanner that is kept across calls. Returns
+ * false on errors
+ */
+bool smtlib2_abstract_parser_parse_terms(smtlib2_abstract_parser *p,
+                                         const char **texts, size_t n,
+                                         smtlib2_term *out);
+
+/**
+ * Enables (or disables) the instrumentation of the callbacks: every call is
+ * counted and timed (see smtlib2stats.h), and the statistics can then be
+ * obtained with smtlib2_abstract_parser_get_stats or with a
+ * "(get-info :all-statistics)" command. Since the callbacks of the backend
+ * are wrapped, this must be called after the backend is created, and not
+ * from within a callback
+ */
+void smtlib2_abstract_parser_enable_stats(smtlib2_abstract_parser *p,
+                                          bool yes);
+/* NULL if the instrumentation is not enabled */
+smtlib2_parser_stats *smtlib2_abstract_parser_get_stats(
+    smtlib2_abstract_parser *p);
+
+/**
+ * Writes a timeline of the parsing to "out", as trace events that can be
+ * opened with chrome://tracing or https://ui.perfetto.dev (see
+ * smtlib2trace.h): a span for every top-level command, with its line, byte
+ * offset and time spent in the lexer, and nested spans for the callbacks
+ * and for printing the response. The time of a command not covered by them
+ * is spent in the parser. The output is flushed after every command. NULL
+ * stops tracing and terminates the trace, without closing the output. Like
+ * the statistics, this must be done after the backend is created, and not
+ * from within a callback
+ */
+void smtlib2_abstract_parser_set_trace(smtlib2_abstract_parser *p, FILE *out);
+
+/**
+ * Records every callback invoked by the parser, with its arguments, in a
+ * compact binary form written to "out" (see smtlib2record.h), from which
+ * the same calls can be made to any backend without parsing the script
+ * again (see smtlib2_abstract_parser_replay_recording). NULL stops the
+ * recording and flushes it, without closing the output. Like the
+ * statistics, this must be done after the backend is created, and not from
+ * within a callback
+ */
+void smtlib2_abstract_parser_set_recording(smtlib2_abstract_parser *p,
+                                           FILE *out);
+
+/**
+ * Answers the check-sats from the given cache when the same assertions, up
+ * to the names of the declarations and their order, were checked before,
+ * possibly by another parser or (with a cache kept in a file) another run;
+ * the answers of the backend are stored in the cache (see smtlib2memo.h).
+ * The cache is not owned by the parser, and must outlive it. NULL removes
+ * the layer. This must be done after the backend is created and before
+ * the first command, and not from within a callback
+ */
+void smtlib2_abstract_parser_set_memo(smtlib2_abstract_parser *p,
+                                      smtlib2_memo_cache *c);
+
+/**
+ * Stores in "out" the live and peak bytes of the parser, split by subsystem
+ * (see smtlib2memory.h). This works only if the allocator of the parser is
+ * a smtlib2_memory_accounting, otherwise false is returned. Since the
+ * allocator is shared, the figures include all the other objects using it
+ */
+bool smtlib2_abstract_parser_memory_report(smtlib2_abstract_parser *p,
+                                           smtlib2_memory_report *out);
 
 smtlib2_parser_interface * SMTLIB2_PARSER_INTERFACE(smtlib2_abstract_parser *p);
 
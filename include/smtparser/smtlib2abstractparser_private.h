@@ -29,6 +29,10 @@
 
 #include "smtparser/smtlib2abstractparser.h"
 #include "smtparser/smtlib2scanner.h"
+#include "smtparser/smtlib2stats.h"
+#include "smtparser/smtlib2trace.h"
+#include "smtparser/smtlib2record.h"
+#include "smtparser/smtlib2snapshot.h"
 
 typedef enum {
     SMTLIB2_RESPONSE_SUCCESS,
@@ -72,12 +76,99 @@ struct smtlib2_abstract_parser {
     smtlib2_hashtable *info_;
 
     smtlib2_vector *internal_parsed_terms_;
-    bool internal_parsed_terms_enabled_;
+    /* reusable scanner (and its input) for parsing individual terms */
+    smtlib2_charbuf *term_buf_;
+    smtlib2_sstream *term_stream_;
+    smtlib2_scanner *term_scanner_;
+
+    bool lazy_asserts_;
+    bool pipelined_;
+    int fork_join_threads_;
 
     smtlib2_scanner *scanner_;
+
+    /* the commands answered so far, and how many of them were errors */
+    size_t num_commands_;
+    size_t num_errors_;
+
+    /* the allocator current when the parser was created, used while parsing
+     * and running the callbacks */
+    smtlib2_allocator *allocator_;
+
+    /* the wrappers of the callbacks, installed when statistics are enabled
+     * or the parser is traced (NULL otherwise) */
+    smtlib2_parser_stats *stats_;
+    bool stats_enabled_;
+    smtlib2_tracer *tracer_;
+    /* the recorder of the callbacks, beneath the wrappers of the statistics
+     * and above the memoisation layer (see
+     * smtlib2_abstract_parser_set_recording) */
+    smtlib2_recorder *recorder_;
+    /* the memoisation layer, beneath the wrappers of the statistics (see
+     * smtlib2_abstract_parser_set_memo) */
+    smtlib2_memo *memo_;
+    /* set by the backends supporting snapshots (see smtlib2snapshot.h) */
+    const smtlib2_snapshot_backend *snapshot_backend_;
+    /* the undo trail of the assertion stack, as (action, data) pairs, and
+     * its size at every push (see smtlib2_abstract_parser_record_undo) */
+    smtlib2_vector *undo_trail_;
+    smtlib2_vector *undo_levels_;
+    /* the maps saved and restored with persistent scopes, and their copies
+     * when the scopes were enabled and at every push (see
+     * smtlib2_abstract_parser_add_scoped_map) */
+    bool persistent_scopes_;
+    smtlib2_vector *scoped_maps_;
+    smtlib2_vector *scope_roots_;
 };
 
 
+/**
+ * The assertion stack is kept as an undo trail, shared by the parser and the
+ * backend. Every change that pop must undo is recorded as an action, with
+ * its data: the parser records the bindings of define-fun, and the backend
+ * its declarations, named terms, assertions or anything else. push marks the
+ * end of the trail, and pop n runs the actions recorded after the n-th mark
+ * from the end, the last one first, in a single walk. reset-assertions
+ * undoes the whole trail, also the part recorded before the first push.
+ *
+ * The default push, pop, reset-assertions and reset callbacks do just this
+ * (the latter also allowing a new set-logic), and
+ * can be called by the callbacks of backends with scopes of their own, e.g.
+ * a solver context
+ */
+typedef void (*smtlib2_undo_action)(smtlib2_abstract_parser *p,
+                                    intptr_t data);
+
+void smtlib2_abstract_parser_record_undo(smtlib2_abstract_parser *p,
+                                         smtlib2_undo_action action,
+                                         intptr_t data);
+/* the number of open push levels */
+size_t smtlib2_abstract_parser_num_levels(smtlib2_abstract_parser *p);
+/* the current size of the trail, and undoing the actions recorded since it
+ * had a given size, which must not be before the mark of the innermost push
+ * level: for scopes within a single command, e.g. the sort parameters of
+ * define-sort */
+size_t smtlib2_abstract_parser_trail_size(smtlib2_abstract_parser *p);
+void smtlib2_abstract_parser_undo_to(smtlib2_abstract_parser *p, size_t size);
+
+/**
+ * Registers a persistent map of the backend that is part of the assertion
+ * stack, before persistent scopes are enabled (see
+ * smtlib2_abstract_parser_set_persistent_scopes). With persistent scopes,
+ * push saves a copy of the map, and pop restores it, so the changes to the
+ * map must not be recorded in the trail; this is what
+ * smtlib2_abstract_parser_record_map_undo takes care of. The bindings of
+ * define-fun are registered by the parser itself
+ */
+void smtlib2_abstract_parser_add_scoped_map(smtlib2_abstract_parser *p,
+                                            smtlib2_pmap *m);
+/* records the undo action of a change to a registered map, only if
+ * persistent scopes are disabled */
+void smtlib2_abstract_parser_record_map_undo(smtlib2_abstract_parser *p,
+                                             smtlib2_undo_action action,
+                                             intptr_t data);
+
+
 void smtlib2_abstract_parser_set_logic(smtlib2_parser_interface *p,
                                        const char *logic);
 void smtlib2_abstract_parser_declare_sort(smtlib2_parser_interface *p,
@@ -103,8 +194,12 @@ void smtlib2_abstract_parser_define_function(smtlib2_parser_interface *p,
                                              smtlib2_term term);
 void smtlib2_abstract_parser_push(smtlib2_parser_interface *p, int n);
 void smtlib2_abstract_parser_pop(smtlib2_parser_interface *p, int n);
+void smtlib2_abstract_parser_reset_assertions(smtlib2_parser_interface *p);
+void smtlib2_abstract_parser_reset(smtlib2_parser_interface *p);
 void smtlib2_abstract_parser_assert_formula(smtlib2_parser_interface *p,
                                             smtlib2_term term);
+void smtlib2_abstract_parser_assert_lazy_formula(smtlib2_parser_interface *p,
+                                                 smtlib2_lazy_term *term);
 void smtlib2_abstract_parser_check_sat(smtlib2_parser_interface *p);
 void smtlib2_abstract_parser_get_unsat_core(smtlib2_parser_interface *p);
 void smtlib2_abstract_parser_get_proof(smtlib2_parser_interface *p);
@@ -0,0 +1,92 @@
+/* -*- C -*-
+ *
+ * Pluggable memory allocators for the SMT-LIB v2 parser
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2ALLOCATOR_H_INCLUDED
+#define SMTLIB2ALLOCATOR_H_INCLUDED
+
+#include <stddef.h>
+
+/**
+ * An allocator. "realloc" must accept a NULL pointer (behaving as "alloc"),
+ * "free" is never called with a NULL pointer
+ */
+typedef struct smtlib2_allocator {
+    void *(*alloc)(void *user_data, size_t size);
+    void *(*realloc)(void *user_data, void *ptr, size_t size);
+    void (*free)(void *user_data, void *ptr);
+    void *user_data;
+} smtlib2_allocator;
+
+/*
+ * All the memory of the library is obtained with the following functions,
+ * which use the current allocator of the calling thread (by default, the one
+ * based on malloc, realloc and free).
+ *
+ * A parser remembers the allocator current when it is created, and makes it
+ * current again while it parses and runs its callbacks, and while it is
+ * deleted (see e.g. smtlib2_reference_parser_new_with_allocator). So all the
+ * memory of a parser (including the scanners and the terms and strings built
+ * by its callbacks) comes from the same allocator, and with an arena the
+ * whole parser can be discarded by deleting the arena instead of the parser.
+ *
+ * Memory must be freed with the allocator that was current when it was
+ * allocated
+ */
+void *smtlib2_malloc(size_t size);
+void *smtlib2_realloc(void *ptr, size_t size);
+void smtlib2_free(void *ptr);
+
+smtlib2_allocator *smtlib2_default_allocator(void);
+smtlib2_allocator *smtlib2_get_allocator(void);
+/* sets the current allocator of the calling thread (the default one if "a"
+ * is NULL), and returns the previous one */
+smtlib2_allocator *smtlib2_set_allocator(smtlib2_allocator *a);
+
+
+/**
+ * A simple arena: memory is taken from big chunks, and freeing is a no-op
+ * (except for the last block). Everything is released at once by
+ * smtlib2_arena_delete. Not thread-safe
+ */
+typedef struct smtlib2_arena smtlib2_arena;
+
+/* chunk_size is the size of the chunks (0 for the default of 1MB) */
+smtlib2_arena *smtlib2_arena_new(size_t chunk_size);
+void smtlib2_arena_delete(smtlib2_arena *a);
+smtlib2_allocator *smtlib2_arena_allocator(smtlib2_arena *a);
+/* total size of the chunks of the arena */
+size_t smtlib2_arena_size(smtlib2_arena *a);
+
+
+/* thread-local storage, if supported by the compiler */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+    !defined(__STDC_NO_THREADS__)
+#  define SMTLIB2_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#  define SMTLIB2_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#  define SMTLIB2_THREAD_LOCAL __declspec(thread)
+#endif
+
+#endif /* SMTLIB2ALLOCATOR_H_INCLUDED */
@@ -0,0 +1,153 @@
+/* -*- C -*-
+ *
+ * Compact binary serialization of parsed SMT-LIB v2 scripts
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2BINARY_H_INCLUDED
+#define SMTLIB2BINARY_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2termdag.h"
+
+/*
+ * File format
+ * -----------
+ *
+ * A binary script is the 8-byte header "SMT2BIN" followed by a format version
+ * byte, and then by a sequence of records. Each record starts with a one-byte
+ * opcode. Integers are unsigned LEB128 varints, signed integers are zigzag
+ * encoded first.
+ *
+ * Definition records intern symbols, sorts and DAG nodes, and are numbered
+ * densely per kind in order of appearance. Every definition is emitted right
+ * before its first use, so the stream is in topological order and can be
+ * replayed in a single pass:
+ *
+ *   SYMBOL  length bytes '\0'
+ *   SORT    kind name+1 nidx idx... nargs sort...
+ *   TERM    kind symbol+1 sort+1 nidx idx... nargs term...
+ *
+ * (the "+1" fields use 0 for "none"). Symbols are NUL-terminated in the file,
+ * so a mapped file can hand them to the callbacks without copying.
+ *
+ * The remaining records are the commands of the script, in order, with symbol,
+ * sort and term operands given by id. Terms are stored after let-expansion
+ * (which is what backends see through make_term anyway), and annotations are
+ * kept as separate ANNOTATE records preceding the command that contains them.
+ */
+
+#define SMTLIB2_BINARY_VERSION 1
+
+/**
+ * The encoding of the integers of the format, shared with the other binary
+ * formats of the library (see smtlib2record.h). The readers decode the
+ * number at data[*pos], and advance *pos past it; they return false if the
+ * number is truncated or malformed
+ */
+void smtlib2_binary_put_uint(smtlib2_charbuf *buf, uint64_t n);
+void smtlib2_binary_put_int(smtlib2_charbuf *buf, int64_t n);
+bool smtlib2_binary_get_uint(const unsigned char *data, size_t size,
+                             size_t *pos, uint64_t *out);
+bool smtlib2_binary_get_int(const unsigned char *data, size_t size,
+                            size_t *pos, int64_t *out);
+
+/**
+ * A backend that records every command of the script being parsed, building
+ * its terms in a term DAG, and writes them to a file in binary form
+ */
+typedef struct smtlib2_binary_writer {
+    smtlib2_abstract_parser parent_;
+    FILE *out_;
+    smtlib2_charbuf *buf_;
+    smtlib2_termdag *dag_;
+    size_t emitted_symbols_;
+    size_t emitted_sorts_;
+    size_t emitted_terms_;
+    size_t emitted_commands_;
+    smtlib2_vector *bound_vars_;
+    bool in_sort_params_;
+} smtlib2_binary_writer;
+
+
+/* "out" can be NULL, in which case the records are left in buf_ (without
+ * being flushed), for the owner of the writer to take */
+smtlib2_binary_writer *smtlib2_binary_writer_new(FILE *out);
+/* like smtlib2_binary_writer_new, but with all the memory of the writer
+ * coming from the given allocator (see smtlib2allocator.h) */
+smtlib2_binary_writer *smtlib2_binary_writer_new_with_allocator(
+                                                       FILE *out,
+                                                       smtlib2_allocator *a);
+/* flushes the pending output, returns false on I/O errors */
+bool smtlib2_binary_writer_flush(smtlib2_binary_writer *w);
+void smtlib2_binary_writer_delete(smtlib2_binary_writer *w);
+smtlib2_parser_interface *SMTLIB2_PARSER_INTERFACE_BINARY_WRITER(
+                                                  smtlib2_binary_writer *w);
+
+
+/**
+ * A reader for binary scripts. Files are memory-mapped where the platform
+ * allows it
+ */
+typedef struct smtlib2_binary_reader smtlib2_binary_reader;
+
+/* both return NULL if the input is not a binary script */
+smtlib2_binary_reader *smtlib2_binary_reader_new(const char *filename);
+smtlib2_binary_reader *smtlib2_binary_reader_new_from_memory(const char *data,
+                                                             size_t size);
+/* a reader whose records are appended in pieces (without the file header)
+ * with smtlib2_binary_reader_append, and then replayed as they come: every
+ * replay continues from where the previous one stopped. Each piece must end
+ * at a record boundary */
+smtlib2_binary_reader *smtlib2_binary_reader_new_incremental(void);
+void smtlib2_binary_reader_append(smtlib2_binary_reader *r, const char *data,
+                                  size_t size);
+void smtlib2_binary_reader_delete(smtlib2_binary_reader *r);
+
+/**
+ * Replays the commands into the given backend, invoking the same callbacks
+ * (with the same arguments) that parsing the original script would have
+ * invoked, up to let-expansion. Returns false if the input is corrupted, in
+ * which case smtlib2_binary_reader_get_error_msg() tells why
+ */
+bool smtlib2_binary_reader_replay(smtlib2_binary_reader *r,
+                                  smtlib2_parser_interface *parser);
+const char *smtlib2_binary_reader_get_error_msg(smtlib2_binary_reader *r);
+
+/**
+ * Replays the records not replayed yet, and then builds the term with the
+ * given id (the id_ of a node in the DAG of the writer that produced the
+ * records) with the callbacks of the given backend. Only the definitions
+ * the term depends on are built. Returns false if the input is corrupted
+ */
+bool smtlib2_binary_reader_build_term(smtlib2_binary_reader *r,
+                                      smtlib2_parser_interface *parser,
+                                      uint64_t id, smtlib2_term *out);
+
+/**
+ * Like smtlib2_binary_reader_replay, but also handles the responses of an
+ * abstract parser, in the same way as smtlib2_abstract_parser_parse does
+ */
+bool smtlib2_abstract_parser_replay(smtlib2_abstract_parser *p,
+                                    smtlib2_binary_reader *r);
+
+#endif /* SMTLIB2BINARY_H_INCLUDED */
@@ -0,0 +1,108 @@
+/* -*- C -*-
+ *
+ * Index of the top-level commands of SMT-LIB v2 scripts
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2CMDINDEX_H_INCLUDED
+#define SMTLIB2CMDINDEX_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+
+typedef enum {
+    SMTLIB2_COMMAND_UNKNOWN,
+    SMTLIB2_COMMAND_SET_LOGIC,
+    SMTLIB2_COMMAND_DECLARE_SORT,
+    SMTLIB2_COMMAND_DEFINE_SORT,
+    SMTLIB2_COMMAND_DECLARE_FUN,
+    SMTLIB2_COMMAND_DEFINE_FUN,
+    SMTLIB2_COMMAND_PUSH,
+    SMTLIB2_COMMAND_POP,
+    SMTLIB2_COMMAND_ASSERT,
+    SMTLIB2_COMMAND_CHECK_SAT,
+    SMTLIB2_COMMAND_GET_ASSERTIONS,
+    SMTLIB2_COMMAND_GET_UNSAT_CORE,
+    SMTLIB2_COMMAND_GET_PROOF,
+    SMTLIB2_COMMAND_SET_OPTION,
+    SMTLIB2_COMMAND_GET_INFO,
+    SMTLIB2_COMMAND_SET_INFO,
+    SMTLIB2_COMMAND_GET_ASSIGNMENT,
+    SMTLIB2_COMMAND_GET_MODEL,
+    SMTLIB2_COMMAND_GET_VALUE,
+    SMTLIB2_COMMAND_EXIT,
+    SMTLIB2_COMMAND_RESET_ASSERTIONS,
+    SMTLIB2_COMMAND_RESET
+} smtlib2_command_kind;
+
+/* the SMT-LIB name of the command, or NULL for SMTLIB2_COMMAND_UNKNOWN */
+const char *smtlib2_command_kind_name(smtlib2_command_kind kind);
+
+
+/**
+ * The byte spans of the top-level commands of a script, computed with a
+ * single pass over the input that only looks at parentheses, strings, quoted
+ * symbols and comments. Anything at the top level that is not a
+ * parenthesized command is recorded as a SMTLIB2_COMMAND_UNKNOWN span, so
+ * that parsing it reports the same error as parsing the whole script
+ */
+typedef struct smtlib2_command_index smtlib2_command_index;
+
+/* indexes the given memory area, which must outlive the index */
+smtlib2_command_index *smtlib2_command_index_new(const char *data,
+                                                 size_t size);
+/* maps the file in memory and indexes it. Returns NULL on I/O errors */
+smtlib2_command_index *smtlib2_command_index_new_from_file(
+                                                  const char *filename);
+void smtlib2_command_index_delete(smtlib2_command_index *idx);
+
+size_t smtlib2_command_index_size(smtlib2_command_index *idx);
+smtlib2_command_kind smtlib2_command_index_kind(smtlib2_command_index *idx,
+                                                size_t i);
+/* the span of the i-th command is [begin, end) */
+size_t smtlib2_command_index_begin(smtlib2_command_index *idx, size_t i);
+size_t smtlib2_command_index_end(smtlib2_command_index *idx, size_t i);
+const char *smtlib2_command_index_data(smtlib2_command_index *idx);
+
+/* the first command ending after the given byte offset (or the number of
+ * commands, if there is none) */
+size_t smtlib2_command_index_find(smtlib2_command_index *idx, size_t offset);
+
+/**
+ * Parses the commands in [first, last) of the index, as if they were the
+ * whole script. Whatever they depend on (declarations, definitions, scopes)
+ * must have already been given to the parser
+ */
+void smtlib2_abstract_parser_parse_commands(smtlib2_abstract_parser *p,
+                                            smtlib2_command_index *idx,
+                                            size_t first, size_t last);
+
+/*
+ * The scanning helpers used by the index, for other quick passes over
+ * SMT-LIB text. smtlib2_skip_blanks returns the position of the first byte
+ * at or after pos that is not whitespace or part of a comment.
+ * smtlib2_skip_sexpr returns the position right after the s-expression (a
+ * token, or a parenthesized list) starting at pos, or size if it is not
+ * closed
+ */
+size_t smtlib2_skip_blanks(const char *data, size_t pos, size_t size);
+size_t smtlib2_skip_sexpr(const char *data, size_t pos, size_t size);
+
+#endif /* SMTLIB2CMDINDEX_H_INCLUDED */
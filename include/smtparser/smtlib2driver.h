@@ -0,0 +1,77 @@
+/* -*- C -*-
+ *
+ * Command-line driver for SMT-LIB v2 backends, with measurement modes
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2DRIVER_H_INCLUDED
+#define SMTLIB2DRIVER_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+
+typedef enum {
+    SMTLIB2_DRIVER_LEX,    /* tokenise only */
+    SMTLIB2_DRIVER_PARSE,  /* also recognise the grammar, with no-op
+                            * callbacks (see smtlib2null.h) */
+    SMTLIB2_DRIVER_FULL    /* also run the actual backend */
+} smtlib2_driver_mode;
+
+typedef smtlib2_abstract_parser *(*smtlib2_driver_newfun)(void);
+typedef void (*smtlib2_driver_deletefun)(smtlib2_abstract_parser *p);
+
+/**
+ * A main function for executables wrapping a backend. The arguments are the
+ * input files (standard input if none), parsed with a fresh backend each.
+ *
+ * With --mode=lex|parse|full, each input is read in memory and processed by
+ * all the phases up to the given one (the output of all but the last is
+ * discarded). The wall time, token count and throughput of every phase are
+ * printed on standard error, so that the cost of the scanner, of the grammar
+ * and term parser, and of the backend can be told apart.
+ *
+ * With --stats, the callbacks of the backend are instrumented (see
+ * smtlib2_abstract_parser_enable_stats), and their call counts and latency
+ * percentiles are printed on standard error after each input. With
+ * --memory, the live and peak bytes of every subsystem are printed as well
+ * (see smtlib2_abstract_parser_memory_report). With --trace=FILE.json, a
+ * timeline of the commands and callbacks is written to the given file (see
+ * smtlib2_abstract_parser_set_trace). With --pipeline, the lexer of every
+ * parser (but not the one reading standard input) runs on its own thread
+ * (see smtlib2_abstract_parser_set_pipelined). With --queue, the commands
+ * are executed by the backend on a thread of its own, while the parser
+ * reads the following ones (see smtlib2queue.h); standard input is then
+ * executed one command at a time. With --fork-join=N, the asserts are
+ * parsed lazily, and those that are big conjunctions are parsed by N threads
+ * (see smtlib2forkjoin.h). With --memo=FILE, the check-sats are answered
+ * from a cache kept in the given file, shared by all the inputs, when the
+ * same query was already checked (see smtlib2memo.h); --memo-max=N limits
+ * it to N entries. The hits and misses are printed on standard error at the
+ * end. With --record=FILE, the callbacks invoked by the parser are recorded
+ * in the given file (see smtlib2_abstract_parser_set_recording). With
+ * --replay, the inputs are such recordings, whose callbacks are invoked on
+ * the backend without parsing anything; with --mode, the time taken is
+ * printed on standard error
+ */
+int smtlib2_driver_main(int argc, char **argv,
+                        smtlib2_driver_newfun new_parser,
+                        smtlib2_driver_deletefun delete_parser);
+
+#endif /* SMTLIB2DRIVER_H_INCLUDED */
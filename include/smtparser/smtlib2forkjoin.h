@@ -0,0 +1,60 @@
+/* -*- C -*-
+ *
+ * Fork-join parsing of huge conjunctions
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2FORKJOIN_H_INCLUDED
+#define SMTLIB2FORKJOIN_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+
+/**
+ * Parses a lazy term (see smtlib2_abstract_parser_set_lazy_asserts) with the
+ * help of worker threads, if it is a big conjunction: an "and" with many
+ * arguments, possibly in the body of some "let"s. The arguments are found
+ * with a quick pass over the text that only matches parentheses (see
+ * smtlib2_skip_sexpr), and split in one chunk per thread. Each chunk is
+ * parsed on a worker thread by a binary writer of its own (see
+ * smtlib2binary.h), which builds the terms in a hash-consed DAG without
+ * calling the backend. Then, on the calling thread, the let bindings are
+ * defined in the backend as usual, the DAGs are replayed into it within the
+ * let scopes, and the conjuncts are passed to a single make_term for "and".
+ *
+ * The workers know nothing about the declarations, definitions and let
+ * bindings of the backend: the symbols of the conjuncts are resolved by the
+ * backend during the replay, so the scopes visible at the split point are
+ * respected, and the backend is only ever called from the calling thread.
+ * As with smtlib2_abstract_parser_replay, the backend sees the terms up to
+ * let-expansion and sharing.
+ *
+ * Returns false, without doing anything, if the term is not split (because
+ * it is not a big enough conjunction, or threads are not available). If a
+ * chunk has a syntax error, false is returned as well, so that the caller
+ * parses the whole term and reports the error as usual. Otherwise, the term
+ * is stored in "out" (NULL on errors of the backend)
+ */
+bool smtlib2_fork_join_force_term(smtlib2_abstract_parser *p,
+                                  smtlib2_lazy_term *t, int nthreads,
+                                  smtlib2_term *out);
+
+#endif /* SMTLIB2FORKJOIN_H_INCLUDED */
@@ -27,6 +27,7 @@
 #ifndef SMTLIB2GENVECTOR_H_INCLUDED
 #define SMTLIB2GENVECTOR_H_INCLUDED
 
+#include "smtparser/smtlib2allocator.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <stdlib.h>
@@ -58,7 +59,7 @@ void name ## _swap(name *v1, name *v2);
 #define SMTLIB2_DEFINE_VECTOR(name, type) \
 name *name ## _new(void)                                \
 {                                                                       \
-    name *ret = (name *)malloc(sizeof(name)); \
+    name *ret = (name *)smtlib2_malloc(sizeof(name));                   \
     ret->data_ = NULL;                                                  \
     ret->size_ = 0;                                                     \
     ret->capacity_ = 0;                                                 \
@@ -70,9 +71,9 @@ name *name ## _new(void)                                \
 void name ## _delete(name *v)                           \
 {                                                                       \
     if (v->data_) {                                                     \
-        free(v->data_);                                                 \
+        smtlib2_free(v->data_);                                         \
     }                                                                   \
-    free(v);                                                            \
+    smtlib2_free(v);                                                    \
 }                                                                       \
                                                                         \
                                                                         \
@@ -112,7 +113,7 @@ void name ## _reserve(name *v, size_t cap)              \
     assert(cap > 0);                                                    \
                                                                         \
     if (v->capacity_ < cap) {                                           \
-        v->data_ = (type *)realloc(v->data_, sizeof(type)*cap); \
+        v->data_ = (type *)smtlib2_realloc(v->data_, sizeof(type)*cap); \
         v->capacity_ = cap;                                             \
     }                                                                   \
 }                                                                       \
@@ -123,7 +124,7 @@ void name ## _clear(name *v)                            \
     v->size_ = 0;                                                       \
     v->capacity_ = 0;                                                   \
     if (v->data_) {                                                     \
-        free(v->data_);                                                 \
+        smtlib2_free(v->data_);                                         \
         v->data_ = NULL;                                                \
     }                                                                   \
 }                                                                       \
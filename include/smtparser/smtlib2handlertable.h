@@ -0,0 +1,65 @@
+/* -*- C -*-
+ *
+ * Immutable, perfectly hashed tables of symbol handlers
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2HANDLERTABLE_H_INCLUDED
+#define SMTLIB2HANDLERTABLE_H_INCLUDED
+
+#include "smtparser/smtlib2termparser.h"
+
+typedef struct smtlib2_handler_entry {
+    const char *symbol_;
+    smtlib2_term_parser_symbolhandler handler_;
+} smtlib2_handler_entry;
+
+/**
+ * A table of symbol handlers that can't be changed once built, so that a
+ * single one can be shared by any number of term parsers and threads (see
+ * smtlib2_term_parser_set_handler_table). The symbols are placed with a
+ * perfect hash (hash and displace), so a lookup costs one hash of the symbol
+ * and one string comparison.
+ *
+ * The symbols are not copied: typically the entries are a static array of
+ * the backend. The table does not use the current allocator, so it can
+ * outlive the parsers (and arenas) that use it. The symbols of the entries
+ * must be distinct
+ */
+smtlib2_handler_table *smtlib2_handler_table_new(
+    const smtlib2_handler_entry *entries, size_t n);
+void smtlib2_handler_table_delete(smtlib2_handler_table *t);
+/* NULL if the symbol is not in the table */
+smtlib2_term_parser_symbolhandler smtlib2_handler_table_find(
+    const smtlib2_handler_table *t, const char *symbol);
+
+/**
+ * Returns the table stored in "*slot", building it from the given entries
+ * the first time. Concurrent first calls may build more than one table, but
+ * only one is stored and returned to all of them. The stored table is never
+ * deleted, so "slot" is typically a static variable of a backend
+ */
+const smtlib2_handler_table *smtlib2_handler_table_once(
+    smtlib2_handler_table **slot, const smtlib2_handler_entry *entries,
+    size_t n);
+
+#endif /* SMTLIB2HANDLERTABLE_H_INCLUDED */
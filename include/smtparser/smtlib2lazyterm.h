@@ -0,0 +1,54 @@
+/* -*- C -*-
+ *
+ * Unparsed terms, for the lazy handling of assertions
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2LAZYTERM_H_INCLUDED
+#define SMTLIB2LAZYTERM_H_INCLUDED
+
+#include "smtparser/smtlib2types.h"
+#include <stddef.h>
+
+/**
+ * The source text of a term that has not been parsed yet. See
+ * smtlib2_abstract_parser_set_lazy_asserts() and
+ * smtlib2_abstract_parser_force_term()
+ */
+struct smtlib2_lazy_term {
+    char *text_;      /* NUL-terminated */
+    size_t length_;
+    size_t offset_;   /* byte offset of the term in the input */
+    int line_;        /* line of the input where the term starts */
+};
+
+/* takes ownership of "text", which must be allocated with smtlib2_malloc */
+smtlib2_lazy_term *smtlib2_lazy_term_new(char *text, size_t length,
+                                         size_t offset, int line);
+void smtlib2_lazy_term_delete(smtlib2_lazy_term *t);
+
+/**
+ * If the term is annotated with ":named", returns (a copy of) its name,
+ * otherwise NULL. This only looks at the text, without parsing the term
+ */
+char *smtlib2_lazy_term_get_name(smtlib2_lazy_term *t);
+
+#endif /* SMTLIB2LAZYTERM_H_INCLUDED */
@@ -0,0 +1,125 @@
+/* -*- C -*-
+ *
+ * Memoisation of check-sat responses, keyed by a canonical hash of the query
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2MEMO_H_INCLUDED
+#define SMTLIB2MEMO_H_INCLUDED
+
+#include "smtparser/smtlib2utils.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * A 128-bit hash of a query, made of two 64-bit hashes computed with
+ * different mixing functions
+ */
+typedef struct smtlib2_memo_key {
+    uint64_t h1_;
+    uint64_t h2_;
+} smtlib2_memo_key;
+
+
+typedef struct smtlib2_memo_stats {
+    uint64_t hits_;         /* check-sats answered from the cache */
+    uint64_t misses_;       /* check-sats passed to the backend */
+    uint64_t uncacheable_;  /* misses whose assertions could not be hashed
+                             * (counted in misses_ as well) */
+    uint64_t stores_;       /* sat and unsat answers added */
+    uint64_t evictions_;    /* entries dropped to stay within the limit */
+} smtlib2_memo_stats;
+
+
+/**
+ * A cache of check-sat answers, kept in memory and (optionally) in a file,
+ * so that it survives the process and can be shared by several runs. The
+ * file is a header followed by fixed-size records of 17 bytes (the key, in
+ * little-endian order, and the answer), which are appended as the answers
+ * are stored; a truncated or garbled tail is dropped when the cache is
+ * opened.
+ *
+ * With max_entries > 0, the cache keeps at most that many entries,
+ * evicting the oldest ones first, and the file is rewritten with only the
+ * live entries when it has twice as many records. A cache can be used by
+ * several parsers, but by one thread at a time. Processes appending to the
+ * same file at the same time may lose entries (but not corrupt the other
+ * ones) when it is rewritten
+ */
+typedef struct smtlib2_memo_cache smtlib2_memo_cache;
+
+/* "path" is created if it doesn't exist. With a NULL path, the cache is
+ * kept in memory only. Returns NULL if the file can't be read or written,
+ * or is not a cache */
+smtlib2_memo_cache *smtlib2_memo_cache_open(const char *path,
+                                            size_t max_entries);
+void smtlib2_memo_cache_close(smtlib2_memo_cache *c);
+
+/* the answer is true for sat and false for unsat */
+bool smtlib2_memo_cache_lookup(smtlib2_memo_cache *c,
+                               const smtlib2_memo_key *k, bool *sat);
+void smtlib2_memo_cache_store(smtlib2_memo_cache *c,
+                              const smtlib2_memo_key *k, bool sat);
+size_t smtlib2_memo_cache_size(smtlib2_memo_cache *c);
+
+const smtlib2_memo_stats *smtlib2_memo_cache_get_stats(
+    smtlib2_memo_cache *c);
+/* prints the statistics and the size of the cache, on a line starting with
+ * ";;" */
+void smtlib2_memo_cache_print_stats(smtlib2_memo_cache *c, FILE *out);
+
+
+/**
+ * The layer answering the check-sats of a parser from a cache. It wraps the
+ * callbacks of the backend, in the same way as the statistics (see
+ * smtlib2stats.h), and mirrors the terms and sorts they build in a term DAG
+ * of its own (see smtlib2termdag.h), together with the declarations, the
+ * scopes and the assertion stack. At every check-sat, the live assertions
+ * are hashed into a key that does not depend on the order of the
+ * declarations, on the names of the declared sorts and functions and of the
+ * bound variables, on unused declarations, nor on the order of the
+ * assertions (up to assertions with the same structure, which are kept in
+ * the order they were made), while the sorts of the symbols and the bodies
+ * of define-fun and define-sort are part of it. If the key is in the cache,
+ * the answer is given without calling the backend; otherwise the backend
+ * answers, and sat and unsat are stored. A get-value, get-assignment,
+ * get-unsat-core or get-proof following a check-sat answered from the cache
+ * first runs the check-sat in the backend.
+ *
+ * The symbols must be declared after the layer is installed: an unknown
+ * symbol is taken to be a builtin of the logic. Asserts that the backend
+ * keeps lazy (see smtlib2_abstract_parser_set_lazy_asserts) and terms that
+ * the layer did not see being built make the check-sats that follow them
+ * uncacheable, until they are popped.
+ *
+ * Used by smtlib2_abstract_parser_set_memo
+ */
+typedef struct smtlib2_memo smtlib2_memo;
+struct smtlib2_abstract_parser;
+
+/* wraps the callbacks of p, beneath the wrappers of the statistics and the
+ * recorder (if any). Not to be called from within a callback */
+smtlib2_memo *smtlib2_memo_new(struct smtlib2_abstract_parser *p,
+                               smtlib2_memo_cache *c);
+/* restores the original callbacks of "p" */
+void smtlib2_memo_delete(smtlib2_memo *m, struct smtlib2_abstract_parser *p);
+
+#endif /* SMTLIB2MEMO_H_INCLUDED */
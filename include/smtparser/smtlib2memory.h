@@ -0,0 +1,104 @@
+/* -*- C -*-
+ *
+ * Memory accounting: live and peak bytes per subsystem
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2MEMORY_H_INCLUDED
+#define SMTLIB2MEMORY_H_INCLUDED
+
+#include "smtparser/smtlib2allocator.h"
+#include <stdio.h>
+
+/**
+ * The subsystems the memory of a parser is accounted to. Every allocation is
+ * tagged with the current tag of the calling thread, which the parts of the
+ * library set while they allocate their own data. Everything else (the
+ * parser objects, and the sorts, terms and strings created by the callbacks)
+ * is accounted to the backend.
+ *
+ * The term parser tables are SMTLIB2_MEM_BINDINGS (bindings_, with the
+ * symbols of define-fun), SMTLIB2_MEM_LET_BINDINGS (let_bindings_ and the let
+ * scopes), SMTLIB2_MEM_SYMBOL_HANDLERS (symbol_handlers_) and
+ * SMTLIB2_MEM_TERM_PARAMS (term_params_). SMTLIB2_MEM_RESPONSE covers the
+ * response data of the abstract parser and the stored set-info values
+ */
+typedef enum {
+    SMTLIB2_MEM_BACKEND,
+    SMTLIB2_MEM_TOKENS,          /* the scanners, their buffers and the
+                                  * strings of the tokens */
+    SMTLIB2_MEM_GRAMMAR,         /* the stacks of bison and the lists and
+                                  * identifiers built by the grammar */
+    SMTLIB2_MEM_BINDINGS,
+    SMTLIB2_MEM_LET_BINDINGS,
+    SMTLIB2_MEM_SYMBOL_HANDLERS,
+    SMTLIB2_MEM_TERM_PARAMS,
+    SMTLIB2_MEM_RESPONSE,
+
+    SMTLIB2_MEM_TAG_COUNT
+} smtlib2_memory_tag;
+
+/* "backend", "tokens", "grammar", "bindings", ... */
+const char *smtlib2_memory_tag_name(smtlib2_memory_tag t);
+
+/* sets the current tag of the calling thread, and returns the previous one.
+ * The tag of a block is the one current when it was first allocated: it is
+ * kept when the block is reallocated, and freeing a block with any tag
+ * current is fine */
+smtlib2_memory_tag smtlib2_set_memory_tag(smtlib2_memory_tag t);
+
+
+typedef struct smtlib2_memory_report {
+    size_t live_[SMTLIB2_MEM_TAG_COUNT];
+    size_t peak_[SMTLIB2_MEM_TAG_COUNT];
+    size_t total_live_;
+    size_t total_peak_;  /* the peak of the sum, not the sum of the peaks */
+} smtlib2_memory_report;
+
+/* prints the report as a table, with sizes in KB */
+void smtlib2_memory_report_print(const smtlib2_memory_report *r, FILE *out);
+
+
+/**
+ * An allocator that keeps the live and peak bytes of every tag, taking the
+ * memory from another allocator. Every block is preceded by a small header
+ * with its size and tag. Not thread-safe.
+ *
+ * To account the memory of a parser, make the allocator current while the
+ * parser is created (or use the *_new_with_allocator constructors), and then
+ * call smtlib2_abstract_parser_memory_report at any time
+ */
+typedef struct smtlib2_memory_accounting smtlib2_memory_accounting;
+
+/* "base" is the allocator used for the memory (the default one if NULL) */
+smtlib2_memory_accounting *smtlib2_memory_accounting_new(
+    smtlib2_allocator *base);
+void smtlib2_memory_accounting_delete(smtlib2_memory_accounting *a);
+smtlib2_allocator *smtlib2_memory_accounting_allocator(
+    smtlib2_memory_accounting *a);
+/* the accounting owning the given allocator, NULL if "a" is not the allocator
+ * of an accounting */
+smtlib2_memory_accounting *smtlib2_memory_accounting_of(smtlib2_allocator *a);
+void smtlib2_memory_accounting_report(smtlib2_memory_accounting *a,
+                                      smtlib2_memory_report *out);
+
+#endif /* SMTLIB2MEMORY_H_INCLUDED */
@@ -0,0 +1,55 @@
+/* -*- C -*-
+ *
+ * Null backend for the SMT-LIB v2 parser, accepting everything and doing nothing
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2NULL_H_INCLUDED
+#define SMTLIB2NULL_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+
+/**
+ * A backend whose callbacks all succeed without doing anything: sorts and
+ * terms are represented by a single dummy value, and no symbol tables are
+ * kept. It measures the cost of lexing and parsing alone, and is the lower
+ * bound for the cost of any real backend
+ */
+typedef struct smtlib2_null_parser {
+    smtlib2_abstract_parser parent_;
+} smtlib2_null_parser;
+
+
+smtlib2_null_parser *smtlib2_null_parser_new(void);
+/* like smtlib2_null_parser_new, but with all the memory of the parser coming
+ * from the given allocator (see smtlib2allocator.h) */
+smtlib2_null_parser *smtlib2_null_parser_new_with_allocator(
+                                                        smtlib2_allocator *a);
+void smtlib2_null_parser_delete(smtlib2_null_parser *p);
+/* for backends built on top of this one, which only override the
+ * callbacks they care about (see e.g. smtlib2splitter.h) */
+void smtlib2_null_parser_init(smtlib2_null_parser *p, smtlib2_context ctx);
+void smtlib2_null_parser_deinit(smtlib2_null_parser *p);
+smtlib2_parser_interface *SMTLIB2_PARSER_INTERFACE_NULL(
+                                                  smtlib2_null_parser *p);
+
+#endif /* SMTLIB2NULL_H_INCLUDED */
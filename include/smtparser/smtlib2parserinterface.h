@@ -28,6 +28,7 @@
 #define SMTLIB2PARSERINTERFACE_H_INCLUDED
 
 #include "smtparser/smtlib2types.h"
+#include "smtparser/smtlib2lazyterm.h"
 #include "smtparser/smtlib2utils.h"
 
 
@@ -102,11 +103,32 @@ struct smtlib2_parser_interface {
      */
     void (*pop)(smtlib2_parser_interface *parser, int n);
 
+    /**
+     * callback for a "reset-assertions" command
+     */
+    void (*reset_assertions)(smtlib2_parser_interface *parser);
+
+    /**
+     * callback for a "reset" command
+     */
+    void (*reset)(smtlib2_parser_interface *parser);
+
     /**
      * callback for an "assert" command
      */
     void (*assert_formula)(smtlib2_parser_interface *parser, smtlib2_term term);
 
+    /**
+     * callback for an "assert" command when lazy assertions are enabled
+     * (see smtlib2_abstract_parser_set_lazy_asserts)
+     * "term" holds the source text of the asserted term, which has not been
+     *        parsed yet. The callback takes ownership of it, and can turn it
+     *        into an actual term with smtlib2_abstract_parser_force_term,
+     *        as long as the scope in which it was asserted is still open
+     */
+    void (*assert_lazy_formula)(smtlib2_parser_interface *parser,
+                                smtlib2_lazy_term *term);
+
     /**
      * callback for a "check-sat" command
      */
@@ -165,10 +187,11 @@ struct smtlib2_parser_interface {
 
     /**
      * callback for a "get-value" command
-     * "terms" is a vector of *string representations* of the terms for which
-     *         the model value is requested. In order to get the actual terms,
-     *         such strings should be parsed. For this, the (non-standard)
-     *         ".internal-parse-terms" command can be used.
+     * "terms" is a vector of smtlib2_lazy_term pointers, holding the
+     *         *source text* (and byte offset) of the terms for which the
+     *         model value is requested, as captured by the lexer. The handles
+     *         are owned by the parser. In order to get the actual terms, they
+     *         should be parsed with smtlib2_abstract_parser_force_terms.
      *
      *         The reason for this choice is that the SMT-LIB v2 language
      *         mandates that responses to a get-value command return the same
@@ -178,7 +201,8 @@ struct smtlib2_parser_interface {
      *         let bindings) directly at parsing time
      *
      *         See smtlib2yices.c for an example of use of
-     *         ".internal-parse-terms" from within a "get-value" callback
+     *         smtlib2_abstract_parser_force_terms from within a "get-value"
+     *         callback
      */
     void (*get_value)(smtlib2_parser_interface *parser, smtlib2_vector *terms);
 
@@ -193,7 +217,8 @@ struct smtlib2_parser_interface {
     void (*handle_error)(smtlib2_parser_interface *parser, const char *msg);
 
     /**
-     * callback for the ".internal-parse-terms" command (see above)
+     * callback for the terms parsed in term-only mode (see
+     * smtlib2_parse_terms and smtlib2_abstract_parser_parse_terms)
      */
     void (*set_internal_parsed_terms)(smtlib2_parser_interface *parser,
                                       smtlib2_vector *terms);
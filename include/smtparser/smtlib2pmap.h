@@ -0,0 +1,81 @@
+/* -*- C -*-
+ *
+ * Persistent hash maps
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2PMAP_H_INCLUDED
+#define SMTLIB2PMAP_H_INCLUDED
+
+#include "smtparser/smtlib2hashtable.h"
+
+typedef struct smtlib2_pmap_node smtlib2_pmap_node;
+
+/**
+ * A persistent hash map, implemented as a hash array mapped trie: copying a
+ * map is O(1), and the copies share all their structure. Updating a map
+ * copies only the path from the root to the entry (at most 7 nodes of up to
+ * 32 slots), and nodes that are not shared with other copies are updated in
+ * place, so a map that is never copied behaves like an ordinary hash table.
+ *
+ * The nodes and entries are reference counted (atomically, where the
+ * compiler allows), so copies can be used and released by different
+ * threads, as long as each copy is only used by one thread at a time. They
+ * must all be created with the same allocator (see smtlib2allocator.h),
+ * since any copy may be the one releasing them.
+ *
+ * The map owns its keys and values: they are released with the free
+ * functions given to smtlib2_pmap_init (if not NULL) when no copy refers to
+ * them anymore. As for smtlib2_hashtable, NULL hash and equality functions
+ * compare the keys as integers
+ */
+typedef struct smtlib2_pmap {
+    smtlib2_pmap_node *root_;
+    size_t size_;
+    smtlib2_hashfun hf_;
+    smtlib2_eqfun eqf_;
+    smtlib2_freefun fk_;
+    smtlib2_freefun fv_;
+} smtlib2_pmap;
+
+
+void smtlib2_pmap_init(smtlib2_pmap *m, smtlib2_hashfun hf, smtlib2_eqfun ef,
+                       smtlib2_freefun fk, smtlib2_freefun fv);
+void smtlib2_pmap_deinit(smtlib2_pmap *m);
+/* makes dest (which must have been initialized with the same functions as
+ * src) a copy of src, in O(1) */
+void smtlib2_pmap_assign(smtlib2_pmap *dest, const smtlib2_pmap *src);
+/* the map takes ownership of the key and of the value. An entry with the same
+ * key is replaced, and its key and value are released */
+void smtlib2_pmap_set(smtlib2_pmap *m, intptr_t key, intptr_t val);
+bool smtlib2_pmap_find_key_value(const smtlib2_pmap *m, intptr_t key,
+                                 intptr_t *out_key, intptr_t *out_val);
+/* returns false if there was no entry with the given key */
+bool smtlib2_pmap_erase(smtlib2_pmap *m, intptr_t key);
+
+#define smtlib2_pmap_size(m) ((m)->size_)
+#define smtlib2_pmap_find(m, k, ov) \
+    smtlib2_pmap_find_key_value((m), (k), NULL, (ov))
+#define smtlib2_pmap_find_key(m, k, ok) \
+    smtlib2_pmap_find_key_value((m), (k), (ok), NULL)
+
+#endif /* SMTLIB2PMAP_H_INCLUDED */
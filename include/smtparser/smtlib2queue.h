@@ -0,0 +1,61 @@
+/* -*- C -*-
+ *
+ * Execution of the commands of a backend on a thread of its own
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2QUEUE_H_INCLUDED
+#define SMTLIB2QUEUE_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+
+/**
+ * Parses a script on the calling thread, while the backend executes its
+ * commands on a second thread. The script is parsed by a binary writer (see
+ * smtlib2binary.h), which builds the terms of every command in its own term
+ * DAG; the records of each command are passed through a queue to the
+ * backend thread, which replays them into "backend" and prints the
+ * responses, in order. So while the solver works on a check-sat, the asserts
+ * that follow it are already being parsed.
+ *
+ * The parser never waits for the backend, unless "interactive" is set: then
+ * every command is executed (and its response printed) before the next one
+ * is read, as a user at a prompt expects. The queue is bounded, so a parser
+ * far ahead of the backend waits as well.
+ *
+ * The backend is used only by the backend thread until the end of the
+ * script, and its allocator is used there. If enabled, the lexer runs on a
+ * thread too (see smtlib2_abstract_parser_set_pipelined). The commands are
+ * replayed up to let-expansion, as with smtlib2_abstract_parser_replay, and
+ * the backend is not traced (see smtlib2_abstract_parser_set_trace). Only
+ * complete commands reach the backend: a command with a syntax error is
+ * answered with the error, but the scopes it opened before the error (e.g.
+ * for the parameters of a define-fun) are not opened in the backend. If the
+ * library is built without SMTLIB2_HAVE_PTHREADS, the script is just parsed
+ * by the backend as usual
+ */
+void smtlib2_queue_parse(smtlib2_abstract_parser *backend, FILE *src,
+                         bool interactive);
+void smtlib2_queue_parse_buffer(smtlib2_abstract_parser *backend,
+                                const char *data, size_t size);
+
+#endif /* SMTLIB2QUEUE_H_INCLUDED */
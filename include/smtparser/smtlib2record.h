@@ -0,0 +1,125 @@
+/* -*- C -*-
+ *
+ * Recording of the callbacks of a parser, and replay into a backend
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2RECORD_H_INCLUDED
+#define SMTLIB2RECORD_H_INCLUDED
+
+#include "smtparser/smtlib2parserinterface.h"
+#include <stdio.h>
+
+/*
+ * File format
+ * -----------
+ *
+ * A recording is the 7-byte header "SMT2REC" followed by a format version
+ * byte, and then by a sequence of records, each starting with a one-byte
+ * opcode. Integers are encoded as in binary scripts (see smtlib2binary.h).
+ *
+ * There is a record for every callback invoked by the parser, in the order
+ * of the calls, holding its arguments. Strings are interned by records
+ *
+ *   STRING  length bytes '\0'
+ *
+ * emitted right before the first record that uses them, and are numbered
+ * from 1 in order of appearance. The sorts and terms returned by the
+ * backend are numbered from 1 as well, separately, in order of appearance:
+ * the record of a callback returning one ends with its id, and a handle
+ * that the backend returns again gets the same id. Arguments refer to
+ * strings, sorts and terms by id, with 0 for NULL; vectors are given by
+ * their size plus one (0 for NULL), followed by their elements. An END
+ * record follows the callbacks of every command whose response is printed.
+ *
+ * Unlike binary scripts, nothing is interpreted: terms are recorded as they
+ * are built, with their let bindings and scopes, annotations and errors
+ * included, so that the calls of the parser can be reproduced exactly.
+ * Lazy terms (see smtlib2_abstract_parser_set_lazy_asserts) and the terms
+ * of get-value are recorded as their source text.
+ */
+
+#define SMTLIB2_RECORD_VERSION 1
+
+/**
+ * A recorder of the callbacks of a parser. It wraps them, in the same way as
+ * the statistics (see smtlib2stats.h), and writes the record of each call
+ * before passing it to the backend. The calls that the backend makes itself
+ * from within a callback (e.g. when forcing a lazy term) are not recorded,
+ * and sorts and terms that were not returned by a recorded call are
+ * recorded as NULL. Records are buffered, and flushed every 64KB.
+ *
+ * Used by smtlib2_abstract_parser_set_recording
+ */
+typedef struct smtlib2_recorder smtlib2_recorder;
+struct smtlib2_abstract_parser;
+
+/* wraps the callbacks of p, beneath the wrappers of the statistics (if
+ * any), and writes the header of the recording to "out". Not to be called
+ * from within a callback */
+smtlib2_recorder *smtlib2_recorder_new(struct smtlib2_abstract_parser *p,
+                                       FILE *out);
+/* writes an END record */
+void smtlib2_recorder_end_command(smtlib2_recorder *r);
+/* flushes the pending output, returns false on I/O errors */
+bool smtlib2_recorder_flush(smtlib2_recorder *r);
+/* the callbacks wrapped by the recorder */
+smtlib2_parser_interface *smtlib2_recorder_wrapped(smtlib2_recorder *r);
+/* flushes the pending output (without closing it), and restores the
+ * original callbacks of "p" */
+void smtlib2_recorder_delete(smtlib2_recorder *r,
+                             struct smtlib2_abstract_parser *p);
+
+
+/**
+ * A reader for recordings. Files are memory-mapped where the platform
+ * allows it
+ */
+typedef struct smtlib2_recording smtlib2_recording;
+
+/* both return NULL if the input is not a recording */
+smtlib2_recording *smtlib2_recording_new(const char *filename);
+smtlib2_recording *smtlib2_recording_new_from_memory(const char *data,
+                                                     size_t size);
+void smtlib2_recording_delete(smtlib2_recording *r);
+
+/**
+ * Invokes the recorded callbacks on the given backend, in the same order
+ * and with the same arguments, except for the sorts and terms, which are
+ * the ones it returned for the recorded ones. Every replay starts from the
+ * beginning of the recording. Returns false if the recording is corrupted,
+ * in which case smtlib2_recording_get_error_msg() tells why (the callbacks
+ * before the corrupted record are invoked anyway)
+ */
+bool smtlib2_recording_replay(smtlib2_recording *r,
+                              smtlib2_parser_interface *parser);
+const char *smtlib2_recording_get_error_msg(smtlib2_recording *r);
+
+/**
+ * Like smtlib2_recording_replay, but also handles the responses of an
+ * abstract parser, printing them at the END records in the same way as
+ * smtlib2_abstract_parser_parse does. If the parser is being recorded in
+ * turn, the output is the same as the input
+ */
+bool smtlib2_abstract_parser_replay_recording(
+    struct smtlib2_abstract_parser *p, smtlib2_recording *r);
+
+#endif /* SMTLIB2RECORD_H_INCLUDED */
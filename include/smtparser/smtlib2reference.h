@@ -0,0 +1,75 @@
+/* -*- C -*-
+ *
+ * Reference backend for the SMT-LIB v2 parser, with no solver behind it
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2REFERENCE_H_INCLUDED
+#define SMTLIB2REFERENCE_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2termdag.h"
+#include "smtparser/smtlib2pmap.h"
+
+/**
+ * A self-contained backend implementing all the callbacks, without any
+ * solver: it keeps a table of sorts (declared, defined and builtin), the
+ * declared functions, the named terms and the assertions, with push/pop
+ * scopes (its tables are registered for persistent scopes, see
+ * smtlib2_abstract_parser_set_persistent_scopes), and builds all the terms
+ * in a term DAG. Functions defined with parameters are not expanded: they
+ * are treated as declared functions, and their applications are kept as
+ * such. check-sat always answers "unknown".
+ *
+ * It is meant as a baseline for benchmarking and testing the parser, and as
+ * an example of a complete backend. It supports snapshots (see
+ * smtlib2snapshot.h): its tables are persistent maps, and the DAG of a
+ * snapshot is frozen and shared by the clones, which build their terms in
+ * layers of their own on top of it
+ */
+typedef struct smtlib2_reference_parser {
+    smtlib2_abstract_parser parent_;
+    smtlib2_termdag *dag_;
+    smtlib2_pmap sorts_;             /* symbol -> arity (-1 for indexed) */
+    smtlib2_pmap sort_defs_;         /* symbol -> smtlib2_reference_sort_def */
+    smtlib2_pmap functions_;         /* symbol -> smtlib2_dag_sort */
+    smtlib2_pmap named_terms_;       /* symbol -> smtlib2_dag_term */
+    smtlib2_vector *bound_vars_;
+    smtlib2_pmap assertions_;        /* index -> smtlib2_dag_term */
+    /* the sorts before the parameters of a define-sort, and the size of the
+     * trail then */
+    smtlib2_pmap param_sorts_;
+    size_t param_mark_;
+} smtlib2_reference_parser;
+
+
+smtlib2_reference_parser *smtlib2_reference_parser_new(void);
+/* like smtlib2_reference_parser_new, but with all the memory of the parser
+ * coming from the given allocator (see smtlib2allocator.h) */
+smtlib2_reference_parser *smtlib2_reference_parser_new_with_allocator(
+                                                        smtlib2_allocator *a);
+void smtlib2_reference_parser_delete(smtlib2_reference_parser *p);
+smtlib2_parser_interface *SMTLIB2_PARSER_INTERFACE_REFERENCE(
+                                                  smtlib2_reference_parser *p);
+
+#endif /* SMTLIB2REFERENCE_H_INCLUDED */
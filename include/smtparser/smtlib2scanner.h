@@ -30,11 +30,80 @@
 
 #include "smtparser/smtlib2parserinterface.h"
 #include "smtparser/smtlib2stream.h"
+#include "smtparser/smtlib2stats.h"
 
 typedef struct smtlib2_scanner smtlib2_scanner;
 
+/**
+ * Where a top-level command starts, and how long it took to lex it. Filled
+ * while the command is read, when the scanner tracks it (see
+ * smtlib2_scanner_track_command)
+ */
+typedef struct smtlib2_command_info {
+    size_t offset_;           /* byte offset of the opening parenthesis */
+    int line_;                /* line of the opening parenthesis */
+    const char *name_;        /* bison name of the command token (e.g.
+                               * "\"assert\""), NULL if not read yet */
+    size_t tokens_;           /* number of tokens read */
+    smtlib2_ticks start_;     /* when the opening parenthesis was read */
+    smtlib2_ticks lex_ticks_; /* time spent in the lexer since then */
+    bool traced_;             /* used by the tracer (see smtlib2trace.h) */
+} smtlib2_command_info;
+
 smtlib2_scanner *smtlib2_scanner_new(smtlib2_stream *source);
 void smtlib2_scanner_delete(smtlib2_scanner *s);
+
+/* puts the scanner back in its initial state, reading from "source". This is
+ * much cheaper than deleting it and creating a new one, as the flex buffers
+ * are kept */
+void smtlib2_scanner_reset(smtlib2_scanner *s, smtlib2_stream *source);
+
+/* like smtlib2_scanner_new/smtlib2_scanner_delete, but using a small pool of
+ * reset scanners local to the calling thread, when the library is built with
+ * SMTLIB2_SCANNER_POOL (otherwise, they just create and delete scanners).
+ * smtlib2_scanner_pool_clear frees the scanners in the pool of the calling
+ * thread (e.g. before it exits) */
+smtlib2_scanner *smtlib2_scanner_acquire(smtlib2_stream *source);
+void smtlib2_scanner_release(smtlib2_scanner *s);
+void smtlib2_scanner_pool_clear(void);
 void smtlib2_parse(smtlib2_scanner *scanner, smtlib2_parser_interface *parser);
 
+/* parses the whole content of the stream as a list of terms, which are passed
+ * to the set_internal_parsed_terms callback. The scanner is restarted first,
+ * so that it can be reused for several calls on the same stream after
+ * refilling it */
+void smtlib2_parse_terms(smtlib2_scanner *scanner,
+                         smtlib2_parser_interface *parser);
+
+/* when enabled, the terms of "assert" commands are not parsed, but passed to
+ * the assert_lazy_formula callback */
+void smtlib2_scanner_set_lazy_asserts(smtlib2_scanner *s, bool yes);
+
+/* makes the scanner fill "info" (which is cleared first) while reading the
+ * next command. NULL stops tracking */
+void smtlib2_scanner_track_command(smtlib2_scanner *s,
+                                   smtlib2_command_info *info);
+
+/**
+ * Runs the lexer on a separate thread, ahead of the parser: the tokens are
+ * passed to smtlib2_parse through a bounded lock-free queue, so that lexing
+ * overlaps with parsing and with the callbacks. The lexer reads the stream
+ * until its end, so this is not meant for interactive input. Returns false
+ * (and the scanner keeps working on the calling thread) if the library is
+ * built without SMTLIB2_HAVE_PTHREADS, or if the scanner does not use the
+ * default allocator, as others might not be thread-safe.
+ * smtlib2_scanner_stop_pipeline stops the thread and discards the tokens not
+ * parsed yet; resetting, releasing or deleting the scanner does the same
+ */
+bool smtlib2_scanner_start_pipeline(smtlib2_scanner *s);
+void smtlib2_scanner_stop_pipeline(smtlib2_scanner *s);
+
+/* true once the end of the input has been read by the parser. Without the
+ * lexer thread, this is the same as the end of the stream */
+bool smtlib2_scanner_at_end(smtlib2_scanner *s);
+
+/* runs only the lexer until the end of the input, discarding the tokens, and
+ * returns how many were read. Useful for measuring the lexer alone */
+size_t smtlib2_scanner_count_tokens(smtlib2_scanner *s);
+
 #endif /* SMTLIB2SCANNER_H_INCLUDED */
@@ -0,0 +1,54 @@
+/* -*- C -*-
+ *
+ * Scanner for the SMT-LIB v2 parser (private part)
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2SCANNER_PRIVATE_H_INCLUDED
+#define SMTLIB2SCANNER_PRIVATE_H_INCLUDED
+
+#include "smtparser/smtlib2scanner.h"
+
+/**
+ * The scanner is also the "extra" data of the flex lexer, so that the lexer
+ * can access its state
+ */
+struct smtlib2_scanner {
+    void *flex_scanner_;
+    smtlib2_allocator *allocator_;  /* used for all the memory of flex */
+    smtlib2_stream *stream_;
+    size_t offset_;        /* bytes consumed by the lexer so far */
+    int start_token_;      /* token to return before reading the input */
+    bool lazy_asserts_;
+    int lazy_depth_;       /* nesting depth of the lazy term being read */
+    size_t lazy_offset_;   /* where the lazy term being read starts */
+    int lazy_line_;
+    bool lazy_list_;       /* reading the term list of a get-value */
+    smtlib2_command_info *command_;  /* the command being tracked, if any */
+    struct smtlib2_token_ring *ring_; /* the lexer thread, if running */
+};
+
+/* the position (byte offset and line) right after the last token passed to
+ * the parser */
+void smtlib2_scanner_token_position(smtlib2_scanner *s, size_t *offset,
+                                    int *line);
+
+#endif /* SMTLIB2SCANNER_PRIVATE_H_INCLUDED */
@@ -0,0 +1,97 @@
+/* -*- C -*-
+ *
+ * Cone-of-influence slicing of the queries of a script
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2SLICER_H_INCLUDED
+#define SMTLIB2SLICER_H_INCLUDED
+
+#include "smtparser/smtlib2splitter.h"
+
+/**
+ * A splitter (see smtlib2splitter.h) that also drops from every query the
+ * commands outside the cone of influence of its assertions. While the script
+ * is parsed, every command records the function and sort symbols it refers
+ * to, as seen by the term parser when making terms and sorts (let-bound
+ * symbols are resolved by the term parser itself, so they never show up).
+ * The label of a :named annotation counts as a symbol of its command, so
+ * that the asserts referring to the label are linked to the one naming it.
+ * The terms of get-value are parsed too, for the same reason. Then, for
+ * every query:
+ *
+ *  - the asserts are the roots, together with the commands that are not
+ *    declarations or definitions (set-option, check-sat, get-value, ...);
+ *  - a declare-fun, define-fun, declare-sort or define-sort is kept only if
+ *    the symbol it introduces is referred to by a kept command, transitively.
+ *
+ * With a goal (see smtlib2_slicer_set_goal), only the last assert of each
+ * query is a root, and the other asserts are kept only if they refer to a
+ * symbol of the cone, transitively. Only the symbols declared or defined in
+ * the query and the :named labels count here: sharing a theory symbol such
+ * as + or Int doesn't make two asserts related. This is the usual relevance
+ * filtering of verification conditions: the unrelated axioms are dropped,
+ * which preserves the answer of the query unless they are unsatisfiable on
+ * their own.
+ *
+ * The queries are printed and written with the functions of the splitter,
+ * on the parent_ field
+ */
+typedef struct smtlib2_slicer {
+    smtlib2_splitter parent_;
+    bool goal_;
+    smtlib2_hashtable *functions_; /* symbol -> id */
+    smtlib2_hashtable *sorts_;     /* sort symbol -> id */
+    size_t num_symbols_;
+    smtlib2_vector *uses_;    /* the ids of the symbols referred to by the
+                               * commands, command after command */
+    smtlib2_vector *offsets_; /* the i-th command refers to the symbols in
+                               * uses_[offsets_[i], offsets_[i+1]) */
+    smtlib2_vector *seen_;    /* per symbol, 1 + the last command that
+                               * referred to it */
+    smtlib2_vector *defined_; /* per command, 1 + the id of the symbol it
+                               * introduces (0 if none) */
+    smtlib2_vector *labels_;  /* per symbol, whether it is the label of a
+                               * :named annotation */
+    size_t num_dropped_[2];   /* declarations and definitions, asserts */
+    /* the get-value callback of the splitter */
+    void (*get_value_)(smtlib2_parser_interface *p, smtlib2_vector *terms);
+} smtlib2_slicer;
+
+
+smtlib2_slicer *smtlib2_slicer_new(void);
+void smtlib2_slicer_delete(smtlib2_slicer *sl);
+
+/* if true, the last assert of each query is its goal (see above) */
+void smtlib2_slicer_set_goal(smtlib2_slicer *sl, bool yes);
+
+/* records and slices the queries of the indexed script, which must outlive
+ * the slicer */
+void smtlib2_slicer_parse(smtlib2_slicer *sl, smtlib2_command_index *idx);
+
+/* the number of declarations and definitions dropped, over all the
+ * queries */
+size_t smtlib2_slicer_num_dropped_declarations(smtlib2_slicer *sl);
+/* the number of asserts dropped, over all the queries */
+size_t smtlib2_slicer_num_dropped_asserts(smtlib2_slicer *sl);
+
+#endif /* SMTLIB2SLICER_H_INCLUDED */
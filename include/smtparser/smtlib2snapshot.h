@@ -0,0 +1,76 @@
+/* -*- C -*-
+ *
+ * Snapshots of SMT-LIB v2 parsers, cloned in O(1)
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2SNAPSHOT_H_INCLUDED
+#define SMTLIB2SNAPSHOT_H_INCLUDED
+
+#include "smtparser/smtlib2abstractparser.h"
+
+/**
+ * A snapshot of the state of a parser between two commands: the bindings of
+ * define-fun, the info, the options and the state of the backend. Any
+ * number of clones can be made from a snapshot, each a new parser that
+ * continues from that state independently of the others and of the
+ * original, e.g. to try the different suffixes of a script that share a
+ * long prefix, on different threads.
+ *
+ * The state is kept in persistent structures (see smtlib2pmap.h), so taking
+ * a snapshot and cloning it take constant time in the size of the state:
+ * the clones share it with the snapshot, and copy only what they modify.
+ * The only exceptions are the undo trail of the assertion stack (see
+ * smtlib2_abstract_parser_record_undo), which is copied, and the maps saved
+ * at every push with persistent scopes, of which a copy is made per level.
+ *
+ * Snapshots need the support of the backend, which provides the hooks
+ * below; at the moment, only the reference backend (smtlib2reference.h) has
+ * them. Since they share memory across parsers, they can only be taken of
+ * parsers created with the default allocator (see smtlib2allocator.h).
+ *
+ * A clone is a parser of the same backend as the original, to be deleted
+ * with the function of the backend. The callback wrappers of statistics,
+ * tracing, recording (smtlib2record.h) and memoisation (smtlib2memo.h) are
+ * not cloned. Snapshots and clones can be used and deleted by
+ * different threads, as long as each one is only used by one thread at a
+ * time
+ */
+typedef struct smtlib2_snapshot smtlib2_snapshot;
+
+typedef struct smtlib2_snapshot_backend {
+    /* returns the state of the backend of p, which continues after it */
+    void *(*save)(smtlib2_abstract_parser *p);
+    /* returns a new parser of the backend, in the saved state */
+    smtlib2_abstract_parser *(*restore)(void *state);
+    void (*release)(void *state);
+} smtlib2_snapshot_backend;
+
+
+/* returns NULL if the backend of p doesn't support snapshots, or p doesn't
+ * use the default allocator */
+smtlib2_snapshot *smtlib2_parser_snapshot(smtlib2_abstract_parser *p);
+smtlib2_abstract_parser *smtlib2_parser_clone(smtlib2_snapshot *s);
+/* the clones are independent of the snapshot, and can outlive it */
+void smtlib2_snapshot_delete(smtlib2_snapshot *s);
+
+#endif /* SMTLIB2SNAPSHOT_H_INCLUDED */
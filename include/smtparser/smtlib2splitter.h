@@ -0,0 +1,91 @@
+/* -*- C -*-
+ *
+ * Splitting of incremental scripts into independent queries
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SMTLIB2SPLITTER_H_INCLUDED
+#define SMTLIB2SPLITTER_H_INCLUDED
+
+#include "smtparser/smtlib2null.h"
+#include "smtparser/smtlib2cmdindex.h"
+#include <stdio.h>
+
+/**
+ * A backend that turns an incremental script into one standalone,
+ * non-incremental script per check-sat. It keeps the assertion stack of the
+ * script: the declarations, definitions and asserts of every push level,
+ * undone by pop (and all of them by reset-assertions and reset, the latter
+ * also forgetting the set-logic, set-option and set-info commands seen so
+ * far). At every check-sat, the commands live at that point are
+ * recorded as a query, which then consists of:
+ *
+ *  - the set-logic, set-option and set-info commands seen so far;
+ *  - the live declare-sort, define-sort, declare-fun, define-fun and assert
+ *    commands, in the order of the script;
+ *  - the check-sat, followed by the get-value, get-assignment,
+ *    get-unsat-core, get-proof and get-assertions commands right after it;
+ *  - an exit.
+ *
+ * The commands are parsed one at a time with the command index of the script
+ * (see smtlib2cmdindex.h), so that each one is printed back from its exact
+ * source text. The asserts are parsed lazily (see
+ * smtlib2_abstract_parser_set_lazy_asserts), so their terms are never built;
+ * everything else goes through the callbacks of the null backend. Commands
+ * with errors are reported on the diagnostic output, and left out
+ */
+typedef struct smtlib2_splitter {
+    smtlib2_null_parser parent_;
+    smtlib2_command_index *index_;
+    size_t current_;          /* the command being parsed */
+    smtlib2_vector *header_;  /* indices of the commands of every query */
+    smtlib2_vector *stack_;   /* indices of the live commands */
+    smtlib2_vector *levels_;  /* size of stack_ at every push */
+    smtlib2_vector *queries_; /* per check-sat, a vector with the indices of
+                               * its commands */
+    bool attach_;             /* get-value & co. go to the last query */
+} smtlib2_splitter;
+
+
+smtlib2_splitter *smtlib2_splitter_new(void);
+void smtlib2_splitter_delete(smtlib2_splitter *s);
+/* for backends built on top of this one (see e.g. smtlib2slicer.h) */
+void smtlib2_splitter_init(smtlib2_splitter *s, smtlib2_context ctx);
+void smtlib2_splitter_deinit(smtlib2_splitter *s);
+
+/* records the queries of the indexed script, which must outlive the
+ * splitter */
+void smtlib2_splitter_parse(smtlib2_splitter *s, smtlib2_command_index *idx);
+
+size_t smtlib2_splitter_num_queries(smtlib2_splitter *s);
+/* prints the i-th query. Returns false on I/O errors */
+bool smtlib2_splitter_print_query(smtlib2_splitter *s, size_t i, FILE *out);
+/**
+ * Writes each query to a file of its own, named "PREFIXn.smt2" with n the
+ * number of its check-sat (from 1, on at least 4 digits). The files are
+ * written by nthreads writer threads, or by the calling thread if threads
+ * are not available. Returns the number of files that could not be written
+ */
+size_t smtlib2_splitter_write(smtlib2_splitter *s, const char *prefix,
+                              int nthreads);
+
+#endif /* SMTLIB2SPLITTER_H_INCLUDED */
@@ -0,0 +1,165 @@
+/* -*- C -*-
+ *
+ * Instrumentation of the parser callbacks: counters and latency histograms
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2STATS_H_INCLUDED
+#define SMTLIB2STATS_H_INCLUDED
+
+#include "smtparser/smtlib2vector.h"
+#include "smtparser/smtlib2parserinterface.h"
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * A cheap timestamp: the time-stamp counter on x86 (and the virtual counter
+ * on AArch64), nanoseconds elsewhere. The conversion to time is done only
+ * when reporting (see smtlib2_parser_stats_ns)
+ */
+typedef uint64_t smtlib2_ticks;
+
+smtlib2_ticks smtlib2_ticks_now(void);
+/* nanoseconds per tick, measured against the wall clock by spinning for
+ * about a millisecond */
+double smtlib2_ticks_calibrate(void);
+
+
+/**
+ * A histogram in the style of HdrHistogram: every power of two is split in
+ * 2^SMTLIB2_HISTOGRAM_SUB_BITS buckets, so that the values are counted with
+ * a relative error below 1/16 over the whole 64-bit range, and recording a
+ * sample costs a few instructions. The buckets are allocated at the first
+ * sample, with the current allocator
+ */
+#define SMTLIB2_HISTOGRAM_SUB_BITS 4
+#define SMTLIB2_HISTOGRAM_BUCKETS \
+    ((64 - SMTLIB2_HISTOGRAM_SUB_BITS + 1) << SMTLIB2_HISTOGRAM_SUB_BITS)
+
+typedef struct smtlib2_histogram {
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t min_;
+    uint64_t max_;
+    uint64_t *buckets_;
+} smtlib2_histogram;
+
+void smtlib2_histogram_init(smtlib2_histogram *h);
+void smtlib2_histogram_deinit(smtlib2_histogram *h);
+void smtlib2_histogram_record(smtlib2_histogram *h, uint64_t value);
+/* the value below which the fraction "q" (between 0 and 1) of the samples
+ * falls, up to the precision of the buckets. 0 if there are no samples */
+uint64_t smtlib2_histogram_percentile(const smtlib2_histogram *h, double q);
+
+
+/**
+ * The instrumented callbacks of smtlib2_parser_interface, plus the symbol
+ * lookups done by the term parser for every term
+ */
+typedef enum {
+    SMTLIB2_STAT_SET_LOGIC,
+    SMTLIB2_STAT_DECLARE_SORT,
+    SMTLIB2_STAT_DEFINE_SORT,
+    SMTLIB2_STAT_DECLARE_FUNCTION,
+    SMTLIB2_STAT_DECLARE_VARIABLE,
+    SMTLIB2_STAT_DEFINE_FUNCTION,
+    SMTLIB2_STAT_PUSH,
+    SMTLIB2_STAT_POP,
+    SMTLIB2_STAT_RESET_ASSERTIONS,
+    SMTLIB2_STAT_RESET,
+    SMTLIB2_STAT_ASSERT_FORMULA,
+    SMTLIB2_STAT_ASSERT_LAZY_FORMULA,
+    SMTLIB2_STAT_CHECK_SAT,
+    SMTLIB2_STAT_GET_ASSIGNMENT,
+    SMTLIB2_STAT_GET_ASSERTIONS,
+    SMTLIB2_STAT_GET_UNSAT_CORE,
+    SMTLIB2_STAT_GET_PROOF,
+    SMTLIB2_STAT_SET_STR_OPTION,
+    SMTLIB2_STAT_SET_INT_OPTION,
+    SMTLIB2_STAT_SET_RAT_OPTION,
+    SMTLIB2_STAT_GET_INFO,
+    SMTLIB2_STAT_SET_INFO,
+    SMTLIB2_STAT_GET_VALUE,
+    SMTLIB2_STAT_EXIT,
+    SMTLIB2_STAT_HANDLE_ERROR,
+    SMTLIB2_STAT_SET_INTERNAL_PARSED_TERMS,
+    SMTLIB2_STAT_PUSH_LET_SCOPE,
+    SMTLIB2_STAT_POP_LET_SCOPE,
+    SMTLIB2_STAT_PUSH_QUANTIFIER_SCOPE,
+    SMTLIB2_STAT_POP_QUANTIFIER_SCOPE,
+    SMTLIB2_STAT_PUSH_SORT_PARAM_SCOPE,
+    SMTLIB2_STAT_POP_SORT_PARAM_SCOPE,
+    SMTLIB2_STAT_MAKE_TERM,
+    SMTLIB2_STAT_MAKE_NUMBER_TERM,
+    SMTLIB2_STAT_MAKE_FORALL_TERM,
+    SMTLIB2_STAT_MAKE_EXISTS_TERM,
+    SMTLIB2_STAT_ANNOTATE_TERM,
+    SMTLIB2_STAT_DEFINE_LET_BINDING,
+    SMTLIB2_STAT_MAKE_SORT,
+    SMTLIB2_STAT_MAKE_PARAMETRIC_SORT,
+    SMTLIB2_STAT_MAKE_FUNCTION_SORT,
+    SMTLIB2_STAT_SYMBOL_LOOKUP,
+    SMTLIB2_STAT_COUNT
+} smtlib2_stat;
+
+/* the name used in reports, e.g. ":make-term" */
+const char *smtlib2_stat_name(smtlib2_stat which);
+
+
+typedef struct smtlib2_parser_stats smtlib2_parser_stats;
+struct smtlib2_abstract_parser;
+
+/**
+ * Wraps every (non-NULL) callback of "p" with a function that counts its
+ * invocations and records their latency, then calls the original one. The
+ * wrappers also emit a span for every callback if the parser is traced (see
+ * smtlib2_abstract_parser_set_trace). Must be called after the backend has
+ * installed its callbacks, and not from within a callback. Used by
+ * smtlib2_abstract_parser_enable_stats
+ */
+smtlib2_parser_stats *smtlib2_parser_stats_new(
+    struct smtlib2_abstract_parser *p);
+/* restores the original callbacks of "p" */
+void smtlib2_parser_stats_delete(smtlib2_parser_stats *s,
+                                 struct smtlib2_abstract_parser *p);
+/* the original callbacks, which another layer can wrap in turn to stay
+ * beneath the statistics (see smtlib2memo.h) */
+smtlib2_parser_interface *smtlib2_parser_stats_wrapped(
+    smtlib2_parser_stats *s);
+
+/* forgets all the samples recorded so far */
+void smtlib2_parser_stats_reset(smtlib2_parser_stats *s);
+const smtlib2_histogram *smtlib2_parser_stats_get(smtlib2_parser_stats *s,
+                                                  smtlib2_stat which);
+/* converts ticks to nanoseconds (calibrated against the wall clock) */
+double smtlib2_parser_stats_ns(smtlib2_parser_stats *s, uint64_t ticks);
+
+/**
+ * Pushes to "out" a pair <name, value> for every callback invoked at least
+ * once, where value is an attribute list like
+ * "(:count 3 :total-ns 120 :mean-ns 40 :p50-ns 38 ...)". The strings are
+ * owned by "s", and are valid until the next report
+ */
+void smtlib2_parser_stats_report(smtlib2_parser_stats *s, smtlib2_vector *out);
+/* prints a table of the statistics, with lines starting with ";;" */
+void smtlib2_parser_stats_print(smtlib2_parser_stats *s, FILE *out);
+
+#endif /* SMTLIB2STATS_H_INCLUDED */
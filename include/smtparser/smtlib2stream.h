@@ -68,5 +68,21 @@ typedef struct {
 smtlib2_sstream *smtlib2_sstream_new(smtlib2_charbuf *buf);
 void smtlib2_sstream_delete(smtlib2_sstream *s);
 
+/*****************************************************************************
+ * Read-only streams over a memory area, which is not copied. Like FILE-based
+ * streams, they report eof only after an attempt to read past the end
+ *****************************************************************************/
+
+typedef struct {
+    smtlib2_stream parent_;
+    const char *data_;
+    size_t size_;
+    size_t nextidx_;
+    bool eof_;
+} smtlib2_mstream;
+
+smtlib2_mstream *smtlib2_mstream_new(const char *data, size_t size);
+void smtlib2_mstream_delete(smtlib2_mstream *s);
+
 
 #endif /* SMTLIB2STREAM_H_INCLUDED */
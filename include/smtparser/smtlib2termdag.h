@@ -0,0 +1,142 @@
+/* -*- C -*-
+ *
+ * Hash-consed DAG of sorts and terms for the SMT-LIB v2 parser
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2TERMDAG_H_INCLUDED
+#define SMTLIB2TERMDAG_H_INCLUDED
+
+#include "smtparser/smtlib2utils.h"
+#include <stdint.h>
+
+typedef struct smtlib2_termdag smtlib2_termdag;
+
+/**
+ * An interned symbol. Symbols are numbered densely in creation order
+ */
+typedef struct smtlib2_dag_symbol {
+    uint32_t id_;
+    uint32_t hash_;
+    char name_[1];
+} smtlib2_dag_symbol;
+
+
+typedef enum {
+    SMTLIB2_DAG_SORT_BASIC,       /* a sort name, possibly indexed,
+                                   * e.g. Int or (_ BitVec 8) */
+    SMTLIB2_DAG_SORT_PARAMETRIC,  /* an instantiated parametric sort,
+                                   * e.g. (Array Int Int) */
+    SMTLIB2_DAG_SORT_FUNCTION     /* a function sort: domain sorts followed
+                                   * by the codomain */
+} smtlib2_dag_sort_kind;
+
+
+typedef struct smtlib2_dag_sort {
+    uint32_t id_;
+    uint32_t hash_;
+    smtlib2_dag_sort_kind kind_;
+    smtlib2_dag_symbol *name_;  /* NULL for function sorts */
+    size_t nidx_;
+    intptr_t *idx_;
+    size_t nargs_;
+    struct smtlib2_dag_sort **args_;
+} smtlib2_dag_sort;
+
+
+typedef enum {
+    SMTLIB2_DAG_TERM_APP,     /* a symbol, possibly indexed and annotated
+                               * with an "as" sort, applied to arguments
+                               * (constants have no arguments) */
+    SMTLIB2_DAG_TERM_NUMBER,  /* a numeric constant. the symbol holds the
+                               * digits, the index is { width, base }, as in
+                               * the make_number_term callback */
+    SMTLIB2_DAG_TERM_VAR,     /* a variable bound by a quantifier or by the
+                               * parameter list of a define-fun */
+    SMTLIB2_DAG_TERM_FORALL,  /* the bound variables followed by the body */
+    SMTLIB2_DAG_TERM_EXISTS
+} smtlib2_dag_term_kind;
+
+
+typedef struct smtlib2_dag_term {
+    uint32_t id_;
+    uint32_t hash_;
+    smtlib2_dag_term_kind kind_;
+    smtlib2_dag_symbol *symbol_;  /* NULL for quantifiers */
+    smtlib2_dag_sort *sort_;      /* "as" annotation or variable sort */
+    size_t nidx_;
+    intptr_t *idx_;
+    size_t nargs_;
+    struct smtlib2_dag_term **args_;
+} smtlib2_dag_term;
+
+
+smtlib2_termdag *smtlib2_termdag_new(void);
+/* releases a reference to the DAG (see below), deleting it with the last
+ * one */
+void smtlib2_termdag_delete(smtlib2_termdag *d);
+
+/**
+ * Returns a new, empty DAG built on top of base, which is frozen: no nodes
+ * can be added to it anymore, but it can be shared by any number of DAGs
+ * built on it, also used by different threads. The nodes of base are found
+ * by the lookups of the new DAG, and its own nodes are numbered after them.
+ * The new DAG holds a reference to base (the DAGs are reference counted,
+ * starting from 1 when created)
+ */
+smtlib2_termdag *smtlib2_termdag_new_layer(smtlib2_termdag *base);
+smtlib2_termdag *smtlib2_termdag_retain(smtlib2_termdag *d);
+/* true if the DAG has no nodes of its own */
+bool smtlib2_termdag_is_empty(smtlib2_termdag *d);
+/* the DAG this one is built on, or NULL */
+smtlib2_termdag *smtlib2_termdag_base(smtlib2_termdag *d);
+
+smtlib2_dag_symbol *smtlib2_termdag_intern(smtlib2_termdag *d,
+                                           const char *name);
+
+/*
+ * the following return the unique node with the given structure, creating
+ * it if necessary. New nodes always get the next free id, so nodes are
+ * numbered in topological order
+ */
+smtlib2_dag_sort *smtlib2_termdag_mk_sort(smtlib2_termdag *d,
+                                          smtlib2_dag_sort_kind kind,
+                                          smtlib2_dag_symbol *name,
+                                          size_t nidx, const intptr_t *idx,
+                                          size_t nargs,
+                                          smtlib2_dag_sort **args);
+smtlib2_dag_term *smtlib2_termdag_mk_term(smtlib2_termdag *d,
+                                          smtlib2_dag_term_kind kind,
+                                          smtlib2_dag_symbol *symbol,
+                                          smtlib2_dag_sort *sort,
+                                          size_t nidx, const intptr_t *idx,
+                                          size_t nargs,
+                                          smtlib2_dag_term **args);
+
+size_t smtlib2_termdag_num_symbols(smtlib2_termdag *d);
+size_t smtlib2_termdag_num_sorts(smtlib2_termdag *d);
+size_t smtlib2_termdag_num_terms(smtlib2_termdag *d);
+
+smtlib2_dag_symbol *smtlib2_termdag_symbol(smtlib2_termdag *d, uint32_t id);
+smtlib2_dag_sort *smtlib2_termdag_sort(smtlib2_termdag *d, uint32_t id);
+smtlib2_dag_term *smtlib2_termdag_term(smtlib2_termdag *d, uint32_t id);
+
+#endif /* SMTLIB2TERMDAG_H_INCLUDED */
@@ -30,9 +30,13 @@
 
 #include "smtparser/smtlib2types.h"
 #include "smtparser/smtlib2utils.h"
+#include "smtparser/smtlib2stats.h"
+#include "smtparser/smtlib2pmap.h"
 
 
 typedef struct smtlib2_term_parser smtlib2_term_parser;
+/* see smtlib2handlertable.h */
+typedef struct smtlib2_handler_table smtlib2_handler_table;
 
 typedef smtlib2_term (*smtlib2_term_parser_symbolhandler)(smtlib2_context ctx,
                                                           const char *symbol,
@@ -54,13 +58,21 @@ typedef smtlib2_term (*smtlib2_term_parser_functionhandler)(
 struct smtlib2_term_parser {
     smtlib2_context ctx_;
     smtlib2_hashtable *symbol_handlers_;
+    /* shared handlers, looked up when the symbol is not in symbol_handlers_
+     * (may be NULL) */
+    const smtlib2_handler_table *handler_table_;
     smtlib2_term_parser_functionhandler function_term_handler_;
     smtlib2_term_parser_numberhandler number_term_handler_;
     smtlib2_hashtable *let_bindings_;
     smtlib2_vector *let_levels_;
-    smtlib2_hashtable *bindings_;
-    smtlib2_hashtable *term_params_;
+    /* persistent, so that they can be shared by parser snapshots (see
+     * smtlib2snapshot.h) */
+    smtlib2_pmap bindings_;
+    smtlib2_pmap term_params_;
     char *errmsg_;
+    /* if not NULL, the latency of the symbol lookups of make_term is
+     * recorded here (see smtlib2stats.h) */
+    smtlib2_histogram *lookup_stats_;
 };
 
 
@@ -92,6 +104,12 @@ void smtlib2_term_parser_undefine_binding(smtlib2_term_parser *tp,
 void smtlib2_term_parser_set_handler(smtlib2_term_parser *tp,
                                      const char *symbol,
                                      smtlib2_term_parser_symbolhandler handler);
+/* uses the handlers of the given table for the symbols that have no handler
+ * set with smtlib2_term_parser_set_handler, which thus overrides the table
+ * (also with a NULL handler, which hides the symbol of the table). The table
+ * must outlive the term parser */
+void smtlib2_term_parser_set_handler_table(smtlib2_term_parser *tp,
+                                           const smtlib2_handler_table *t);
 void smtlib2_term_parser_set_function_handler(
     smtlib2_term_parser *tp,
     smtlib2_term_parser_functionhandler handler);
@@ -101,5 +119,6 @@ void smtlib2_term_parser_set_number_handler(
 
 bool smtlib2_term_parser_error(smtlib2_term_parser *tp);
 const char *smtlib2_term_parser_get_error_msg(smtlib2_term_parser *tp);
+void smtlib2_term_parser_clear_error(smtlib2_term_parser *tp);
 
 #endif /* SMTLIBTERMPARSER_H_INCLUDED */
@@ -0,0 +1,65 @@
+/* -*- C -*-
+ *
+ * Timeline traces of the parser, in the Chrome trace-event format
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SMTLIB2TRACE_H_INCLUDED
+#define SMTLIB2TRACE_H_INCLUDED
+
+#include "smtparser/smtlib2scanner.h"
+#include "smtparser/smtlib2stats.h"
+#include <stdio.h>
+
+/**
+ * Writes nested spans as trace events in the JSON array format of Chrome,
+ * which can be opened with chrome://tracing or https://ui.perfetto.dev. The
+ * array is terminated only when the tracer is deleted, which the viewers
+ * tolerate, so that a partial trace of a process that got stuck or killed is
+ * still readable
+ */
+typedef struct smtlib2_tracer smtlib2_tracer;
+
+smtlib2_tracer *smtlib2_tracer_new(FILE *out);
+/* terminates the trace, without closing the output */
+void smtlib2_tracer_delete(smtlib2_tracer *t);
+
+/**
+ * Spans for top-level commands. "info" is filled by the scanner while the
+ * command is read (see smtlib2_scanner_track_command): the span starts when
+ * its first token is read, and carries its line, byte offset, number of
+ * tokens and time spent in the lexer. Nothing is written for an empty
+ * command (at the end of the input). Commands can be nested (e.g. when a
+ * callback parses some other input): begin returns the command it
+ * interrupts, to be passed to end
+ */
+smtlib2_command_info *smtlib2_tracer_begin_command(smtlib2_tracer *t,
+                                                   smtlib2_command_info *info);
+void smtlib2_tracer_end_command(smtlib2_tracer *t,
+                                smtlib2_command_info *prev);
+
+/* a span nested in the current command. "name" and "category" must be
+ * plain identifiers (no JSON escapes are needed) */
+void smtlib2_tracer_begin(smtlib2_tracer *t, const char *name,
+                          const char *category, smtlib2_ticks when);
+void smtlib2_tracer_end(smtlib2_tracer *t, smtlib2_ticks when);
+
+#endif /* SMTLIB2TRACE_H_INCLUDED */
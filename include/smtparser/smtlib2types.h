@@ -31,4 +31,6 @@ typedef void *smtlib2_term;
 typedef void *smtlib2_sort;
 typedef void *smtlib2_context;
 
+typedef struct smtlib2_lazy_term smtlib2_lazy_term;
+
 #endif /* SMTLIB2TYPES_H_INCLUDED */
@@ -37,4 +37,11 @@ char *smtlib2_strdup(const char *src);
 char *smtlib2_sprintf(const char *fmt, ...);
 char *smtlib2_vsprintf(const char *fmt, va_list args);
 
+/*
+ * maps the whole file in memory, read-only (it is read into a buffer on
+ * platforms without mmap). Returns NULL if the file can't be opened
+ */
+const char *smtlib2_map_file(const char *filename, size_t *size);
+void smtlib2_unmap_file(const char *data, size_t size);
+
 #endif /* SMTLIB2UTILS_H_INCLUDED */
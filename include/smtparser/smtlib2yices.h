@@ -39,8 +39,6 @@ typedef struct smtlib2_yices_parser {
     smtlib2_hashtable *parametric_sorts_;
     int next_sort_idx_;
     smtlib2_hashtable *numbers_;
-    smtlib2_vector *defines_;
-    smtlib2_vector *defines_sorts_;
     smtlib2_hashtable *logics_arith_only_;
     smtlib2_hashtable *named_terms_;
     smtlib2_hashtable *term_names_;
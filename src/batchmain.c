@@ -0,0 +1,437 @@
+/* -*- C -*-
+ *
+ * Parallel parsing of a corpus of SMT-LIB v2 files
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "smtparser/smtlib2null.h"
+#include "smtparser/smtlib2reference.h"
+#include "smtparser/smtlib2scanner.h"
+#include "smtparser/smtlib2charbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+typedef struct batch_file {
+    char *path_;
+    size_t size_;
+    bool ok_;  /* false if the file could not be read */
+    size_t commands_;
+    size_t errors_;
+    double time_;
+} batch_file;
+
+
+/*
+ * A work-stealing deque of file indices. The files are dealt to the workers
+ * in decreasing size order: a worker takes the largest of its files from the
+ * front of its deque, and when it runs out it steals from the back of the
+ * other deques, where their smallest files are. No file is added once the
+ * workers are started. Parsing a file costs much more than taking the lock,
+ * so a mutex per deque is enough
+ */
+typedef struct batch_deque {
+    pthread_mutex_t lock_;
+    size_t *items_;
+    size_t head_;
+    size_t tail_;
+} batch_deque;
+
+typedef struct batch_worker {
+    pthread_t thread_;
+    int id_;
+    struct batch *batch_;
+    batch_deque deque_;
+    size_t done_;
+    size_t stolen_;
+    double busy_;
+} batch_worker;
+
+typedef struct batch {
+    batch_file *files_;
+    size_t num_files_;
+    batch_worker *workers_;
+    int num_workers_;
+    bool null_backend_;
+} batch;
+
+
+static double now(void)
+{
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+static bool has_suffix(const char *s, const char *suffix)
+{
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+
+/* adds "path" to "out", or all the .smt2 files below it if it is a
+ * directory */
+static void collect(const char *path, smtlib2_vector *out)
+{
+    struct stat st;
+    DIR *d;
+    struct dirent *e;
+
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        smtlib2_vector_push(out, (intptr_t)smtlib2_strdup(path));
+        return;
+    }
+    d = opendir(path);
+    if (!d) {
+        fprintf(stderr, "can't open directory `%s'\n", path);
+        return;
+    }
+    while ((e = readdir(d)) != NULL) {
+        char *sub;
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) {
+            continue;
+        }
+        sub = smtlib2_sprintf("%s/%s", path, e->d_name);
+        if (stat(sub, &st) == 0 &&
+            (S_ISDIR(st.st_mode) || has_suffix(sub, ".smt2"))) {
+            collect(sub, out);
+        }
+        smtlib2_free(sub);
+    }
+    closedir(d);
+}
+
+
+/* adds the paths listed in the given file, one per line */
+static bool collect_list(const char *listname, smtlib2_vector *out)
+{
+    FILE *in = strcmp(listname, "-") == 0 ? stdin : fopen(listname, "r");
+    smtlib2_charbuf *line;
+    int c;
+
+    if (!in) {
+        fprintf(stderr, "can't open `%s' for reading\n", listname);
+        return false;
+    }
+    line = smtlib2_charbuf_new();
+    do {
+        c = getc(in);
+        if (c == '\n' || c == EOF) {
+            if (SMTLIB2_VECTOR_SIZE(line) > 0) {
+                smtlib2_charbuf_push(line, '\0');
+                collect(smtlib2_charbuf_array(line), out);
+                smtlib2_charbuf_clear(line);
+            }
+        } else if (c != '\r') {
+            smtlib2_charbuf_push(line, (char)c);
+        }
+    } while (c != EOF);
+    smtlib2_charbuf_delete(line);
+    if (in != stdin) {
+        fclose(in);
+    }
+    return true;
+}
+
+
+static int by_decreasing_size(const void *a, const void *b)
+{
+    const batch_file *fa = *(const batch_file * const *)a;
+    const batch_file *fb = *(const batch_file * const *)b;
+    if (fa->size_ != fb->size_) {
+        return fa->size_ > fb->size_ ? -1 : 1;
+    }
+    return strcmp(fa->path_, fb->path_);
+}
+
+
+static bool take(batch_worker *w, size_t *out)
+{
+    batch *b = w->batch_;
+    batch_deque *q = &(w->deque_);
+    bool found = false;
+    int i;
+
+    pthread_mutex_lock(&(q->lock_));
+    if (q->head_ < q->tail_) {
+        *out = q->items_[q->head_++];
+        found = true;
+    }
+    pthread_mutex_unlock(&(q->lock_));
+
+    for (i = 1; !found && i < b->num_workers_; ++i) {
+        batch_deque *v = &(b->workers_[(w->id_ + i) % b->num_workers_].deque_);
+        pthread_mutex_lock(&(v->lock_));
+        if (v->head_ < v->tail_) {
+            *out = v->items_[--v->tail_];
+            found = true;
+            ++w->stolen_;
+        }
+        pthread_mutex_unlock(&(v->lock_));
+    }
+    return found;
+}
+
+
+static void run_file(batch *b, batch_file *f, FILE *devnull)
+{
+    size_t size;
+    const char *data = smtlib2_map_file(f->path_, &size);
+    smtlib2_abstract_parser *p;
+    double start = now();
+
+    if (!data) {
+        f->ok_ = false;
+        return;
+    }
+    if (b->null_backend_) {
+        p = &(smtlib2_null_parser_new()->parent_);
+    } else {
+        p = &(smtlib2_reference_parser_new()->parent_);
+    }
+    p->outstream_ = devnull;
+    p->errstream_ = devnull;
+    smtlib2_abstract_parser_parse_buffer(p, data, size);
+    f->commands_ = p->num_commands_;
+    f->errors_ = p->num_errors_;
+    if (b->null_backend_) {
+        smtlib2_null_parser_delete((smtlib2_null_parser *)p);
+    } else {
+        smtlib2_reference_parser_delete((smtlib2_reference_parser *)p);
+    }
+    smtlib2_unmap_file(data, size);
+    f->size_ = size;
+    f->ok_ = true;
+    f->time_ = now() - start;
+}
+
+
+static void *worker_main(void *arg)
+{
+    batch_worker *w = (batch_worker *)arg;
+    FILE *devnull = fopen("/dev/null", "w");
+    size_t idx;
+
+    while (take(w, &idx)) {
+        batch_file *f = &(w->batch_->files_[idx]);
+        run_file(w->batch_, f, devnull);
+        ++w->done_;
+        w->busy_ += f->time_;
+    }
+    /* the scanner pool is per thread */
+    smtlib2_scanner_pool_clear();
+    fclose(devnull);
+    return NULL;
+}
+
+
+static int default_workers(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) {
+        return (int)n;
+    }
+#endif
+    return 1;
+}
+
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "USAGE: %s [OPTIONS] INPUT ...\n"
+            "  -j N       number of worker threads (default: one per CPU)\n"
+            "  -b BACKEND `reference' (the default) or `null', which only "
+            "parses\n"
+            "  -l FILE    also parse the inputs listed in FILE, one per line "
+            "(`-' for\n"
+            "             standard input)\n"
+            "  -q         print only the totals\n"
+            "Directories are searched recursively for .smt2 files. For every "
+            "file, its\nsize, commands, errors and time are printed on "
+            "standard output, and the\ntotals on standard error\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+    smtlib2_vector *paths = smtlib2_vector_new();
+    batch b;
+    batch_file **order;
+    bool quiet = false;
+    size_t n, bytes = 0, commands = 0, errors = 0, unreadable = 0;
+    double start, wall, busy = 0;
+    int i, ret = 0;
+
+    b.num_workers_ = default_workers();
+    b.null_backend_ = false;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+        const char *opt = argv[i];
+        if (i+1 < argc && strcmp(opt, "-j") == 0) {
+            b.num_workers_ = atoi(argv[++i]);
+        } else if (i+1 < argc && strcmp(opt, "-b") == 0) {
+            const char *be = argv[++i];
+            if (strcmp(be, "null") == 0) {
+                b.null_backend_ = true;
+            } else if (strcmp(be, "reference") != 0) {
+                fprintf(stderr, "unknown backend `%s'\n", be);
+                return 1;
+            }
+        } else if (i+1 < argc && strcmp(opt, "-l") == 0) {
+            if (!collect_list(argv[++i], paths)) {
+                return 1;
+            }
+        } else if (strcmp(opt, "-q") == 0) {
+            quiet = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    for (; i < argc; ++i) {
+        collect(argv[i], paths);
+    }
+    if (smtlib2_vector_size(paths) == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (b.num_workers_ < 1) b.num_workers_ = 1;
+
+    /* the files are dealt in decreasing size order, so that the largest are
+     * parsed first and the smallest fill the gaps at the end */
+    b.num_files_ = smtlib2_vector_size(paths);
+    b.files_ = (batch_file *)smtlib2_malloc(sizeof(batch_file) * b.num_files_);
+    order = (batch_file **)smtlib2_malloc(sizeof(batch_file *) * b.num_files_);
+    for (n = 0; n < b.num_files_; ++n) {
+        struct stat st;
+        batch_file *f = &(b.files_[n]);
+        f->path_ = (char *)smtlib2_vector_at(paths, n);
+        f->size_ = stat(f->path_, &st) == 0 ? (size_t)st.st_size : 0;
+        f->ok_ = false;
+        f->commands_ = 0;
+        f->errors_ = 0;
+        f->time_ = 0;
+        order[n] = f;
+    }
+    qsort(order, b.num_files_, sizeof(batch_file *), by_decreasing_size);
+
+    b.workers_ = (batch_worker *)smtlib2_malloc(
+        sizeof(batch_worker) * b.num_workers_);
+    for (i = 0; i < b.num_workers_; ++i) {
+        batch_worker *w = &(b.workers_[i]);
+        w->id_ = i;
+        w->batch_ = &b;
+        w->done_ = 0;
+        w->stolen_ = 0;
+        w->busy_ = 0;
+        pthread_mutex_init(&(w->deque_.lock_), NULL);
+        w->deque_.items_ = (size_t *)smtlib2_malloc(
+            sizeof(size_t) * (b.num_files_ / b.num_workers_ + 1));
+        w->deque_.head_ = 0;
+        w->deque_.tail_ = 0;
+    }
+    for (n = 0; n < b.num_files_; ++n) {
+        batch_deque *q = &(b.workers_[n % b.num_workers_].deque_);
+        q->items_[q->tail_++] = (size_t)(order[n] - b.files_);
+    }
+
+    start = now();
+    for (i = 0; i < b.num_workers_; ++i) {
+        if (pthread_create(&(b.workers_[i].thread_), NULL, worker_main,
+                           &(b.workers_[i])) != 0) {
+            fprintf(stderr, "can't create the worker threads\n");
+            return 1;
+        }
+    }
+    for (i = 0; i < b.num_workers_; ++i) {
+        pthread_join(b.workers_[i].thread_, NULL);
+    }
+    wall = now() - start;
+
+    if (!quiet) {
+        printf("%-40s %12s %10s %8s %10s\n", "file", "bytes", "commands",
+               "errors", "time(s)");
+    }
+    for (n = 0; n < b.num_files_; ++n) {
+        batch_file *f = &(b.files_[n]);
+        if (!f->ok_) {
+            fprintf(stderr, "can't read `%s'\n", f->path_);
+            ++unreadable;
+            ret = 1;
+            continue;
+        }
+        if (!quiet) {
+            printf("%-40s %12lu %10lu %8lu %10.4f\n", f->path_,
+                   (unsigned long)f->size_, (unsigned long)f->commands_,
+                   (unsigned long)f->errors_, f->time_);
+        }
+        bytes += f->size_;
+        commands += f->commands_;
+        errors += f->errors_;
+    }
+    fflush(stdout);
+
+    for (i = 0; i < b.num_workers_; ++i) {
+        batch_worker *w = &(b.workers_[i]);
+        fprintf(stderr, ";; worker %-3d %8lu files (%lu stolen), busy "
+                "%.3f s\n", i, (unsigned long)w->done_,
+                (unsigned long)w->stolen_, w->busy_);
+        busy += w->busy_;
+        pthread_mutex_destroy(&(w->deque_.lock_));
+        smtlib2_free(w->deque_.items_);
+    }
+    fprintf(stderr, ";; %lu files (%lu unreadable), %lu bytes, %lu commands, "
+            "%lu errors\n", (unsigned long)b.num_files_,
+            (unsigned long)unreadable, (unsigned long)bytes,
+            (unsigned long)commands, (unsigned long)errors);
+    fprintf(stderr, ";; %d workers, %.3f s wall, %.3f s busy, %.2f MB/s\n",
+            b.num_workers_, wall, busy,
+            wall > 0 ? bytes / 1048576.0 / wall : 0.0);
+
+    for (n = 0; n < b.num_files_; ++n) {
+        smtlib2_free(b.files_[n].path_);
+    }
+    smtlib2_free(b.workers_);
+    smtlib2_free(order);
+    smtlib2_free(b.files_);
+    smtlib2_vector_delete(paths);
+    smtlib2_scanner_pool_clear();
+    return ret;
+}
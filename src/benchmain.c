@@ -0,0 +1,556 @@
+/* -*- C -*-
+ *
+ * Throughput benchmarks for the SMT-LIB v2 parser, on generated or given inputs
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "smtparser/smtlib2null.h"
+#include "smtparser/smtlib2reference.h"
+#include "smtparser/smtlib2scanner.h"
+#include "smtparser/smtlib2cmdindex.h"
+#include "smtparser/smtlib2charbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#  ifndef __linux__
+#  include <sys/resource.h>
+#  endif
+#endif
+
+
+/*
+ * Allocation counting. With glibc, the allocation functions can be replaced
+ * by wrappers of the glibc ones; this is disabled under the sanitizers, that
+ * replace them as well
+ */
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#  define SMTLIB2_BENCH_NO_MALLOC_HOOK
+#endif
+#if defined(__GLIBC__) && !defined(SMTLIB2_BENCH_NO_MALLOC_HOOK)
+#define SMTLIB2_BENCH_COUNT_ALLOCS
+
+extern void *__libc_malloc(size_t n);
+extern void *__libc_calloc(size_t n, size_t sz);
+extern void *__libc_realloc(void *p, size_t n);
+
+static size_t num_allocs = 0;
+
+void *malloc(size_t n)
+{
+    ++num_allocs;
+    return __libc_malloc(n);
+}
+
+void *calloc(size_t n, size_t sz)
+{
+    ++num_allocs;
+    return __libc_calloc(n, sz);
+}
+
+void *realloc(void *p, size_t n)
+{
+    ++num_allocs;
+    return __libc_realloc(p, n);
+}
+#endif /* SMTLIB2_BENCH_COUNT_ALLOCS */
+
+
+static double now(void)
+{
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+/* the peak RSS is per process, on Linux it can be reset between phases */
+static void reset_peak_rss(void)
+{
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f) {
+        fputs("5", f);
+        fclose(f);
+    }
+#endif
+}
+
+
+/* in KB, or -1 if not available */
+static long peak_rss(void)
+{
+#if defined(__linux__)
+    char line[256];
+    long ret = -1;
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            ret = atol(line + 6);
+            break;
+        }
+    }
+    fclose(f);
+    return ret;
+#elif !defined(_WIN32)
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#  ifdef __APPLE__
+    return ru.ru_maxrss / 1024;
+#  else
+    return ru.ru_maxrss;
+#  endif
+#else
+    return -1;
+#endif
+}
+
+
+/*
+ * Generator of synthetic inputs. Every shape stresses a different part of
+ * the lexer and parser; the output is fully determined by the scale
+ */
+
+static void emit(smtlib2_charbuf *out, const char *fmt, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    smtlib2_charbuf_push_str(out, buf);
+}
+
+
+/* a simple LCG, so that the generated data does not depend on the libc */
+static unsigned int gen_random(unsigned int *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return (*state >> 16) & 0x7fff;
+}
+
+
+static void gen_declarations(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, n = 20000 * scale;
+    for (i = 0; i < n; ++i) {
+        if (i % 4 == 3) {
+            emit(out, "(declare-fun f%u (Int Real (_ BitVec 32)) Bool)\n", i);
+        } else {
+            emit(out, "(declare-fun x%u () Int)\n", i);
+        }
+    }
+}
+
+
+static void gen_let_chains(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, j, n = 20 * scale, depth = 500;
+    emit(out, "(declare-fun x () Int)\n");
+    for (i = 0; i < n; ++i) {
+        emit(out, "(assert (let ((l0 x))");
+        for (j = 1; j < depth; ++j) {
+            emit(out, " (let ((l%u (+ l%u %u)))", j, j-1, i+j);
+        }
+        emit(out, " (> l%u 0)", depth-1);
+        for (j = 0; j < depth; ++j) {
+            smtlib2_charbuf_push(out, ')');
+        }
+        emit(out, ")\n");
+    }
+}
+
+
+static void gen_flat_and(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, j, n = 5 * scale, width = 20000;
+    for (i = 0; i < width; ++i) {
+        emit(out, "(declare-fun b%u () Bool)\n", i);
+    }
+    for (i = 0; i < n; ++i) {
+        emit(out, "(assert (and");
+        for (j = 0; j < width; ++j) {
+            emit(out, (j + i) % 3 ? " b%u" : " (not b%u)", j);
+        }
+        emit(out, "))\n");
+    }
+}
+
+
+static void gen_bv_constants(smtlib2_charbuf *out, unsigned int scale)
+{
+    static const char hex[] = "0123456789abcdef";
+    unsigned int i, j, n = 200 * scale, width = 4096;
+    unsigned int state = 1;
+    emit(out, "(declare-fun v () (_ BitVec %u))\n", width);
+    for (i = 0; i < n; ++i) {
+        emit(out, "(assert (= v #%c", i % 2 ? 'x' : 'b');
+        for (j = 0; j < (i % 2 ? width / 4 : width); ++j) {
+            unsigned int r = gen_random(&state);
+            smtlib2_charbuf_push(out, i % 2 ? hex[r & 15] : "01"[r & 1]);
+        }
+        emit(out, "))\n");
+    }
+}
+
+
+static void gen_push_pop(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, n = 10000 * scale;
+    emit(out, "(declare-fun q () Bool)\n");
+    for (i = 0; i < n; ++i) {
+        emit(out, "(push 1)\n(declare-fun p%u () Bool)\n"
+             "(assert (or p%u q))\n(check-sat)\n(pop 1)\n", i, i);
+    }
+}
+
+
+/* nested scopes with many entries, all popped at once */
+static void gen_deep_scopes(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, j, k, n = 10 * scale, depth = 100, width = 50;
+    emit(out, "(declare-fun q () Int)\n");
+    for (i = 0; i < n; ++i) {
+        for (j = 0; j < depth; ++j) {
+            emit(out, "(push 1)\n");
+            for (k = 0; k < width; ++k) {
+                emit(out, "(declare-fun x%u_%u () Int)\n"
+                     "(define-fun d%u_%u () Int (+ x%u_%u q))\n"
+                     "(assert (> d%u_%u 0))\n", j, k, j, k, j, k, j, k);
+            }
+        }
+        emit(out, "(check-sat)\n(pop %u)\n", depth);
+    }
+}
+
+
+static void gen_strings(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, j, n = 500 * scale, len = 8192;
+    unsigned int state = 2;
+    for (i = 0; i < n; ++i) {
+        emit(out, "(set-info :source \"");
+        for (j = 0; j < len; ++j) {
+            unsigned int r = gen_random(&state);
+            if (r % 97 == 0) {
+                smtlib2_charbuf_push_str(out, "\\\"");
+            } else if (r % 61 == 0) {
+                smtlib2_charbuf_push(out, '\n');
+            } else {
+                smtlib2_charbuf_push(out, 'a' + r % 26);
+            }
+        }
+        emit(out, "\")\n");
+    }
+}
+
+
+static void gen_get_value(smtlib2_charbuf *out, unsigned int scale)
+{
+    unsigned int i, j, n = 50 * scale, depth = 1000;
+    emit(out, "(declare-fun x () Int)\n(declare-fun g (Int Int) Int)\n"
+         "(check-sat)\n");
+    for (i = 0; i < n; ++i) {
+        emit(out, "(get-value (");
+        for (j = 0; j < depth; ++j) {
+            emit(out, "(g %u ", j);
+        }
+        emit(out, "x");
+        for (j = 0; j < depth; ++j) {
+            smtlib2_charbuf_push(out, ')');
+        }
+        emit(out, "))\n");
+    }
+}
+
+
+typedef void (*generator)(smtlib2_charbuf *out, unsigned int scale);
+
+static const struct {
+    const char *name;
+    generator gen;
+} shapes[] = {
+    { "declarations", gen_declarations },
+    { "let-chains", gen_let_chains },
+    { "flat-and", gen_flat_and },
+    { "bv-constants", gen_bv_constants },
+    { "push-pop", gen_push_pop },
+    { "deep-scopes", gen_deep_scopes },
+    { "strings", gen_strings },
+    { "get-value", gen_get_value },
+    { NULL, NULL }
+};
+
+
+static char *generate(int shape, unsigned int scale, size_t *size)
+{
+    smtlib2_charbuf *out = smtlib2_charbuf_new();
+    char *ret;
+    emit(out, "(set-option :print-success false)\n(set-logic ALL)\n");
+    shapes[shape].gen(out, scale);
+    *size = smtlib2_vector_size(out);
+    smtlib2_charbuf_push(out, '\0');
+    ret = smtlib2_charbuf_array_release(out);
+    smtlib2_charbuf_delete(out);
+    return ret;
+}
+
+
+/*
+ * The phases
+ */
+
+typedef enum {
+    PHASE_LEX, PHASE_NULL, PHASE_REFERENCE, PHASE_PERSISTENT, PHASE_ARENA
+} phase;
+
+static const char *phase_names[] = {
+    "lex-only", "null", "reference", "persistent", "arena"
+};
+
+static FILE *devnull = NULL;
+
+
+static void run_phase(phase ph, const char *data, size_t size)
+{
+    switch (ph) {
+    case PHASE_LEX: {
+        smtlib2_mstream *ms = smtlib2_mstream_new(data, size);
+        smtlib2_scanner *s = smtlib2_scanner_new((smtlib2_stream *)ms);
+        smtlib2_scanner_count_tokens(s);
+        smtlib2_scanner_delete(s);
+        smtlib2_mstream_delete(ms);
+    }
+        break;
+    case PHASE_NULL: {
+        smtlib2_null_parser *p = smtlib2_null_parser_new();
+        p->parent_.outstream_ = devnull;
+        smtlib2_abstract_parser_parse_buffer(&(p->parent_), data, size);
+        smtlib2_null_parser_delete(p);
+    }
+        break;
+    case PHASE_REFERENCE:
+    case PHASE_PERSISTENT: {
+        /* the scopes undone through the trail, or restored from the maps
+         * saved by push */
+        smtlib2_reference_parser *p = smtlib2_reference_parser_new();
+        p->parent_.outstream_ = devnull;
+        smtlib2_abstract_parser_set_persistent_scopes(
+            &(p->parent_), ph == PHASE_PERSISTENT);
+        smtlib2_abstract_parser_parse_buffer(&(p->parent_), data, size);
+        smtlib2_reference_parser_delete(p);
+    }
+        break;
+    case PHASE_ARENA: {
+        /* the reference backend with all its memory taken from an arena,
+         * which is dropped at the end instead of deleting the parser */
+        smtlib2_arena *a = smtlib2_arena_new(0);
+        smtlib2_reference_parser *p =
+            smtlib2_reference_parser_new_with_allocator(
+                smtlib2_arena_allocator(a));
+        p->parent_.outstream_ = devnull;
+        smtlib2_abstract_parser_parse_buffer(&(p->parent_), data, size);
+        smtlib2_arena_delete(a);
+    }
+        break;
+    }
+}
+
+
+static void bench(const char *name, const char *data, size_t size,
+                  int repeat)
+{
+    smtlib2_command_index *idx = smtlib2_command_index_new(data, size);
+    size_t ncmds = smtlib2_command_index_size(idx);
+    int ph, r;
+
+    smtlib2_command_index_delete(idx);
+
+    for (ph = PHASE_LEX; ph <= PHASE_ARENA; ++ph) {
+        double best = -1;
+        size_t allocs = 0;
+        long rss;
+
+        reset_peak_rss();
+        for (r = 0; r < repeat; ++r) {
+            double start, t;
+#ifdef SMTLIB2_BENCH_COUNT_ALLOCS
+            size_t a = num_allocs;
+#endif
+            start = now();
+            run_phase((phase)ph, data, size);
+            t = now() - start;
+#ifdef SMTLIB2_BENCH_COUNT_ALLOCS
+            allocs = num_allocs - a;
+#endif
+            if (best < 0 || t < best) {
+                best = t;
+            }
+        }
+        if (best <= 0) {
+            best = 1e-9;
+        }
+        rss = peak_rss();
+
+        printf("%-14s %-10s %9.2f %9.4f %9.2f %12.0f", name, phase_names[ph],
+               size / 1048576.0, best, size / 1048576.0 / best,
+               ncmds / best);
+#ifdef SMTLIB2_BENCH_COUNT_ALLOCS
+        printf(" %12lu", (unsigned long)allocs);
+#else
+        printf(" %12s", "n/a");
+#endif
+        if (rss >= 0) {
+            printf(" %12ld\n", rss);
+        } else {
+            printf(" %12s\n", "n/a");
+        }
+        fflush(stdout);
+    }
+}
+
+
+static int find_shape(const char *name)
+{
+    int i;
+    for (i = 0; shapes[i].name; ++i) {
+        if (strcmp(shapes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    fprintf(stderr, "unknown shape `%s' (use -l for a list)\n", name);
+    return -1;
+}
+
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "USAGE: %s [OPTIONS] [INPUT.smt2 ...]\n"
+            "  -s SCALE   size multiplier of the generated inputs "
+            "(default 1)\n"
+            "  -r REPEAT  runs of each phase, the fastest is reported "
+            "(default 3)\n"
+            "  -p SHAPE   benchmark only the given generated shape\n"
+            "  -g SHAPE   write the generated input of SHAPE to standard "
+            "output\n"
+            "  -l         list the shapes of the generated inputs\n"
+            "If input files are given, they are benchmarked instead of the "
+            "generated ones\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned int scale = 1;
+    int repeat = 3;
+    int only = -1;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+        const char *opt = argv[i];
+        if (strcmp(opt, "-l") == 0) {
+            int j;
+            for (j = 0; shapes[j].name; ++j) {
+                printf("%s\n", shapes[j].name);
+            }
+            return 0;
+        } else if (i+1 < argc && strcmp(opt, "-s") == 0) {
+            scale = (unsigned int)atoi(argv[++i]);
+        } else if (i+1 < argc && strcmp(opt, "-r") == 0) {
+            repeat = atoi(argv[++i]);
+        } else if (i+1 < argc && strcmp(opt, "-p") == 0) {
+            if ((only = find_shape(argv[++i])) < 0) {
+                return 1;
+            }
+        } else if (i+1 < argc && strcmp(opt, "-g") == 0) {
+            size_t size;
+            char *data;
+            int shape = find_shape(argv[++i]);
+            if (shape < 0) {
+                return 1;
+            }
+            data = generate(shape, scale ? scale : 1, &size);
+            fwrite(data, 1, size, stdout);
+            smtlib2_free(data);
+            return 0;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (scale < 1) scale = 1;
+    if (repeat < 1) repeat = 1;
+
+#ifdef _WIN32
+    devnull = fopen("NUL", "w");
+#else
+    devnull = fopen("/dev/null", "w");
+#endif
+    if (!devnull) {
+        fprintf(stderr, "can't open the null device\n");
+        return 1;
+    }
+
+    printf("%-14s %-10s %9s %9s %9s %12s %12s %12s\n", "input", "phase",
+           "MB", "time(s)", "MB/s", "commands/s", "allocs", "peak RSS(KB)");
+    if (i < argc) {
+        for (; i < argc; ++i) {
+            size_t size;
+            const char *data = smtlib2_map_file(argv[i], &size);
+            const char *name = strrchr(argv[i], '/');
+            if (!data) {
+                fprintf(stderr, "can't read `%s'\n", argv[i]);
+                continue;
+            }
+            bench(name ? name+1 : argv[i], data, size, repeat);
+            smtlib2_unmap_file(data, size);
+        }
+    } else {
+        int s;
+        for (s = 0; shapes[s].name; ++s) {
+            if (only < 0 || only == s) {
+                size_t size;
+                char *data = generate(s, scale, &size);
+                bench(shapes[s].name, data, size, repeat);
+                smtlib2_free(data);
+            }
+        }
+    }
+
+    fclose(devnull);
+    smtlib2_scanner_pool_clear();
+    return 0;
+}
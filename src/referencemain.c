@@ -0,0 +1,44 @@
+/* -*- C -*-
+ *
+ * Runs SMT-LIB v2 scripts through the reference backend of smtlib2reference.h
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "smtparser/smtlib2reference.h"
+#include "smtparser/smtlib2driver.h"
+
+
+static smtlib2_abstract_parser *new_reference(void)
+{
+    return (smtlib2_abstract_parser *)smtlib2_reference_parser_new();
+}
+
+
+static void delete_reference(smtlib2_abstract_parser *p)
+{
+    smtlib2_reference_parser_delete((smtlib2_reference_parser *)p);
+}
+
+
+int main(int argc, char **argv)
+{
+    return smtlib2_driver_main(argc, argv, new_reference, delete_reference);
+}
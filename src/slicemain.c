@@ -0,0 +1,122 @@
+/* -*- C -*-
+ *
+ * Cone-of-influence slicing of the queries of an SMT-LIB v2 script
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2slicer.h"
+#include "smtparser/smtlib2scanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "USAGE: %s [OPTIONS] INPUT.smt2\n"
+            "  -g         the last assert of each query is its goal: drop "
+            "also the\n"
+            "             asserts unrelated to it\n"
+            "  -j N       number of writer threads (default: 4)\n"
+            "  -o PREFIX  write the n-th query to PREFIXnnnn.smt2 (default: "
+            "print all\n"
+            "             the queries on the standard output)\n"
+            "Writes a standalone script for every check-sat of the input, "
+            "without the\ndeclarations and definitions (and, with -g, the "
+            "asserts) outside the cone\nof influence of its assertions\n",
+            prog);
+}
+
+
+int main(int argc, char **argv)
+{
+    int nthreads = 4;
+    bool goal = false;
+    const char *input, *prefix = NULL;
+    smtlib2_command_index *idx;
+    smtlib2_slicer *sl;
+    smtlib2_abstract_parser *ap;
+    size_t j, n, failed = 0;
+    bool errors;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+        if (strcmp(argv[i], "-g") == 0) {
+            goal = true;
+        } else if (i+1 < argc && strcmp(argv[i], "-j") == 0) {
+            nthreads = atoi(argv[++i]);
+        } else if (i+1 < argc && strcmp(argv[i], "-o") == 0) {
+            prefix = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i + 1 != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    input = argv[i];
+
+    idx = smtlib2_command_index_new_from_file(input);
+    if (!idx) {
+        fprintf(stderr, "can't open `%s' for reading\n", input);
+        return 1;
+    }
+
+    sl = smtlib2_slicer_new();
+    ap = &(sl->parent_.parent_.parent_);
+    /* the responses of the parser, errors included, must not mix with the
+     * queries printed on stdout */
+    ap->outstream_ = stderr;
+    ap->errstream_ = stderr;
+    smtlib2_slicer_set_goal(sl, goal);
+    smtlib2_slicer_parse(sl, idx);
+    errors = ap->num_errors_ > 0 || ap->response_ == SMTLIB2_RESPONSE_ERROR;
+    n = smtlib2_splitter_num_queries(&(sl->parent_));
+    if (prefix) {
+        failed = smtlib2_splitter_write(&(sl->parent_), prefix, nthreads);
+    } else {
+        for (j = 0; j < n; ++j) {
+            if (!smtlib2_splitter_print_query(&(sl->parent_), j, stdout)) {
+                ++failed;
+            }
+        }
+    }
+    fprintf(stderr, ";; %lu queries, dropped %lu declarations and "
+            "definitions and %lu asserts", (unsigned long)n,
+            (unsigned long)smtlib2_slicer_num_dropped_declarations(sl),
+            (unsigned long)smtlib2_slicer_num_dropped_asserts(sl));
+    if (failed) {
+        fprintf(stderr, ", %lu could not be written", (unsigned long)failed);
+    }
+    if (errors) {
+        fprintf(stderr, ", errors while parsing the input");
+    }
+    fprintf(stderr, "\n");
+
+    smtlib2_slicer_delete(sl);
+    smtlib2_command_index_delete(idx);
+    smtlib2_scanner_pool_clear();
+    return (failed || errors) ? 1 : 0;
+}
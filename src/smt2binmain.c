@@ -0,0 +1,90 @@
+/* -*- C -*-
+ *
+ * Converts SMT-LIB v2 scripts to the binary format of smtlib2binary.h
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2binary.h"
+#include <stdio.h>
+#include <string.h>
+
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    FILE *out = stdout;
+    smtlib2_binary_writer *w;
+    smtlib2_abstract_parser *ap;
+    int ret = 0;
+
+    if (argc > 3 || (argc > 1 && (strcmp(argv[1], "-h") == 0 ||
+                                  strcmp(argv[1], "--help") == 0))) {
+        fprintf(stderr, "USAGE: %s [INPUT.smt2 [OUTPUT]]\n"
+                "(use `-' for standard input/output)\n", argv[0]);
+        return 1;
+    }
+    if (argc > 1 && strcmp(argv[1], "-") != 0) {
+        in = fopen(argv[1], "r");
+        if (!in) {
+            fprintf(stderr, "can't open `%s' for reading\n", argv[1]);
+            return 1;
+        }
+    }
+    if (argc > 2 && strcmp(argv[2], "-") != 0) {
+        out = fopen(argv[2], "wb");
+        if (!out) {
+            fprintf(stderr, "can't open `%s' for writing\n", argv[2]);
+            if (in != stdin) fclose(in);
+            return 1;
+        }
+    }
+
+    w = smtlib2_binary_writer_new(out);
+    ap = (smtlib2_abstract_parser *)w;
+    /* errors are reported on stderr, the output is for the binary data */
+    ap->outstream_ = stderr;
+    smtlib2_abstract_parser_parse(ap, in);
+    if (ap->num_errors_ > 0 || ap->response_ == SMTLIB2_RESPONSE_ERROR) {
+        /* the failed commands are missing from the output, which is then
+         * not a faithful copy of the input: drop what is still pending (an
+         * output file is removed below) */
+        fprintf(stderr, "errors while parsing the input\n");
+        smtlib2_charbuf_resize(w->buf_, 0);
+        ret = 1;
+    } else if (!smtlib2_binary_writer_flush(w)) {
+        fprintf(stderr, "error writing the output\n");
+        ret = 1;
+    }
+    smtlib2_binary_writer_delete(w);
+
+    if (in != stdin) fclose(in);
+    if (out != stdout) {
+        if (fclose(out) != 0) {
+            ret = 1;
+        }
+        if (ret != 0) {
+            remove(argv[2]);
+        }
+    }
+
+    return ret;
+}
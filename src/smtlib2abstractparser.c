@@ -27,11 +27,16 @@
 
 #include "smtparser/smtlib2abstractparser.h"
 #include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2forkjoin.h"
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 
 
+static void smtlib2_abstract_parser_drop_roots(smtlib2_abstract_parser *p,
+                                               size_t block);
+
+
 smtlib2_parser_interface * SMTLIB2_PARSER_INTERFACE(smtlib2_abstract_parser *p) {
     return &(p->parent_);
 }
@@ -40,21 +45,46 @@ void smtlib2_abstract_parser_init(smtlib2_abstract_parser *p,
                                   smtlib2_context ctx)
 {
     smtlib2_parser_interface *pi;
+    smtlib2_memory_tag tag;
     
+    p->allocator_ = smtlib2_get_allocator();
     p->termparser_ = smtlib2_term_parser_new(ctx);
     p->outstream_ = stdout;
     p->errstream_ = stderr;
     p->response_ = SMTLIB2_RESPONSE_SUCCESS;
     p->print_success_ = true;
     p->errmsg_ = NULL;
+    tag = smtlib2_set_memory_tag(SMTLIB2_MEM_RESPONSE);
     p->response_data_ = smtlib2_vector_new();
+    smtlib2_vector_reserve(p->response_data_, 16);
+    p->info_ = smtlib2_hashtable_new(smtlib2_hashfun_str, smtlib2_eqfun_str);
+    smtlib2_set_memory_tag(tag);
     p->status_ = SMTLIB2_STATUS_UNKNOWN;
     p->set_logic_ok_ = true;
     p->exiting_ = false;
-    p->info_ = smtlib2_hashtable_new(smtlib2_hashfun_str, smtlib2_eqfun_str);
     p->internal_parsed_terms_ = smtlib2_vector_new();
-    p->internal_parsed_terms_enabled_ = false;
+    p->term_buf_ = NULL;
+    p->term_stream_ = NULL;
+    p->term_scanner_ = NULL;
+    p->lazy_asserts_ = false;
+    p->fork_join_threads_ = 0;
+    p->pipelined_ = false;
     p->scanner_ = NULL;
+    p->num_commands_ = 0;
+    p->num_errors_ = 0;
+    p->stats_ = NULL;
+    p->stats_enabled_ = false;
+    p->tracer_ = NULL;
+    p->recorder_ = NULL;
+    p->memo_ = NULL;
+    p->snapshot_backend_ = NULL;
+    p->undo_trail_ = smtlib2_vector_new();
+    p->undo_levels_ = smtlib2_vector_new();
+    p->persistent_scopes_ = false;
+    p->scoped_maps_ = smtlib2_vector_new();
+    p->scope_roots_ = smtlib2_vector_new();
+    smtlib2_vector_push(p->scoped_maps_,
+                        (intptr_t)&(p->termparser_->bindings_));
 
     /* set the default interface */
     pi = SMTLIB2_PARSER_INTERFACE(p);
@@ -68,7 +98,10 @@ void smtlib2_abstract_parser_init(smtlib2_abstract_parser *p,
     pi->define_function = smtlib2_abstract_parser_define_function;
     pi->push = smtlib2_abstract_parser_push;
     pi->pop = smtlib2_abstract_parser_pop;
+    pi->reset_assertions = smtlib2_abstract_parser_reset_assertions;
+    pi->reset = smtlib2_abstract_parser_reset;
     pi->assert_formula = smtlib2_abstract_parser_assert_formula;
+    pi->assert_lazy_formula = smtlib2_abstract_parser_assert_lazy_formula;
     pi->check_sat = smtlib2_abstract_parser_check_sat;
     pi->get_unsat_core = smtlib2_abstract_parser_get_unsat_core;
     pi->get_proof = smtlib2_abstract_parser_get_proof;
@@ -99,36 +132,121 @@ void smtlib2_abstract_parser_init(smtlib2_abstract_parser *p,
 
 void smtlib2_abstract_parser_deinit(smtlib2_abstract_parser *p)
 {
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+
+    if (p->stats_) {
+        smtlib2_parser_stats_delete(p->stats_, p);
+        p->stats_ = NULL;
+    }
+    if (p->tracer_) {
+        smtlib2_tracer_delete(p->tracer_);
+    }
+    if (p->recorder_) {
+        smtlib2_recorder_delete(p->recorder_, p);
+        p->recorder_ = NULL;
+    }
+    if (p->memo_) {
+        smtlib2_memo_delete(p->memo_, p);
+        p->memo_ = NULL;
+    }
     smtlib2_vector_delete(p->internal_parsed_terms_);
-    smtlib2_hashtable_delete(p->info_,
-                             (smtlib2_freefun)free, (smtlib2_freefun)free);
+    smtlib2_vector_delete(p->undo_levels_);
+    smtlib2_vector_delete(p->undo_trail_);
+    smtlib2_abstract_parser_drop_roots(p, 0);
+    smtlib2_vector_delete(p->scope_roots_);
+    smtlib2_vector_delete(p->scoped_maps_);
+    if (p->scanner_) {
+        smtlib2_scanner_delete(p->scanner_);
+    }
+    if (p->term_scanner_) {
+        smtlib2_scanner_delete(p->term_scanner_);
+        smtlib2_sstream_delete(p->term_stream_);
+        smtlib2_charbuf_delete(p->term_buf_);
+    }
+    smtlib2_hashtable_delete(p->info_, (smtlib2_freefun)smtlib2_free,
+                             (smtlib2_freefun)smtlib2_free);
     smtlib2_vector_delete(p->response_data_);
     smtlib2_term_parser_delete(p->termparser_);
+
+    smtlib2_set_allocator(prev);
 }
 
 
-void smtlib2_abstract_parser_parse(smtlib2_abstract_parser *p, FILE *src)
+/* runs all the commands read from the given stream, with the allocator of
+ * the parser. The scanner owned by the parser is reused across calls; nested
+ * calls (e.g. from a callback) get one from the scanner pool instead */
+static void smtlib2_abstract_parser_run(smtlib2_abstract_parser *p,
+                                        smtlib2_stream *stream)
 {
-    smtlib2_fstream *stream;
-    smtlib2_scanner *scanner;
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+    smtlib2_scanner *scanner = p->scanner_;
 
-    stream = smtlib2_fstream_new(src);
-    scanner = smtlib2_scanner_new((smtlib2_stream *)stream);
+    if (scanner) {
+        p->scanner_ = NULL;
+        smtlib2_scanner_reset(scanner, stream);
+    } else {
+        scanner = smtlib2_scanner_acquire(stream);
+    }
+    smtlib2_scanner_set_lazy_asserts(scanner, p->lazy_asserts_);
+    if (p->pipelined_) {
+        smtlib2_scanner_start_pipeline(scanner);
+    }
 
     smtlib2_abstract_parser_reset_response(p);
 
-    while (!smtlib2_stream_eof((smtlib2_stream *)stream)) {
-        smtlib2_parse(scanner, SMTLIB2_PARSER_INTERFACE(p));
-        if (p->exiting_) {
-            break;
+    while (!smtlib2_scanner_at_end(scanner)) {
+        smtlib2_tracer *tracer = p->tracer_;
+        smtlib2_command_info info, *outer = NULL;
+
+        if (tracer) {
+            smtlib2_scanner_track_command(scanner, &info);
+            outer = smtlib2_tracer_begin_command(tracer, &info);
         }
-        if (!smtlib2_stream_eof((smtlib2_stream *)stream)) {
+        smtlib2_parse(scanner, SMTLIB2_PARSER_INTERFACE(p));
+        if (!p->exiting_ && !smtlib2_scanner_at_end(scanner)) {
+            ++p->num_commands_;
+            if (p->response_ == SMTLIB2_RESPONSE_ERROR) {
+                ++p->num_errors_;
+            }
+            if (tracer) {
+                smtlib2_tracer_begin(tracer, "response", "output",
+                                     smtlib2_ticks_now());
+            }
             smtlib2_abstract_parser_print_response(p);
             smtlib2_abstract_parser_reset_response(p);
+            if (tracer) {
+                smtlib2_tracer_end(tracer, smtlib2_ticks_now());
+            }
+            if (p->recorder_) {
+                smtlib2_recorder_end_command(p->recorder_);
+            }
+        }
+        if (tracer) {
+            smtlib2_scanner_track_command(scanner, NULL);
+            smtlib2_tracer_end_command(tracer, outer);
+        }
+        if (p->exiting_) {
+            break;
         }
     }
+    smtlib2_scanner_stop_pipeline(scanner);
 
-    smtlib2_scanner_delete(scanner);
+    if (!p->scanner_) {
+        p->scanner_ = scanner;
+    } else {
+        smtlib2_scanner_release(scanner);
+    }
+
+    smtlib2_set_allocator(prev);
+}
+
+
+void smtlib2_abstract_parser_parse(smtlib2_abstract_parser *p, FILE *src)
+{
+    smtlib2_fstream *stream;
+
+    stream = smtlib2_fstream_new(src);
+    smtlib2_abstract_parser_run(p, (smtlib2_stream *)stream);
     smtlib2_fstream_delete(stream);
 }
 
@@ -137,29 +255,363 @@ void smtlib2_abstract_parser_parse_string(smtlib2_abstract_parser *p, const char
 {
     smtlib2_charbuf *buf;
     smtlib2_sstream *stream;
-    smtlib2_scanner *scanner;
 
     buf = smtlib2_charbuf_new();
     smtlib2_charbuf_push_str(buf, str);
     stream = smtlib2_sstream_new(buf);
-    scanner = smtlib2_scanner_new((smtlib2_stream *)stream);
+    smtlib2_abstract_parser_run(p, (smtlib2_stream *)stream);
+    smtlib2_sstream_delete(stream);
+    smtlib2_charbuf_delete(buf);
+}
 
-    smtlib2_abstract_parser_reset_response(p);
 
-    while (!smtlib2_stream_eof((smtlib2_stream *)stream)) {
-        smtlib2_parse(scanner, SMTLIB2_PARSER_INTERFACE(p));
-        if (p->exiting_) {
-            break;
+void smtlib2_abstract_parser_parse_buffer(smtlib2_abstract_parser *p,
+                                          const char *data, size_t size)
+{
+    smtlib2_mstream *stream;
+
+    stream = smtlib2_mstream_new(data, size);
+    smtlib2_abstract_parser_run(p, (smtlib2_stream *)stream);
+    smtlib2_mstream_delete(stream);
+}
+
+
+void smtlib2_abstract_parser_set_lazy_asserts(smtlib2_abstract_parser *p,
+                                              bool yes)
+{
+    p->lazy_asserts_ = yes;
+}
+
+
+void smtlib2_abstract_parser_set_pipelined(smtlib2_abstract_parser *p,
+                                           bool yes)
+{
+    p->pipelined_ = yes;
+}
+
+
+void smtlib2_abstract_parser_set_fork_join(smtlib2_abstract_parser *p,
+                                           int nthreads)
+{
+    p->fork_join_threads_ = nthreads;
+}
+
+
+void smtlib2_abstract_parser_record_undo(smtlib2_abstract_parser *p,
+                                         smtlib2_undo_action action,
+                                         intptr_t data)
+{
+    smtlib2_vector_push(p->undo_trail_, (intptr_t)action);
+    smtlib2_vector_push(p->undo_trail_, data);
+}
+
+
+void smtlib2_abstract_parser_record_map_undo(smtlib2_abstract_parser *p,
+                                             smtlib2_undo_action action,
+                                             intptr_t data)
+{
+    if (!p->persistent_scopes_) {
+        smtlib2_abstract_parser_record_undo(p, action, data);
+    }
+}
+
+
+void smtlib2_abstract_parser_add_scoped_map(smtlib2_abstract_parser *p,
+                                            smtlib2_pmap *m)
+{
+    smtlib2_vector_push(p->scoped_maps_, (intptr_t)m);
+}
+
+
+/*
+ * With persistent scopes, scope_roots_ holds a block of copies of the
+ * scoped maps (in the order of scoped_maps_) for the state when the scopes
+ * were enabled, followed by one block for the state at the push of every
+ * open level: with n levels, the blocks are numbered from 0 to n
+ */
+static void smtlib2_abstract_parser_save_roots(smtlib2_abstract_parser *p)
+{
+    size_t i;
+    for (i = 0; i < smtlib2_vector_size(p->scoped_maps_); ++i) {
+        smtlib2_pmap *m = (smtlib2_pmap *)smtlib2_vector_at(p->scoped_maps_, i);
+        smtlib2_pmap *c = (smtlib2_pmap *)smtlib2_malloc(sizeof(smtlib2_pmap));
+        smtlib2_pmap_init(c, m->hf_, m->eqf_, m->fk_, m->fv_);
+        smtlib2_pmap_assign(c, m);
+        smtlib2_vector_push(p->scope_roots_, (intptr_t)c);
+    }
+}
+
+
+/* releases the blocks of copies from the given one on */
+static void smtlib2_abstract_parser_drop_roots(smtlib2_abstract_parser *p,
+                                               size_t block)
+{
+    size_t start = block * smtlib2_vector_size(p->scoped_maps_);
+    while (smtlib2_vector_size(p->scope_roots_) > start) {
+        smtlib2_pmap *c = (smtlib2_pmap *)smtlib2_vector_last(p->scope_roots_);
+        smtlib2_pmap_deinit(c);
+        smtlib2_free(c);
+        smtlib2_vector_pop(p->scope_roots_);
+    }
+}
+
+
+/* restores the scoped maps from the given block of copies, and releases the
+ * blocks after it */
+static void smtlib2_abstract_parser_restore_roots(smtlib2_abstract_parser *p,
+                                                  size_t block)
+{
+    size_t i, n = smtlib2_vector_size(p->scoped_maps_);
+    for (i = 0; i < n; ++i) {
+        smtlib2_pmap_assign(
+            (smtlib2_pmap *)smtlib2_vector_at(p->scoped_maps_, i),
+            (smtlib2_pmap *)smtlib2_vector_at(p->scope_roots_, block * n + i));
+    }
+    smtlib2_abstract_parser_drop_roots(p, block + 1);
+}
+
+
+void smtlib2_abstract_parser_set_persistent_scopes(smtlib2_abstract_parser *p,
+                                                   bool yes)
+{
+    if (smtlib2_vector_size(p->undo_levels_) == 0 &&
+        yes != p->persistent_scopes_) {
+        smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+        /* the changes recorded so far stay in the trail, and are undone by
+         * reset-assertions after restoring the maps */
+        if (yes) {
+            smtlib2_abstract_parser_save_roots(p);
+        } else {
+            smtlib2_abstract_parser_drop_roots(p, 0);
         }
-        if (!smtlib2_stream_eof((smtlib2_stream *)stream)) {
-            smtlib2_abstract_parser_print_response(p);
-            smtlib2_abstract_parser_reset_response(p);
+        p->persistent_scopes_ = yes;
+        smtlib2_set_allocator(prev);
+    }
+}
+
+
+size_t smtlib2_abstract_parser_num_levels(smtlib2_abstract_parser *p)
+{
+    return smtlib2_vector_size(p->undo_levels_);
+}
+
+
+size_t smtlib2_abstract_parser_trail_size(smtlib2_abstract_parser *p)
+{
+    return smtlib2_vector_size(p->undo_trail_);
+}
+
+
+void smtlib2_abstract_parser_undo_to(smtlib2_abstract_parser *p, size_t size)
+{
+    while (smtlib2_vector_size(p->undo_trail_) > size) {
+        intptr_t data = smtlib2_vector_last(p->undo_trail_);
+        smtlib2_undo_action action;
+        smtlib2_vector_pop(p->undo_trail_);
+        action = (smtlib2_undo_action)smtlib2_vector_last(p->undo_trail_);
+        smtlib2_vector_pop(p->undo_trail_);
+        action(p, data);
+    }
+}
+
+
+/* undoes the binding of a define-fun. The symbol is the key of the binding,
+ * which may be released by undefine_binding */
+static void smtlib2_abstract_parser_undo_define(smtlib2_abstract_parser *p,
+                                                intptr_t symbol)
+{
+    smtlib2_term_parser_undefine_binding(p->termparser_, (const char *)symbol);
+}
+
+
+smtlib2_term smtlib2_abstract_parser_force_term(smtlib2_abstract_parser *p,
+                                                smtlib2_lazy_term *t)
+{
+    smtlib2_vector *terms;
+    smtlib2_vector *out;
+    smtlib2_term ret = NULL;
+
+    if (smtlib2_fork_join_force_term(p, t, p->fork_join_threads_, &ret)) {
+        return ret;
+    }
+
+    terms = smtlib2_vector_new();
+    out = smtlib2_vector_new();
+    smtlib2_vector_push(terms, (intptr_t)t);
+    if (smtlib2_abstract_parser_force_terms(p, terms, out)) {
+        ret = (smtlib2_term)smtlib2_vector_at(out, 0);
+    }
+    smtlib2_vector_delete(out);
+    smtlib2_vector_delete(terms);
+
+    return ret;
+}
+
+
+bool smtlib2_abstract_parser_force_terms(smtlib2_abstract_parser *p,
+                                         smtlib2_vector *terms,
+                                         smtlib2_vector *out)
+{
+    size_t i, n = smtlib2_vector_size(terms);
+    const char **texts =
+        (const char **)smtlib2_malloc(sizeof(const char *) * n);
+    smtlib2_term *res =
+        (smtlib2_term *)smtlib2_malloc(sizeof(smtlib2_term) * n);
+    bool ret;
+
+    for (i = 0; i < n; ++i) {
+        texts[i] = ((smtlib2_lazy_term *)smtlib2_vector_at(terms, i))->text_;
+    }
+    ret = smtlib2_abstract_parser_parse_terms(p, texts, n, res);
+    if (ret) {
+        for (i = 0; i < n; ++i) {
+            smtlib2_vector_push(out, (intptr_t)res[i]);
         }
     }
+    smtlib2_free(res);
+    smtlib2_free(texts);
 
-    smtlib2_scanner_delete(scanner);
-    smtlib2_sstream_delete(stream);
-    smtlib2_charbuf_delete(buf);
+    return ret;
+}
+
+
+bool smtlib2_abstract_parser_parse_terms(smtlib2_abstract_parser *p,
+                                         const char **texts, size_t n,
+                                         smtlib2_term *out)
+{
+    size_t i;
+    bool ret = false;
+    smtlib2_allocator *prev;
+
+    if (n == 0) {
+        return true;
+    }
+
+    prev = smtlib2_set_allocator(p->allocator_);
+    if (!p->term_scanner_) {
+        p->term_buf_ = smtlib2_charbuf_new();
+        p->term_stream_ = smtlib2_sstream_new(p->term_buf_);
+        p->term_scanner_ =
+            smtlib2_scanner_new((smtlib2_stream *)p->term_stream_);
+    }
+
+    smtlib2_charbuf_resize(p->term_buf_, 0);
+    for (i = 0; i < n; ++i) {
+        smtlib2_charbuf_push_str(p->term_buf_, texts[i]);
+        smtlib2_charbuf_push(p->term_buf_, ' ');
+    }
+    p->term_stream_->nextidx_ = 0;
+
+    smtlib2_vector_resize(p->internal_parsed_terms_, 0);
+    smtlib2_parse_terms(p->term_scanner_, SMTLIB2_PARSER_INTERFACE(p));
+
+    if (p->response_ != SMTLIB2_RESPONSE_ERROR) {
+        if (smtlib2_vector_size(p->internal_parsed_terms_) == n) {
+            for (i = 0; i < n; ++i) {
+                out[i] = (smtlib2_term)smtlib2_vector_at(
+                    p->internal_parsed_terms_, i);
+            }
+            ret = true;
+        } else {
+            p->response_ = SMTLIB2_RESPONSE_ERROR;
+            p->errmsg_ = smtlib2_strdup("invalid term");
+        }
+    }
+
+    smtlib2_set_allocator(prev);
+    return ret;
+}
+
+
+/* the callbacks are wrapped as long as either statistics or tracing are
+ * enabled */
+static void smtlib2_abstract_parser_update_wrappers(smtlib2_abstract_parser *p)
+{
+    bool needed = p->stats_enabled_ || p->tracer_;
+    if (needed && !p->stats_) {
+        p->stats_ = smtlib2_parser_stats_new(p);
+    } else if (!needed && p->stats_) {
+        smtlib2_parser_stats_delete(p->stats_, p);
+        p->stats_ = NULL;
+    }
+}
+
+
+void smtlib2_abstract_parser_enable_stats(smtlib2_abstract_parser *p,
+                                          bool yes)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+    if (yes && !p->stats_enabled_ && p->stats_) {
+        /* drop what was recorded while only tracing */
+        smtlib2_parser_stats_reset(p->stats_);
+    }
+    p->stats_enabled_ = yes;
+    smtlib2_abstract_parser_update_wrappers(p);
+    smtlib2_set_allocator(prev);
+}
+
+
+smtlib2_parser_stats *smtlib2_abstract_parser_get_stats(
+    smtlib2_abstract_parser *p)
+{
+    return p->stats_enabled_ ? p->stats_ : NULL;
+}
+
+
+bool smtlib2_abstract_parser_memory_report(smtlib2_abstract_parser *p,
+                                           smtlib2_memory_report *out)
+{
+    smtlib2_memory_accounting *a = smtlib2_memory_accounting_of(p->allocator_);
+    if (!a) {
+        return false;
+    }
+    smtlib2_memory_accounting_report(a, out);
+    return true;
+}
+
+
+void smtlib2_abstract_parser_set_trace(smtlib2_abstract_parser *p, FILE *out)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+    if (p->tracer_) {
+        smtlib2_tracer_delete(p->tracer_);
+        p->tracer_ = NULL;
+    }
+    if (out) {
+        p->tracer_ = smtlib2_tracer_new(out);
+    }
+    smtlib2_abstract_parser_update_wrappers(p);
+    smtlib2_set_allocator(prev);
+}
+
+
+void smtlib2_abstract_parser_set_recording(smtlib2_abstract_parser *p,
+                                           FILE *out)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+    if (p->recorder_) {
+        smtlib2_recorder_delete(p->recorder_, p);
+        p->recorder_ = NULL;
+    }
+    if (out) {
+        p->recorder_ = smtlib2_recorder_new(p, out);
+    }
+    smtlib2_set_allocator(prev);
+}
+
+
+void smtlib2_abstract_parser_set_memo(smtlib2_abstract_parser *p,
+                                      smtlib2_memo_cache *c)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+    if (p->memo_) {
+        smtlib2_memo_delete(p->memo_, p);
+        p->memo_ = NULL;
+    }
+    if (c) {
+        p->memo_ = smtlib2_memo_new(p, c);
+    }
+    smtlib2_set_allocator(prev);
 }
 
 
@@ -237,12 +689,19 @@ void smtlib2_abstract_parser_define_function(smtlib2_parser_interface *p,
 {
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
     if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
-        smtlib2_term_parser_define_binding(pp->termparser_, name, params, term);
-        if (smtlib2_term_parser_error(pp->termparser_)) {
+        smtlib2_term_parser *tp = pp->termparser_;
+        intptr_t k;
+        smtlib2_term_parser_define_binding(tp, name, params, term);
+        if (smtlib2_term_parser_error(tp)) {
             pp->response_ = SMTLIB2_RESPONSE_ERROR;
             pp->errmsg_ = smtlib2_strdup(
-                smtlib2_term_parser_get_error_msg(pp->termparser_));
+                smtlib2_term_parser_get_error_msg(tp));
         } else {
+            if (!pp->persistent_scopes_ &&
+                smtlib2_pmap_find_key(&(tp->bindings_), (intptr_t)name, &k)) {
+                smtlib2_abstract_parser_record_undo(
+                    pp, smtlib2_abstract_parser_undo_define, k);
+            }
             pp->response_ = SMTLIB2_RESPONSE_SUCCESS;
         }
     }
@@ -252,16 +711,69 @@ void smtlib2_abstract_parser_define_function(smtlib2_parser_interface *p,
 void smtlib2_abstract_parser_push(smtlib2_parser_interface *p, int n)
 {
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
-    pp->response_ = SMTLIB2_RESPONSE_ERROR;
-    pp->errmsg_ = smtlib2_strdup("unimplemented");
+    if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
+        while (n-- > 0) {
+            smtlib2_vector_push(pp->undo_levels_,
+                                (intptr_t)smtlib2_vector_size(pp->undo_trail_));
+            if (pp->persistent_scopes_) {
+                smtlib2_abstract_parser_save_roots(pp);
+            }
+        }
+        pp->response_ = SMTLIB2_RESPONSE_SUCCESS;
+    }
 }
 
 
 void smtlib2_abstract_parser_pop(smtlib2_parser_interface *p, int n)
 {
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
-    pp->response_ = SMTLIB2_RESPONSE_ERROR;
-    pp->errmsg_ = smtlib2_strdup("unimplemented");
+    size_t levels = smtlib2_vector_size(pp->undo_levels_);
+
+    if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
+        if (n < 0 || (size_t)n > levels) {
+            pp->response_ = SMTLIB2_RESPONSE_ERROR;
+            pp->errmsg_ = smtlib2_sprintf("can't pop %d levels", n);
+        } else {
+            if (n > 0) {
+                size_t mark =
+                    (size_t)smtlib2_vector_at(pp->undo_levels_, levels - n);
+                smtlib2_vector_resize(pp->undo_levels_, levels - n);
+                smtlib2_abstract_parser_undo_to(pp, mark);
+                if (pp->persistent_scopes_) {
+                    /* the block of the outermost popped level goes too, the
+                     * next push saves a new one */
+                    smtlib2_abstract_parser_restore_roots(pp, levels - n + 1);
+                    smtlib2_abstract_parser_drop_roots(pp, levels - n + 1);
+                }
+            }
+            pp->response_ = SMTLIB2_RESPONSE_SUCCESS;
+        }
+    }
+}
+
+
+void smtlib2_abstract_parser_reset_assertions(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
+    if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
+        smtlib2_vector_clear(pp->undo_levels_);
+        if (pp->persistent_scopes_) {
+            smtlib2_abstract_parser_restore_roots(pp, 0);
+        }
+        smtlib2_abstract_parser_undo_to(pp, 0);
+        pp->response_ = SMTLIB2_RESPONSE_SUCCESS;
+    }
+}
+
+
+void smtlib2_abstract_parser_reset(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
+    smtlib2_abstract_parser_reset_assertions(p);
+    if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
+        pp->set_logic_ok_ = true;
+        pp->status_ = SMTLIB2_STATUS_UNKNOWN;
+    }
 }
 
 
@@ -274,6 +786,19 @@ void smtlib2_abstract_parser_assert_formula(smtlib2_parser_interface *p,
 }
 
 
+void smtlib2_abstract_parser_assert_lazy_formula(smtlib2_parser_interface *p,
+                                                 smtlib2_lazy_term *term)
+{
+    /* by default, force the term right away */
+    smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
+    smtlib2_term t = smtlib2_abstract_parser_force_term(pp, term);
+    smtlib2_lazy_term_delete(term);
+    if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
+        p->assert_formula(p, t);
+    }
+}
+
+
 void smtlib2_abstract_parser_check_sat(smtlib2_parser_interface *p)
 {
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
@@ -370,9 +895,16 @@ void smtlib2_abstract_parser_get_info(smtlib2_parser_interface *p,
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
 
     if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
-        intptr_t v;
-        if (smtlib2_hashtable_find(pp->info_, (intptr_t)keyword, &v)) {
-            smtlib2_vector_push(pp->response_data_, (intptr_t)keyword);
+        intptr_t k, v;
+        if (pp->stats_enabled_ && strcmp(keyword, ":all-statistics") == 0) {
+            smtlib2_parser_stats_report(pp->stats_, pp->response_data_);
+            pp->response_ = SMTLIB2_RESPONSE_INFO;
+        } else if (smtlib2_hashtable_find_key_value(pp->info_,
+                                                    (intptr_t)keyword,
+                                                    &k, &v)) {
+            /* the response refers to the stored copy of the keyword, the
+             * given one does not outlive the command */
+            smtlib2_vector_push(pp->response_data_, k);
             smtlib2_vector_push(pp->response_data_, v);
             pp->response_ = SMTLIB2_RESPONSE_INFO;
         } else {
@@ -389,8 +921,16 @@ void smtlib2_abstract_parser_set_info(smtlib2_parser_interface *p,
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
 
     if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
-        smtlib2_hashtable_set(pp->info_, (intptr_t)smtlib2_strdup(keyword),
-                              (intptr_t)smtlib2_strdup(value));
+        intptr_t k, v;
+        smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_RESPONSE);
+        if (smtlib2_hashtable_find_key_value(pp->info_, (intptr_t)keyword,
+                                             &k, &v)) {
+            smtlib2_free((char *)v);
+        } else {
+            k = (intptr_t)smtlib2_strdup(keyword);
+        }
+        smtlib2_hashtable_set(pp->info_, k, (intptr_t)smtlib2_strdup(value));
+        smtlib2_set_memory_tag(tag);
         pp->response_ = SMTLIB2_RESPONSE_SUCCESS;
     }
 }
@@ -426,13 +966,7 @@ void smtlib2_abstract_parser_set_internal_parsed_terms(
 {
     smtlib2_abstract_parser *pp = (smtlib2_abstract_parser *)p;
     if (pp->response_ != SMTLIB2_RESPONSE_ERROR) {
-        if (pp->internal_parsed_terms_enabled_) {
-            smtlib2_vector_swap(pp->internal_parsed_terms_, terms);
-        } else {
-            pp->response_ = SMTLIB2_RESPONSE_ERROR;
-            pp->errmsg_ =
-                smtlib2_strdup("unknown command `.internal-parse-terms'");
-        }
+        smtlib2_vector_swap(pp->internal_parsed_terms_, terms);
     }
 }
 
@@ -661,8 +1195,10 @@ void smtlib2_abstract_parser_reset_response(smtlib2_abstract_parser *p)
 {
     p->response_ = SMTLIB2_RESPONSE_SUCCESS;
     if (p->errmsg_) {
-        free(p->errmsg_);
+        smtlib2_free(p->errmsg_);
         p->errmsg_ = NULL;
     }
+    /* an error in a term must not leak into the following commands */
+    smtlib2_term_parser_clear_error(p->termparser_);
     smtlib2_vector_clear(p->response_data_);
 }
@@ -0,0 +1,244 @@
+/* -*- C -*-
+ *
+ * Pluggable memory allocators for the SMT-LIB v2 parser
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static void *smtlib2_default_alloc(void *user_data, size_t size)
+{
+    return malloc(size);
+}
+
+
+static void *smtlib2_default_realloc(void *user_data, void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+
+static void smtlib2_default_free(void *user_data, void *ptr)
+{
+    free(ptr);
+}
+
+
+static smtlib2_allocator smtlib2_default = {
+    smtlib2_default_alloc,
+    smtlib2_default_realloc,
+    smtlib2_default_free,
+    NULL
+};
+
+/* without thread-local storage, the current allocator is global */
+#ifdef SMTLIB2_THREAD_LOCAL
+static SMTLIB2_THREAD_LOCAL smtlib2_allocator *smtlib2_current = NULL;
+#else
+static smtlib2_allocator *smtlib2_current = NULL;
+#endif
+
+#define CURRENT (smtlib2_current ? smtlib2_current : &smtlib2_default)
+
+
+void *smtlib2_malloc(size_t size)
+{
+    smtlib2_allocator *a = CURRENT;
+    return a->alloc(a->user_data, size);
+}
+
+
+void *smtlib2_realloc(void *ptr, size_t size)
+{
+    smtlib2_allocator *a = CURRENT;
+    return a->realloc(a->user_data, ptr, size);
+}
+
+
+void smtlib2_free(void *ptr)
+{
+    if (ptr) {
+        smtlib2_allocator *a = CURRENT;
+        a->free(a->user_data, ptr);
+    }
+}
+
+
+smtlib2_allocator *smtlib2_default_allocator(void)
+{
+    return &smtlib2_default;
+}
+
+
+smtlib2_allocator *smtlib2_get_allocator(void)
+{
+    return CURRENT;
+}
+
+
+smtlib2_allocator *smtlib2_set_allocator(smtlib2_allocator *a)
+{
+    smtlib2_allocator *ret = CURRENT;
+    smtlib2_current = (a == &smtlib2_default) ? NULL : a;
+    return ret;
+}
+
+
+/*
+ * Arenas. Every block is preceded by its size, so that realloc knows how
+ * much to copy
+ */
+
+#define SMTLIB2_ARENA_ALIGN 16
+#define SMTLIB2_ARENA_HEADER SMTLIB2_ARENA_ALIGN
+#define SMTLIB2_ARENA_ROUND(n) \
+    (((n) + SMTLIB2_ARENA_ALIGN - 1) & ~((size_t)SMTLIB2_ARENA_ALIGN - 1))
+
+typedef struct smtlib2_arena_chunk {
+    struct smtlib2_arena_chunk *next_;
+    size_t size_;
+    size_t used_;
+    /* followed by the data, aligned to SMTLIB2_ARENA_ALIGN */
+} smtlib2_arena_chunk;
+
+#define CHUNK_DATA(c) \
+    ((char *)(c) + SMTLIB2_ARENA_ROUND(sizeof(smtlib2_arena_chunk)))
+
+struct smtlib2_arena {
+    smtlib2_allocator allocator_;
+    smtlib2_arena_chunk *chunks_;
+    size_t chunk_size_;
+    size_t total_;
+    char *last_;  /* the last block allocated, which can grow in place */
+};
+
+
+static void *smtlib2_arena_alloc(void *user_data, size_t size)
+{
+    smtlib2_arena *a = (smtlib2_arena *)user_data;
+    smtlib2_arena_chunk *c = a->chunks_;
+    size_t need = SMTLIB2_ARENA_HEADER + SMTLIB2_ARENA_ROUND(size);
+    char *ret;
+
+    if (!c || c->used_ + need > c->size_) {
+        size_t sz = need > a->chunk_size_ ? need : a->chunk_size_;
+        c = (smtlib2_arena_chunk *)malloc(
+            SMTLIB2_ARENA_ROUND(sizeof(smtlib2_arena_chunk)) + sz);
+        if (!c) {
+            return NULL;
+        }
+        c->size_ = sz;
+        c->used_ = 0;
+        c->next_ = a->chunks_;
+        a->chunks_ = c;
+        a->total_ += sz;
+    }
+    ret = CHUNK_DATA(c) + c->used_ + SMTLIB2_ARENA_HEADER;
+    ((size_t *)ret)[-1] = size;
+    c->used_ += need;
+    a->last_ = ret;
+    return ret;
+}
+
+
+static void *smtlib2_arena_realloc(void *user_data, void *ptr, size_t size)
+{
+    smtlib2_arena *a = (smtlib2_arena *)user_data;
+    size_t old;
+    void *ret;
+
+    if (!ptr) {
+        return smtlib2_arena_alloc(user_data, size);
+    }
+    old = ((size_t *)ptr)[-1];
+    if ((char *)ptr == a->last_) {
+        /* the last block can grow (or shrink) in place */
+        smtlib2_arena_chunk *c = a->chunks_;
+        size_t used = c->used_ - SMTLIB2_ARENA_ROUND(old) +
+            SMTLIB2_ARENA_ROUND(size);
+        if (used <= c->size_) {
+            c->used_ = used;
+            ((size_t *)ptr)[-1] = size;
+            return ptr;
+        }
+    } else if (size <= old) {
+        return ptr;
+    }
+    ret = smtlib2_arena_alloc(user_data, size);
+    if (ret) {
+        memcpy(ret, ptr, old < size ? old : size);
+    }
+    return ret;
+}
+
+
+static void smtlib2_arena_free(void *user_data, void *ptr)
+{
+    smtlib2_arena *a = (smtlib2_arena *)user_data;
+    if ((char *)ptr == a->last_) {
+        smtlib2_arena_chunk *c = a->chunks_;
+        c->used_ -= SMTLIB2_ARENA_HEADER +
+            SMTLIB2_ARENA_ROUND(((size_t *)ptr)[-1]);
+        a->last_ = NULL;
+    }
+}
+
+
+smtlib2_arena *smtlib2_arena_new(size_t chunk_size)
+{
+    smtlib2_arena *ret = (smtlib2_arena *)malloc(sizeof(smtlib2_arena));
+    ret->allocator_.alloc = smtlib2_arena_alloc;
+    ret->allocator_.realloc = smtlib2_arena_realloc;
+    ret->allocator_.free = smtlib2_arena_free;
+    ret->allocator_.user_data = ret;
+    ret->chunks_ = NULL;
+    ret->chunk_size_ = chunk_size ? chunk_size : (1 << 20);
+    ret->total_ = 0;
+    ret->last_ = NULL;
+    return ret;
+}
+
+
+void smtlib2_arena_delete(smtlib2_arena *a)
+{
+    while (a->chunks_) {
+        smtlib2_arena_chunk *c = a->chunks_;
+        a->chunks_ = c->next_;
+        free(c);
+    }
+    free(a);
+}
+
+
+smtlib2_allocator *smtlib2_arena_allocator(smtlib2_arena *a)
+{
+    return &(a->allocator_);
+}
+
+
+size_t smtlib2_arena_size(smtlib2_arena *a)
+{
+    return a->total_;
+}
@@ -0,0 +1,1893 @@
+/* -*- C -*-
+ *
+ * Compact binary serialization of parsed SMT-LIB v2 scripts
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2binary.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char smtlib2_binary_magic[7] = { 'S','M','T','2','B','I','N' };
+
+#define SMTLIB2_BINARY_FLUSH_SIZE (1 << 16)
+
+typedef enum {
+    SMTLIB2_BIN_SYMBOL = 1,
+    SMTLIB2_BIN_SORT,
+    SMTLIB2_BIN_TERM,
+    SMTLIB2_BIN_ANNOTATE,
+    SMTLIB2_BIN_SET_LOGIC,
+    SMTLIB2_BIN_DECLARE_SORT,
+    SMTLIB2_BIN_DEFINE_SORT,
+    SMTLIB2_BIN_DECLARE_FUN,
+    SMTLIB2_BIN_DEFINE_FUN,
+    SMTLIB2_BIN_PUSH,
+    SMTLIB2_BIN_POP,
+    SMTLIB2_BIN_ASSERT,
+    SMTLIB2_BIN_CHECK_SAT,
+    SMTLIB2_BIN_GET_ASSERTIONS,
+    SMTLIB2_BIN_GET_UNSAT_CORE,
+    SMTLIB2_BIN_GET_PROOF,
+    SMTLIB2_BIN_GET_ASSIGNMENT,
+    SMTLIB2_BIN_SET_OPTION_STR,
+    SMTLIB2_BIN_SET_OPTION_INT,
+    SMTLIB2_BIN_SET_OPTION_RAT,
+    SMTLIB2_BIN_GET_INFO,
+    SMTLIB2_BIN_SET_INFO,
+    SMTLIB2_BIN_GET_VALUE,
+    SMTLIB2_BIN_EXIT,
+    SMTLIB2_BIN_RESET_ASSERTIONS,
+    SMTLIB2_BIN_RESET
+} smtlib2_binary_opcode;
+
+
+/*----------------------------------------------------------------------------
+ * numbers
+ *----------------------------------------------------------------------------*/
+
+void smtlib2_binary_put_uint(smtlib2_charbuf *buf, uint64_t n)
+{
+    while (n >= 0x80) {
+        smtlib2_charbuf_push(buf, (char)((n & 0x7f) | 0x80));
+        n >>= 7;
+    }
+    smtlib2_charbuf_push(buf, (char)n);
+}
+
+
+void smtlib2_binary_put_int(smtlib2_charbuf *buf, int64_t n)
+{
+    smtlib2_binary_put_uint(buf, ((uint64_t)n << 1) ^ (uint64_t)(n >> 63));
+}
+
+
+bool smtlib2_binary_get_uint(const unsigned char *data, size_t size,
+                             size_t *pos, uint64_t *out)
+{
+    uint64_t ret = 0;
+    int shift = 0;
+    while (*pos < size && shift < 64) {
+        unsigned char b = data[(*pos)++];
+        ret |= ((uint64_t)(b & 0x7f)) << shift;
+        if (!(b & 0x80)) {
+            *out = ret;
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+
+
+bool smtlib2_binary_get_int(const unsigned char *data, size_t size,
+                            size_t *pos, int64_t *out)
+{
+    uint64_t n;
+    if (!smtlib2_binary_get_uint(data, size, pos, &n)) {
+        return false;
+    }
+    *out = (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+    return true;
+}
+
+
+/*----------------------------------------------------------------------------
+ * writer
+ *----------------------------------------------------------------------------*/
+
+static void smtlib2_binary_writer_set_logic(smtlib2_parser_interface *p,
+                                            const char *logic);
+static void smtlib2_binary_writer_declare_sort(smtlib2_parser_interface *p,
+                                               const char *sortname,
+                                               int arity);
+static void smtlib2_binary_writer_define_sort(smtlib2_parser_interface *p,
+                                              const char *sortname,
+                                              smtlib2_vector *params,
+                                              smtlib2_sort sort);
+static void smtlib2_binary_writer_push_sort_param_scope(
+                                                   smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_pop_sort_param_scope(
+                                                   smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_declare_function(smtlib2_parser_interface *p,
+                                                   const char *name,
+                                                   smtlib2_sort sort);
+static void smtlib2_binary_writer_declare_variable(smtlib2_parser_interface *p,
+                                                   const char *name,
+                                                   smtlib2_sort sort);
+static void smtlib2_binary_writer_define_function(smtlib2_parser_interface *p,
+                                                  const char *name,
+                                                  smtlib2_vector *params,
+                                                  smtlib2_sort sort,
+                                                  smtlib2_term term);
+static void smtlib2_binary_writer_push(smtlib2_parser_interface *p, int n);
+static void smtlib2_binary_writer_pop(smtlib2_parser_interface *p, int n);
+static void smtlib2_binary_writer_assert_formula(smtlib2_parser_interface *p,
+                                                 smtlib2_term term);
+static void smtlib2_binary_writer_check_sat(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_reset_assertions(
+                                                   smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_reset(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_get_assertions(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_get_unsat_core(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_get_proof(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_get_assignment(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_set_str_option(smtlib2_parser_interface *p,
+                                                 const char *keyword,
+                                                 const char *value);
+static void smtlib2_binary_writer_set_int_option(smtlib2_parser_interface *p,
+                                                 const char *keyword,
+                                                 int value);
+static void smtlib2_binary_writer_set_rat_option(smtlib2_parser_interface *p,
+                                                 const char *keyword,
+                                                 double value);
+static void smtlib2_binary_writer_get_info(smtlib2_parser_interface *p,
+                                           const char *keyword);
+static void smtlib2_binary_writer_set_info(smtlib2_parser_interface *p,
+                                           const char *keyword,
+                                           const char *value);
+static void smtlib2_binary_writer_get_value(smtlib2_parser_interface *p,
+                                            smtlib2_vector *terms);
+static void smtlib2_binary_writer_exit(smtlib2_parser_interface *p);
+static void smtlib2_binary_writer_push_quantifier_scope(
+                                                   smtlib2_parser_interface *p);
+static smtlib2_term smtlib2_binary_writer_pop_quantifier_scope(
+                                                   smtlib2_parser_interface *p);
+static smtlib2_term smtlib2_binary_writer_make_forall_term(
+                                                   smtlib2_parser_interface *p,
+                                                   smtlib2_term term);
+static smtlib2_term smtlib2_binary_writer_make_exists_term(
+                                                   smtlib2_parser_interface *p,
+                                                   smtlib2_term term);
+static void smtlib2_binary_writer_annotate_term(smtlib2_parser_interface *p,
+                                                smtlib2_term term,
+                                                smtlib2_vector *annotations);
+static smtlib2_sort smtlib2_binary_writer_make_sort(smtlib2_parser_interface *p,
+                                                    const char *sortname,
+                                                    smtlib2_vector *index);
+static smtlib2_sort smtlib2_binary_writer_make_parametric_sort(
+                                                    smtlib2_parser_interface *p,
+                                                    const char *name,
+                                                    smtlib2_vector *tps);
+static smtlib2_sort smtlib2_binary_writer_make_function_sort(
+                                                    smtlib2_parser_interface *p,
+                                                    smtlib2_vector *tps);
+
+static smtlib2_term smtlib2_binary_writer_mk_function(smtlib2_context ctx,
+                                                      const char *symbol,
+                                                      smtlib2_sort sort,
+                                                      smtlib2_vector *index,
+                                                      smtlib2_vector *args);
+static smtlib2_term smtlib2_binary_writer_mk_number(smtlib2_context ctx,
+                                                    const char *rep,
+                                                    unsigned int width,
+                                                    unsigned int base);
+
+static void emit_byte(smtlib2_binary_writer *w, int b);
+static void emit_uint(smtlib2_binary_writer *w, uint64_t n);
+static void emit_int(smtlib2_binary_writer *w, int64_t n);
+static uint32_t emit_symbol(smtlib2_binary_writer *w, const char *s);
+static void emit_new_nodes(smtlib2_binary_writer *w);
+static void emit_command(smtlib2_binary_writer *w, smtlib2_binary_opcode op);
+static void finish_command(smtlib2_binary_writer *w);
+
+
+#define WRITER(p) ((smtlib2_binary_writer *)(p))
+#define WRITER_OK(p) \
+    (((smtlib2_abstract_parser *)(p))->response_ != SMTLIB2_RESPONSE_ERROR)
+
+
+smtlib2_parser_interface *SMTLIB2_PARSER_INTERFACE_BINARY_WRITER(
+    smtlib2_binary_writer *w)
+{
+    return &(w->parent_.parent_);
+}
+
+
+smtlib2_binary_writer *smtlib2_binary_writer_new(FILE *out)
+{
+    smtlib2_binary_writer *ret =
+        (smtlib2_binary_writer *)smtlib2_malloc(sizeof(smtlib2_binary_writer));
+    smtlib2_parser_interface *pi;
+    smtlib2_term_parser *tp;
+
+    smtlib2_abstract_parser_init((smtlib2_abstract_parser *)ret,
+                                 (smtlib2_context)ret);
+    /* the writer only records, so there is nothing interesting to report */
+    ret->parent_.print_success_ = false;
+    ret->out_ = out;
+    ret->buf_ = smtlib2_charbuf_new();
+    ret->dag_ = smtlib2_termdag_new();
+    ret->emitted_symbols_ = 0;
+    ret->emitted_sorts_ = 0;
+    ret->emitted_terms_ = 0;
+    ret->emitted_commands_ = 0;
+    ret->bound_vars_ = smtlib2_vector_new();
+    ret->in_sort_params_ = false;
+
+    pi = SMTLIB2_PARSER_INTERFACE_BINARY_WRITER(ret);
+    pi->set_logic = smtlib2_binary_writer_set_logic;
+    pi->declare_sort = smtlib2_binary_writer_declare_sort;
+    pi->define_sort = smtlib2_binary_writer_define_sort;
+    pi->push_sort_param_scope = smtlib2_binary_writer_push_sort_param_scope;
+    pi->pop_sort_param_scope = smtlib2_binary_writer_pop_sort_param_scope;
+    pi->declare_function = smtlib2_binary_writer_declare_function;
+    pi->declare_variable = smtlib2_binary_writer_declare_variable;
+    pi->define_function = smtlib2_binary_writer_define_function;
+    pi->push = smtlib2_binary_writer_push;
+    pi->pop = smtlib2_binary_writer_pop;
+    pi->reset_assertions = smtlib2_binary_writer_reset_assertions;
+    pi->reset = smtlib2_binary_writer_reset;
+    pi->assert_formula = smtlib2_binary_writer_assert_formula;
+    pi->check_sat = smtlib2_binary_writer_check_sat;
+    pi->get_assertions = smtlib2_binary_writer_get_assertions;
+    pi->get_unsat_core = smtlib2_binary_writer_get_unsat_core;
+    pi->get_proof = smtlib2_binary_writer_get_proof;
+    pi->get_assignment = smtlib2_binary_writer_get_assignment;
+    pi->set_str_option = smtlib2_binary_writer_set_str_option;
+    pi->set_int_option = smtlib2_binary_writer_set_int_option;
+    pi->set_rat_option = smtlib2_binary_writer_set_rat_option;
+    pi->get_info = smtlib2_binary_writer_get_info;
+    pi->set_info = smtlib2_binary_writer_set_info;
+    pi->get_value = smtlib2_binary_writer_get_value;
+    pi->exit = smtlib2_binary_writer_exit;
+    pi->push_quantifier_scope = smtlib2_binary_writer_push_quantifier_scope;
+    pi->pop_quantifier_scope = smtlib2_binary_writer_pop_quantifier_scope;
+    pi->make_forall_term = smtlib2_binary_writer_make_forall_term;
+    pi->make_exists_term = smtlib2_binary_writer_make_exists_term;
+    pi->annotate_term = smtlib2_binary_writer_annotate_term;
+    pi->make_sort = smtlib2_binary_writer_make_sort;
+    pi->make_parametric_sort = smtlib2_binary_writer_make_parametric_sort;
+    pi->make_function_sort = smtlib2_binary_writer_make_function_sort;
+
+    tp = ret->parent_.termparser_;
+    smtlib2_term_parser_set_function_handler(
+        tp, smtlib2_binary_writer_mk_function);
+    smtlib2_term_parser_set_number_handler(tp, smtlib2_binary_writer_mk_number);
+
+    smtlib2_charbuf_reserve(ret->buf_, SMTLIB2_BINARY_FLUSH_SIZE);
+    smtlib2_charbuf_push_str(ret->buf_, "SMT2BIN");
+    emit_byte(ret, SMTLIB2_BINARY_VERSION);
+
+    return ret;
+}
+
+
+bool smtlib2_binary_writer_flush(smtlib2_binary_writer *w)
+{
+    size_t n = SMTLIB2_VECTOR_SIZE(w->buf_);
+    bool ok = true;
+    if (!w->out_) {
+        /* the records are taken from buf_ by the owner */
+        return true;
+    }
+    if (n > 0) {
+        ok = fwrite(smtlib2_charbuf_array(w->buf_), 1, n, w->out_) == n;
+        smtlib2_charbuf_resize(w->buf_, 0);
+    }
+    return fflush(w->out_) == 0 && ok;
+}
+
+
+smtlib2_binary_writer *smtlib2_binary_writer_new_with_allocator(
+    FILE *out, smtlib2_allocator *a)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(a);
+    smtlib2_binary_writer *ret = smtlib2_binary_writer_new(out);
+    smtlib2_set_allocator(prev);
+    return ret;
+}
+
+
+void smtlib2_binary_writer_delete(smtlib2_binary_writer *w)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(w->parent_.allocator_);
+    smtlib2_binary_writer_flush(w);
+    smtlib2_vector_delete(w->bound_vars_);
+    smtlib2_termdag_delete(w->dag_);
+    smtlib2_charbuf_delete(w->buf_);
+    smtlib2_abstract_parser_deinit(&(w->parent_));
+    smtlib2_free(w);
+    smtlib2_set_allocator(prev);
+}
+
+
+static void smtlib2_binary_writer_set_logic(smtlib2_parser_interface *p,
+                                            const char *logic)
+{
+    smtlib2_abstract_parser_set_logic(p, logic);
+    if (WRITER_OK(p)) {
+        uint32_t s = emit_symbol(WRITER(p), logic);
+        emit_command(WRITER(p), SMTLIB2_BIN_SET_LOGIC);
+        emit_uint(WRITER(p), s);
+        finish_command(WRITER(p));
+    }
+}
+
+
+static void smtlib2_binary_writer_declare_sort(smtlib2_parser_interface *p,
+                                               const char *sortname,
+                                               int arity)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    /* the parameters of a define-sort are replayed together with it */
+    if (WRITER_OK(p) && !w->in_sort_params_) {
+        uint32_t s = emit_symbol(w, sortname);
+        emit_command(w, SMTLIB2_BIN_DECLARE_SORT);
+        emit_uint(w, s);
+        emit_int(w, arity);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_define_sort(smtlib2_parser_interface *p,
+                                              const char *sortname,
+                                              smtlib2_vector *params,
+                                              smtlib2_sort sort)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        size_t i, n = params ? smtlib2_vector_size(params) : 0;
+        uint32_t s = emit_symbol(w, sortname);
+        emit_command(w, SMTLIB2_BIN_DEFINE_SORT);
+        emit_uint(w, s);
+        emit_uint(w, n);
+        for (i = 0; i < n; ++i) {
+            emit_uint(w, ((smtlib2_dag_sort *)smtlib2_vector_at(params, i))->id_);
+        }
+        emit_uint(w, ((smtlib2_dag_sort *)sort)->id_);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_push_sort_param_scope(
+    smtlib2_parser_interface *p)
+{
+    WRITER(p)->in_sort_params_ = true;
+}
+
+
+static void smtlib2_binary_writer_pop_sort_param_scope(
+    smtlib2_parser_interface *p)
+{
+    WRITER(p)->in_sort_params_ = false;
+}
+
+
+static void smtlib2_binary_writer_declare_function(smtlib2_parser_interface *p,
+                                                   const char *name,
+                                                   smtlib2_sort sort)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        uint32_t s = emit_symbol(w, name);
+        emit_command(w, SMTLIB2_BIN_DECLARE_FUN);
+        emit_uint(w, s);
+        emit_uint(w, ((smtlib2_dag_sort *)sort)->id_);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_declare_variable(smtlib2_parser_interface *p,
+                                                   const char *name,
+                                                   smtlib2_sort sort)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        smtlib2_dag_symbol *s = smtlib2_termdag_intern(w->dag_, name);
+        smtlib2_dag_term *v = smtlib2_termdag_mk_term(
+            w->dag_, SMTLIB2_DAG_TERM_VAR, s, (smtlib2_dag_sort *)sort,
+            0, NULL, 0, NULL);
+        smtlib2_vector_push(w->bound_vars_, (intptr_t)v);
+        emit_new_nodes(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_define_function(smtlib2_parser_interface *p,
+                                                  const char *name,
+                                                  smtlib2_vector *params,
+                                                  smtlib2_sort sort,
+                                                  smtlib2_term term)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    /* constants are expanded by the term parser; functions with parameters,
+     * which it does not support, are recorded as applications */
+    if (!params || smtlib2_vector_size(params) == 0) {
+        smtlib2_abstract_parser_define_function(p, name, params, sort, term);
+    }
+
+    if (WRITER_OK(p)) {
+        size_t i, n = params ? smtlib2_vector_size(params) : 0;
+        uint32_t s = emit_symbol(w, name);
+        emit_command(w, SMTLIB2_BIN_DEFINE_FUN);
+        emit_uint(w, s);
+        emit_uint(w, n);
+        for (i = 0; i < n; ++i) {
+            emit_uint(w, ((smtlib2_dag_term *)smtlib2_vector_at(params, i))->id_);
+        }
+        emit_uint(w, ((smtlib2_dag_sort *)sort)->id_);
+        emit_uint(w, ((smtlib2_dag_term *)term)->id_);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_push(smtlib2_parser_interface *p, int n)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    /* the define-funs of the levels are forgotten by the parser on pop, so
+     * that they can be defined again */
+    smtlib2_abstract_parser_push(p, n);
+    if (WRITER_OK(p)) {
+        emit_command(w, SMTLIB2_BIN_PUSH);
+        emit_int(w, n);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_pop(smtlib2_parser_interface *p, int n)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    smtlib2_abstract_parser_pop(p, n);
+    if (WRITER_OK(p)) {
+        emit_command(w, SMTLIB2_BIN_POP);
+        emit_int(w, n);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_reset_assertions(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser_reset_assertions(p);
+    if (WRITER_OK(p)) {
+        emit_command(WRITER(p), SMTLIB2_BIN_RESET_ASSERTIONS);
+        finish_command(WRITER(p));
+    }
+}
+
+
+static void smtlib2_binary_writer_reset(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser_reset(p);
+    if (WRITER_OK(p)) {
+        emit_command(WRITER(p), SMTLIB2_BIN_RESET);
+        finish_command(WRITER(p));
+    }
+}
+
+
+static void smtlib2_binary_writer_assert_formula(smtlib2_parser_interface *p,
+                                                 smtlib2_term term)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        emit_command(w, SMTLIB2_BIN_ASSERT);
+        emit_uint(w, ((smtlib2_dag_term *)term)->id_);
+        finish_command(w);
+    }
+}
+
+
+#define SMTLIB2_BINARY_WRITER_NULLARY(name, op)                         \
+    static void smtlib2_binary_writer_ ## name(smtlib2_parser_interface *p) \
+    {                                                                   \
+        if (WRITER_OK(p)) {                                             \
+            emit_command(WRITER(p), op);                                \
+            finish_command(WRITER(p));                                  \
+        }                                                               \
+    }
+
+SMTLIB2_BINARY_WRITER_NULLARY(check_sat, SMTLIB2_BIN_CHECK_SAT)
+SMTLIB2_BINARY_WRITER_NULLARY(get_assertions, SMTLIB2_BIN_GET_ASSERTIONS)
+SMTLIB2_BINARY_WRITER_NULLARY(get_unsat_core, SMTLIB2_BIN_GET_UNSAT_CORE)
+SMTLIB2_BINARY_WRITER_NULLARY(get_proof, SMTLIB2_BIN_GET_PROOF)
+SMTLIB2_BINARY_WRITER_NULLARY(get_assignment, SMTLIB2_BIN_GET_ASSIGNMENT)
+
+
+static void smtlib2_binary_writer_set_str_option(smtlib2_parser_interface *p,
+                                                 const char *keyword,
+                                                 const char *value)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        uint32_t k = emit_symbol(w, keyword);
+        uint32_t v = emit_symbol(w, value);
+        emit_command(w, SMTLIB2_BIN_SET_OPTION_STR);
+        emit_uint(w, k);
+        emit_uint(w, v);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_set_int_option(smtlib2_parser_interface *p,
+                                                 const char *keyword,
+                                                 int value)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        uint32_t k = emit_symbol(w, keyword);
+        emit_command(w, SMTLIB2_BIN_SET_OPTION_INT);
+        emit_uint(w, k);
+        emit_int(w, value);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_set_rat_option(smtlib2_parser_interface *p,
+                                                 const char *keyword,
+                                                 double value)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        uint64_t bits;
+        int i;
+        uint32_t k = emit_symbol(w, keyword);
+        memcpy(&bits, &value, sizeof(bits));
+        emit_command(w, SMTLIB2_BIN_SET_OPTION_RAT);
+        emit_uint(w, k);
+        for (i = 0; i < 8; ++i) {
+            emit_byte(w, (int)((bits >> (8 * i)) & 0xff));
+        }
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_get_info(smtlib2_parser_interface *p,
+                                           const char *keyword)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        uint32_t k = emit_symbol(w, keyword);
+        emit_command(w, SMTLIB2_BIN_GET_INFO);
+        emit_uint(w, k);
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_set_info(smtlib2_parser_interface *p,
+                                           const char *keyword,
+                                           const char *value)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        uint32_t k = emit_symbol(w, keyword);
+        uint32_t v = emit_symbol(w, value);
+        emit_command(w, SMTLIB2_BIN_SET_INFO);
+        emit_uint(w, k);
+        emit_uint(w, v);
+        finish_command(w);
+    }
+}
+
+
+#define TEXT(t) (((smtlib2_lazy_term *)(t))->text_)
+
+static void smtlib2_binary_writer_get_value(smtlib2_parser_interface *p,
+                                            smtlib2_vector *terms)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p)) {
+        size_t i, n = smtlib2_vector_size(terms);
+        for (i = 0; i < n; ++i) {
+            emit_symbol(w, TEXT(smtlib2_vector_at(terms, i)));
+        }
+        emit_command(w, SMTLIB2_BIN_GET_VALUE);
+        emit_uint(w, n);
+        for (i = 0; i < n; ++i) {
+            emit_uint(w, emit_symbol(w, TEXT(smtlib2_vector_at(terms, i))));
+        }
+        finish_command(w);
+    }
+}
+
+
+static void smtlib2_binary_writer_exit(smtlib2_parser_interface *p)
+{
+    emit_command(WRITER(p), SMTLIB2_BIN_EXIT);
+    finish_command(WRITER(p));
+    smtlib2_abstract_parser_exit(p);
+}
+
+
+static void smtlib2_binary_writer_push_quantifier_scope(
+    smtlib2_parser_interface *p)
+{
+    smtlib2_vector_push(WRITER(p)->bound_vars_, (intptr_t)NULL);
+}
+
+
+static smtlib2_term smtlib2_binary_writer_pop_quantifier_scope(
+    smtlib2_parser_interface *p)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+    while (smtlib2_vector_size(w->bound_vars_) > 0 &&
+           smtlib2_vector_last(w->bound_vars_) != (intptr_t)NULL) {
+        smtlib2_vector_pop(w->bound_vars_);
+    }
+    if (smtlib2_vector_size(w->bound_vars_) > 0) {
+        smtlib2_vector_pop(w->bound_vars_);
+    }
+    return NULL;
+}
+
+
+static smtlib2_term smtlib2_binary_writer_make_quantifier(
+    smtlib2_binary_writer *w, smtlib2_dag_term_kind kind, smtlib2_term body)
+{
+    size_t begin, n;
+    smtlib2_dag_term **args;
+    smtlib2_dag_term *ret;
+
+    if (!body) {
+        return NULL;
+    }
+    n = smtlib2_vector_size(w->bound_vars_);
+    begin = n;
+    while (begin > 0 && smtlib2_vector_at(w->bound_vars_, begin-1)) {
+        --begin;
+    }
+    /* the variables of the innermost scope, followed by the body */
+    smtlib2_vector_push(w->bound_vars_, (intptr_t)body);
+    args = (smtlib2_dag_term **)&(smtlib2_vector_at(w->bound_vars_, begin));
+    ret = smtlib2_termdag_mk_term(w->dag_, kind, NULL, NULL, 0, NULL,
+                                  n - begin + 1, args);
+    smtlib2_vector_pop(w->bound_vars_);
+    emit_new_nodes(w);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_binary_writer_make_forall_term(
+    smtlib2_parser_interface *p, smtlib2_term term)
+{
+    return smtlib2_binary_writer_make_quantifier(
+        WRITER(p), SMTLIB2_DAG_TERM_FORALL, term);
+}
+
+
+static smtlib2_term smtlib2_binary_writer_make_exists_term(
+    smtlib2_parser_interface *p, smtlib2_term term)
+{
+    return smtlib2_binary_writer_make_quantifier(
+        WRITER(p), SMTLIB2_DAG_TERM_EXISTS, term);
+}
+
+
+static void smtlib2_binary_writer_annotate_term(smtlib2_parser_interface *p,
+                                                smtlib2_term term,
+                                                smtlib2_vector *annotations)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+
+    if (WRITER_OK(p) && term) {
+        size_t i, n = smtlib2_vector_size(annotations);
+        for (i = 0; i < n; ++i) {
+            char **an = (char **)smtlib2_vector_at(annotations, i);
+            emit_symbol(w, an[0]);
+            emit_symbol(w, an[1]);
+        }
+        emit_byte(w, SMTLIB2_BIN_ANNOTATE);
+        emit_uint(w, ((smtlib2_dag_term *)term)->id_);
+        emit_uint(w, n);
+        for (i = 0; i < n; ++i) {
+            char **an = (char **)smtlib2_vector_at(annotations, i);
+            emit_uint(w, emit_symbol(w, an[0]));
+            emit_uint(w, emit_symbol(w, an[1]));
+        }
+    }
+}
+
+
+static smtlib2_sort smtlib2_binary_writer_make_sort(smtlib2_parser_interface *p,
+                                                    const char *sortname,
+                                                    smtlib2_vector *index)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+    smtlib2_dag_sort *ret;
+
+    ret = smtlib2_termdag_mk_sort(
+        w->dag_, SMTLIB2_DAG_SORT_BASIC,
+        smtlib2_termdag_intern(w->dag_, sortname),
+        index ? smtlib2_vector_size(index) : 0,
+        index ? smtlib2_vector_array(index) : NULL, 0, NULL);
+    emit_new_nodes(w);
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_binary_writer_make_parametric_sort(
+    smtlib2_parser_interface *p, const char *name, smtlib2_vector *tps)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+    smtlib2_dag_sort *ret;
+    size_t i;
+
+    for (i = 0; i < smtlib2_vector_size(tps); ++i) {
+        if (!smtlib2_vector_at(tps, i)) {
+            return NULL;
+        }
+    }
+    ret = smtlib2_termdag_mk_sort(
+        w->dag_, SMTLIB2_DAG_SORT_PARAMETRIC,
+        smtlib2_termdag_intern(w->dag_, name), 0, NULL,
+        smtlib2_vector_size(tps),
+        (smtlib2_dag_sort **)smtlib2_vector_array(tps));
+    emit_new_nodes(w);
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_binary_writer_make_function_sort(
+    smtlib2_parser_interface *p, smtlib2_vector *tps)
+{
+    smtlib2_binary_writer *w = WRITER(p);
+    smtlib2_dag_sort *ret;
+    size_t i;
+
+    for (i = 0; i < smtlib2_vector_size(tps); ++i) {
+        if (!smtlib2_vector_at(tps, i)) {
+            return NULL;
+        }
+    }
+    ret = smtlib2_termdag_mk_sort(
+        w->dag_, SMTLIB2_DAG_SORT_FUNCTION, NULL, 0, NULL,
+        smtlib2_vector_size(tps),
+        (smtlib2_dag_sort **)smtlib2_vector_array(tps));
+    emit_new_nodes(w);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_binary_writer_mk_function(smtlib2_context ctx,
+                                                      const char *symbol,
+                                                      smtlib2_sort sort,
+                                                      smtlib2_vector *index,
+                                                      smtlib2_vector *args)
+{
+    smtlib2_binary_writer *w = WRITER(ctx);
+    smtlib2_dag_symbol *s = smtlib2_termdag_intern(w->dag_, symbol);
+    smtlib2_dag_term *ret;
+    size_t i;
+
+    if (!index && !args) {
+        /* references to bound variables, innermost scope first */
+        i = smtlib2_vector_size(w->bound_vars_);
+        while (i-- > 0) {
+            smtlib2_dag_term *v =
+                (smtlib2_dag_term *)smtlib2_vector_at(w->bound_vars_, i);
+            if (v && v->symbol_ == s) {
+                return v;
+            }
+        }
+    }
+    if (args) {
+        for (i = 0; i < smtlib2_vector_size(args); ++i) {
+            if (!smtlib2_vector_at(args, i)) {
+                return NULL;
+            }
+        }
+    }
+    ret = smtlib2_termdag_mk_term(
+        w->dag_, SMTLIB2_DAG_TERM_APP, s, (smtlib2_dag_sort *)sort,
+        index ? smtlib2_vector_size(index) : 0,
+        index ? smtlib2_vector_array(index) : NULL,
+        args ? smtlib2_vector_size(args) : 0,
+        args ? (smtlib2_dag_term **)smtlib2_vector_array(args) : NULL);
+    emit_new_nodes(w);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_binary_writer_mk_number(smtlib2_context ctx,
+                                                    const char *rep,
+                                                    unsigned int width,
+                                                    unsigned int base)
+{
+    smtlib2_binary_writer *w = WRITER(ctx);
+    smtlib2_dag_term *ret;
+    intptr_t idx[2];
+
+    idx[0] = width;
+    idx[1] = base;
+    ret = smtlib2_termdag_mk_term(w->dag_, SMTLIB2_DAG_TERM_NUMBER,
+                                  smtlib2_termdag_intern(w->dag_, rep), NULL,
+                                  2, idx, 0, NULL);
+    emit_new_nodes(w);
+    return ret;
+}
+
+
+static void emit_byte(smtlib2_binary_writer *w, int b)
+{
+    smtlib2_charbuf_push(w->buf_, (char)b);
+}
+
+
+static void emit_uint(smtlib2_binary_writer *w, uint64_t n)
+{
+    smtlib2_binary_put_uint(w->buf_, n);
+}
+
+
+static void emit_int(smtlib2_binary_writer *w, int64_t n)
+{
+    smtlib2_binary_put_int(w->buf_, n);
+}
+
+
+static uint32_t emit_symbol(smtlib2_binary_writer *w, const char *s)
+{
+    smtlib2_dag_symbol *sym = smtlib2_termdag_intern(w->dag_, s);
+    emit_new_nodes(w);
+    return sym->id_;
+}
+
+
+static void emit_new_nodes(smtlib2_binary_writer *w)
+{
+    size_t i;
+    smtlib2_termdag *d = w->dag_;
+
+    while (w->emitted_symbols_ < smtlib2_termdag_num_symbols(d)) {
+        smtlib2_dag_symbol *s =
+            smtlib2_termdag_symbol(d, (uint32_t)w->emitted_symbols_++);
+        size_t n = strlen(s->name_);
+        emit_byte(w, SMTLIB2_BIN_SYMBOL);
+        emit_uint(w, n);
+        smtlib2_charbuf_reserve(w->buf_, SMTLIB2_VECTOR_SIZE(w->buf_) + n + 1);
+        memcpy(smtlib2_charbuf_array(w->buf_) + SMTLIB2_VECTOR_SIZE(w->buf_),
+               s->name_, n + 1);
+        SMTLIB2_VECTOR_SIZE(w->buf_) += n + 1;
+    }
+    while (w->emitted_sorts_ < smtlib2_termdag_num_sorts(d)) {
+        smtlib2_dag_sort *s =
+            smtlib2_termdag_sort(d, (uint32_t)w->emitted_sorts_++);
+        emit_byte(w, SMTLIB2_BIN_SORT);
+        emit_uint(w, s->kind_);
+        emit_uint(w, s->name_ ? s->name_->id_ + 1 : 0);
+        emit_uint(w, s->nidx_);
+        for (i = 0; i < s->nidx_; ++i) {
+            emit_int(w, s->idx_[i]);
+        }
+        emit_uint(w, s->nargs_);
+        for (i = 0; i < s->nargs_; ++i) {
+            emit_uint(w, s->args_[i]->id_);
+        }
+    }
+    while (w->emitted_terms_ < smtlib2_termdag_num_terms(d)) {
+        smtlib2_dag_term *t =
+            smtlib2_termdag_term(d, (uint32_t)w->emitted_terms_++);
+        emit_byte(w, SMTLIB2_BIN_TERM);
+        emit_uint(w, t->kind_);
+        emit_uint(w, t->symbol_ ? t->symbol_->id_ + 1 : 0);
+        emit_uint(w, t->sort_ ? t->sort_->id_ + 1 : 0);
+        emit_uint(w, t->nidx_);
+        for (i = 0; i < t->nidx_; ++i) {
+            emit_int(w, t->idx_[i]);
+        }
+        emit_uint(w, t->nargs_);
+        for (i = 0; i < t->nargs_; ++i) {
+            emit_uint(w, t->args_[i]->id_);
+        }
+    }
+}
+
+
+static void emit_command(smtlib2_binary_writer *w, smtlib2_binary_opcode op)
+{
+    emit_new_nodes(w);
+    emit_byte(w, op);
+}
+
+
+static void finish_command(smtlib2_binary_writer *w)
+{
+    ++w->emitted_commands_;
+    ((smtlib2_abstract_parser *)w)->response_ = SMTLIB2_RESPONSE_SUCCESS;
+    if (SMTLIB2_VECTOR_SIZE(w->buf_) >= SMTLIB2_BINARY_FLUSH_SIZE) {
+        smtlib2_binary_writer_flush(w);
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * reader
+ *----------------------------------------------------------------------------*/
+
+struct smtlib2_binary_reader {
+    const unsigned char *data_;
+    size_t size_;
+    size_t pos_;
+    bool mapped_;
+    smtlib2_charbuf *input_;   /* the records appended so far, if
+                                * incremental */
+    smtlib2_vector *symbols_;  /* offsets of the symbols in data_ */
+    smtlib2_vector *sort_offsets_;
+    smtlib2_vector *term_offsets_;
+    smtlib2_vector *sort_handles_;
+    smtlib2_vector *term_handles_;
+    smtlib2_charbuf *sort_built_;
+    smtlib2_charbuf *term_built_;
+    smtlib2_vector *trail_;
+    smtlib2_vector *marks_;
+    smtlib2_vector *stack_;
+    char *errmsg_;
+};
+
+
+#define SYMBOL_AT(r, id) \
+    ((const char *)((r)->data_ + smtlib2_vector_at((r)->symbols_, (id))))
+
+
+/* a decoded SORT or TERM record. ids refer to the reader tables */
+typedef struct smtlib2_binary_node {
+    uint64_t kind;
+    uint64_t symbol;  /* +1 */
+    uint64_t sort;    /* +1 */
+    uint64_t nidx;
+    size_t idx_pos;
+    uint64_t nargs;
+    size_t args_pos;
+} smtlib2_binary_node;
+
+
+static smtlib2_binary_reader *smtlib2_binary_reader_init(
+    const unsigned char *data, size_t size, bool mapped);
+static bool read_uint(smtlib2_binary_reader *r, size_t *pos, uint64_t *out);
+static bool read_int(smtlib2_binary_reader *r, size_t *pos, int64_t *out);
+static bool read_id(smtlib2_binary_reader *r, size_t *pos,
+                    smtlib2_vector *table, uint64_t *out);
+static bool read_symbol(smtlib2_binary_reader *r, size_t *pos,
+                        const char **out);
+static bool read_node(smtlib2_binary_reader *r, size_t pos, bool is_term,
+                      smtlib2_binary_node *out);
+static bool format_error(smtlib2_binary_reader *r, const char *msg);
+static void memoize(smtlib2_binary_reader *r, uint64_t id, bool is_sort,
+                    intptr_t handle);
+static void backtrack(smtlib2_binary_reader *r, size_t mark);
+static bool build_sort(smtlib2_binary_reader *r, smtlib2_parser_interface *pi,
+                       uint64_t id, smtlib2_vector *params,
+                       smtlib2_sort *out);
+static bool build_term(smtlib2_binary_reader *r, smtlib2_parser_interface *pi,
+                       uint64_t id, smtlib2_term *out);
+static bool declare_bound_var(smtlib2_binary_reader *r,
+                              smtlib2_parser_interface *pi, uint64_t id,
+                              smtlib2_term *out);
+static bool replay(smtlib2_binary_reader *r, smtlib2_parser_interface *pi,
+                   smtlib2_abstract_parser *ap);
+
+
+smtlib2_binary_reader *smtlib2_binary_reader_new(const char *filename)
+{
+    smtlib2_binary_reader *ret = NULL;
+    size_t size;
+    const char *data = smtlib2_map_file(filename, &size);
+    if (data) {
+        ret = smtlib2_binary_reader_init((const unsigned char *)data, size,
+                                         true);
+        if (!ret) {
+            smtlib2_unmap_file(data, size);
+        }
+    }
+    return ret;
+}
+
+
+smtlib2_binary_reader *smtlib2_binary_reader_new_from_memory(const char *data,
+                                                             size_t size)
+{
+    return smtlib2_binary_reader_init((const unsigned char *)data, size,
+                                      false);
+}
+
+
+smtlib2_binary_reader *smtlib2_binary_reader_new_incremental(void)
+{
+    static const unsigned char header[] = { 'S','M','T','2','B','I','N',
+                                            SMTLIB2_BINARY_VERSION };
+    smtlib2_binary_reader *ret =
+        smtlib2_binary_reader_init(header, sizeof(header), false);
+    ret->input_ = smtlib2_charbuf_new();
+    ret->data_ = NULL;
+    ret->size_ = 0;
+    ret->pos_ = 0;
+    return ret;
+}
+
+
+void smtlib2_binary_reader_append(smtlib2_binary_reader *r, const char *data,
+                                  size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    smtlib2_charbuf_resize(r->input_, r->size_ + size);
+    memcpy(smtlib2_charbuf_array(r->input_) + r->size_, data, size);
+    r->data_ = (const unsigned char *)smtlib2_charbuf_array(r->input_);
+    r->size_ += size;
+}
+
+
+void smtlib2_binary_reader_delete(smtlib2_binary_reader *r)
+{
+    if (r->mapped_) {
+        smtlib2_unmap_file((const char *)r->data_, r->size_);
+    }
+    if (r->input_) {
+        smtlib2_charbuf_delete(r->input_);
+    }
+    if (r->errmsg_) {
+        smtlib2_free(r->errmsg_);
+    }
+    smtlib2_vector_delete(r->stack_);
+    smtlib2_vector_delete(r->marks_);
+    smtlib2_vector_delete(r->trail_);
+    smtlib2_charbuf_delete(r->term_built_);
+    smtlib2_charbuf_delete(r->sort_built_);
+    smtlib2_vector_delete(r->term_handles_);
+    smtlib2_vector_delete(r->sort_handles_);
+    smtlib2_vector_delete(r->term_offsets_);
+    smtlib2_vector_delete(r->sort_offsets_);
+    smtlib2_vector_delete(r->symbols_);
+    smtlib2_free(r);
+}
+
+
+bool smtlib2_binary_reader_replay(smtlib2_binary_reader *r,
+                                  smtlib2_parser_interface *parser)
+{
+    return replay(r, parser, NULL);
+}
+
+
+bool smtlib2_abstract_parser_replay(smtlib2_abstract_parser *p,
+                                    smtlib2_binary_reader *r)
+{
+    bool ret;
+    smtlib2_abstract_parser_reset_response(p);
+    ret = replay(r, SMTLIB2_PARSER_INTERFACE(p), p);
+    smtlib2_abstract_parser_reset_response(p);
+    return ret;
+}
+
+
+const char *smtlib2_binary_reader_get_error_msg(smtlib2_binary_reader *r)
+{
+    return r->errmsg_;
+}
+
+
+bool smtlib2_binary_reader_build_term(smtlib2_binary_reader *r,
+                                      smtlib2_parser_interface *parser,
+                                      uint64_t id, smtlib2_term *out)
+{
+    if (!replay(r, parser, NULL)) {
+        return false;
+    }
+    if (id >= smtlib2_vector_size(r->term_offsets_)) {
+        return format_error(r, "reference to an undefined term");
+    }
+    return build_term(r, parser, id, out);
+}
+
+
+static smtlib2_binary_reader *smtlib2_binary_reader_init(
+    const unsigned char *data, size_t size, bool mapped)
+{
+    smtlib2_binary_reader *ret;
+
+    if (size < sizeof(smtlib2_binary_magic) + 1 ||
+        memcmp(data, smtlib2_binary_magic, sizeof(smtlib2_binary_magic)) != 0 ||
+        data[sizeof(smtlib2_binary_magic)] != SMTLIB2_BINARY_VERSION) {
+        return NULL;
+    }
+
+    ret = (smtlib2_binary_reader *)smtlib2_malloc(
+        sizeof(smtlib2_binary_reader));
+    ret->data_ = data;
+    ret->size_ = size;
+    ret->pos_ = sizeof(smtlib2_binary_magic) + 1;
+    ret->mapped_ = mapped;
+    ret->input_ = NULL;
+    ret->symbols_ = smtlib2_vector_new();
+    ret->sort_offsets_ = smtlib2_vector_new();
+    ret->term_offsets_ = smtlib2_vector_new();
+    ret->sort_handles_ = smtlib2_vector_new();
+    ret->term_handles_ = smtlib2_vector_new();
+    ret->sort_built_ = smtlib2_charbuf_new();
+    ret->term_built_ = smtlib2_charbuf_new();
+    ret->trail_ = smtlib2_vector_new();
+    ret->marks_ = smtlib2_vector_new();
+    ret->stack_ = smtlib2_vector_new();
+    ret->errmsg_ = NULL;
+
+    return ret;
+}
+
+
+static bool read_uint(smtlib2_binary_reader *r, size_t *pos, uint64_t *out)
+{
+    if (!smtlib2_binary_get_uint(r->data_, r->size_, pos, out)) {
+        return format_error(r, "truncated or malformed number");
+    }
+    return true;
+}
+
+
+static bool read_int(smtlib2_binary_reader *r, size_t *pos, int64_t *out)
+{
+    if (!smtlib2_binary_get_int(r->data_, r->size_, pos, out)) {
+        return format_error(r, "truncated or malformed number");
+    }
+    return true;
+}
+
+
+static bool read_id(smtlib2_binary_reader *r, size_t *pos,
+                    smtlib2_vector *table, uint64_t *out)
+{
+    if (!read_uint(r, pos, out)) {
+        return false;
+    }
+    if (*out >= smtlib2_vector_size(table)) {
+        return format_error(r, "reference to an undefined entry");
+    }
+    return true;
+}
+
+
+static bool read_symbol(smtlib2_binary_reader *r, size_t *pos,
+                        const char **out)
+{
+    uint64_t id;
+    if (!read_id(r, pos, r->symbols_, &id)) {
+        return false;
+    }
+    *out = SYMBOL_AT(r, id);
+    return true;
+}
+
+
+static bool read_node(smtlib2_binary_reader *r, size_t pos, bool is_term,
+                      smtlib2_binary_node *out)
+{
+    uint64_t i, tmp;
+    int64_t itmp;
+    smtlib2_vector *args = is_term ? r->term_offsets_ : r->sort_offsets_;
+
+    if (!read_uint(r, &pos, &out->kind) ||
+        !read_uint(r, &pos, &out->symbol)) {
+        return false;
+    }
+    if (out->symbol > smtlib2_vector_size(r->symbols_)) {
+        return format_error(r, "reference to an undefined symbol");
+    }
+    out->sort = 0;
+    if (is_term) {
+        if (!read_uint(r, &pos, &out->sort)) {
+            return false;
+        }
+        if (out->sort > smtlib2_vector_size(r->sort_offsets_)) {
+            return format_error(r, "reference to an undefined sort");
+        }
+    }
+    if (!read_uint(r, &pos, &out->nidx)) {
+        return false;
+    }
+    out->idx_pos = pos;
+    for (i = 0; i < out->nidx; ++i) {
+        if (!read_int(r, &pos, &itmp)) {
+            return false;
+        }
+    }
+    if (!read_uint(r, &pos, &out->nargs)) {
+        return false;
+    }
+    out->args_pos = pos;
+    for (i = 0; i < out->nargs; ++i) {
+        if (!read_id(r, &pos, args, &tmp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static bool format_error(smtlib2_binary_reader *r, const char *msg)
+{
+    if (!r->errmsg_) {
+        r->errmsg_ = smtlib2_sprintf("corrupted binary script: %s", msg);
+    }
+    return false;
+}
+
+
+static void memoize(smtlib2_binary_reader *r, uint64_t id, bool is_sort,
+                    intptr_t handle)
+{
+    smtlib2_vector *handles = is_sort ? r->sort_handles_ : r->term_handles_;
+    char *built = smtlib2_charbuf_array(is_sort ? r->sort_built_
+                                        : r->term_built_);
+
+    /* remember the previous entry, which a nested quantifier can shadow */
+    smtlib2_vector_push(r->trail_, smtlib2_vector_at(handles, id));
+    smtlib2_vector_push(r->trail_, (intptr_t)((id << 2) |
+                                              (built[id] ? 2 : 0) |
+                                              (is_sort ? 1 : 0)));
+    smtlib2_vector_at(handles, id) = handle;
+    built[id] = 1;
+}
+
+
+/*
+ * restores the memoized handles to what they were at the given mark. Handles
+ * created inside a scope that is later closed (a push level, a quantifier)
+ * may not be valid anymore, so they are rebuilt on demand
+ */
+static void backtrack(smtlib2_binary_reader *r, size_t mark)
+{
+    while (smtlib2_vector_size(r->trail_) > mark) {
+        uint64_t e = (uint64_t)smtlib2_vector_last(r->trail_);
+        intptr_t old;
+        smtlib2_vector_pop(r->trail_);
+        old = smtlib2_vector_last(r->trail_);
+        smtlib2_vector_pop(r->trail_);
+        if (e & 1) {
+            smtlib2_vector_at(r->sort_handles_, e >> 2) = old;
+            smtlib2_charbuf_array(r->sort_built_)[e >> 2] = (e & 2) ? 1 : 0;
+        } else {
+            smtlib2_vector_at(r->term_handles_, e >> 2) = old;
+            smtlib2_charbuf_array(r->term_built_)[e >> 2] = (e & 2) ? 1 : 0;
+        }
+    }
+}
+
+
+/*
+ * "params" is non-NULL inside a define-sort with parameters: it maps the
+ * parameter sort ids to their handles, and memoization is bypassed, since the
+ * parameter names may clash with those of actual sorts
+ */
+static bool build_sort(smtlib2_binary_reader *r, smtlib2_parser_interface *pi,
+                       uint64_t id, smtlib2_vector *params,
+                       smtlib2_sort *out)
+{
+    smtlib2_binary_node n;
+    smtlib2_vector *tmp = NULL;
+    const char *name = NULL;
+    const char *err = NULL;
+    size_t pos;
+    uint64_t i;
+    smtlib2_sort ret = NULL;
+
+    if (params) {
+        for (i = 0; i < smtlib2_vector_size(params); i += 2) {
+            if ((uint64_t)smtlib2_vector_at(params, i) == id) {
+                *out = (smtlib2_sort)smtlib2_vector_at(params, i+1);
+                return true;
+            }
+        }
+    } else if (smtlib2_charbuf_array(r->sort_built_)[id]) {
+        *out = (smtlib2_sort)smtlib2_vector_at(r->sort_handles_, id);
+        return true;
+    }
+
+    if (!read_node(r, (size_t)smtlib2_vector_at(r->sort_offsets_, id), false,
+                   &n)) {
+        return false;
+    }
+    if (n.symbol) {
+        name = SYMBOL_AT(r, n.symbol-1);
+    }
+    if (n.nidx || n.nargs) {
+        tmp = smtlib2_vector_new();
+    }
+    pos = n.idx_pos;
+    for (i = 0; i < n.nidx; ++i) {
+        int64_t v;
+        read_int(r, &pos, &v);
+        smtlib2_vector_push(tmp, (intptr_t)v);
+    }
+    pos = n.args_pos;
+    for (i = 0; i < n.nargs; ++i) {
+        uint64_t a;
+        smtlib2_sort s;
+        read_uint(r, &pos, &a);
+        if (!build_sort(r, pi, a, params, &s)) {
+            smtlib2_vector_delete(tmp);
+            return false;
+        }
+        smtlib2_vector_push(tmp, (intptr_t)s);
+    }
+
+    switch (n.kind) {
+    case SMTLIB2_DAG_SORT_BASIC:
+        if (!name) {
+            err = "sort without a name";
+        } else {
+            ret = pi->make_sort(pi, name, tmp);
+        }
+        break;
+    case SMTLIB2_DAG_SORT_PARAMETRIC:
+        if (!name || n.nidx || !n.nargs) {
+            err = "malformed parametric sort";
+        } else {
+            ret = pi->make_parametric_sort(pi, name, tmp);
+        }
+        break;
+    case SMTLIB2_DAG_SORT_FUNCTION:
+        if (n.nidx || n.nargs < 2) {
+            err = "malformed function sort";
+        } else {
+            ret = pi->make_function_sort(pi, tmp);
+        }
+        break;
+    default:
+        err = "unknown sort kind";
+    }
+    if (tmp) {
+        smtlib2_vector_delete(tmp);
+    }
+    if (err) {
+        return format_error(r, err);
+    }
+
+    if (!params) {
+        memoize(r, id, true, (intptr_t)ret);
+    }
+    *out = ret;
+    return true;
+}
+
+
+/* replays the declaration of a bound variable, as quant_var_list does */
+static bool declare_bound_var(smtlib2_binary_reader *r,
+                              smtlib2_parser_interface *pi, uint64_t id,
+                              smtlib2_term *out)
+{
+    smtlib2_binary_node n;
+    const char *name;
+    smtlib2_sort s;
+
+    if (!read_node(r, (size_t)smtlib2_vector_at(r->term_offsets_, id), true,
+                   &n)) {
+        return false;
+    }
+    if (n.kind != SMTLIB2_DAG_TERM_VAR || !n.symbol || !n.sort) {
+        return format_error(r, "malformed variable");
+    }
+    if (!build_sort(r, pi, n.sort-1, NULL, &s)) {
+        return false;
+    }
+    name = SYMBOL_AT(r, n.symbol-1);
+    pi->declare_variable(pi, name, s);
+    *out = pi->make_term(pi, name, s, NULL, NULL);
+    memoize(r, id, false, (intptr_t)*out);
+    return true;
+}
+
+
+/*
+ * builds a term bottom-up with an explicit stack, since the DAG can be much
+ * deeper than the C stack. Each stack entry is a term id shifted by one, with
+ * the low bit set once the arguments have been scheduled. Below the entry of
+ * an open quantifier sits the trail mark taken when its scope was opened
+ */
+static bool build_term(smtlib2_binary_reader *r, smtlib2_parser_interface *pi,
+                       uint64_t id, smtlib2_term *out)
+{
+    smtlib2_vector *stack = r->stack_;
+    smtlib2_vector *tmp = smtlib2_vector_new();
+    smtlib2_vector *idx = smtlib2_vector_new();
+    size_t base = smtlib2_vector_size(stack);
+    bool ok = true;
+
+    smtlib2_vector_push(stack, (intptr_t)(id << 1));
+
+    while (ok && smtlib2_vector_size(stack) > base) {
+        uint64_t e = (uint64_t)smtlib2_vector_last(stack);
+        uint64_t cur = e >> 1;
+        bool quant;
+        smtlib2_binary_node n;
+        size_t pos;
+        uint64_t i, a;
+
+        if (!(e & 1) && smtlib2_charbuf_array(r->term_built_)[cur]) {
+            smtlib2_vector_pop(stack);
+            continue;
+        }
+        if (!read_node(r, (size_t)smtlib2_vector_at(r->term_offsets_, cur),
+                       true, &n)) {
+            ok = false;
+            break;
+        }
+        quant = (n.kind == SMTLIB2_DAG_TERM_FORALL ||
+                 n.kind == SMTLIB2_DAG_TERM_EXISTS);
+
+        if (!(e & 1)) {
+            /* first visit: schedule the arguments */
+            pos = n.args_pos;
+            if (quant) {
+                if (n.nargs < 1) {
+                    ok = format_error(r, "malformed quantifier");
+                    break;
+                }
+                smtlib2_vector_last(stack) =
+                    (intptr_t)smtlib2_vector_size(r->trail_);
+                smtlib2_vector_push(stack, (intptr_t)(e | 1));
+                pi->push_quantifier_scope(pi);
+                for (i = 0; ok && i + 1 < n.nargs; ++i) {
+                    smtlib2_term v;
+                    read_uint(r, &pos, &a);
+                    ok = declare_bound_var(r, pi, a, &v);
+                }
+                read_uint(r, &pos, &a);
+                smtlib2_vector_push(stack, (intptr_t)(a << 1));
+            } else {
+                /* in reverse, so that the arguments are built left to right,
+                 * in the same order as when parsing */
+                smtlib2_vector_last(stack) = (intptr_t)(e | 1);
+                smtlib2_vector_resize(idx, 0);
+                for (i = 0; i < n.nargs; ++i) {
+                    read_uint(r, &pos, &a);
+                    smtlib2_vector_push(idx, (intptr_t)a);
+                }
+                for (i = n.nargs; i-- > 0; ) {
+                    a = (uint64_t)smtlib2_vector_at(idx, i);
+                    if (!smtlib2_charbuf_array(r->term_built_)[a]) {
+                        smtlib2_vector_push(stack, (intptr_t)(a << 1));
+                    }
+                }
+            }
+            continue;
+        }
+
+        /* second visit: all the arguments are available */
+        smtlib2_vector_resize(tmp, 0);
+        smtlib2_vector_resize(idx, 0);
+        pos = n.args_pos;
+        for (i = 0; i < n.nargs; ++i) {
+            read_uint(r, &pos, &a);
+            if (!quant && !smtlib2_charbuf_array(r->term_built_)[a]) {
+                break;
+            }
+            smtlib2_vector_push(tmp, smtlib2_vector_at(r->term_handles_, a));
+        }
+        if (i < n.nargs) {
+            /* an argument was invalidated in the meantime, start over */
+            smtlib2_vector_last(stack) = (intptr_t)(cur << 1);
+            continue;
+        }
+
+        if (quant) {
+            smtlib2_term res, body = (smtlib2_term)smtlib2_vector_last(tmp);
+            size_t mark;
+            smtlib2_vector_pop(stack);
+            mark = (size_t)smtlib2_vector_last(stack);
+            if (n.kind == SMTLIB2_DAG_TERM_FORALL) {
+                res = pi->make_forall_term(pi, body);
+            } else {
+                res = pi->make_exists_term(pi, body);
+            }
+            body = pi->pop_quantifier_scope(pi);
+            if (body) {
+                res = body;
+            }
+            backtrack(r, mark);
+            smtlib2_vector_pop(stack);
+            memoize(r, cur, false, (intptr_t)res);
+            continue;
+        }
+
+        smtlib2_vector_pop(stack);
+        pos = n.idx_pos;
+        for (i = 0; i < n.nidx; ++i) {
+            int64_t v;
+            read_int(r, &pos, &v);
+            smtlib2_vector_push(idx, (intptr_t)v);
+        }
+
+        switch (n.kind) {
+        case SMTLIB2_DAG_TERM_APP: {
+            smtlib2_sort s = NULL;
+            if (!n.symbol) {
+                ok = format_error(r, "application without a symbol");
+                break;
+            }
+            if (n.sort && !build_sort(r, pi, n.sort-1, NULL, &s)) {
+                ok = false;
+                break;
+            }
+            memoize(r, cur, false, (intptr_t)pi->make_term(
+                        pi,
+                        SYMBOL_AT(r, n.symbol-1),
+                        s, n.nidx ? idx : NULL, n.nargs ? tmp : NULL));
+        }
+            break;
+        case SMTLIB2_DAG_TERM_NUMBER:
+            if (!n.symbol || n.nidx != 2) {
+                ok = format_error(r, "malformed number");
+                break;
+            }
+            memoize(r, cur, false, (intptr_t)pi->make_number_term(
+                        pi,
+                        SYMBOL_AT(r, n.symbol-1),
+                        (int)smtlib2_vector_at(idx, 0),
+                        (int)smtlib2_vector_at(idx, 1)));
+            break;
+        case SMTLIB2_DAG_TERM_VAR:
+            /* a variable outside of its scope */
+            ok = format_error(r, "unbound variable");
+            break;
+        default:
+            ok = format_error(r, "unknown term kind");
+        }
+    }
+
+    /* on errors, close the scopes of the quantifiers that are still open,
+     * innermost first, so that the backend is left as it was */
+    while (!ok && smtlib2_vector_size(stack) > base) {
+        uint64_t e = (uint64_t)smtlib2_vector_last(stack);
+        smtlib2_binary_node n;
+        smtlib2_vector_pop(stack);
+        if ((e & 1) &&
+            read_node(r, (size_t)smtlib2_vector_at(r->term_offsets_, e >> 1),
+                      true, &n) &&
+            (n.kind == SMTLIB2_DAG_TERM_FORALL ||
+             n.kind == SMTLIB2_DAG_TERM_EXISTS)) {
+            pi->pop_quantifier_scope(pi);
+            backtrack(r, (size_t)smtlib2_vector_last(stack));
+            smtlib2_vector_pop(stack);
+        }
+    }
+    smtlib2_vector_resize(stack, base);
+    smtlib2_vector_delete(idx);
+    smtlib2_vector_delete(tmp);
+    if (ok) {
+        *out = (smtlib2_term)smtlib2_vector_at(r->term_handles_, id);
+    }
+    return ok;
+}
+
+
+static bool replay(smtlib2_binary_reader *r, smtlib2_parser_interface *pi,
+                   smtlib2_abstract_parser *ap)
+{
+    size_t pos = r->pos_;
+    smtlib2_vector *tmp = smtlib2_vector_new();
+    bool ok = true;
+
+    while (ok && pos < r->size_) {
+        int op = r->data_[pos++];
+        bool is_command = true;
+        const char *s1, *s2;
+        uint64_t u1, u2, i;
+        int64_t i1;
+        smtlib2_sort sort;
+        smtlib2_term term;
+
+        smtlib2_vector_resize(tmp, 0);
+
+        switch (op) {
+        case SMTLIB2_BIN_SYMBOL:
+            is_command = false;
+            if (!read_uint(r, &pos, &u1)) {
+                ok = false;
+            } else if (u1 >= r->size_ - pos || r->data_[pos + u1] != '\0') {
+                ok = format_error(r, "malformed symbol");
+            } else {
+                smtlib2_vector_push(r->symbols_, (intptr_t)pos);
+                pos += u1 + 1;
+            }
+            break;
+        case SMTLIB2_BIN_SORT:
+        case SMTLIB2_BIN_TERM: {
+            smtlib2_binary_node n;
+            bool is_term = (op == SMTLIB2_BIN_TERM);
+            is_command = false;
+            if (!read_node(r, pos, is_term, &n)) {
+                ok = false;
+                break;
+            }
+            smtlib2_vector_push(
+                is_term ? r->term_offsets_ : r->sort_offsets_, (intptr_t)pos);
+            smtlib2_vector_push(
+                is_term ? r->term_handles_ : r->sort_handles_, 0);
+            smtlib2_charbuf_push(
+                is_term ? r->term_built_ : r->sort_built_, 0);
+            /* skip to the end of the record */
+            pos = n.args_pos;
+            for (i = 0; i < n.nargs; ++i) {
+                read_uint(r, &pos, &u1);
+            }
+        }
+            break;
+        case SMTLIB2_BIN_ANNOTATE:
+            is_command = false;
+            if (!read_id(r, &pos, r->term_offsets_, &u1) ||
+                !read_uint(r, &pos, &u2)) {
+                ok = false;
+                break;
+            }
+            {
+                char **pairs =
+                    (char **)smtlib2_malloc(sizeof(char *) * 2 * (u2+1));
+                for (i = 0; ok && i < u2; ++i) {
+                    ok = read_symbol(r, &pos, &s1) &&
+                        read_symbol(r, &pos, &s2);
+                    pairs[2*i] = (char *)s1;
+                    pairs[2*i+1] = (char *)s2;
+                    smtlib2_vector_push(tmp, (intptr_t)&pairs[2*i]);
+                }
+                if (ok && (ok = build_term(r, pi, u1, &term))) {
+                    pi->annotate_term(pi, term, tmp);
+                }
+                smtlib2_free(pairs);
+            }
+            break;
+        case SMTLIB2_BIN_SET_LOGIC:
+            if ((ok = read_symbol(r, &pos, &s1))) {
+                pi->set_logic(pi, s1);
+            }
+            break;
+        case SMTLIB2_BIN_DECLARE_SORT:
+            if ((ok = read_symbol(r, &pos, &s1) && read_int(r, &pos, &i1))) {
+                pi->declare_sort(pi, s1, (int)i1);
+            }
+            break;
+        case SMTLIB2_BIN_DEFINE_SORT:
+            if (!read_symbol(r, &pos, &s1) || !read_uint(r, &pos, &u1)) {
+                ok = false;
+                break;
+            }
+            if (u1 == 0) {
+                if ((ok = read_id(r, &pos, r->sort_offsets_, &u2) &&
+                     build_sort(r, pi, u2, NULL, &sort))) {
+                    pi->define_sort(pi, s1, NULL, sort);
+                }
+            } else {
+                /* as in sort_param_list */
+                smtlib2_vector *params = smtlib2_vector_new();
+                pi->push_sort_param_scope(pi);
+                for (i = 0; ok && i < u1; ++i) {
+                    smtlib2_binary_node n;
+                    const char *pname;
+                    ok = read_id(r, &pos, r->sort_offsets_, &u2) &&
+                        read_node(r, (size_t)smtlib2_vector_at(
+                                      r->sort_offsets_, u2), false, &n);
+                    if (ok && !n.symbol) {
+                        ok = format_error(r, "malformed sort parameter");
+                    }
+                    if (ok) {
+                        pname = SYMBOL_AT(r, n.symbol-1);
+                        pi->declare_sort(pi, pname, 0);
+                        sort = pi->make_sort(pi, pname, NULL);
+                        smtlib2_vector_push(params, (intptr_t)u2);
+                        smtlib2_vector_push(params, (intptr_t)sort);
+                        smtlib2_vector_push(tmp, (intptr_t)sort);
+                    }
+                }
+                if (ok && (ok = read_id(r, &pos, r->sort_offsets_, &u2) &&
+                           build_sort(r, pi, u2, params, &sort))) {
+                    pi->define_sort(pi, s1, tmp, sort);
+                }
+                pi->pop_sort_param_scope(pi);
+                smtlib2_vector_delete(params);
+            }
+            break;
+        case SMTLIB2_BIN_DECLARE_FUN:
+            if ((ok = read_symbol(r, &pos, &s1) &&
+                 read_id(r, &pos, r->sort_offsets_, &u1) &&
+                 build_sort(r, pi, u1, NULL, &sort))) {
+                pi->declare_function(pi, s1, sort);
+            }
+            break;
+        case SMTLIB2_BIN_DEFINE_FUN: {
+            size_t mark = smtlib2_vector_size(r->trail_);
+            if (!read_symbol(r, &pos, &s1) || !read_uint(r, &pos, &u1)) {
+                ok = false;
+                break;
+            }
+            if (u1) {
+                pi->push_quantifier_scope(pi);
+            }
+            for (i = 0; ok && i < u1; ++i) {
+                ok = read_id(r, &pos, r->term_offsets_, &u2) &&
+                    declare_bound_var(r, pi, u2, &term);
+                smtlib2_vector_push(tmp, (intptr_t)term);
+            }
+            if (ok && (ok = read_id(r, &pos, r->sort_offsets_, &u2) &&
+                       build_sort(r, pi, u2, NULL, &sort) &&
+                       read_id(r, &pos, r->term_offsets_, &u1) &&
+                       build_term(r, pi, u1, &term))) {
+                pi->define_function(pi, s1, smtlib2_vector_size(tmp) ? tmp : NULL,
+                                    sort, term);
+            }
+            if (smtlib2_vector_size(tmp)) {
+                pi->pop_quantifier_scope(pi);
+                backtrack(r, mark);
+            }
+        }
+            break;
+        case SMTLIB2_BIN_PUSH:
+            if ((ok = read_int(r, &pos, &i1))) {
+                for (i = 0; i < (uint64_t)(i1 > 0 ? i1 : 0); ++i) {
+                    smtlib2_vector_push(r->marks_,
+                                        (intptr_t)smtlib2_vector_size(r->trail_));
+                }
+                pi->push(pi, (int)i1);
+            }
+            break;
+        case SMTLIB2_BIN_POP:
+            if ((ok = read_int(r, &pos, &i1))) {
+                size_t mark = (size_t)-1;
+                for (i = 0; i < (uint64_t)(i1 > 0 ? i1 : 0) &&
+                         smtlib2_vector_size(r->marks_) > 0; ++i) {
+                    mark = (size_t)smtlib2_vector_last(r->marks_);
+                    smtlib2_vector_pop(r->marks_);
+                }
+                pi->pop(pi, (int)i1);
+                if (mark != (size_t)-1) {
+                    backtrack(r, mark);
+                }
+            }
+            break;
+        case SMTLIB2_BIN_RESET_ASSERTIONS:
+        case SMTLIB2_BIN_RESET:
+            /* the define-funs of all the levels are forgotten */
+            smtlib2_vector_clear(r->marks_);
+            backtrack(r, 0);
+            if (op == SMTLIB2_BIN_RESET) {
+                pi->reset(pi);
+            } else {
+                pi->reset_assertions(pi);
+            }
+            break;
+        case SMTLIB2_BIN_ASSERT:
+            if ((ok = read_id(r, &pos, r->term_offsets_, &u1) &&
+                 build_term(r, pi, u1, &term))) {
+                pi->assert_formula(pi, term);
+            }
+            break;
+        case SMTLIB2_BIN_CHECK_SAT: pi->check_sat(pi); break;
+        case SMTLIB2_BIN_GET_ASSERTIONS: pi->get_assertions(pi); break;
+        case SMTLIB2_BIN_GET_UNSAT_CORE: pi->get_unsat_core(pi); break;
+        case SMTLIB2_BIN_GET_PROOF: pi->get_proof(pi); break;
+        case SMTLIB2_BIN_GET_ASSIGNMENT: pi->get_assignment(pi); break;
+        case SMTLIB2_BIN_SET_OPTION_STR:
+            if ((ok = read_symbol(r, &pos, &s1) && read_symbol(r, &pos, &s2))) {
+                pi->set_str_option(pi, s1, s2);
+            }
+            break;
+        case SMTLIB2_BIN_SET_OPTION_INT:
+            if ((ok = read_symbol(r, &pos, &s1) && read_int(r, &pos, &i1))) {
+                pi->set_int_option(pi, s1, (int)i1);
+            }
+            break;
+        case SMTLIB2_BIN_SET_OPTION_RAT:
+            if ((ok = read_symbol(r, &pos, &s1))) {
+                uint64_t bits = 0;
+                double d;
+                if (r->size_ - pos < 8) {
+                    ok = format_error(r, "truncated option value");
+                    break;
+                }
+                for (i = 0; i < 8; ++i) {
+                    bits |= ((uint64_t)r->data_[pos++]) << (8 * i);
+                }
+                memcpy(&d, &bits, sizeof(d));
+                pi->set_rat_option(pi, s1, d);
+            }
+            break;
+        case SMTLIB2_BIN_GET_INFO:
+            if ((ok = read_symbol(r, &pos, &s1))) {
+                pi->get_info(pi, s1);
+            }
+            break;
+        case SMTLIB2_BIN_SET_INFO:
+            if ((ok = read_symbol(r, &pos, &s1) && read_symbol(r, &pos, &s2))) {
+                pi->set_info(pi, s1, s2);
+            }
+            break;
+        case SMTLIB2_BIN_GET_VALUE:
+            if ((ok = read_uint(r, &pos, &u1))) {
+                for (i = 0; ok && i < u1; ++i) {
+                    if ((ok = read_symbol(r, &pos, &s1))) {
+                        smtlib2_vector_push(
+                            tmp, (intptr_t)smtlib2_lazy_term_new(
+                                smtlib2_strdup(s1), strlen(s1), 0, 0));
+                    }
+                }
+                if (ok) {
+                    pi->get_value(pi, tmp);
+                }
+                for (i = 0; i < smtlib2_vector_size(tmp); ++i) {
+                    smtlib2_lazy_term_delete(
+                        (smtlib2_lazy_term *)smtlib2_vector_at(tmp, i));
+                }
+            }
+            break;
+        case SMTLIB2_BIN_EXIT:
+            pi->exit(pi);
+            break;
+        default:
+            ok = format_error(r, "unknown record");
+        }
+
+        if (ok && is_command && ap) {
+            if (ap->exiting_) {
+                break;
+            }
+            smtlib2_abstract_parser_print_response(ap);
+            smtlib2_abstract_parser_reset_response(ap);
+        }
+    }
+
+    smtlib2_vector_delete(tmp);
+    r->pos_ = pos;
+    return ok;
+}
@@ -35,17 +35,39 @@ not the header*/
 #define YY_NO_UNISTD_H
 #include "smtlib2flexlexer.h"
 #undef YY_NO_UNISTD_H
+#include "smtparser/smtlib2scanner_private.h"
+#include "smtparser/smtlib2memory.h"
 
 #include <limits.h>
 #include <assert.h>
 
 #define YYMAXDEPTH LONG_MAX
+#define YYMALLOC smtlib2_grammar_malloc
+#define YYFREE smtlib2_free
 #define YYLTYPE_IS_TRIVIAL 1
 
 void smtlib2_parser_error(YYLTYPE *yylloc, yyscan_t scanner,
                           smtlib2_parser_interface *parser,
                           const char *s);
 
+/* the tokens, straight from the lexer or from the thread running it (see
+ * smtlib2_scanner_start_pipeline) */
+extern int smtlib2_scanner_lex(YYSTYPE *lval, YYLTYPE *lloc, yyscan_t scanner);
+
+/* the lexer, wrapped to fill the information about the current command when
+ * the scanner tracks it */
+static int smtlib2_parser_tracked_lex(YYSTYPE *lval, YYLTYPE *lloc,
+                                      yyscan_t scanner);
+#undef yylex
+#define yylex smtlib2_parser_tracked_lex
+
+/* the allocations of the grammar, accounted to SMTLIB2_MEM_GRAMMAR. The
+ * vectors get some room already, so that their growth is accounted there as
+ * well */
+static void *smtlib2_grammar_malloc(size_t size);
+static char *smtlib2_grammar_strdup(const char *s);
+static smtlib2_vector *smtlib2_grammar_vector_new(void);
+
 /*
  * Stores information about an identifier. Used to handle type annotations and
  * indexed identifiers, without supporting such things in the core solver
@@ -90,6 +112,7 @@ smtlib2_term smtlib2_make_term_from_identifier(
     smtlib2_vector *attributelist;
     smtlib2_vector *stringlist;
     smtlib2_vector *intlist;
+    smtlib2_lazy_term *lazyterm;
 };
 
 
@@ -103,7 +126,9 @@ smtlib2_term smtlib2_make_term_from_identifier(
 %token <string> STRING
 %token <string> SYMBOL
 %token <string> KEYWORD
+%token <lazyterm> LAZY_TERM
 %token TK_EOF
+%token TK_START_TERMS
 
 %token TK_AS            "as"
 %token TK_UNDERSCORE    "_"
@@ -119,6 +144,8 @@ smtlib2_term smtlib2_make_term_from_identifier(
 %token TK_DEFINE_FUN           "define-fun"
 %token TK_PUSH                 "push"
 %token TK_POP                  "pop"
+%token TK_RESET_ASSERTIONS     "reset-assertions"
+%token TK_RESET                "reset"
 %token TK_ASSERT               "assert"
 %token TK_CHECK_SAT            "check-sat"
 %token TK_GET_ASSERTIONS       "get-assertions"
@@ -131,7 +158,6 @@ smtlib2_term smtlib2_make_term_from_identifier(
 %token TK_GET_MODEL            "get-model"
 %token TK_GET_VALUE            "get-value"
 %token TK_EXIT                 "exit"
-%token TK_INTERNAL_PARSE_TERMS ".internal-parse-terms"
 
 %type <string> logic_name
 %type <sort> a_sort
@@ -156,10 +182,19 @@ smtlib2_term smtlib2_make_term_from_identifier(
 %type <stringlist> attribute_value_list
 %type <attributelist> term_attribute_list
 
-%type <string> verbatim_term
 %type <stringlist> verbatim_term_list
 
-%destructor { free($$); } BINCONSTANT HEXCONSTANT RATCONSTANT NUMERAL SYMBOL KEYWORD STRING logic_name
+%destructor { smtlib2_free($$); } BINCONSTANT HEXCONSTANT RATCONSTANT NUMERAL
+%destructor { smtlib2_free($$); } SYMBOL KEYWORD STRING logic_name
+%destructor { smtlib2_lazy_term_delete($$); } LAZY_TERM
+%destructor {
+    size_t i;
+    for (i = 0; i < smtlib2_vector_size($$); ++i) {
+        smtlib2_lazy_term_delete(
+            (smtlib2_lazy_term *)smtlib2_vector_at($$, i));
+    }
+    smtlib2_vector_delete($$);
+} verbatim_term_list
 
 %destructor { smtlib2_vector_delete($$); } term_list
 %destructor { smtlib2_vector_delete($$); } sort_list
@@ -169,12 +204,27 @@ smtlib2_term smtlib2_make_term_from_identifier(
 %destructor { smtlib2_indexed_identifier_delete((smtlib2_indexed_identifier *)$$); } term_symbol
 %destructor { smtlib2_indexed_identifier_delete((smtlib2_indexed_identifier *)$$); } term_unqualified_symbol
 %destructor { smtlib2_vector_delete($$); } term_attribute_list
-%destructor { free($$[0]); free($$[1]); free($$); } term_attribute
+%destructor {
+    smtlib2_free($$[0]); smtlib2_free($$[1]); smtlib2_free($$);
+} term_attribute
 
-%start single_command
+%start parser_input
 
 %%
 
+/* TK_START_TERMS is never produced by the lexer for the input text: it is
+ * emitted first when the scanner is in term-only mode (see smtlib2_parse_terms)
+ */
+parser_input :
+  single_command
+| TK_START_TERMS term_list
+  {
+      parser->set_internal_parsed_terms(parser, $2);
+      smtlib2_vector_delete($2);
+      YYACCEPT;
+  }
+;
+
 single_command : command
   {
       YYACCEPT;
@@ -189,6 +239,8 @@ command :
 | cmd_define_fun
 | cmd_push
 | cmd_pop
+| cmd_reset_assertions
+| cmd_reset
 | cmd_assert
 | cmd_check_sat
 | cmd_get_assertions
@@ -200,7 +252,6 @@ command :
 | cmd_get_assignment
 | cmd_get_value
 | cmd_exit
-| cmd_internal_parse_terms
 | cmd_error
 ;
 
@@ -214,7 +265,7 @@ cmd_error :
 cmd_set_logic : '(' TK_SET_LOGIC logic_name ')'
   {
       parser->set_logic(parser, $3);
-      free($3);
+      smtlib2_free($3);
   }
 ;
 
@@ -223,8 +274,8 @@ cmd_declare_sort : '(' TK_DECLARE_SORT SYMBOL NUMERAL ')'
   {
       int n = atoi($4);
       parser->declare_sort(parser, $3, n);
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 ;
 
@@ -233,14 +284,14 @@ cmd_define_sort :
   '(' TK_DEFINE_SORT SYMBOL '(' ')' a_sort ')'
   {
       parser->define_sort(parser, $3, NULL, $6);
-      free($3);
+      smtlib2_free($3);
   }
 | '(' TK_DEFINE_SORT SYMBOL '(' sort_param_list ')' a_sort ')'
   {
       parser->define_sort(parser, $3, $5, $7);
       parser->pop_sort_param_scope(parser);
       smtlib2_vector_delete($5);
-      free($3);
+      smtlib2_free($3);
   }
 ;
 
@@ -250,7 +301,7 @@ cmd_declare_fun :
   {
       smtlib2_sort tp = $6;
       parser->declare_function(parser, $3, tp);
-      free($3);
+      smtlib2_free($3);
   }
 | '(' TK_DECLARE_FUN SYMBOL '(' sort_list ')' a_sort ')'
   {
@@ -259,7 +310,7 @@ cmd_declare_fun :
       smtlib2_vector_push($5, (intptr_t)tp);
       tp = parser->make_function_sort(parser, $5);
       parser->declare_function(parser, $3, tp);
-      free($3);
+      smtlib2_free($3);
       smtlib2_vector_delete($5);
   }
 ;
@@ -268,13 +319,13 @@ cmd_define_fun :
   '(' TK_DEFINE_FUN SYMBOL '(' ')' a_sort a_term ')'
   {
       parser->define_function(parser, $3, NULL, $6, $7);
-      free($3);
+      smtlib2_free($3);
   }
 | '(' TK_DEFINE_FUN SYMBOL '(' quant_var_list ')' a_sort a_term ')'
   {
       parser->define_function(parser, $3, $5, $7, $8);
       parser->pop_quantifier_scope(parser);
-      free($3);
+      smtlib2_free($3);
       smtlib2_vector_delete($5);
   }
 ;
@@ -283,7 +334,7 @@ cmd_define_fun :
 cmd_push : '(' TK_PUSH NUMERAL ')'
   {
       int n = atoi($3);
-      free($3);
+      smtlib2_free($3);
       parser->push(parser, n);
   }
 ;
@@ -292,17 +343,35 @@ cmd_push : '(' TK_PUSH NUMERAL ')'
 cmd_pop : '(' TK_POP NUMERAL ')'
   {
       int n = atoi($3);
-      free($3);
+      smtlib2_free($3);
       parser->pop(parser, n);
   }
 ;
 
 
+cmd_reset_assertions : '(' TK_RESET_ASSERTIONS ')'
+  {
+      parser->reset_assertions(parser);
+  }
+;
+
+
+cmd_reset : '(' TK_RESET ')'
+  {
+      parser->reset(parser);
+  }
+;
+
+
 cmd_assert :
   '(' TK_ASSERT a_term ')'
   {
       parser->assert_formula(parser, $3);
   }
+| '(' TK_ASSERT LAZY_TERM ')'
+  {
+      parser->assert_lazy_formula(parser, $3);
+  }
 ;
 
 
@@ -339,15 +408,15 @@ cmd_set_option :
   {
       int n = atoi($4);
       parser->set_int_option(parser, $3, n);
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 | '(' TK_SET_OPTION KEYWORD RATCONSTANT ')'
   {
       double n = atof($4);
       parser->set_rat_option(parser, $3, n);
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 | '(' TK_SET_OPTION KEYWORD SYMBOL ')'
   {
@@ -358,18 +427,18 @@ cmd_set_option :
       } else if (strcmp($4, "none") == 0) {
           parser->set_rat_option(parser, $3, 0);
       } else {
-          free($4);
-          free($3);
+          smtlib2_free($4);
+          smtlib2_free($3);
           YYERROR;
       }
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 | '(' TK_SET_OPTION KEYWORD STRING ')'
   {
       parser->set_str_option(parser, $3, $4);
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 ;
 
@@ -377,7 +446,7 @@ cmd_set_option :
 cmd_get_info : '(' TK_GET_INFO KEYWORD ')'
   {
       parser->get_info(parser, $3);
-      free($3);
+      smtlib2_free($3);
   }
 ;
 
@@ -386,8 +455,8 @@ cmd_set_info :
   '(' TK_SET_INFO KEYWORD info_argument ')'
   {
       parser->set_info(parser, $3, $4);
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 ;
 
@@ -424,8 +493,8 @@ cmd_get_value : '(' TK_GET_VALUE '(' verbatim_term_list ')' ')'
       size_t i;
       parser->get_value(parser, $4);
       for (i = 0; i < smtlib2_vector_size($4); ++i) {
-          char *s = (char *)smtlib2_vector_at($4, i);
-          free(s);
+          smtlib2_lazy_term_delete(
+              (smtlib2_lazy_term *)smtlib2_vector_at($4, i));
       }
       smtlib2_vector_delete($4);
   }
@@ -439,13 +508,6 @@ cmd_exit : '(' TK_EXIT ')'
 ;
 
 
-cmd_internal_parse_terms : '(' TK_INTERNAL_PARSE_TERMS '(' term_list ')' ')'
-  {
-      parser->set_internal_parsed_terms(parser, $4);
-      smtlib2_vector_delete($4);
-  }
-;
-
     
 
 a_term :
@@ -468,9 +530,9 @@ annotated_term :
       parser->annotate_term(parser, $$, $4);
       for (i = 0; i < smtlib2_vector_size($4); ++i) {
           char **pair = (char **)smtlib2_vector_at($4, i);
-          free(pair[0]);
-          free(pair[1]);
-          free(pair);
+          smtlib2_free(pair[0]);
+          smtlib2_free(pair[1]);
+          smtlib2_free(pair);
       }
       smtlib2_vector_delete($4);
   }
@@ -540,12 +602,12 @@ term_unqualified_symbol :
   SYMBOL
   {
       $$ = smtlib2_indexed_identifier_new($1, NULL, NULL);
-      free($1);
+      smtlib2_free($1);
   }
 | '(' TK_UNDERSCORE SYMBOL num_list ')'
   {
       $$ = smtlib2_indexed_identifier_new($3, $4, NULL);
-      free($3);
+      smtlib2_free($3);
       /* $$ takes ownership of $4, so we don't delete it here */
   }
 ;
@@ -555,31 +617,31 @@ term_num_constant :
   NUMERAL
   {
       $$ = parser->make_number_term(parser, $1, 0, 10);
-      free($1);
+      smtlib2_free($1);
   }
 | RATCONSTANT
   {
       $$ = parser->make_number_term(parser, $1, 0, 10);
-      free($1);
+      smtlib2_free($1);
   }
 | BINCONSTANT
   {
       const char *s = $1 + 2; /* skip the "#b" prefix */
       $$ = parser->make_number_term(parser, s, strlen(s), 2);
-      free($1);
+      smtlib2_free($1);
   }
 | HEXCONSTANT
   {
       const char *s = $1 + 2; /* skip the "#x" prefix */
       $$ = parser->make_number_term(parser, s, 4 * strlen(s), 16);
-      free($1);
+      smtlib2_free($1);
   }
 | '(' TK_UNDERSCORE BVCONSTANT NUMERAL ')'
   {
       const char *s = $3 + 2; /* skip the "bv" prefix */
       $$ = parser->make_number_term(parser, s, atoi($4), 10);
-      free($4);
-      free($3);
+      smtlib2_free($4);
+      smtlib2_free($3);
   }
 ;
 
@@ -587,7 +649,7 @@ term_num_constant :
 term_attribute_list :
   term_attribute
   {
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       smtlib2_vector_push($$, (intptr_t)$1);
   }
 | term_attribute_list term_attribute
@@ -601,7 +663,7 @@ term_attribute_list :
 term_attribute :
   KEYWORD attribute_value
   {
-      $$ = (char **)malloc(sizeof(char *) * 2);
+      $$ = (char **)smtlib2_grammar_malloc(sizeof(char *) * 2);
       $$[0] = $1;
       $$[1] = $2;
   }
@@ -615,11 +677,11 @@ attribute_value :
   }
 | TK_LET
   {
-      $$ = smtlib2_strdup("let");
+      $$ = smtlib2_grammar_strdup("let");
   }
 | '(' ')'
   {
-      $$ = smtlib2_strdup("()");
+      $$ = smtlib2_grammar_strdup("()");
   }
 | '(' attribute_value_list ')'
   {
@@ -632,7 +694,7 @@ attribute_value :
       }
       howmany += 2 /* '(' and ')' */ +
           (smtlib2_vector_size($2)-1) /* ' 's */ + 1; /* '\0' */
-      $$ = (char *)malloc(sizeof(char) * howmany);
+      $$ = (char *)smtlib2_grammar_malloc(sizeof(char) * howmany);
 
       /* concatenate everything together */
       s = $$;
@@ -645,7 +707,7 @@ attribute_value :
               *s++ = *s2++;
           }
           *s++ = ' ';
-          free(s3);
+          smtlib2_free(s3);
       }
       *(s-1) = ')';
       *s = '\0';
@@ -658,7 +720,7 @@ attribute_value :
 attribute_value_list :
   attribute_value
   {
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       smtlib2_vector_push($$, (intptr_t)$1);
   }
 | attribute_value_list attribute_value
@@ -672,17 +734,17 @@ attribute_value_list :
 num_list :
   NUMERAL
   {
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       int n = atoi($1);
       smtlib2_vector_push($$, n);
-      free($1);
+      smtlib2_free($1);
   }
 | num_list NUMERAL
   {
       int n = atoi($2);
       smtlib2_vector_push($1, n);
       $$ = $1;
-      free($2);
+      smtlib2_free($2);
   }
 ;
 
@@ -691,17 +753,17 @@ int_list :
   NUMERAL
   {
       int n;
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       n = atoi($1);
       smtlib2_vector_push($$, n);
-      free($1);
+      smtlib2_free($1);
   }
 | int_list NUMERAL
   {
       int n = atoi($2);
       smtlib2_vector_push($1, n);
       $$ = $1;
-      free($2);
+      smtlib2_free($2);
   }
 ;
 
@@ -709,7 +771,7 @@ int_list :
 term_list :
   a_term
   {
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       smtlib2_vector_push($$, (intptr_t)$1);
   }
 | term_list a_term
@@ -725,11 +787,11 @@ quant_var_list :
   {
       intptr_t t;
       parser->push_quantifier_scope(parser);
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       parser->declare_variable(parser, $2, $3);
       t = (intptr_t)parser->make_term(parser, $2, $3, NULL, NULL);
       smtlib2_vector_push($$, t);
-      free($2);
+      smtlib2_free($2);
   }
 | quant_var_list '(' SYMBOL a_sort ')'
   {
@@ -737,7 +799,7 @@ quant_var_list :
       parser->declare_variable(parser, $3, $4);
       t = (intptr_t)parser->make_term(parser, $3, $4, NULL, NULL);
       smtlib2_vector_push($1, t);
-      free($3);
+      smtlib2_free($3);
       $$ = $1;
   }
 ;
@@ -759,7 +821,7 @@ let_bindings :
 let_binding : '(' SYMBOL a_term ')'
   {
       parser->define_let_binding(parser, $2, $3);
-      free($2);
+      smtlib2_free($2);
   }
 ;
 
@@ -769,10 +831,10 @@ logic_name :
   { $$ = $1; }
 | SYMBOL '[' NUMERAL ']'
   {
-      $$ = (char *)(malloc(strlen($1) + strlen($3) + 2 + 1));
+      $$ = (char *)smtlib2_grammar_malloc(strlen($1) + strlen($3) + 2 + 1);
       sprintf($$, "%s[%s]", $1, $3);
-      free($1);
-      free($3);
+      smtlib2_free($1);
+      smtlib2_free($3);
   }
 ;
 
@@ -780,7 +842,7 @@ logic_name :
 sort_list :
   a_sort
   {
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       smtlib2_vector_push($$, (intptr_t)$1);
   }
 | sort_list a_sort
@@ -795,29 +857,32 @@ a_sort :
   SYMBOL
   {
       $$ = parser->make_sort(parser, $1, NULL);
-      free($1);
+      smtlib2_free($1);
   }
 | '(' TK_UNDERSCORE SYMBOL int_list ')'
   {
       $$ = parser->make_sort(parser, $3, $4);
       smtlib2_vector_delete($4);
-      free($3);
+      smtlib2_free($3);
   }
 | '(' SYMBOL sort_list ')'
   {
       $$ = parser->make_parametric_sort(parser, $2, $3);
       smtlib2_vector_delete($3);
-      free($2);
+      smtlib2_free($2);
   }
 ;
 
 
 sort_param_list : 
-  a_sort_param
   {
+      /* before the first parameter, so that it is in the scope as well */
       parser->push_sort_param_scope(parser);
-      $$ = smtlib2_vector_new();
-      smtlib2_vector_push($$, (intptr_t)$1);
+  }
+  a_sort_param
+  {
+      $$ = smtlib2_grammar_vector_new();
+      smtlib2_vector_push($$, (intptr_t)$2);
   }
 | sort_param_list a_sort_param
   {
@@ -831,18 +896,18 @@ a_sort_param : SYMBOL
   {
       parser->declare_sort(parser, $1, 0);
       $$ = parser->make_sort(parser, $1, NULL);
-      free($1);
+      smtlib2_free($1);
   }
 ;
 
 
 verbatim_term_list :
-  verbatim_term
+  LAZY_TERM
   {
-      $$ = smtlib2_vector_new();
+      $$ = smtlib2_grammar_vector_new();
       smtlib2_vector_push($$, (intptr_t)$1);
   }
-| verbatim_term_list verbatim_term
+| verbatim_term_list LAZY_TERM
   {
       $$ = $1;
       smtlib2_vector_push($$, (intptr_t)$2);
@@ -850,27 +915,16 @@ verbatim_term_list :
 ;
 
 
-verbatim_term : 
-  attribute_value
-  {
-      $$ = $1;
-  }
-| KEYWORD
-  {
-      $$ = $1;
-  }
-;
-
-
 %%
 
 
 smtlib2_indexed_identifier *smtlib2_indexed_identifier_new(
     const char *n, smtlib2_vector *i, smtlib2_sort t)
 {
-    smtlib2_indexed_identifier *ret = (smtlib2_indexed_identifier *)malloc(
-        sizeof(smtlib2_indexed_identifier));
-    ret->name = smtlib2_strdup(n);
+    smtlib2_indexed_identifier *ret =
+        (smtlib2_indexed_identifier *)smtlib2_grammar_malloc(
+            sizeof(smtlib2_indexed_identifier));
+    ret->name = smtlib2_grammar_strdup(n);
     ret->idx = i;
     ret->tp = t;
 
@@ -880,8 +934,11 @@ smtlib2_indexed_identifier *smtlib2_indexed_identifier_new(
 
 void smtlib2_indexed_identifier_delete(smtlib2_indexed_identifier *i)
 {
-    free(i->name);
-    free(i);
+    smtlib2_free(i->name);
+    if (i->idx) {
+        smtlib2_vector_delete(i->idx);
+    }
+    smtlib2_free(i);
 }
 
 
@@ -899,3 +956,71 @@ void smtlib2_parser_error(YYLTYPE *yylloc, yyscan_t scanner,
 {
     parser->handle_error(parser, s);
 }
+
+
+static int smtlib2_parser_tracked_lex(YYSTYPE *lval, YYLTYPE *lloc,
+                                      yyscan_t scanner)
+{
+    smtlib2_scanner *s = (smtlib2_scanner *)smtlib2_parser_get_extra(scanner);
+    smtlib2_command_info *info = s->command_;
+    smtlib2_memory_tag tag;
+    smtlib2_ticks start;
+    int tok;
+
+    if (!info) {
+        tag = smtlib2_set_memory_tag(SMTLIB2_MEM_TOKENS);
+        tok = smtlib2_scanner_lex(lval, lloc, scanner);
+        smtlib2_set_memory_tag(tag);
+        return tok;
+    }
+
+    start = smtlib2_ticks_now();
+    tag = smtlib2_set_memory_tag(SMTLIB2_MEM_TOKENS);
+    tok = smtlib2_scanner_lex(lval, lloc, scanner);
+    smtlib2_set_memory_tag(tag);
+    if (tok <= 0) {
+        return tok;
+    }
+    if (info->tokens_++ == 0) {
+        /* the time spent waiting for the command is not counted */
+        info->start_ = smtlib2_ticks_now();
+        smtlib2_scanner_token_position(s, &(info->offset_), &(info->line_));
+        if (info->offset_ > 0) {
+            --info->offset_;
+        }
+    } else {
+        if (info->tokens_ == 2) {
+            info->name_ = yytname[YYTRANSLATE(tok)];
+        }
+        info->lex_ticks_ += smtlib2_ticks_now() - start;
+    }
+    return tok;
+}
+
+
+static void *smtlib2_grammar_malloc(size_t size)
+{
+    smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_GRAMMAR);
+    void *ret = smtlib2_malloc(size);
+    smtlib2_set_memory_tag(tag);
+    return ret;
+}
+
+
+static char *smtlib2_grammar_strdup(const char *s)
+{
+    smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_GRAMMAR);
+    char *ret = smtlib2_strdup(s);
+    smtlib2_set_memory_tag(tag);
+    return ret;
+}
+
+
+static smtlib2_vector *smtlib2_grammar_vector_new(void)
+{
+    smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_GRAMMAR);
+    smtlib2_vector *ret = smtlib2_vector_new();
+    smtlib2_vector_reserve(ret, 4);
+    smtlib2_set_memory_tag(tag);
+    return ret;
+}
@@ -0,0 +1,420 @@
+/* -*- C -*-
+ *
+ * Index of the top-level commands of SMT-LIB v2 scripts
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2cmdindex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SMTLIB2_CMDINDEX_SSE2
+#endif
+
+
+struct smtlib2_command_index {
+    const char *data_;
+    size_t size_;
+    bool mapped_;
+    smtlib2_vector *begin_;
+    smtlib2_vector *end_;
+    smtlib2_charbuf *kinds_;
+};
+
+
+static const char *smtlib2_command_names[] = {
+    NULL,
+    "set-logic",
+    "declare-sort",
+    "define-sort",
+    "declare-fun",
+    "define-fun",
+    "push",
+    "pop",
+    "assert",
+    "check-sat",
+    "get-assertions",
+    "get-unsat-core",
+    "get-proof",
+    "set-option",
+    "get-info",
+    "set-info",
+    "get-assignment",
+    "get-model",
+    "get-value",
+    "exit",
+    "reset-assertions",
+    "reset"
+};
+
+#define SMTLIB2_NUM_COMMAND_KINDS \
+    (sizeof(smtlib2_command_names) / sizeof(smtlib2_command_names[0]))
+
+
+/* the bytes that can change the nesting depth or the lexical state */
+static const char smtlib2_special_chars[256] = {
+    ['('] = 1, [')'] = 1, ['"'] = 1, ['|'] = 1, [';'] = 1
+};
+
+/* the bytes that end a symbol or keyword */
+static const char smtlib2_delimiters[256] = {
+    [' '] = 1, ['\t'] = 1, ['\n'] = 1, ['\r'] = 1,
+    ['('] = 1, [')'] = 1, ['"'] = 1, ['|'] = 1, [';'] = 1
+};
+
+
+static void smtlib2_command_index_build(smtlib2_command_index *idx);
+static size_t skip_special(const char *data, size_t pos, size_t size);
+static size_t scan_command(const char *data, size_t pos, size_t size);
+static size_t skip_string(const char *data, size_t pos, size_t size);
+static size_t skip_until(const char *data, size_t pos, size_t size, char c);
+static smtlib2_command_kind command_kind(const char *data, size_t pos,
+                                         size_t size);
+
+
+const char *smtlib2_command_kind_name(smtlib2_command_kind kind)
+{
+    if ((size_t)kind < SMTLIB2_NUM_COMMAND_KINDS) {
+        return smtlib2_command_names[kind];
+    }
+    return NULL;
+}
+
+
+smtlib2_command_index *smtlib2_command_index_new(const char *data,
+                                                 size_t size)
+{
+    smtlib2_command_index *ret =
+        (smtlib2_command_index *)smtlib2_malloc(sizeof(smtlib2_command_index));
+    ret->data_ = data;
+    ret->size_ = size;
+    ret->mapped_ = false;
+    ret->begin_ = smtlib2_vector_new();
+    ret->end_ = smtlib2_vector_new();
+    ret->kinds_ = smtlib2_charbuf_new();
+
+    smtlib2_command_index_build(ret);
+
+    return ret;
+}
+
+
+smtlib2_command_index *smtlib2_command_index_new_from_file(
+    const char *filename)
+{
+    smtlib2_command_index *ret;
+    size_t size;
+    const char *data = smtlib2_map_file(filename, &size);
+    if (!data) {
+        return NULL;
+    }
+    ret = smtlib2_command_index_new(data, size);
+    ret->mapped_ = true;
+    return ret;
+}
+
+
+void smtlib2_command_index_delete(smtlib2_command_index *idx)
+{
+    if (idx->mapped_) {
+        smtlib2_unmap_file(idx->data_, idx->size_);
+    }
+    smtlib2_charbuf_delete(idx->kinds_);
+    smtlib2_vector_delete(idx->end_);
+    smtlib2_vector_delete(idx->begin_);
+    smtlib2_free(idx);
+}
+
+
+size_t smtlib2_command_index_size(smtlib2_command_index *idx)
+{
+    return smtlib2_vector_size(idx->begin_);
+}
+
+
+smtlib2_command_kind smtlib2_command_index_kind(smtlib2_command_index *idx,
+                                                size_t i)
+{
+    return (smtlib2_command_kind)smtlib2_charbuf_array(idx->kinds_)[i];
+}
+
+
+size_t smtlib2_command_index_begin(smtlib2_command_index *idx, size_t i)
+{
+    return (size_t)smtlib2_vector_at(idx->begin_, i);
+}
+
+
+size_t smtlib2_command_index_end(smtlib2_command_index *idx, size_t i)
+{
+    return (size_t)smtlib2_vector_at(idx->end_, i);
+}
+
+
+const char *smtlib2_command_index_data(smtlib2_command_index *idx)
+{
+    return idx->data_;
+}
+
+
+size_t smtlib2_command_index_find(smtlib2_command_index *idx, size_t offset)
+{
+    size_t lo = 0, hi = smtlib2_vector_size(idx->end_);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((size_t)smtlib2_vector_at(idx->end_, mid) <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+
+void smtlib2_abstract_parser_parse_commands(smtlib2_abstract_parser *p,
+                                            smtlib2_command_index *idx,
+                                            size_t first, size_t last)
+{
+    if (first < last && last <= smtlib2_command_index_size(idx)) {
+        size_t b = smtlib2_command_index_begin(idx, first);
+        size_t e = smtlib2_command_index_end(idx, last-1);
+        smtlib2_abstract_parser_parse_buffer(p, idx->data_ + b, e - b);
+    }
+}
+
+
+size_t smtlib2_skip_blanks(const char *data, size_t pos, size_t size)
+{
+    while (pos < size) {
+        switch (data[pos]) {
+        case ' ': case '\t': case '\n': case '\r':
+            ++pos;
+            break;
+        case ';':
+            pos = skip_until(data, pos+1, size, '\n');
+            break;
+        default:
+            return pos;
+        }
+    }
+    return size;
+}
+
+
+size_t smtlib2_skip_sexpr(const char *data, size_t pos, size_t size)
+{
+    size_t begin = pos;
+
+    if (pos >= size) {
+        return size;
+    }
+    if (data[pos] == '(') {
+        return scan_command(data, pos+1, size);
+    }
+    while (pos < size && !smtlib2_delimiters[(unsigned char)data[pos]]) {
+        ++pos;
+    }
+    if (pos == begin) {
+        pos = skip_special(data, pos, size);
+    }
+    return pos;
+}
+
+
+static void smtlib2_command_index_build(smtlib2_command_index *idx)
+{
+    const char *data = idx->data_;
+    size_t size = idx->size_;
+    size_t pos = 0;
+
+    while (pos < size) {
+        size_t begin = pos;
+        smtlib2_command_kind kind = SMTLIB2_COMMAND_UNKNOWN;
+
+        switch (data[pos]) {
+        case ' ': case '\t': case '\n': case '\r':
+            ++pos;
+            continue;
+        case ';':
+            pos = skip_until(data, pos+1, size, '\n');
+            continue;
+        case '(':
+            kind = command_kind(data, pos+1, size);
+            pos = scan_command(data, pos+1, size);
+            break;
+        case ')':
+            ++pos;
+            break;
+        default:
+            /* stray tokens */
+            while (pos < size && !smtlib2_delimiters[(unsigned char)data[pos]]) {
+                ++pos;
+            }
+            if (pos == begin) {
+                pos = skip_special(data, pos, size);
+            }
+        }
+
+        smtlib2_vector_push(idx->begin_, (intptr_t)begin);
+        smtlib2_vector_push(idx->end_, (intptr_t)pos);
+        smtlib2_charbuf_push(idx->kinds_, (char)kind);
+    }
+}
+
+
+/* skips a string or quoted symbol starting at pos */
+static size_t skip_special(const char *data, size_t pos, size_t size)
+{
+    if (data[pos] == '"') {
+        return skip_string(data, pos+1, size);
+    } else if (data[pos] == '|') {
+        return skip_until(data, pos+1, size, '|');
+    }
+    return pos+1;
+}
+
+
+/*
+ * returns the position right after the parenthesis closing the command whose
+ * body starts at pos, or size if the command is not closed
+ */
+static size_t scan_command(const char *data, size_t pos, size_t size)
+{
+    size_t depth = 1;
+
+    while (pos < size) {
+#ifdef SMTLIB2_CMDINDEX_SSE2
+        /* skip whole blocks of 16 bytes that can't close the command */
+        const __m128i lpar = _mm_set1_epi8('(');
+        const __m128i rpar = _mm_set1_epi8(')');
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i bar = _mm_set1_epi8('|');
+        const __m128i semi = _mm_set1_epi8(';');
+        while (pos + 16 <= size) {
+            __m128i c = _mm_loadu_si128((const __m128i *)(data + pos));
+            unsigned int l = _mm_movemask_epi8(_mm_cmpeq_epi8(c, lpar));
+            unsigned int r = _mm_movemask_epi8(_mm_cmpeq_epi8(c, rpar));
+            unsigned int o = _mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(c, quote),
+                             _mm_or_si128(_mm_cmpeq_epi8(c, bar),
+                                          _mm_cmpeq_epi8(c, semi))));
+            size_t nr = (size_t)__builtin_popcount(r);
+            if (o == 0 && depth > nr) {
+                depth = depth + __builtin_popcount(l) - nr;
+                pos += 16;
+            } else {
+                unsigned int m = l | r | o;
+                if (m) {
+                    pos += __builtin_ctz(m);
+                } else {
+                    pos += 16;
+                }
+                break;
+            }
+        }
+#endif
+        while (pos < size && !smtlib2_special_chars[(unsigned char)data[pos]]) {
+            ++pos;
+        }
+        if (pos >= size) {
+            break;
+        }
+        switch (data[pos]) {
+        case '(':
+            ++depth;
+            ++pos;
+            break;
+        case ')':
+            ++pos;
+            if (--depth == 0) {
+                return pos;
+            }
+            break;
+        case ';':
+            pos = skip_until(data, pos+1, size, '\n');
+            break;
+        default:
+            pos = skip_special(data, pos, size);
+        }
+    }
+    return size;
+}
+
+
+/*
+ * returns the position right after the closing quote. As in the lexer, a
+ * quote preceded by a backslash doesn't end the string
+ */
+static size_t skip_string(const char *data, size_t pos, size_t size)
+{
+    size_t start = pos;
+    while (pos < size) {
+        const char *q = (const char *)memchr(data + pos, '"', size - pos);
+        if (!q) {
+            break;
+        }
+        pos = (size_t)(q - data) + 1;
+        if (pos - 1 == start || data[pos-2] != '\\') {
+            return pos;
+        }
+    }
+    return size;
+}
+
+
+/* returns the position right after the first occurrence of c */
+static size_t skip_until(const char *data, size_t pos, size_t size, char c)
+{
+    const char *q;
+    if (pos >= size) {
+        return size;
+    }
+    q = (const char *)memchr(data + pos, c, size - pos);
+    return q ? (size_t)(q - data) + 1 : size;
+}
+
+
+static smtlib2_command_kind command_kind(const char *data, size_t pos,
+                                         size_t size)
+{
+    size_t end, i;
+
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\t' ||
+                          data[pos] == '\n' || data[pos] == '\r')) {
+        ++pos;
+    }
+    end = pos;
+    while (end < size && !smtlib2_delimiters[(unsigned char)data[end]]) {
+        ++end;
+    }
+    for (i = 1; i < SMTLIB2_NUM_COMMAND_KINDS; ++i) {
+        const char *name = smtlib2_command_names[i];
+        if (strlen(name) == end - pos &&
+            memcmp(name, data + pos, end - pos) == 0) {
+            return (smtlib2_command_kind)i;
+        }
+    }
+    return SMTLIB2_COMMAND_UNKNOWN;
+}
@@ -0,0 +1,445 @@
+/* -*- C -*-
+ *
+ * Command-line driver for SMT-LIB v2 backends, with measurement modes
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "smtparser/smtlib2driver.h"
+#include "smtparser/smtlib2null.h"
+#include "smtparser/smtlib2queue.h"
+#include "smtparser/smtlib2scanner.h"
+#include "smtparser/smtlib2charbuf.h"
+#include "smtparser/smtlib2record.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+
+static const char *smtlib2_driver_mode_names[] = { "lex", "parse", "full" };
+
+
+static double smtlib2_driver_now(void)
+{
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+/* reads the whole stream in a malloc'ed buffer */
+static char *smtlib2_driver_read_all(FILE *in, size_t *size)
+{
+    smtlib2_charbuf *buf = smtlib2_charbuf_new();
+    char *ret;
+    size_t n = 0;
+
+    for (;;) {
+        size_t got;
+        smtlib2_charbuf_resize(buf, n + 65536);
+        got = fread(smtlib2_charbuf_array(buf) + n, 1, 65536, in);
+        n += got;
+        if (got < 65536) {
+            break;
+        }
+    }
+    smtlib2_charbuf_resize(buf, n + 1);
+    smtlib2_charbuf_array(buf)[n] = '\0';
+    *size = n;
+    ret = smtlib2_charbuf_array_release(buf);
+    smtlib2_charbuf_delete(buf);
+    return ret;
+}
+
+
+/* with stats, the callbacks of the backend are instrumented, and their
+ * statistics printed on standard error at the end. With a trace file, a
+ * timeline of the commands is written to it. With memory, the parser is
+ * created with an accounting allocator, whose report is printed at the end.
+ * With pipeline, the lexer runs on its own thread. With fork_join > 1, the
+ * asserts are parsed lazily, and big conjunctions with that many threads.
+ * With a memo cache, the check-sats are answered from it when possible.
+ * With a record file, the callbacks are recorded in it */
+static smtlib2_abstract_parser *smtlib2_driver_new_parser(
+    smtlib2_driver_newfun new_parser, bool stats, FILE *trace, bool memory,
+    bool pipeline, int fork_join, smtlib2_memo_cache *memo, FILE *record)
+{
+    smtlib2_abstract_parser *p;
+    if (memory) {
+        smtlib2_memory_accounting *a = smtlib2_memory_accounting_new(NULL);
+        smtlib2_allocator *prev =
+            smtlib2_set_allocator(smtlib2_memory_accounting_allocator(a));
+        p = new_parser();
+        smtlib2_set_allocator(prev);
+    } else {
+        p = new_parser();
+    }
+    if (memo) {
+        smtlib2_abstract_parser_set_memo(p, memo);
+    }
+    if (record) {
+        smtlib2_abstract_parser_set_recording(p, record);
+    }
+    if (stats) {
+        smtlib2_abstract_parser_enable_stats(p, true);
+    }
+    if (trace) {
+        smtlib2_abstract_parser_set_trace(p, trace);
+    }
+    smtlib2_abstract_parser_set_pipelined(p, pipeline);
+    if (fork_join > 1) {
+        smtlib2_abstract_parser_set_lazy_asserts(p, true);
+        smtlib2_abstract_parser_set_fork_join(p, fork_join);
+    }
+    return p;
+}
+
+
+static void smtlib2_driver_delete_parser(
+    smtlib2_abstract_parser *p, smtlib2_driver_deletefun delete_parser)
+{
+    smtlib2_parser_stats *s = smtlib2_abstract_parser_get_stats(p);
+    smtlib2_memory_accounting *a = smtlib2_memory_accounting_of(p->allocator_);
+    if (s) {
+        smtlib2_parser_stats_print(s, stderr);
+    }
+    if (a) {
+        smtlib2_memory_report r;
+        smtlib2_memory_accounting_report(a, &r);
+        smtlib2_memory_report_print(&r, stderr);
+    }
+    delete_parser(p);
+    if (a) {
+        smtlib2_memory_accounting_delete(a);
+    }
+}
+
+
+static void smtlib2_driver_measure(const char *data, size_t size,
+                                   smtlib2_driver_mode mode, bool stats,
+                                   FILE *trace, bool memory, bool pipeline,
+                                   bool queue, int fork_join,
+                                   smtlib2_memo_cache *memo, FILE *record,
+                                   smtlib2_driver_newfun new_parser,
+                                   smtlib2_driver_deletefun delete_parser)
+{
+    FILE *devnull;
+    size_t ntokens = 0;
+    int phase;
+
+#ifdef _WIN32
+    devnull = fopen("NUL", "w");
+#else
+    devnull = fopen("/dev/null", "w");
+#endif
+
+    for (phase = SMTLIB2_DRIVER_LEX; phase <= (int)mode; ++phase) {
+        double start = smtlib2_driver_now(), t;
+
+        switch (phase) {
+        case SMTLIB2_DRIVER_LEX: {
+            smtlib2_mstream *ms = smtlib2_mstream_new(data, size);
+            smtlib2_scanner *s = smtlib2_scanner_acquire((smtlib2_stream *)ms);
+            ntokens = smtlib2_scanner_count_tokens(s);
+            smtlib2_scanner_release(s);
+            smtlib2_mstream_delete(ms);
+        }
+            break;
+        case SMTLIB2_DRIVER_PARSE: {
+            smtlib2_null_parser *np = smtlib2_null_parser_new();
+            if (devnull) {
+                np->parent_.outstream_ = devnull;
+            }
+            smtlib2_abstract_parser_set_pipelined(&(np->parent_), pipeline);
+            smtlib2_abstract_parser_parse_buffer(&(np->parent_), data, size);
+            smtlib2_null_parser_delete(np);
+        }
+            break;
+        case SMTLIB2_DRIVER_FULL: {
+            smtlib2_abstract_parser *p =
+                smtlib2_driver_new_parser(new_parser, stats, trace, memory,
+                                          pipeline, fork_join, memo, record);
+            if (queue) {
+                smtlib2_queue_parse_buffer(p, data, size);
+            } else {
+                smtlib2_abstract_parser_parse_buffer(p, data, size);
+            }
+            smtlib2_driver_delete_parser(p, delete_parser);
+        }
+            break;
+        }
+
+        t = smtlib2_driver_now() - start;
+        fprintf(stderr, ";; %-5s %lu bytes, %lu tokens, %.4f s, %.2f MB/s\n",
+                smtlib2_driver_mode_names[phase], (unsigned long)size,
+                (unsigned long)ntokens, t,
+                t > 0 ? size / 1048576.0 / t : 0.0);
+    }
+
+    if (devnull) {
+        fclose(devnull);
+    }
+}
+
+
+/* replays a recording of the callbacks into a fresh backend, printing the
+ * time taken if measuring */
+static bool smtlib2_driver_replay(smtlib2_recording *r, size_t size,
+                                  bool measure, bool stats, FILE *trace,
+                                  bool memory, smtlib2_memo_cache *memo,
+                                  FILE *record,
+                                  smtlib2_driver_newfun new_parser,
+                                  smtlib2_driver_deletefun delete_parser)
+{
+    double start = smtlib2_driver_now(), t;
+    smtlib2_abstract_parser *p =
+        smtlib2_driver_new_parser(new_parser, stats, trace, memory, false, 0,
+                                  memo, record);
+    bool ok = smtlib2_abstract_parser_replay_recording(p, r);
+    smtlib2_driver_delete_parser(p, delete_parser);
+    t = smtlib2_driver_now() - start;
+
+    if (!ok) {
+        fprintf(stderr, "%s\n", smtlib2_recording_get_error_msg(r));
+    }
+    if (measure) {
+        fprintf(stderr, ";; %-5s %lu bytes, %.4f s, %.2f MB/s\n", "replay",
+                (unsigned long)size, t,
+                t > 0 ? size / 1048576.0 / t : 0.0);
+    }
+    return ok;
+}
+
+
+int smtlib2_driver_main(int argc, char **argv,
+                        smtlib2_driver_newfun new_parser,
+                        smtlib2_driver_deletefun delete_parser)
+{
+    bool measure = false;
+    bool stats = false;
+    bool memory = false;
+    bool pipeline = false;
+    bool queue = false;
+    bool replay = false;
+    int fork_join = 0;
+    FILE *trace = NULL;
+    FILE *record = NULL;
+    const char *memo_path = NULL;
+    size_t memo_max = 0;
+    smtlib2_memo_cache *memo = NULL;
+    smtlib2_driver_mode mode = SMTLIB2_DRIVER_FULL;
+    int i, first, ret = 0;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+        if (strncmp(argv[i], "--mode=", 7) == 0) {
+            const char *m = argv[i] + 7;
+            int j;
+            measure = false;
+            for (j = SMTLIB2_DRIVER_LEX; j <= SMTLIB2_DRIVER_FULL; ++j) {
+                if (strcmp(m, smtlib2_driver_mode_names[j]) == 0) {
+                    mode = (smtlib2_driver_mode)j;
+                    measure = true;
+                }
+            }
+            if (!measure) {
+                fprintf(stderr, "unknown mode `%s'\n", m);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (strcmp(argv[i], "--memory") == 0) {
+            memory = true;
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipeline = true;
+        } else if (strcmp(argv[i], "--queue") == 0) {
+            queue = true;
+        } else if (strncmp(argv[i], "--fork-join=", 12) == 0) {
+            fork_join = atoi(argv[i] + 12);
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay = true;
+        } else if (strncmp(argv[i], "--record=", 9) == 0 && !record) {
+            record = fopen(argv[i] + 9, "wb");
+            if (!record) {
+                fprintf(stderr, "can't open `%s' for writing\n",
+                        argv[i] + 9);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--memo=", 7) == 0) {
+            memo_path = argv[i] + 7;
+        } else if (strncmp(argv[i], "--memo-max=", 11) == 0) {
+            memo_max = (size_t)atol(argv[i] + 11);
+        } else if (strncmp(argv[i], "--trace=", 8) == 0 && !trace) {
+            trace = fopen(argv[i] + 8, "w");
+            if (!trace) {
+                fprintf(stderr, "can't open `%s' for writing\n",
+                        argv[i] + 8);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "USAGE: %s [--mode=lex|parse|full] [--stats] "
+                    "[--memory] [--pipeline] [--queue] [--fork-join=N] "
+                    "[--trace=FILE.json] [--memo=FILE [--memo-max=N]] "
+                    "[--record=FILE] [--replay] [INPUT.smt2 ...]\n"
+                    "(use `-' for standard input)\n", argv[0]);
+            return 1;
+        }
+    }
+    if (record && (argc - i > 1 || queue)) {
+        /* a recording holds the callbacks of a single parser, and needs to
+         * know where the commands end */
+        fprintf(stderr, "--record needs a single input, and can't be used "
+                "with --queue\n");
+        fclose(record);
+        if (trace) {
+            fclose(trace);
+        }
+        return 1;
+    }
+    if (trace && argc - i > 1) {
+        /* a trace file holds the timeline of a single parser */
+        fprintf(stderr, "--trace needs a single input\n");
+        fclose(trace);
+        return 1;
+    }
+    if (trace && queue) {
+        /* the backend is not traced when it runs on its own thread */
+        fprintf(stderr, "--trace can't be used with --queue\n");
+        fclose(trace);
+        return 1;
+    }
+
+    if (memo_path) {
+        memo = smtlib2_memo_cache_open(memo_path, memo_max);
+        if (!memo) {
+            fprintf(stderr, "can't use `%s' as a memo cache\n", memo_path);
+            if (trace) {
+                fclose(trace);
+            }
+            if (record) {
+                fclose(record);
+            }
+            return 1;
+        }
+    }
+
+    first = i;
+    for (; i < argc || i == first; ++i) {
+        FILE *in = stdin;
+        bool is_file = i < argc && strcmp(argv[i], "-") != 0;
+
+        if (replay) {
+            smtlib2_recording *r;
+            size_t size = 0;
+            char *data = NULL;
+            if (is_file) {
+                r = smtlib2_recording_new(argv[i]);
+            } else {
+                data = smtlib2_driver_read_all(stdin, &size);
+                r = smtlib2_recording_new_from_memory(data, size);
+            }
+            if (!r) {
+                fprintf(stderr, "`%s' is not a recording\n",
+                        is_file ? argv[i] : "-");
+                ret = 1;
+            } else {
+                if (is_file) {
+                    fprintf(stderr, ";; %s\n", argv[i]);
+                }
+                if (!smtlib2_driver_replay(r, size, measure, stats, trace,
+                                           memory, memo, record, new_parser,
+                                           delete_parser)) {
+                    ret = 1;
+                }
+                smtlib2_recording_delete(r);
+            }
+            if (data) {
+                smtlib2_free(data);
+            }
+        } else if (measure) {
+            size_t size;
+            if (is_file) {
+                const char *data = smtlib2_map_file(argv[i], &size);
+                if (!data) {
+                    fprintf(stderr, "can't open `%s' for reading\n", argv[i]);
+                    ret = 1;
+                    continue;
+                }
+                fprintf(stderr, ";; %s\n", argv[i]);
+                smtlib2_driver_measure(data, size, mode, stats, trace, memory,
+                                       pipeline, queue, fork_join, memo,
+                                       record, new_parser, delete_parser);
+                smtlib2_unmap_file(data, size);
+            } else {
+                char *data = smtlib2_driver_read_all(stdin, &size);
+                smtlib2_driver_measure(data, size, mode, stats, trace, memory,
+                                       pipeline, queue, fork_join, memo,
+                                       record, new_parser, delete_parser);
+                smtlib2_free(data);
+            }
+        } else {
+            smtlib2_abstract_parser *p;
+            if (is_file) {
+                in = fopen(argv[i], "r");
+                if (!in) {
+                    fprintf(stderr, "can't open `%s' for reading\n", argv[i]);
+                    ret = 1;
+                    continue;
+                }
+            }
+            /* the input is streamed, so that interactive use works (hence
+             * standard input is never read ahead) */
+            p = smtlib2_driver_new_parser(new_parser, stats, trace, memory,
+                                          pipeline && is_file, fork_join,
+                                          memo, record);
+            if (queue) {
+                smtlib2_queue_parse(p, in, !is_file);
+            } else {
+                smtlib2_abstract_parser_parse(p, in);
+            }
+            smtlib2_driver_delete_parser(p, delete_parser);
+            if (in != stdin) fclose(in);
+        }
+    }
+
+    if (trace) {
+        fclose(trace);
+    }
+    if (record && fclose(record) != 0) {
+        fprintf(stderr, "error writing the recording\n");
+        ret = 1;
+    }
+    if (memo) {
+        smtlib2_memo_cache_print_stats(memo, stderr);
+        smtlib2_memo_cache_close(memo);
+    }
+    smtlib2_scanner_pool_clear();
+    return ret;
+}
@@ -0,0 +1,386 @@
+/* -*- C -*-
+ *
+ * Fork-join parsing of huge conjunctions
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2forkjoin.h"
+#include "smtparser/smtlib2binary.h"
+#include "smtparser/smtlib2cmdindex.h"
+#include "smtparser/smtlib2lazyterm.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SMTLIB2_HAVE_PTHREADS
+#include <pthread.h>
+
+/* the smallest number of conjuncts worth a thread */
+#define SMTLIB2_FORK_JOIN_MIN_CHUNK 1024
+
+
+/* the spans of the parts of a conjunction, as offsets in the text */
+typedef struct smtlib2_fork_join_split {
+    smtlib2_vector *lets_;      /* the number of bindings of each let, from
+                                 * the outermost */
+    smtlib2_vector *bindings_;  /* symbol begin, end, term begin, end */
+    smtlib2_vector *args_;      /* begin, end of each conjunct */
+} smtlib2_fork_join_split;
+
+
+typedef struct smtlib2_fork_join_chunk {
+    const char **texts_;
+    size_t n_;
+    smtlib2_term *terms_;         /* the DAG nodes of the conjuncts */
+    smtlib2_binary_writer *writer_;
+    bool ok_;
+} smtlib2_fork_join_chunk;
+
+
+static char *copy_span(const char *data, size_t begin, size_t end)
+{
+    char *ret = (char *)smtlib2_malloc(end - begin + 1);
+    memcpy(ret, data + begin, end - begin);
+    ret[end - begin] = '\0';
+    return ret;
+}
+
+
+static bool is_token(const char *data, size_t begin, size_t end,
+                     const char *s)
+{
+    return end - begin == strlen(s) &&
+        memcmp(data + begin, s, end - begin) == 0;
+}
+
+
+/* expects a closing parenthesis at (or after blanks from) *pos */
+static bool skip_close(const char *data, size_t *pos, size_t size)
+{
+    *pos = smtlib2_skip_blanks(data, *pos, size);
+    if (*pos < size && data[*pos] == ')') {
+        ++*pos;
+        return true;
+    }
+    return false;
+}
+
+
+/* finds the bindings of a let whose "(" was at pos-1 */
+static bool split_let(const char *data, size_t *pos, size_t size,
+                      smtlib2_fork_join_split *out)
+{
+    intptr_t n = 0;
+    size_t p = smtlib2_skip_blanks(data, *pos, size), e;
+
+    if (p >= size || data[p] != '(') {
+        return false;
+    }
+    for (++p; ; ++n) {
+        p = smtlib2_skip_blanks(data, p, size);
+        if (p >= size) {
+            return false;
+        } else if (data[p] == ')') {
+            break;
+        } else if (data[p] != '(') {
+            return false;
+        }
+        p = smtlib2_skip_blanks(data, p+1, size);
+        e = smtlib2_skip_sexpr(data, p, size);
+        /* anything but a plain or quoted symbol is left to the grammar */
+        if (p >= size || strchr("()\":#0123456789", data[p])) {
+            return false;
+        }
+        smtlib2_vector_push(out->bindings_, (intptr_t)p);
+        smtlib2_vector_push(out->bindings_, (intptr_t)e);
+        p = smtlib2_skip_blanks(data, e, size);
+        if (p >= size || data[p] == ')') {
+            return false;
+        }
+        e = smtlib2_skip_sexpr(data, p, size);
+        smtlib2_vector_push(out->bindings_, (intptr_t)p);
+        smtlib2_vector_push(out->bindings_, (intptr_t)e);
+        p = e;
+        if (!skip_close(data, &p, size)) {
+            return false;
+        }
+    }
+    if (n == 0) {
+        return false;
+    }
+    smtlib2_vector_push(out->lets_, n);
+    *pos = p+1;
+    return true;
+}
+
+
+/* matches (let (...) ... (let (...) (and ...)) ...) */
+static bool split_term(const char *data, size_t size,
+                       smtlib2_fork_join_split *out)
+{
+    size_t pos = 0, e, i;
+
+    for (;;) {
+        pos = smtlib2_skip_blanks(data, pos, size);
+        if (pos >= size || data[pos] != '(') {
+            return false;
+        }
+        pos = smtlib2_skip_blanks(data, pos+1, size);
+        e = smtlib2_skip_sexpr(data, pos, size);
+        if (is_token(data, pos, e, "let")) {
+            pos = e;
+            if (!split_let(data, &pos, size, out)) {
+                return false;
+            }
+        } else if (is_token(data, pos, e, "and")) {
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    for (pos = e; ; pos = e) {
+        pos = smtlib2_skip_blanks(data, pos, size);
+        if (pos >= size) {
+            return false;
+        } else if (data[pos] == ')') {
+            break;
+        }
+        e = smtlib2_skip_sexpr(data, pos, size);
+        smtlib2_vector_push(out->args_, (intptr_t)pos);
+        smtlib2_vector_push(out->args_, (intptr_t)e);
+    }
+    ++pos;
+    for (i = 0; i < smtlib2_vector_size(out->lets_); ++i) {
+        if (!skip_close(data, &pos, size)) {
+            return false;
+        }
+    }
+    return smtlib2_skip_blanks(data, pos, size) == size;
+}
+
+
+/* a worker: parses the conjuncts of a chunk in a DAG */
+static void *smtlib2_fork_join_worker(void *data)
+{
+    smtlib2_fork_join_chunk *c = (smtlib2_fork_join_chunk *)data;
+    smtlib2_binary_writer *w = smtlib2_binary_writer_new(NULL);
+
+    /* the records are replayed directly, the file header is not needed */
+    smtlib2_charbuf_resize(w->buf_, 0);
+    c->ok_ = smtlib2_abstract_parser_parse_terms(&(w->parent_), c->texts_,
+                                                 c->n_, c->terms_);
+    /* a syntax error is reported by parsing the whole term again */
+    smtlib2_abstract_parser_reset_response(&(w->parent_));
+    c->writer_ = w;
+    return NULL;
+}
+
+
+/*
+ * defines the let bindings, replays the conjuncts and builds their
+ * conjunction, as the grammar would do (see plain_term in
+ * smtlib2bisonparser.y)
+ */
+static smtlib2_term smtlib2_fork_join_stitch(smtlib2_abstract_parser *p,
+                                             const char *data,
+                                             smtlib2_fork_join_split *split,
+                                             smtlib2_fork_join_chunk *chunks,
+                                             size_t nchunks)
+{
+    smtlib2_parser_interface *pi = SMTLIB2_PARSER_INTERFACE(p);
+    smtlib2_vector *args = smtlib2_vector_new();
+    smtlib2_term ret = NULL;
+    size_t nlets = smtlib2_vector_size(split->lets_);
+    size_t i, j, b = 0, pushed = 0;
+    bool ok = true;
+
+    for (i = 0; i < nlets && ok; ++i) {
+        pi->push_let_scope(pi);
+        ++pushed;
+        for (j = 0; j < (size_t)smtlib2_vector_at(split->lets_, i) && ok;
+             ++j, b += 4) {
+            size_t sb = smtlib2_vector_at(split->bindings_, b);
+            size_t se = smtlib2_vector_at(split->bindings_, b+1);
+            size_t tb = smtlib2_vector_at(split->bindings_, b+2);
+            size_t te = smtlib2_vector_at(split->bindings_, b+3);
+            char *sym, *text = copy_span(data, tb, te);
+            smtlib2_term t;
+
+            ok = smtlib2_abstract_parser_parse_terms(
+                p, (const char **)&text, 1, &t);
+            if (ok) {
+                if (data[sb] == '|') {
+                    ++sb;
+                    --se;
+                }
+                sym = copy_span(data, sb, se);
+                pi->define_let_binding(pi, sym, t);
+                ok = p->response_ != SMTLIB2_RESPONSE_ERROR;
+                smtlib2_free(sym);
+            }
+            smtlib2_free(text);
+        }
+    }
+
+    for (i = 0; i < nchunks && ok; ++i) {
+        smtlib2_fork_join_chunk *c = &(chunks[i]);
+        smtlib2_binary_reader *r = smtlib2_binary_reader_new_incremental();
+        smtlib2_binary_reader_append(r,
+                                     smtlib2_charbuf_array(c->writer_->buf_),
+                                     SMTLIB2_VECTOR_SIZE(c->writer_->buf_));
+        for (j = 0; j < c->n_ && ok; ++j) {
+            smtlib2_term t;
+            if (!smtlib2_binary_reader_build_term(
+                    r, pi, ((smtlib2_dag_term *)c->terms_[j])->id_, &t)) {
+                p->response_ = SMTLIB2_RESPONSE_ERROR;
+                p->errmsg_ = smtlib2_strdup(
+                    smtlib2_binary_reader_get_error_msg(r));
+                ok = false;
+            } else {
+                smtlib2_vector_push(args, (intptr_t)t);
+                ok = p->response_ != SMTLIB2_RESPONSE_ERROR;
+            }
+        }
+        smtlib2_binary_reader_delete(r);
+    }
+
+    if (ok) {
+        ret = pi->make_term(pi, "and", NULL, NULL, args);
+    }
+    /* the scopes opened are closed even after an error, as in the grammar */
+    while (pushed-- > 0) {
+        smtlib2_term t = pi->pop_let_scope(pi);
+        if (t) {
+            ret = t;
+        }
+    }
+    smtlib2_vector_delete(args);
+
+    return p->response_ != SMTLIB2_RESPONSE_ERROR ? ret : NULL;
+}
+
+#endif /* SMTLIB2_HAVE_PTHREADS */
+
+
+bool smtlib2_fork_join_force_term(smtlib2_abstract_parser *p,
+                                  smtlib2_lazy_term *t, int nthreads,
+                                  smtlib2_term *out)
+{
+#ifdef SMTLIB2_HAVE_PTHREADS
+    smtlib2_fork_join_split split;
+    smtlib2_fork_join_chunk *chunks = NULL;
+    pthread_t *threads;
+    bool *started;
+    const char **texts;
+    smtlib2_term *terms;
+    char *copy;
+    size_t nargs, nchunks = 0, i, pos;
+    smtlib2_allocator *prev;
+    bool ret = true;
+
+    if (nthreads < 2) {
+        return false;
+    }
+
+    prev = smtlib2_set_allocator(p->allocator_);
+    split.lets_ = smtlib2_vector_new();
+    split.bindings_ = smtlib2_vector_new();
+    split.args_ = smtlib2_vector_new();
+    if (split_term(t->text_, t->length_, &split)) {
+        nchunks = smtlib2_vector_size(split.args_) / 2 /
+            SMTLIB2_FORK_JOIN_MIN_CHUNK;
+        if (nchunks > (size_t)nthreads) {
+            nchunks = nthreads;
+        }
+    }
+    if (nchunks < 2) {
+        smtlib2_vector_delete(split.args_);
+        smtlib2_vector_delete(split.bindings_);
+        smtlib2_vector_delete(split.lets_);
+        smtlib2_set_allocator(prev);
+        return false;
+    }
+
+    /* NUL-terminated copies of the conjuncts, all in one block */
+    nargs = smtlib2_vector_size(split.args_) / 2;
+    copy = (char *)smtlib2_malloc(t->length_ + nargs);
+    texts = (const char **)smtlib2_malloc(sizeof(const char *) * nargs);
+    terms = (smtlib2_term *)smtlib2_malloc(sizeof(smtlib2_term) * nargs);
+    for (i = 0, pos = 0; i < nargs; ++i) {
+        size_t b = smtlib2_vector_at(split.args_, 2*i);
+        size_t e = smtlib2_vector_at(split.args_, 2*i+1);
+        memcpy(copy + pos, t->text_ + b, e - b);
+        copy[pos + e - b] = '\0';
+        texts[i] = copy + pos;
+        pos += e - b + 1;
+    }
+
+    chunks = (smtlib2_fork_join_chunk *)smtlib2_malloc(
+        sizeof(smtlib2_fork_join_chunk) * nchunks);
+    threads = (pthread_t *)smtlib2_malloc(sizeof(pthread_t) * nchunks);
+    started = (bool *)smtlib2_malloc(sizeof(bool) * nchunks);
+    for (i = 0; i < nchunks; ++i) {
+        size_t first = i * nargs / nchunks;
+        chunks[i].texts_ = texts + first;
+        chunks[i].n_ = (i+1) * nargs / nchunks - first;
+        chunks[i].terms_ = terms + first;
+        chunks[i].writer_ = NULL;
+        chunks[i].ok_ = false;
+        started[i] = pthread_create(&(threads[i]), NULL,
+                                    smtlib2_fork_join_worker,
+                                    &(chunks[i])) == 0;
+    }
+    for (i = 0; i < nchunks; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            smtlib2_fork_join_worker(&(chunks[i]));
+        }
+        ret = ret && chunks[i].ok_;
+    }
+
+    if (ret) {
+        *out = smtlib2_fork_join_stitch(p, t->text_, &split, chunks, nchunks);
+    }
+
+    for (i = 0; i < nchunks; ++i) {
+        smtlib2_binary_writer_delete(chunks[i].writer_);
+    }
+    smtlib2_free(started);
+    smtlib2_free(threads);
+    smtlib2_free(chunks);
+    smtlib2_free(terms);
+    smtlib2_free(texts);
+    smtlib2_free(copy);
+    smtlib2_vector_delete(split.args_);
+    smtlib2_vector_delete(split.bindings_);
+    smtlib2_vector_delete(split.lets_);
+    smtlib2_set_allocator(prev);
+    return ret;
+#else
+    (void)p;
+    (void)t;
+    (void)nthreads;
+    (void)out;
+    return false;
+#endif
+}
@@ -0,0 +1,243 @@
+/* -*- C -*-
+ *
+ * Immutable, perfectly hashed tables of symbol handlers
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2handlertable.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+/*
+ * Hash and displace: the symbols are split in buckets of about 4 by their
+ * hash, and for every bucket (largest first) a seed is searched such that
+ * the slots of all its symbols, obtained by mixing their hash with the seed,
+ * are free. The slots hold copies of the entries, an empty one has a NULL
+ * symbol
+ */
+struct smtlib2_handler_table {
+    smtlib2_handler_entry *slots_;
+    uint32_t *seeds_;
+    uint32_t num_slots_;
+    uint32_t num_buckets_;
+};
+
+#define SMTLIB2_HANDLER_TABLE_MAX_SEED (1u << 12)
+
+
+static uint32_t smtlib2_handler_hash(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; ++s) {
+        h = (h ^ (unsigned char)*s) * 16777619u;
+    }
+    return h;
+}
+
+
+static uint32_t smtlib2_handler_mix(uint32_t h, uint32_t seed)
+{
+    h ^= seed * 0x9e3779b9u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+#define BUCKET(t, h) ((h) % (t)->num_buckets_)
+#define SLOT(t, h, seed) (smtlib2_handler_mix((h), (seed)) % (t)->num_slots_)
+
+
+/* places the entries in the slots of "t", false if some bucket can't be
+ * placed with any seed */
+static bool smtlib2_handler_table_place(smtlib2_handler_table *t,
+                                        const smtlib2_handler_entry *entries,
+                                        const uint32_t *hashes, size_t n)
+{
+    /* the entries of bucket b are members[first[b] .. first[b+1]) */
+    size_t *first = (size_t *)calloc(t->num_buckets_ + 1, sizeof(size_t));
+    size_t *fill = (size_t *)malloc(sizeof(size_t) * t->num_buckets_);
+    size_t *members = (size_t *)malloc(sizeof(size_t) * n);
+    uint32_t *order = (uint32_t *)malloc(sizeof(uint32_t) * t->num_buckets_);
+    uint32_t *slots = (uint32_t *)malloc(sizeof(uint32_t) * n);
+    bool ok = true;
+    size_t i, j;
+
+    for (i = 0; i < n; ++i) {
+        ++first[BUCKET(t, hashes[i]) + 1];
+    }
+    for (i = 0; i < t->num_buckets_; ++i) {
+        first[i + 1] += first[i];
+        fill[i] = first[i];
+        order[i] = (uint32_t)i;
+    }
+    for (i = 0; i < n; ++i) {
+        members[fill[BUCKET(t, hashes[i])]++] = i;
+    }
+#define BUCKET_SIZE(b) (first[(b) + 1] - first[(b)])
+    /* largest buckets first (insertion sort, the tables are small) */
+    for (i = 1; i < t->num_buckets_; ++i) {
+        uint32_t b = order[i];
+        for (j = i; j > 0 && BUCKET_SIZE(order[j-1]) < BUCKET_SIZE(b); --j) {
+            order[j] = order[j-1];
+        }
+        order[j] = b;
+    }
+
+    for (i = 0; ok && i < t->num_buckets_ && BUCKET_SIZE(order[i]) > 0; ++i) {
+        uint32_t b = order[i], seed;
+        size_t m = BUCKET_SIZE(b), k = 0;
+        const size_t *mb = members + first[b];
+
+        for (seed = 0; seed < SMTLIB2_HANDLER_TABLE_MAX_SEED; ++seed) {
+            for (k = 0; k < m; ++k) {
+                size_t l;
+                slots[k] = SLOT(t, hashes[mb[k]], seed);
+                if (t->slots_[slots[k]].symbol_) {
+                    break;
+                }
+                for (l = 0; l < k && slots[l] != slots[k]; ++l) {
+                }
+                if (l < k) {
+                    break;
+                }
+            }
+            if (k == m) {
+                break;
+            }
+        }
+        if (k < m) {
+            ok = false;
+        } else {
+            t->seeds_[b] = seed;
+            for (k = 0; k < m; ++k) {
+                t->slots_[slots[k]] = entries[mb[k]];
+            }
+        }
+    }
+#undef BUCKET_SIZE
+
+    free(slots);
+    free(order);
+    free(members);
+    free(fill);
+    free(first);
+    return ok;
+}
+
+
+smtlib2_handler_table *smtlib2_handler_table_new(
+    const smtlib2_handler_entry *entries, size_t n)
+{
+    smtlib2_handler_table *ret =
+        (smtlib2_handler_table *)malloc(sizeof(smtlib2_handler_table));
+    uint32_t *hashes = (uint32_t *)malloc(sizeof(uint32_t) * (n + 1));
+    size_t i;
+
+    for (i = 0; i < n; ++i) {
+        hashes[i] = smtlib2_handler_hash(entries[i].symbol_);
+    }
+    ret->num_buckets_ = (uint32_t)(n / 4 + 1);
+    ret->num_slots_ = (uint32_t)(n + n / 4 + 1);
+    ret->slots_ = NULL;
+    ret->seeds_ = NULL;
+    /* with a load of 0.8 a placement is practically always found, more room
+     * is given otherwise */
+    for (;;) {
+        ret->slots_ = (smtlib2_handler_entry *)calloc(
+            ret->num_slots_, sizeof(smtlib2_handler_entry));
+        ret->seeds_ = (uint32_t *)calloc(ret->num_buckets_, sizeof(uint32_t));
+        if (smtlib2_handler_table_place(ret, entries, hashes, n)) {
+            break;
+        }
+        free(ret->slots_);
+        free(ret->seeds_);
+        ret->num_slots_ += ret->num_slots_ / 2;
+        ret->num_buckets_ *= 2;
+    }
+    free(hashes);
+    return ret;
+}
+
+
+void smtlib2_handler_table_delete(smtlib2_handler_table *t)
+{
+    free(t->slots_);
+    free(t->seeds_);
+    free(t);
+}
+
+
+smtlib2_term_parser_symbolhandler smtlib2_handler_table_find(
+    const smtlib2_handler_table *t, const char *symbol)
+{
+    uint32_t h = smtlib2_handler_hash(symbol);
+    const smtlib2_handler_entry *e =
+        &(t->slots_[SLOT(t, h, t->seeds_[BUCKET(t, h)])]);
+    if (e->symbol_ && strcmp(e->symbol_, symbol) == 0) {
+        return e->handler_;
+    }
+    return NULL;
+}
+
+
+/* the stored table is published with a compare-and-swap, so that a thread
+ * that reads it also sees its contents */
+#if defined(__GNUC__)
+#  define LOAD(slot) __atomic_load_n((slot), __ATOMIC_ACQUIRE)
+#  define CAS(slot, expected, t) \
+    __atomic_compare_exchange_n((slot), &(expected), (t), false, \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER)
+#  define LOAD(slot) \
+    ((smtlib2_handler_table *)InterlockedCompareExchangePointer( \
+        (PVOID volatile *)(slot), NULL, NULL))
+#  define CAS(slot, expected, t) \
+    (InterlockedCompareExchangePointer((PVOID volatile *)(slot), (t), \
+                                       (expected)) == (expected))
+#else
+/* no atomics, the first call must not be concurrent */
+#  define LOAD(slot) (*(slot))
+#  define CAS(slot, expected, t) (*(slot) = (t), true)
+#endif
+
+const smtlib2_handler_table *smtlib2_handler_table_once(
+    smtlib2_handler_table **slot, const smtlib2_handler_entry *entries,
+    size_t n)
+{
+    smtlib2_handler_table *ret = LOAD(slot);
+    if (!ret) {
+        smtlib2_handler_table *expected = NULL;
+        ret = smtlib2_handler_table_new(entries, n);
+        if (!CAS(slot, expected, ret)) {
+            /* another thread got there first */
+            smtlib2_handler_table_delete(ret);
+            ret = LOAD(slot);
+        }
+    }
+    return ret;
+}
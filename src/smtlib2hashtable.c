@@ -60,7 +60,7 @@ static bool identity_eqfun(intptr_t k1, intptr_t k2);
 smtlib2_hashtable *smtlib2_hashtable_new(smtlib2_hashfun hf, smtlib2_eqfun ef)
 {
     smtlib2_hashtable *ret =
-        (smtlib2_hashtable *)malloc(sizeof(smtlib2_hashtable));
+        (smtlib2_hashtable *)smtlib2_malloc(sizeof(smtlib2_hashtable));
     ret->table_ = smtlib2_vector_new();
     smtlib2_vector_resize(ret->table_, primes[0]);
     ret->size_ = 0;
@@ -83,7 +83,7 @@ void smtlib2_hashtable_delete(smtlib2_hashtable *t,
         delete_buckets(b, fk, fv);
     }
     smtlib2_vector_delete(t->table_);
-    free(t);
+    smtlib2_free(t);
 }
 
 
@@ -101,7 +101,7 @@ void smtlib2_hashtable_set(smtlib2_hashtable *t, intptr_t key, intptr_t val)
     if (b) {
         b->val_ = val;
     } else {
-        b = (smtlib2_hashtable_bucket *)malloc(
+        b = (smtlib2_hashtable_bucket *)smtlib2_malloc(
             sizeof(smtlib2_hashtable_bucket));
         b->next_ = (smtlib2_hashtable_bucket *)smtlib2_vector_at(t->table_, i);
         b->key_ = key;
@@ -183,7 +183,7 @@ void smtlib2_hashtable_erase_free(smtlib2_hashtable *t, intptr_t key,
             if (fv) {
                 fv(b->val_);
             }
-            free(b);
+            smtlib2_free(b);
             return;
         } else {
             prev = b;
@@ -268,7 +268,7 @@ static void delete_buckets(smtlib2_hashtable_bucket *b,
         if (fv) {
             fv(b->val_);
         }
-        free(b);
+        smtlib2_free(b);
         b = tmp;
     }
 }
@@ -0,0 +1,171 @@
+/* -*- C -*-
+ *
+ * Unparsed terms, for the lazy handling of assertions
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2lazyterm.h"
+#include "smtparser/smtlib2utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static size_t skip_blanks(const char *s, size_t pos, size_t len);
+static size_t token_end(const char *s, size_t pos, size_t len);
+static size_t skip_sexp(const char *s, size_t pos, size_t len);
+
+
+smtlib2_lazy_term *smtlib2_lazy_term_new(char *text, size_t length,
+                                         size_t offset, int line)
+{
+    smtlib2_lazy_term *ret =
+        (smtlib2_lazy_term *)smtlib2_malloc(sizeof(smtlib2_lazy_term));
+    ret->text_ = text;
+    ret->length_ = length;
+    ret->offset_ = offset;
+    ret->line_ = line;
+    return ret;
+}
+
+
+void smtlib2_lazy_term_delete(smtlib2_lazy_term *t)
+{
+    smtlib2_free(t->text_);
+    smtlib2_free(t);
+}
+
+
+char *smtlib2_lazy_term_get_name(smtlib2_lazy_term *t)
+{
+    const char *s = t->text_;
+    size_t len = t->length_;
+    size_t pos = skip_blanks(s, 0, len);
+    size_t end;
+
+    /* (! term attribute*) */
+    if (pos >= len || s[pos] != '(') {
+        return NULL;
+    }
+    pos = skip_blanks(s, pos+1, len);
+    end = token_end(s, pos, len);
+    if (end != pos+1 || s[pos] != '!') {
+        return NULL;
+    }
+    pos = skip_sexp(s, skip_blanks(s, end, len), len);
+
+    for (;;) {
+        pos = skip_blanks(s, pos, len);
+        if (pos >= len || s[pos] != ':') {
+            return NULL;
+        }
+        end = token_end(s, pos, len);
+        if (end - pos == 6 && strncmp(s + pos, ":named", 6) == 0) {
+            pos = skip_blanks(s, end, len);
+            end = skip_sexp(s, pos, len);
+            if (end - pos >= 2 && s[pos] == '|' && s[end-1] == '|') {
+                /* quoted symbols are given without the bars, as by the
+                 * lexer */
+                ++pos;
+                --end;
+            } else if (pos >= len || s[pos] == '(' || s[pos] == ')') {
+                return NULL;
+            }
+            {
+                char *ret = (char *)smtlib2_malloc(end - pos + 1);
+                memcpy(ret, s + pos, end - pos);
+                ret[end - pos] = '\0';
+                return ret;
+            }
+        }
+        pos = skip_blanks(s, end, len);
+        if (pos < len && s[pos] != ':' && s[pos] != ')') {
+            pos = skip_sexp(s, pos, len);
+        }
+    }
+}
+
+
+static size_t skip_blanks(const char *s, size_t pos, size_t len)
+{
+    while (pos < len) {
+        if (s[pos] == ';') {
+            while (pos < len && s[pos] != '\n') {
+                ++pos;
+            }
+        } else if (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' ||
+                   s[pos] == '\r') {
+            ++pos;
+        } else {
+            break;
+        }
+    }
+    return pos;
+}
+
+
+static size_t token_end(const char *s, size_t pos, size_t len)
+{
+    while (pos < len && !strchr(" \t\r\n()\";|", s[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+
+/* returns the position right after the s-expression starting at pos */
+static size_t skip_sexp(const char *s, size_t pos, size_t len)
+{
+    int depth = 0;
+    do {
+        pos = skip_blanks(s, pos, len);
+        if (pos >= len) {
+            break;
+        }
+        switch (s[pos]) {
+        case '(':
+            ++depth;
+            ++pos;
+            break;
+        case ')':
+            --depth;
+            ++pos;
+            break;
+        case '"':
+            for (++pos; pos < len && s[pos] != '"'; ++pos) {
+                if (s[pos] == '\\' && pos+1 < len && s[pos+1] == '"') {
+                    ++pos;
+                }
+            }
+            ++pos;
+            break;
+        case '|':
+            for (++pos; pos < len && s[pos] != '|'; ++pos) {
+                /* nothing */
+            }
+            ++pos;
+            break;
+        default:
+            pos = token_end(s, pos, len);
+        }
+    } while (depth > 0);
+    return pos < len ? pos : len;
+}
@@ -0,0 +1,1828 @@
+/* -*- C -*-
+ *
+ * Memoisation of check-sat responses, keyed by a canonical hash of the query
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2memo.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2termdag.h"
+#include "smtparser/smtlib2pmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * Hashing
+ */
+
+/* the finaliser of MurmurHash3 */
+static uint64_t smtlib2_memo_fmix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+
+static uint64_t smtlib2_memo_mix(uint64_t h, uint64_t v)
+{
+    return smtlib2_memo_fmix(h ^ (v + 0x9e3779b97f4a7c15ULL));
+}
+
+
+/* the two halves are chained with different functions, so that a collision
+ * of one is unlikely to be one of the other */
+static void smtlib2_memo_key_add(smtlib2_memo_key *k, uint64_t v)
+{
+    k->h1_ = smtlib2_memo_mix(k->h1_, v);
+    k->h2_ = smtlib2_memo_fmix((k->h2_ + v) * 0xbf58476d1ce4e5b9ULL +
+                               0x94d049bb133111ebULL);
+}
+
+
+static void smtlib2_memo_key_add_key(smtlib2_memo_key *k,
+                                     const smtlib2_memo_key *v)
+{
+    smtlib2_memo_key_add(k, v->h1_);
+    smtlib2_memo_key_add(k, v->h2_);
+}
+
+
+static void smtlib2_memo_key_init(smtlib2_memo_key *k, uint64_t tag)
+{
+    k->h1_ = 0x243f6a8885a308d3ULL;
+    k->h2_ = 0x13198a2e03707344ULL;
+    smtlib2_memo_key_add(k, tag);
+}
+
+
+/* FNV-1a */
+static uint64_t smtlib2_memo_hash_str(const char *s)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *s; ++s) {
+        h = (h ^ (unsigned char)*s) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+
+/* the tags of the nodes in the hashes */
+enum {
+    SMTLIB2_MEMO_TAG_TERM = 1,   /* + the kind of the term */
+    SMTLIB2_MEMO_TAG_SORT = 16,  /* + the kind of the sort */
+    SMTLIB2_MEMO_TAG_USER = 32,
+    SMTLIB2_MEMO_TAG_NONE,
+    SMTLIB2_MEMO_TAG_DECLS,
+    SMTLIB2_MEMO_TAG_QUERY
+};
+
+
+/*
+ * The cache
+ */
+
+#define SMTLIB2_MEMO_MAGIC "SMT2MEM1"
+#define SMTLIB2_MEMO_MAGIC_SIZE 8
+#define SMTLIB2_MEMO_RECORD_SIZE 17
+
+typedef struct smtlib2_memo_entry {
+    smtlib2_memo_key key_;
+    bool sat_;
+} smtlib2_memo_entry;
+
+
+struct smtlib2_memo_cache {
+    /* the allocator current when the cache was opened, since the entries are
+     * added by the parsers using it */
+    smtlib2_allocator *allocator_;
+    char *path_;
+    FILE *out_;  /* appending to the file */
+    size_t max_entries_;
+    smtlib2_hashtable *entries_;  /* the entries, by key */
+    smtlib2_vector *order_;       /* the entries, oldest first, starting
+                                   * from first_ */
+    size_t first_;
+    size_t file_records_;
+    smtlib2_memo_stats stats_;
+};
+
+
+static uint32_t smtlib2_memo_entry_hash(intptr_t e)
+{
+    return (uint32_t)((smtlib2_memo_entry *)e)->key_.h1_;
+}
+
+
+static bool smtlib2_memo_entry_eq(intptr_t e1, intptr_t e2)
+{
+    const smtlib2_memo_key *k1 = &(((smtlib2_memo_entry *)e1)->key_);
+    const smtlib2_memo_key *k2 = &(((smtlib2_memo_entry *)e2)->key_);
+    return k1->h1_ == k2->h1_ && k1->h2_ == k2->h2_;
+}
+
+
+static size_t smtlib2_memo_cache_live(smtlib2_memo_cache *c)
+{
+    return smtlib2_vector_size(c->order_) - c->first_;
+}
+
+
+/* returns false if the key is there already */
+static bool smtlib2_memo_cache_insert(smtlib2_memo_cache *c,
+                                      const smtlib2_memo_key *k, bool sat)
+{
+    smtlib2_memo_entry probe, *e;
+
+    probe.key_ = *k;
+    if (smtlib2_hashtable_find(c->entries_, (intptr_t)&probe, NULL)) {
+        return false;
+    }
+    e = (smtlib2_memo_entry *)smtlib2_malloc(sizeof(smtlib2_memo_entry));
+    e->key_ = *k;
+    e->sat_ = sat;
+    smtlib2_hashtable_set(c->entries_, (intptr_t)e, (intptr_t)e);
+    smtlib2_vector_push(c->order_, (intptr_t)e);
+
+    while (c->max_entries_ && smtlib2_memo_cache_live(c) > c->max_entries_) {
+        e = (smtlib2_memo_entry *)smtlib2_vector_at(c->order_, c->first_);
+        ++c->first_;
+        smtlib2_hashtable_erase(c->entries_, (intptr_t)e);
+        smtlib2_free(e);
+        ++c->stats_.evictions_;
+    }
+    if (c->first_ > 64 && c->first_ * 2 > smtlib2_vector_size(c->order_)) {
+        size_t n = smtlib2_memo_cache_live(c);
+        memmove(smtlib2_vector_array(c->order_),
+                smtlib2_vector_array(c->order_) + c->first_,
+                sizeof(intptr_t) * n);
+        smtlib2_vector_resize(c->order_, n);
+        c->first_ = 0;
+    }
+    return true;
+}
+
+
+static void smtlib2_memo_write_record(FILE *f, const smtlib2_memo_entry *e)
+{
+    unsigned char buf[SMTLIB2_MEMO_RECORD_SIZE];
+    int i;
+    for (i = 0; i < 8; ++i) {
+        buf[i] = (unsigned char)(e->key_.h1_ >> (8 * i));
+        buf[8 + i] = (unsigned char)(e->key_.h2_ >> (8 * i));
+    }
+    buf[16] = e->sat_ ? 's' : 'u';
+    fwrite(buf, 1, SMTLIB2_MEMO_RECORD_SIZE, f);
+}
+
+
+/* rewrites the file with only the live entries, replacing it atomically,
+ * and reopens it for appending */
+static void smtlib2_memo_cache_rewrite(smtlib2_memo_cache *c)
+{
+    char *tmp = smtlib2_sprintf("%s.tmp", c->path_);
+    FILE *f = fopen(tmp, "wb");
+
+    if (c->out_) {
+        fclose(c->out_);
+        c->out_ = NULL;
+    }
+    if (f) {
+        size_t i;
+        bool ok;
+        fwrite(SMTLIB2_MEMO_MAGIC, 1, SMTLIB2_MEMO_MAGIC_SIZE, f);
+        for (i = c->first_; i < smtlib2_vector_size(c->order_); ++i) {
+            smtlib2_memo_write_record(
+                f, (smtlib2_memo_entry *)smtlib2_vector_at(c->order_, i));
+        }
+        ok = !ferror(f);
+        ok = (fclose(f) == 0) && ok;
+#ifdef _WIN32
+        if (ok) {
+            remove(c->path_);
+        }
+#endif
+        if (ok && rename(tmp, c->path_) == 0) {
+            c->file_records_ = smtlib2_memo_cache_live(c);
+        } else {
+            remove(tmp);
+        }
+    }
+    smtlib2_free(tmp);
+    c->out_ = fopen(c->path_, "ab");
+}
+
+
+/* reads the records of the file. Returns false if it is not a cache, and
+ * sets "rewrite" if it must be rewritten */
+static bool smtlib2_memo_cache_load(smtlib2_memo_cache *c, FILE *in,
+                                    bool *rewrite)
+{
+    unsigned char buf[SMTLIB2_MEMO_RECORD_SIZE];
+    size_t got = fread(buf, 1, SMTLIB2_MEMO_MAGIC_SIZE, in);
+
+    if (got == 0) {
+        *rewrite = true;  /* empty */
+        return true;
+    }
+    if (got < SMTLIB2_MEMO_MAGIC_SIZE ||
+        memcmp(buf, SMTLIB2_MEMO_MAGIC, SMTLIB2_MEMO_MAGIC_SIZE) != 0) {
+        return false;
+    }
+    while ((got = fread(buf, 1, SMTLIB2_MEMO_RECORD_SIZE, in)) ==
+           SMTLIB2_MEMO_RECORD_SIZE && (buf[16] == 's' || buf[16] == 'u')) {
+        smtlib2_memo_key k;
+        int i;
+        k.h1_ = k.h2_ = 0;
+        for (i = 7; i >= 0; --i) {
+            k.h1_ = (k.h1_ << 8) | buf[i];
+            k.h2_ = (k.h2_ << 8) | buf[8 + i];
+        }
+        smtlib2_memo_cache_insert(c, &k, buf[16] == 's');
+        ++c->file_records_;
+    }
+    if (got != 0 ||
+        (c->max_entries_ && c->file_records_ > 2 * c->max_entries_)) {
+        /* a truncated or garbled tail, or too many evicted records */
+        *rewrite = true;
+    }
+    return true;
+}
+
+
+smtlib2_memo_cache *smtlib2_memo_cache_open(const char *path,
+                                            size_t max_entries)
+{
+    smtlib2_memo_cache *ret =
+        (smtlib2_memo_cache *)smtlib2_malloc(sizeof(smtlib2_memo_cache));
+
+    ret->allocator_ = smtlib2_get_allocator();
+    ret->path_ = path ? smtlib2_strdup(path) : NULL;
+    ret->out_ = NULL;
+    ret->max_entries_ = max_entries;
+    ret->entries_ = smtlib2_hashtable_new(smtlib2_memo_entry_hash,
+                                          smtlib2_memo_entry_eq);
+    ret->order_ = smtlib2_vector_new();
+    ret->first_ = 0;
+    ret->file_records_ = 0;
+    memset(&(ret->stats_), 0, sizeof(smtlib2_memo_stats));
+
+    if (path) {
+        FILE *in = fopen(path, "rb");
+        bool rewrite = true;
+        if (in) {
+            bool ok = smtlib2_memo_cache_load(ret, in, &rewrite);
+            fclose(in);
+            if (!ok) {
+                smtlib2_memo_cache_close(ret);
+                return NULL;
+            }
+        }
+        if (rewrite) {
+            smtlib2_memo_cache_rewrite(ret);
+        } else {
+            ret->out_ = fopen(path, "ab");
+        }
+        if (!ret->out_) {
+            smtlib2_memo_cache_close(ret);
+            return NULL;
+        }
+        /* the evictions while loading don't count */
+        memset(&(ret->stats_), 0, sizeof(smtlib2_memo_stats));
+    }
+    return ret;
+}
+
+
+void smtlib2_memo_cache_close(smtlib2_memo_cache *c)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(c->allocator_);
+    size_t i;
+
+    if (c->out_) {
+        fclose(c->out_);
+    }
+    for (i = c->first_; i < smtlib2_vector_size(c->order_); ++i) {
+        smtlib2_free((smtlib2_memo_entry *)smtlib2_vector_at(c->order_, i));
+    }
+    smtlib2_vector_delete(c->order_);
+    smtlib2_hashtable_delete(c->entries_, NULL, NULL);
+    smtlib2_free(c->path_);
+    smtlib2_free(c);
+
+    smtlib2_set_allocator(prev);
+}
+
+
+bool smtlib2_memo_cache_lookup(smtlib2_memo_cache *c,
+                               const smtlib2_memo_key *k, bool *sat)
+{
+    smtlib2_memo_entry probe;
+    intptr_t v;
+
+    probe.key_ = *k;
+    if (smtlib2_hashtable_find(c->entries_, (intptr_t)&probe, &v)) {
+        *sat = ((smtlib2_memo_entry *)v)->sat_;
+        return true;
+    }
+    return false;
+}
+
+
+void smtlib2_memo_cache_store(smtlib2_memo_cache *c,
+                              const smtlib2_memo_key *k, bool sat)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(c->allocator_);
+
+    if (smtlib2_memo_cache_insert(c, k, sat)) {
+        ++c->stats_.stores_;
+        if (c->out_) {
+            smtlib2_memo_write_record(
+                c->out_, (smtlib2_memo_entry *)smtlib2_vector_last(c->order_));
+            fflush(c->out_);
+            ++c->file_records_;
+            if (c->max_entries_ && c->file_records_ > 2 * c->max_entries_) {
+                smtlib2_memo_cache_rewrite(c);
+            }
+        }
+    }
+
+    smtlib2_set_allocator(prev);
+}
+
+
+size_t smtlib2_memo_cache_size(smtlib2_memo_cache *c)
+{
+    return smtlib2_memo_cache_live(c);
+}
+
+
+const smtlib2_memo_stats *smtlib2_memo_cache_get_stats(smtlib2_memo_cache *c)
+{
+    return &(c->stats_);
+}
+
+
+void smtlib2_memo_cache_print_stats(smtlib2_memo_cache *c, FILE *out)
+{
+    const smtlib2_memo_stats *s = &(c->stats_);
+    fprintf(out, ";; memo: %lu hits, %lu misses (%lu uncacheable), "
+            "%lu stored, %lu evicted, %lu entries\n",
+            (unsigned long)s->hits_, (unsigned long)s->misses_,
+            (unsigned long)s->uncacheable_, (unsigned long)s->stores_,
+            (unsigned long)s->evictions_,
+            (unsigned long)smtlib2_memo_cache_live(c));
+}
+
+
+/*
+ * The layer
+ */
+
+/* a declared sort or function, or a define-fun with parameters. Every
+ * declaration gets a symbol of its own in the DAG, which is not a valid
+ * SMT-LIB symbol (the name is prefixed by \1 and followed by a number), so
+ * that it is never confused with a symbol of the logic nor with the same
+ * name declared again after a pop */
+typedef struct smtlib2_memo_decl {
+    bool is_sort_;
+    int arity_;                   /* of a sort */
+    smtlib2_dag_sort *sort_;      /* of a function (the result sort for a
+                                   * define-fun) */
+    smtlib2_dag_term *body_;      /* of a define-fun, NULL otherwise */
+    size_t nparams_;
+    smtlib2_dag_term **params_;
+} smtlib2_memo_decl;
+
+
+/* what a name refers to. All NULL if the layer couldn't follow it (e.g. a
+ * define-fun whose body was built by a term it didn't see) */
+typedef struct smtlib2_memo_name {
+    smtlib2_dag_symbol *symbol_;  /* a declaration */
+    smtlib2_dag_term *term_;      /* a define-fun without parameters, or a
+                                   * :named term */
+    smtlib2_dag_sort *sort_;      /* a define-sort, or one of its
+                                   * parameters */
+    size_t nparams_;
+    smtlib2_dag_sort **params_;   /* of a define-sort */
+} smtlib2_memo_name;
+
+
+/* hashing data of a term or sort, by id */
+typedef struct smtlib2_memo_info {
+    smtlib2_memo_key canon_;  /* valid in the epoch_ of the layer */
+    uint32_t epoch_;
+    bool has_shape_;
+    uint64_t shape_;
+} smtlib2_memo_info;
+
+
+/* hashing data of a symbol, by id */
+typedef struct smtlib2_memo_symbol_info {
+    smtlib2_memo_decl *decl_;  /* NULL for the symbols of the logic */
+    uint64_t hash_;            /* of the name */
+    uint32_t epoch_;
+    uint32_t number_;          /* valid in the epoch_ of the layer */
+} smtlib2_memo_symbol_info;
+
+
+typedef struct smtlib2_memo_level {
+    size_t num_assertions_;
+    smtlib2_pmap term_names_;
+    smtlib2_pmap sort_names_;
+} smtlib2_memo_level;
+
+
+struct smtlib2_memo {
+    smtlib2_parser_interface orig_;  /* the wrapped callbacks */
+    smtlib2_memo_cache *cache_;
+
+    smtlib2_termdag *dag_;
+    /* the DAG nodes of the terms and sorts of the backend */
+    smtlib2_hashtable *terms_;
+    smtlib2_hashtable *sorts_;
+    smtlib2_dag_term *last_;  /* the node of the last term built */
+
+    /* the names in scope, by the DAG symbol of the name */
+    smtlib2_pmap term_names_;
+    smtlib2_pmap sort_names_;
+    /* the sort names outside of the parameters of a define-sort */
+    smtlib2_pmap outer_sort_names_;
+    bool in_sort_params_;
+    smtlib2_vector *decls_;
+    /* the bound variables and let bindings in scope, innermost last, as
+     * pairs of name and node (NULL if not known). A scope starts with a
+     * NULL name, paired with the number of variables before it */
+    smtlib2_vector *lexical_;
+    size_t num_vars_;  /* the variables in lexical_ */
+
+    smtlib2_dag_symbol *logic_;
+    /* the nodes of the assertions (NULL if not known), and the state at
+     * every push */
+    smtlib2_vector *assertions_;
+    smtlib2_vector *levels_;
+    bool lazy_asserted_;
+    /* the last check-sat was answered from the cache */
+    bool pending_check_;
+
+    /* the hashing data, grown as the DAG grows. A canonical hash is valid
+     * for one query, identified by its epoch */
+    smtlib2_memo_info *term_info_;
+    size_t term_cap_;
+    smtlib2_memo_info *sort_info_;
+    size_t sort_cap_;
+    smtlib2_memo_symbol_info *symbol_info_;
+    size_t symbol_cap_;
+    size_t symbols_hashed_;
+    uint32_t epoch_;
+    uint32_t next_number_;
+    smtlib2_memo_key decls_key_;
+    smtlib2_vector *stack_;
+    smtlib2_vector *scratch_;
+};
+
+
+static void *smtlib2_memo_grow(void *a, size_t *cap, size_t need,
+                               size_t elem)
+{
+    if (need > *cap) {
+        size_t n = *cap ? *cap : 64;
+        while (n < need) {
+            n *= 2;
+        }
+        a = smtlib2_realloc(a, n * elem);
+        memset((char *)a + *cap * elem, 0, (n - *cap) * elem);
+        *cap = n;
+    }
+    return a;
+}
+
+
+static void smtlib2_memo_grow_symbols(smtlib2_memo *m)
+{
+    size_t n = smtlib2_termdag_num_symbols(m->dag_);
+    m->symbol_info_ = (smtlib2_memo_symbol_info *)smtlib2_memo_grow(
+        m->symbol_info_, &(m->symbol_cap_), n,
+        sizeof(smtlib2_memo_symbol_info));
+    for (; m->symbols_hashed_ < n; ++m->symbols_hashed_) {
+        smtlib2_dag_symbol *s = smtlib2_termdag_symbol(
+            m->dag_, (uint32_t)m->symbols_hashed_);
+        m->symbol_info_[m->symbols_hashed_].hash_ =
+            smtlib2_memo_hash_str(s->name_);
+    }
+}
+
+
+static void smtlib2_memo_grow_info(smtlib2_memo *m)
+{
+    smtlib2_memo_grow_symbols(m);
+    m->term_info_ = (smtlib2_memo_info *)smtlib2_memo_grow(
+        m->term_info_, &(m->term_cap_), smtlib2_termdag_num_terms(m->dag_),
+        sizeof(smtlib2_memo_info));
+    m->sort_info_ = (smtlib2_memo_info *)smtlib2_memo_grow(
+        m->sort_info_, &(m->sort_cap_), smtlib2_termdag_num_sorts(m->dag_),
+        sizeof(smtlib2_memo_info));
+}
+
+
+static smtlib2_dag_symbol *smtlib2_memo_intern(smtlib2_memo *m,
+                                               const char *name)
+{
+    return smtlib2_termdag_intern(m->dag_, name);
+}
+
+
+/* a new symbol for the declaration d of "name", which takes ownership of d */
+static smtlib2_dag_symbol *smtlib2_memo_declare(smtlib2_memo *m,
+                                                const char *name,
+                                                smtlib2_memo_decl *d)
+{
+    char *n = smtlib2_sprintf("\1%s\1%lu", name,
+                              (unsigned long)smtlib2_vector_size(m->decls_));
+    smtlib2_dag_symbol *ret = smtlib2_memo_intern(m, n);
+    smtlib2_free(n);
+    smtlib2_vector_push(m->decls_, (intptr_t)d);
+    smtlib2_memo_grow_symbols(m);
+    m->symbol_info_[ret->id_].decl_ = d;
+    return ret;
+}
+
+
+static smtlib2_memo_decl *smtlib2_memo_decl_new(void)
+{
+    smtlib2_memo_decl *ret =
+        (smtlib2_memo_decl *)smtlib2_malloc(sizeof(smtlib2_memo_decl));
+    memset(ret, 0, sizeof(smtlib2_memo_decl));
+    return ret;
+}
+
+
+static void smtlib2_memo_free_name(intptr_t n)
+{
+    smtlib2_memo_name *nm = (smtlib2_memo_name *)n;
+    smtlib2_free(nm->params_);
+    smtlib2_free(nm);
+}
+
+
+static smtlib2_memo_name *smtlib2_memo_set_name(smtlib2_pmap *names,
+                                                smtlib2_dag_symbol *name)
+{
+    smtlib2_memo_name *ret =
+        (smtlib2_memo_name *)smtlib2_malloc(sizeof(smtlib2_memo_name));
+    memset(ret, 0, sizeof(smtlib2_memo_name));
+    smtlib2_pmap_set(names, (intptr_t)name, (intptr_t)ret);
+    return ret;
+}
+
+
+static smtlib2_dag_term *smtlib2_memo_term(smtlib2_memo *m, smtlib2_term t)
+{
+    intptr_t v;
+    if (t && smtlib2_hashtable_find(m->terms_, (intptr_t)t, &v)) {
+        return (smtlib2_dag_term *)v;
+    }
+    return NULL;
+}
+
+
+static smtlib2_dag_sort *smtlib2_memo_sort(smtlib2_memo *m, smtlib2_sort s)
+{
+    intptr_t v;
+    if (s && smtlib2_hashtable_find(m->sorts_, (intptr_t)s, &v)) {
+        return (smtlib2_dag_sort *)v;
+    }
+    return NULL;
+}
+
+
+/* the backend may return the same term (or a recycled one) for different
+ * nodes, so the last node wins, and a term without a node is forgotten */
+static void smtlib2_memo_map_term(smtlib2_memo *m, smtlib2_term t,
+                                  smtlib2_dag_term *d)
+{
+    if (t) {
+        if (d) {
+            smtlib2_hashtable_set(m->terms_, (intptr_t)t, (intptr_t)d);
+        } else {
+            smtlib2_hashtable_erase(m->terms_, (intptr_t)t);
+        }
+    }
+    m->last_ = t ? d : NULL;
+}
+
+
+static void smtlib2_memo_map_sort(smtlib2_memo *m, smtlib2_sort s,
+                                  smtlib2_dag_sort *d)
+{
+    if (s) {
+        if (d) {
+            smtlib2_hashtable_set(m->sorts_, (intptr_t)s, (intptr_t)d);
+        } else {
+            smtlib2_hashtable_erase(m->sorts_, (intptr_t)s);
+        }
+    }
+}
+
+
+/* the nodes of the terms (or sorts) in v, in the scratch vector. Returns
+ * false if some is not known */
+static bool smtlib2_memo_nodes(smtlib2_memo *m, smtlib2_vector *v, bool sorts)
+{
+    size_t i, n = v ? smtlib2_vector_size(v) : 0;
+    smtlib2_vector_resize(m->scratch_, 0);
+    for (i = 0; i < n; ++i) {
+        intptr_t e = smtlib2_vector_at(v, i);
+        intptr_t d = sorts ? (intptr_t)smtlib2_memo_sort(m, (smtlib2_sort)e) :
+                             (intptr_t)smtlib2_memo_term(m, (smtlib2_term)e);
+        if (!d) {
+            return false;
+        }
+        smtlib2_vector_push(m->scratch_, d);
+    }
+    return true;
+}
+
+
+/* the sort parameters of a define-sort replaced by the given sorts */
+static smtlib2_dag_sort *smtlib2_memo_subst_sort(smtlib2_memo *m,
+                                                 smtlib2_dag_sort *s,
+                                                 size_t n,
+                                                 smtlib2_dag_sort **params,
+                                                 smtlib2_dag_sort **args)
+{
+    smtlib2_dag_sort **a;
+    size_t i;
+
+    for (i = 0; i < n; ++i) {
+        if (s == params[i]) {
+            return args[i];
+        }
+    }
+    if (!s->nargs_) {
+        return s;
+    }
+    a = (smtlib2_dag_sort **)smtlib2_malloc(sizeof(smtlib2_dag_sort *) *
+                                            s->nargs_);
+    for (i = 0; i < s->nargs_; ++i) {
+        a[i] = smtlib2_memo_subst_sort(m, s->args_[i], n, params, args);
+    }
+    s = smtlib2_termdag_mk_sort(m->dag_, s->kind_, s->name_, s->nidx_,
+                                s->idx_, s->nargs_, a);
+    smtlib2_free(a);
+    return s;
+}
+
+
+static void smtlib2_memo_push_lexical(smtlib2_memo *m,
+                                      smtlib2_dag_symbol *name,
+                                      smtlib2_dag_term *t)
+{
+    smtlib2_vector_push(m->lexical_, (intptr_t)name);
+    smtlib2_vector_push(m->lexical_, (intptr_t)t);
+}
+
+
+/* a scope starts with the number of variables before it */
+static void smtlib2_memo_push_scope(smtlib2_memo *m)
+{
+    smtlib2_memo_push_lexical(m, NULL, (smtlib2_dag_term *)m->num_vars_);
+}
+
+
+static void smtlib2_memo_pop_scope(smtlib2_memo *m)
+{
+    size_t n = smtlib2_vector_size(m->lexical_);
+    while (n > 0) {
+        n -= 2;
+        if (!smtlib2_vector_at(m->lexical_, n)) {
+            m->num_vars_ = (size_t)smtlib2_vector_at(m->lexical_, n+1);
+            break;
+        }
+    }
+    smtlib2_vector_resize(m->lexical_, n);
+}
+
+
+/* the index in lexical_ of the first entry of the innermost scope */
+static size_t smtlib2_memo_scope_begin(smtlib2_memo *m)
+{
+    size_t n = smtlib2_vector_size(m->lexical_);
+    while (n > 0 && smtlib2_vector_at(m->lexical_, n-2)) {
+        n -= 2;
+    }
+    return n;
+}
+
+
+static void smtlib2_memo_clear_names(smtlib2_memo *m)
+{
+    smtlib2_pmap_deinit(&(m->term_names_));
+    smtlib2_pmap_init(&(m->term_names_), NULL, NULL, NULL,
+                      smtlib2_memo_free_name);
+    smtlib2_pmap_deinit(&(m->sort_names_));
+    smtlib2_pmap_init(&(m->sort_names_), NULL, NULL, NULL,
+                      smtlib2_memo_free_name);
+}
+
+
+static void smtlib2_memo_free_level(smtlib2_memo_level *l)
+{
+    smtlib2_pmap_deinit(&(l->term_names_));
+    smtlib2_pmap_deinit(&(l->sort_names_));
+    smtlib2_free(l);
+}
+
+
+static void smtlib2_memo_clear_levels(smtlib2_memo *m)
+{
+    size_t i;
+    for (i = 0; i < smtlib2_vector_size(m->levels_); ++i) {
+        smtlib2_memo_free_level(
+            (smtlib2_memo_level *)smtlib2_vector_at(m->levels_, i));
+    }
+    smtlib2_vector_resize(m->levels_, 0);
+}
+
+
+/*
+ * Mirroring the terms and sorts
+ */
+
+static smtlib2_dag_term *smtlib2_memo_mk_app(smtlib2_memo *m,
+                                             const char *symbol,
+                                             smtlib2_sort sort,
+                                             smtlib2_vector *index,
+                                             smtlib2_vector *args)
+{
+    size_t n = args ? smtlib2_vector_size(args) : 0;
+    smtlib2_dag_symbol *name = smtlib2_memo_intern(m, symbol);
+    smtlib2_dag_sort *s = NULL;
+    smtlib2_memo_name *nm;
+    intptr_t v;
+
+    if (!n && !index) {
+        /* a bound variable or a let binding, innermost first */
+        size_t i = smtlib2_vector_size(m->lexical_);
+        while (i > 0) {
+            i -= 2;
+            if (smtlib2_vector_at(m->lexical_, i) == (intptr_t)name) {
+                return (smtlib2_dag_term *)smtlib2_vector_at(m->lexical_,
+                                                             i+1);
+            }
+        }
+    }
+    if (sort && !(s = smtlib2_memo_sort(m, sort))) {
+        return NULL;
+    }
+    if (smtlib2_pmap_find(&(m->term_names_), (intptr_t)name, &v)) {
+        nm = (smtlib2_memo_name *)v;
+        if (nm->term_ && !n && !index) {
+            return nm->term_;
+        }
+        if (!nm->symbol_) {
+            return NULL;
+        }
+        name = nm->symbol_;
+    }
+    if (!smtlib2_memo_nodes(m, args, false)) {
+        return NULL;
+    }
+    return smtlib2_termdag_mk_term(
+        m->dag_, SMTLIB2_DAG_TERM_APP, name, s,
+        index ? smtlib2_vector_size(index) : 0,
+        index ? smtlib2_vector_array(index) : NULL,
+        n, (smtlib2_dag_term **)smtlib2_vector_array(m->scratch_));
+}
+
+
+/* the variables of the innermost scope, followed by the body */
+static smtlib2_dag_term *smtlib2_memo_mk_quantifier(smtlib2_memo *m,
+                                                    smtlib2_dag_term_kind k,
+                                                    smtlib2_term body)
+{
+    smtlib2_dag_term *b = smtlib2_memo_term(m, body);
+    size_t i, n = smtlib2_vector_size(m->lexical_);
+
+    if (!b) {
+        return NULL;
+    }
+    smtlib2_vector_resize(m->scratch_, 0);
+    for (i = smtlib2_memo_scope_begin(m); i < n; i += 2) {
+        intptr_t v = smtlib2_vector_at(m->lexical_, i+1);
+        if (!v) {
+            return NULL;
+        }
+        smtlib2_vector_push(m->scratch_, v);
+    }
+    smtlib2_vector_push(m->scratch_, (intptr_t)b);
+    return smtlib2_termdag_mk_term(
+        m->dag_, k, NULL, NULL, 0, NULL,
+        smtlib2_vector_size(m->scratch_),
+        (smtlib2_dag_term **)smtlib2_vector_array(m->scratch_));
+}
+
+
+static smtlib2_dag_sort *smtlib2_memo_mk_sort(smtlib2_memo *m,
+                                              const char *name,
+                                              smtlib2_vector *index,
+                                              smtlib2_vector *tps)
+{
+    size_t n = tps ? smtlib2_vector_size(tps) : 0;
+    smtlib2_dag_symbol *s = smtlib2_memo_intern(m, name);
+    intptr_t v;
+
+    if (!smtlib2_memo_nodes(m, tps, true)) {
+        return NULL;
+    }
+    if (!index && smtlib2_pmap_find(&(m->sort_names_), (intptr_t)s, &v)) {
+        smtlib2_memo_name *nm = (smtlib2_memo_name *)v;
+        if (nm->sort_) {
+            if (nm->nparams_ != n) {
+                return NULL;
+            }
+            return smtlib2_memo_subst_sort(
+                m, nm->sort_, n, nm->params_,
+                (smtlib2_dag_sort **)smtlib2_vector_array(m->scratch_));
+        }
+        if (!nm->symbol_) {
+            return NULL;
+        }
+        s = nm->symbol_;
+    }
+    return smtlib2_termdag_mk_sort(
+        m->dag_, n ? SMTLIB2_DAG_SORT_PARAMETRIC : SMTLIB2_DAG_SORT_BASIC, s,
+        index ? smtlib2_vector_size(index) : 0,
+        index ? smtlib2_vector_array(index) : NULL,
+        n, (smtlib2_dag_sort **)smtlib2_vector_array(m->scratch_));
+}
+
+
+/*
+ * The canonical hash of the assertions
+ */
+
+static uint64_t smtlib2_memo_sort_shape(smtlib2_memo *m, smtlib2_dag_sort *s);
+
+
+/* the shape of a symbol is the same for all the declarations with the same
+ * sort, whatever their name */
+static uint64_t smtlib2_memo_symbol_shape(smtlib2_memo *m,
+                                          smtlib2_dag_symbol *s)
+{
+    smtlib2_memo_decl *d;
+    if (!s) {
+        return SMTLIB2_MEMO_TAG_NONE;
+    }
+    d = m->symbol_info_[s->id_].decl_;
+    if (!d) {
+        return m->symbol_info_[s->id_].hash_;
+    }
+    return smtlib2_memo_mix(SMTLIB2_MEMO_TAG_USER,
+                            d->is_sort_ ? (uint64_t)d->arity_ :
+                            smtlib2_memo_sort_shape(m, d->sort_));
+}
+
+
+static uint64_t smtlib2_memo_sort_shape(smtlib2_memo *m, smtlib2_dag_sort *s)
+{
+    smtlib2_memo_info *info = &(m->sort_info_[s->id_]);
+    if (!info->has_shape_) {
+        uint64_t h = SMTLIB2_MEMO_TAG_SORT + s->kind_;
+        size_t i;
+        h = smtlib2_memo_mix(h, smtlib2_memo_symbol_shape(m, s->name_));
+        for (i = 0; i < s->nidx_; ++i) {
+            h = smtlib2_memo_mix(h, (uint64_t)s->idx_[i]);
+        }
+        for (i = 0; i < s->nargs_; ++i) {
+            h = smtlib2_memo_mix(h, smtlib2_memo_sort_shape(m, s->args_[i]));
+        }
+        info = &(m->sort_info_[s->id_]);
+        info->shape_ = h;
+        info->has_shape_ = true;
+    }
+    return info->shape_;
+}
+
+
+static void smtlib2_memo_term_shape(smtlib2_memo *m, smtlib2_dag_term *t)
+{
+    smtlib2_memo_info *info = &(m->term_info_[t->id_]);
+    uint64_t h = SMTLIB2_MEMO_TAG_TERM + t->kind_;
+    size_t i;
+
+    h = smtlib2_memo_mix(h, smtlib2_memo_symbol_shape(m, t->symbol_));
+    h = smtlib2_memo_mix(h, t->sort_ ? smtlib2_memo_sort_shape(m, t->sort_) :
+                         SMTLIB2_MEMO_TAG_NONE);
+    for (i = 0; i < t->nidx_; ++i) {
+        h = smtlib2_memo_mix(h, (uint64_t)t->idx_[i]);
+    }
+    for (i = 0; i < t->nargs_; ++i) {
+        h = smtlib2_memo_mix(h, m->term_info_[t->args_[i]->id_].shape_);
+    }
+    info->shape_ = h;
+    info->has_shape_ = true;
+}
+
+
+static uint32_t smtlib2_memo_number(smtlib2_memo *m, smtlib2_dag_symbol *s);
+static void smtlib2_memo_term_canon(smtlib2_memo *m, smtlib2_dag_term *t);
+
+
+static bool smtlib2_memo_done(smtlib2_memo *m, smtlib2_dag_term *t,
+                              bool canon)
+{
+    smtlib2_memo_info *info = &(m->term_info_[t->id_]);
+    return canon ? info->epoch_ == m->epoch_ : info->has_shape_;
+}
+
+
+/* computes the shape (or the canonical hash) of t and of all its subterms,
+ * children first, with an explicit stack (the terms can be very deep). The
+ * symbols are numbered in the order in which they are found */
+static void smtlib2_memo_visit(smtlib2_memo *m, smtlib2_dag_term *t,
+                               bool canon)
+{
+    size_t base = smtlib2_vector_size(m->stack_);
+
+    if (smtlib2_memo_done(m, t, canon)) {
+        return;
+    }
+    smtlib2_vector_push(m->stack_, (intptr_t)t);
+    smtlib2_vector_push(m->stack_, 0);
+    while (smtlib2_vector_size(m->stack_) > base) {
+        size_t n = smtlib2_vector_size(m->stack_);
+        size_t i = (size_t)smtlib2_vector_at(m->stack_, n-1);
+        t = (smtlib2_dag_term *)smtlib2_vector_at(m->stack_, n-2);
+        if (i < t->nargs_) {
+            smtlib2_dag_term *c = t->args_[i];
+            smtlib2_vector_at(m->stack_, n-1) = (intptr_t)(i+1);
+            if (!smtlib2_memo_done(m, c, canon)) {
+                smtlib2_vector_push(m->stack_, (intptr_t)c);
+                smtlib2_vector_push(m->stack_, 0);
+            }
+        } else {
+            smtlib2_vector_resize(m->stack_, n-2);
+            if (!smtlib2_memo_done(m, t, canon)) {
+                if (canon) {
+                    smtlib2_memo_term_canon(m, t);
+                } else {
+                    smtlib2_memo_term_shape(m, t);
+                }
+            }
+        }
+    }
+}
+
+
+static const smtlib2_memo_key *smtlib2_memo_sort_canon(smtlib2_memo *m,
+                                                       smtlib2_dag_sort *s)
+{
+    smtlib2_memo_info *info = &(m->sort_info_[s->id_]);
+    if (info->epoch_ != m->epoch_) {
+        smtlib2_memo_key k;
+        size_t i;
+        smtlib2_memo_key_init(&k, SMTLIB2_MEMO_TAG_SORT + s->kind_);
+        if (s->name_ && m->symbol_info_[s->name_->id_].decl_) {
+            smtlib2_memo_key_add(&k, SMTLIB2_MEMO_TAG_USER);
+            smtlib2_memo_key_add(&k, smtlib2_memo_number(m, s->name_));
+        } else {
+            smtlib2_memo_key_add(&k, s->name_ ?
+                                 m->symbol_info_[s->name_->id_].hash_ :
+                                 SMTLIB2_MEMO_TAG_NONE);
+        }
+        smtlib2_memo_key_add(&k, s->nidx_);
+        for (i = 0; i < s->nidx_; ++i) {
+            smtlib2_memo_key_add(&k, (uint64_t)s->idx_[i]);
+        }
+        smtlib2_memo_key_add(&k, s->nargs_);
+        for (i = 0; i < s->nargs_; ++i) {
+            smtlib2_memo_key_add_key(&k,
+                                     smtlib2_memo_sort_canon(m, s->args_[i]));
+        }
+        info = &(m->sort_info_[s->id_]);
+        info->canon_ = k;
+        info->epoch_ = m->epoch_;
+    }
+    return &(info->canon_);
+}
+
+
+/* the number of a declared symbol in the current query, given the first
+ * time it is found, when its declaration becomes part of the query */
+static uint32_t smtlib2_memo_number(smtlib2_memo *m, smtlib2_dag_symbol *s)
+{
+    smtlib2_memo_symbol_info *si = &(m->symbol_info_[s->id_]);
+    if (si->epoch_ != m->epoch_) {
+        smtlib2_memo_decl *d = si->decl_;
+        uint32_t ret = m->next_number_++;
+        si->epoch_ = m->epoch_;
+        si->number_ = ret;
+        smtlib2_memo_key_add(&(m->decls_key_), ret);
+        if (d->is_sort_) {
+            smtlib2_memo_key_add(&(m->decls_key_), (uint64_t)d->arity_);
+        } else {
+            smtlib2_memo_key_add_key(&(m->decls_key_),
+                                     smtlib2_memo_sort_canon(m, d->sort_));
+        }
+        if (d->body_) {
+            size_t i;
+            smtlib2_memo_key_add(&(m->decls_key_), d->nparams_);
+            for (i = 0; i < d->nparams_; ++i) {
+                smtlib2_memo_visit(m, d->params_[i], true);
+                smtlib2_memo_key_add_key(
+                    &(m->decls_key_),
+                    &(m->term_info_[d->params_[i]->id_].canon_));
+            }
+            smtlib2_memo_visit(m, d->body_, true);
+            smtlib2_memo_key_add_key(&(m->decls_key_),
+                                     &(m->term_info_[d->body_->id_].canon_));
+        }
+        return ret;
+    }
+    return si->number_;
+}
+
+
+static void smtlib2_memo_term_canon(smtlib2_memo *m, smtlib2_dag_term *t)
+{
+    smtlib2_memo_key k;
+    size_t i;
+
+    smtlib2_memo_key_init(&k, SMTLIB2_MEMO_TAG_TERM + t->kind_);
+    if (t->symbol_ && m->symbol_info_[t->symbol_->id_].decl_) {
+        smtlib2_memo_key_add(&k, SMTLIB2_MEMO_TAG_USER);
+        smtlib2_memo_key_add(&k, smtlib2_memo_number(m, t->symbol_));
+    } else {
+        smtlib2_memo_key_add(&k, t->symbol_ ?
+                             m->symbol_info_[t->symbol_->id_].hash_ :
+                             SMTLIB2_MEMO_TAG_NONE);
+    }
+    if (t->sort_) {
+        smtlib2_memo_key_add_key(&k, smtlib2_memo_sort_canon(m, t->sort_));
+    } else {
+        smtlib2_memo_key_add(&k, SMTLIB2_MEMO_TAG_NONE);
+    }
+    smtlib2_memo_key_add(&k, t->nidx_);
+    for (i = 0; i < t->nidx_; ++i) {
+        smtlib2_memo_key_add(&k, (uint64_t)t->idx_[i]);
+    }
+    smtlib2_memo_key_add(&k, t->nargs_);
+    for (i = 0; i < t->nargs_; ++i) {
+        smtlib2_memo_key_add_key(&k,
+                                 &(m->term_info_[t->args_[i]->id_].canon_));
+    }
+    m->term_info_[t->id_].canon_ = k;
+    m->term_info_[t->id_].epoch_ = m->epoch_;
+}
+
+
+typedef struct smtlib2_memo_sorted {
+    uint64_t shape_;
+    uint32_t id_;
+    smtlib2_dag_term *term_;
+} smtlib2_memo_sorted;
+
+
+static int smtlib2_memo_cmp(const void *a, const void *b)
+{
+    const smtlib2_memo_sorted *x = (const smtlib2_memo_sorted *)a;
+    const smtlib2_memo_sorted *y = (const smtlib2_memo_sorted *)b;
+    if (x->shape_ != y->shape_) {
+        return x->shape_ < y->shape_ ? -1 : 1;
+    }
+    return x->id_ < y->id_ ? -1 : (x->id_ > y->id_);
+}
+
+
+/* The key of the live assertions: they are sorted by their shape, which
+ * does not depend on the names of the declared symbols, and then hashed in
+ * that order, numbering the declared symbols as they are found. So two sets
+ * of assertions that differ only by a renaming of the symbols get the same
+ * key, unless two assertions have the same shape, in which case their order
+ * in the assertion stack matters. Returns false if some assertion is not
+ * known */
+static bool smtlib2_memo_query_key(smtlib2_memo *m, smtlib2_memo_key *out)
+{
+    size_t i, j, n = smtlib2_vector_size(m->assertions_);
+    smtlib2_memo_sorted *a;
+
+    for (i = 0; i < n; ++i) {
+        if (!smtlib2_vector_at(m->assertions_, i)) {
+            return false;
+        }
+    }
+    smtlib2_memo_grow_info(m);
+    if (++m->epoch_ == 0) {
+        /* all the hashes computed so far are invalid */
+        for (i = 0; i < m->term_cap_; ++i) {
+            m->term_info_[i].epoch_ = 0;
+        }
+        for (i = 0; i < m->sort_cap_; ++i) {
+            m->sort_info_[i].epoch_ = 0;
+        }
+        for (i = 0; i < m->symbol_cap_; ++i) {
+            m->symbol_info_[i].epoch_ = 0;
+        }
+        m->epoch_ = 1;
+    }
+    m->next_number_ = 0;
+    smtlib2_memo_key_init(&(m->decls_key_), SMTLIB2_MEMO_TAG_DECLS);
+
+    a = (smtlib2_memo_sorted *)smtlib2_malloc(
+        sizeof(smtlib2_memo_sorted) * (n ? n : 1));
+    for (i = 0; i < n; ++i) {
+        smtlib2_dag_term *t =
+            (smtlib2_dag_term *)smtlib2_vector_at(m->assertions_, i);
+        smtlib2_memo_visit(m, t, false);
+        a[i].shape_ = m->term_info_[t->id_].shape_;
+        a[i].id_ = t->id_;
+        a[i].term_ = t;
+    }
+    qsort(a, n, sizeof(smtlib2_memo_sorted), smtlib2_memo_cmp);
+
+    smtlib2_memo_key_init(out, SMTLIB2_MEMO_TAG_QUERY);
+    smtlib2_memo_key_add(out, m->logic_ ?
+                         m->symbol_info_[m->logic_->id_].hash_ :
+                         SMTLIB2_MEMO_TAG_NONE);
+    for (i = 0, j = 0; i < n; ++i) {
+        /* the same assertion twice counts once */
+        if (i > 0 && a[i].term_ == a[i-1].term_) {
+            continue;
+        }
+        smtlib2_memo_visit(m, a[i].term_, true);
+        smtlib2_memo_key_add_key(out, &(m->term_info_[a[i].id_].canon_));
+        ++j;
+    }
+    smtlib2_memo_key_add(out, j);
+    smtlib2_memo_key_add_key(out, &(m->decls_key_));
+
+    smtlib2_free(a);
+    return true;
+}
+
+
+/*
+ * The wrappers of the callbacks. "p" is always the first parameter
+ */
+
+#define SMTLIB2_MEMO_BEGIN                                              \
+    smtlib2_abstract_parser *ap_ = (smtlib2_abstract_parser *)p;        \
+    smtlib2_memo *m_ = ap_->memo_
+
+#define SMTLIB2_MEMO_OK (ap_->response_ != SMTLIB2_RESPONSE_ERROR)
+
+typedef smtlib2_parser_interface pi_t;
+
+
+static void smtlib2_memo_set_logic(pi_t *p, const char *logic)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.set_logic(p, logic);
+    if (SMTLIB2_MEMO_OK) {
+        m_->logic_ = smtlib2_memo_intern(m_, logic);
+    }
+}
+
+
+static void smtlib2_memo_declare_sort(pi_t *p, const char *name, int arity)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.declare_sort(p, name, arity);
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_dag_symbol *s = smtlib2_memo_intern(m_, name);
+        smtlib2_memo_name *nm = smtlib2_memo_set_name(&(m_->sort_names_), s);
+        if (m_->in_sort_params_) {
+            char *n = smtlib2_sprintf("\2%s", name);
+            nm->sort_ = smtlib2_termdag_mk_sort(
+                m_->dag_, SMTLIB2_DAG_SORT_BASIC, smtlib2_memo_intern(m_, n),
+                0, NULL, 0, NULL);
+            smtlib2_free(n);
+        } else {
+            smtlib2_memo_decl *d = smtlib2_memo_decl_new();
+            d->is_sort_ = true;
+            d->arity_ = arity;
+            nm->symbol_ = smtlib2_memo_declare(m_, name, d);
+        }
+    }
+}
+
+
+static void smtlib2_memo_end_sort_params(smtlib2_memo *m)
+{
+    if (m->in_sort_params_) {
+        smtlib2_pmap_assign(&(m->sort_names_), &(m->outer_sort_names_));
+        smtlib2_pmap_deinit(&(m->outer_sort_names_));
+        smtlib2_pmap_init(&(m->outer_sort_names_), NULL, NULL, NULL,
+                          smtlib2_memo_free_name);
+        m->in_sort_params_ = false;
+    }
+}
+
+
+static void smtlib2_memo_define_sort(pi_t *p, const char *name,
+                                     smtlib2_vector *params,
+                                     smtlib2_sort sort)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.define_sort(p, name, params, sort);
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_dag_sort *body = smtlib2_memo_sort(m_, sort);
+        bool ok = smtlib2_memo_nodes(m_, params, true);
+        size_t n = smtlib2_vector_size(m_->scratch_);
+        smtlib2_memo_name *nm;
+        /* the parameters go out of scope */
+        smtlib2_memo_end_sort_params(m_);
+        nm = smtlib2_memo_set_name(&(m_->sort_names_),
+                                   smtlib2_memo_intern(m_, name));
+        if (body && ok) {
+            nm->sort_ = body;
+            nm->nparams_ = n;
+            if (n) {
+                nm->params_ = (smtlib2_dag_sort **)smtlib2_malloc(
+                    sizeof(smtlib2_dag_sort *) * n);
+                memcpy(nm->params_, smtlib2_vector_array(m_->scratch_),
+                       sizeof(smtlib2_dag_sort *) * n);
+            }
+        }
+    }
+}
+
+
+static void smtlib2_memo_push_sort_param_scope(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.push_sort_param_scope(p);
+    smtlib2_memo_end_sort_params(m_);
+    smtlib2_pmap_assign(&(m_->outer_sort_names_), &(m_->sort_names_));
+    m_->in_sort_params_ = true;
+}
+
+
+static void smtlib2_memo_pop_sort_param_scope(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.pop_sort_param_scope(p);
+    smtlib2_memo_end_sort_params(m_);
+}
+
+
+static void smtlib2_memo_declare_function(pi_t *p, const char *name,
+                                          smtlib2_sort sort)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.declare_function(p, name, sort);
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_dag_sort *s = smtlib2_memo_sort(m_, sort);
+        smtlib2_memo_name *nm = smtlib2_memo_set_name(
+            &(m_->term_names_), smtlib2_memo_intern(m_, name));
+        if (s) {
+            smtlib2_memo_decl *d = smtlib2_memo_decl_new();
+            d->sort_ = s;
+            nm->symbol_ = smtlib2_memo_declare(m_, name, d);
+        }
+    }
+}
+
+
+/* bound variables are numbered by their depth, as de Bruijn levels, so
+ * that their names don't matter, and a variable of a let binding can't be
+ * captured by a variable with the same name in the body */
+static void smtlib2_memo_declare_variable(pi_t *p, const char *name,
+                                          smtlib2_sort sort)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.declare_variable(p, name, sort);
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_dag_sort *s = smtlib2_memo_sort(m_, sort);
+        smtlib2_dag_term *v = NULL;
+        if (s) {
+            intptr_t level = (intptr_t)m_->num_vars_;
+            v = smtlib2_termdag_mk_term(m_->dag_, SMTLIB2_DAG_TERM_VAR,
+                                        NULL, s, 1, &level, 0, NULL);
+        }
+        smtlib2_memo_push_lexical(m_, smtlib2_memo_intern(m_, name), v);
+        ++m_->num_vars_;
+    }
+}
+
+
+static void smtlib2_memo_define_function(pi_t *p, const char *name,
+                                         smtlib2_vector *params,
+                                         smtlib2_sort sort,
+                                         smtlib2_term term)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.define_function(p, name, params, sort, term);
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_dag_term *body = smtlib2_memo_term(m_, term);
+        smtlib2_dag_sort *s = smtlib2_memo_sort(m_, sort);
+        smtlib2_memo_name *nm = smtlib2_memo_set_name(
+            &(m_->term_names_), smtlib2_memo_intern(m_, name));
+        size_t i, begin, n;
+
+        if (!params || !smtlib2_vector_size(params)) {
+            nm->term_ = body;
+            return;
+        }
+        /* the parameters are the variables of the innermost scope */
+        begin = smtlib2_memo_scope_begin(m_);
+        n = (smtlib2_vector_size(m_->lexical_) - begin) / 2;
+        for (i = 0; i < n; ++i) {
+            if (!smtlib2_vector_at(m_->lexical_, begin + 2*i + 1)) {
+                body = NULL;
+            }
+        }
+        if (body && s) {
+            smtlib2_memo_decl *d = smtlib2_memo_decl_new();
+            d->sort_ = s;
+            d->body_ = body;
+            d->nparams_ = n;
+            d->params_ = (smtlib2_dag_term **)smtlib2_malloc(
+                sizeof(smtlib2_dag_term *) * n);
+            for (i = 0; i < n; ++i) {
+                d->params_[i] = (smtlib2_dag_term *)smtlib2_vector_at(
+                    m_->lexical_, begin + 2*i + 1);
+            }
+            nm->symbol_ = smtlib2_memo_declare(m_, name, d);
+        }
+    }
+}
+
+
+static void smtlib2_memo_push(pi_t *p, int n)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.push(p, n);
+    if (SMTLIB2_MEMO_OK) {
+        int i;
+        for (i = 0; i < n; ++i) {
+            smtlib2_memo_level *l = (smtlib2_memo_level *)smtlib2_malloc(
+                sizeof(smtlib2_memo_level));
+            l->num_assertions_ = smtlib2_vector_size(m_->assertions_);
+            smtlib2_pmap_init(&(l->term_names_), NULL, NULL, NULL,
+                              smtlib2_memo_free_name);
+            smtlib2_pmap_assign(&(l->term_names_), &(m_->term_names_));
+            smtlib2_pmap_init(&(l->sort_names_), NULL, NULL, NULL,
+                              smtlib2_memo_free_name);
+            smtlib2_pmap_assign(&(l->sort_names_), &(m_->sort_names_));
+            smtlib2_vector_push(m_->levels_, (intptr_t)l);
+        }
+    }
+}
+
+
+static void smtlib2_memo_pop(pi_t *p, int n)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.pop(p, n);
+    m_->pending_check_ = false;
+    if (SMTLIB2_MEMO_OK && n > 0 &&
+        (size_t)n <= smtlib2_vector_size(m_->levels_)) {
+        size_t k = smtlib2_vector_size(m_->levels_) - n;
+        smtlib2_memo_level *l =
+            (smtlib2_memo_level *)smtlib2_vector_at(m_->levels_, k);
+        smtlib2_pmap_assign(&(m_->term_names_), &(l->term_names_));
+        smtlib2_pmap_assign(&(m_->sort_names_), &(l->sort_names_));
+        smtlib2_vector_resize(m_->assertions_, l->num_assertions_);
+        while (smtlib2_vector_size(m_->levels_) > k) {
+            smtlib2_memo_free_level(
+                (smtlib2_memo_level *)smtlib2_vector_last(m_->levels_));
+            smtlib2_vector_pop(m_->levels_);
+        }
+    }
+}
+
+
+static void smtlib2_memo_reset_assertions(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.reset_assertions(p);
+    m_->pending_check_ = false;
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_memo_clear_levels(m_);
+        smtlib2_memo_clear_names(m_);
+        smtlib2_vector_resize(m_->assertions_, 0);
+    }
+}
+
+
+static void smtlib2_memo_reset(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.reset(p);
+    m_->pending_check_ = false;
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_memo_clear_levels(m_);
+        smtlib2_memo_clear_names(m_);
+        smtlib2_vector_resize(m_->assertions_, 0);
+        m_->logic_ = NULL;
+    }
+}
+
+
+static void smtlib2_memo_assert_formula(pi_t *p, smtlib2_term term)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.assert_formula(p, term);
+    m_->pending_check_ = false;
+    m_->lazy_asserted_ = true;
+    if (SMTLIB2_MEMO_OK) {
+        smtlib2_vector_push(m_->assertions_,
+                            (intptr_t)smtlib2_memo_term(m_, term));
+    }
+}
+
+
+/* the default callback forces the term and asserts it, which the layer sees
+ * (and so it doesn't need to know the lazy term) */
+static void smtlib2_memo_assert_lazy_formula(pi_t *p, smtlib2_lazy_term *term)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->lazy_asserted_ = false;
+    m_->orig_.assert_lazy_formula(p, term);
+    m_->pending_check_ = false;
+    if (SMTLIB2_MEMO_OK && !m_->lazy_asserted_) {
+        smtlib2_vector_push(m_->assertions_, (intptr_t)NULL);
+    }
+}
+
+
+static void smtlib2_memo_check_sat(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_memo_stats *st = &(m_->cache_->stats_);
+    smtlib2_memo_key k;
+    bool cacheable, sat;
+
+    m_->pending_check_ = false;
+    if (!SMTLIB2_MEMO_OK) {
+        m_->orig_.check_sat(p);
+        return;
+    }
+    cacheable = smtlib2_memo_query_key(m_, &k);
+    if (cacheable && smtlib2_memo_cache_lookup(m_->cache_, &k, &sat)) {
+        ++st->hits_;
+        ap_->status_ = sat ? SMTLIB2_STATUS_SAT : SMTLIB2_STATUS_UNSAT;
+        ap_->response_ = SMTLIB2_RESPONSE_STATUS;
+        m_->pending_check_ = true;
+        return;
+    }
+    ++st->misses_;
+    if (!cacheable) {
+        ++st->uncacheable_;
+    }
+    m_->orig_.check_sat(p);
+    if (cacheable && ap_->response_ == SMTLIB2_RESPONSE_STATUS &&
+        ap_->status_ != SMTLIB2_STATUS_UNKNOWN) {
+        smtlib2_memo_cache_store(m_->cache_, &k,
+                                 ap_->status_ == SMTLIB2_STATUS_SAT);
+    }
+}
+
+
+/* the commands that need the state of the backend after a check-sat run it
+ * first, if it was answered from the cache */
+static void smtlib2_memo_run_pending(smtlib2_abstract_parser *ap,
+                                     smtlib2_memo *m)
+{
+    if (m->pending_check_ && ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        m->pending_check_ = false;
+        m->orig_.check_sat(SMTLIB2_PARSER_INTERFACE(ap));
+        if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+            smtlib2_abstract_parser_reset_response(ap);
+        }
+    }
+}
+
+
+#define SMTLIB2_MEMO_WRAP_PENDING(name, params, args)                   \
+    static void smtlib2_memo_##name params                              \
+    {                                                                   \
+        SMTLIB2_MEMO_BEGIN;                                             \
+        smtlib2_memo_run_pending(ap_, m_);                              \
+        if (SMTLIB2_MEMO_OK) {                                          \
+            m_->orig_.name args;                                        \
+        }                                                               \
+    }
+
+SMTLIB2_MEMO_WRAP_PENDING(get_assignment, (pi_t *p), (p))
+SMTLIB2_MEMO_WRAP_PENDING(get_unsat_core, (pi_t *p), (p))
+SMTLIB2_MEMO_WRAP_PENDING(get_proof, (pi_t *p), (p))
+SMTLIB2_MEMO_WRAP_PENDING(get_value, (pi_t *p, smtlib2_vector *terms),
+                          (p, terms))
+
+
+/* a syntax error leaves the scopes of the command open */
+static void smtlib2_memo_handle_error(pi_t *p, const char *msg)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.handle_error(p, msg);
+    smtlib2_vector_resize(m_->lexical_, 0);
+    m_->num_vars_ = 0;
+    smtlib2_memo_end_sort_params(m_);
+}
+
+
+static void smtlib2_memo_push_let_scope(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.push_let_scope(p);
+    smtlib2_memo_push_scope(m_);
+}
+
+
+/* a term returned here replaces the body of the let */
+static smtlib2_term smtlib2_memo_pop_let_scope(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_dag_term *body = m_->last_;
+    smtlib2_term ret = m_->orig_.pop_let_scope(p);
+    smtlib2_memo_pop_scope(m_);
+    if (ret) {
+        smtlib2_memo_map_term(m_, ret, body);
+    }
+    return ret;
+}
+
+
+static void smtlib2_memo_push_quantifier_scope(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.push_quantifier_scope(p);
+    smtlib2_memo_push_scope(m_);
+}
+
+
+/* a term returned here replaces the quantifier */
+static smtlib2_term smtlib2_memo_pop_quantifier_scope(pi_t *p)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_dag_term *q = m_->last_;
+    smtlib2_term ret = m_->orig_.pop_quantifier_scope(p);
+    smtlib2_memo_pop_scope(m_);
+    if (ret) {
+        smtlib2_memo_map_term(m_, ret, q);
+    }
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_memo_make_term(pi_t *p, const char *symbol,
+                                          smtlib2_sort sort,
+                                          smtlib2_vector *index,
+                                          smtlib2_vector *args)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_term ret = m_->orig_.make_term(p, symbol, sort, index, args);
+    smtlib2_memo_map_term(m_, ret,
+                          ret ? smtlib2_memo_mk_app(m_, symbol, sort, index,
+                                                    args) : NULL);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_memo_make_number_term(pi_t *p,
+                                                  const char *numval,
+                                                  int width, int base)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_term ret = m_->orig_.make_number_term(p, numval, width, base);
+    intptr_t idx[2];
+    idx[0] = width;
+    idx[1] = base;
+    smtlib2_memo_map_term(
+        m_, ret, ret ? smtlib2_termdag_mk_term(
+            m_->dag_, SMTLIB2_DAG_TERM_NUMBER,
+            smtlib2_memo_intern(m_, numval), NULL, 2, idx, 0, NULL) : NULL);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_memo_make_forall_term(pi_t *p, smtlib2_term term)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_term ret = m_->orig_.make_forall_term(p, term);
+    smtlib2_memo_map_term(
+        m_, ret, ret ? smtlib2_memo_mk_quantifier(
+            m_, SMTLIB2_DAG_TERM_FORALL, term) : NULL);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_memo_make_exists_term(pi_t *p, smtlib2_term term)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_term ret = m_->orig_.make_exists_term(p, term);
+    smtlib2_memo_map_term(
+        m_, ret, ret ? smtlib2_memo_mk_quantifier(
+            m_, SMTLIB2_DAG_TERM_EXISTS, term) : NULL);
+    return ret;
+}
+
+
+/* a :named term can be referred to by its name */
+static void smtlib2_memo_annotate_term(pi_t *p, smtlib2_term term,
+                                       smtlib2_vector *annotations)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.annotate_term(p, term, annotations);
+    if (SMTLIB2_MEMO_OK && term) {
+        size_t i;
+        for (i = 0; i < smtlib2_vector_size(annotations); ++i) {
+            char **an = (char **)smtlib2_vector_at(annotations, i);
+            if (strcmp(an[0], ":named") == 0) {
+                smtlib2_memo_name *nm = smtlib2_memo_set_name(
+                    &(m_->term_names_), smtlib2_memo_intern(m_, an[1]));
+                nm->term_ = smtlib2_memo_term(m_, term);
+            }
+        }
+    }
+}
+
+
+static void smtlib2_memo_define_let_binding(pi_t *p, const char *symbol,
+                                            smtlib2_term term)
+{
+    SMTLIB2_MEMO_BEGIN;
+    m_->orig_.define_let_binding(p, symbol, term);
+    smtlib2_memo_push_lexical(m_, smtlib2_memo_intern(m_, symbol),
+                              smtlib2_memo_term(m_, term));
+}
+
+
+static smtlib2_sort smtlib2_memo_make_sort(pi_t *p, const char *sortname,
+                                          smtlib2_vector *index)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_sort ret = m_->orig_.make_sort(p, sortname, index);
+    smtlib2_memo_map_sort(m_, ret,
+                          ret ? smtlib2_memo_mk_sort(m_, sortname, index,
+                                                     NULL) : NULL);
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_memo_make_parametric_sort(pi_t *p,
+                                                     const char *sortname,
+                                                     smtlib2_vector *tps)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_sort ret = m_->orig_.make_parametric_sort(p, sortname, tps);
+    smtlib2_memo_map_sort(m_, ret,
+                          ret ? smtlib2_memo_mk_sort(m_, sortname, NULL,
+                                                     tps) : NULL);
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_memo_make_function_sort(pi_t *p,
+                                                   smtlib2_vector *tps)
+{
+    SMTLIB2_MEMO_BEGIN;
+    smtlib2_sort ret = m_->orig_.make_function_sort(p, tps);
+    smtlib2_dag_sort *s = NULL;
+    if (ret && smtlib2_memo_nodes(m_, tps, true)) {
+        s = smtlib2_termdag_mk_sort(
+            m_->dag_, SMTLIB2_DAG_SORT_FUNCTION, NULL, 0, NULL,
+            smtlib2_vector_size(m_->scratch_),
+            (smtlib2_dag_sort **)smtlib2_vector_array(m_->scratch_));
+    }
+    smtlib2_memo_map_sort(m_, ret, s);
+    return ret;
+}
+
+
+#define SMTLIB2_MEMO_HOOK(pi, name) \
+    if ((pi)->name) (pi)->name = smtlib2_memo_##name
+
+
+/* the callbacks wrapped by the layer: those of the backend, or the ones
+ * beneath the recorder or the statistics wrappers */
+static smtlib2_parser_interface *smtlib2_memo_target(
+    smtlib2_abstract_parser *p)
+{
+    if (p->recorder_) {
+        return smtlib2_recorder_wrapped(p->recorder_);
+    }
+    return p->stats_ ? smtlib2_parser_stats_wrapped(p->stats_) :
+        SMTLIB2_PARSER_INTERFACE(p);
+}
+
+
+smtlib2_memo *smtlib2_memo_new(struct smtlib2_abstract_parser *p,
+                               smtlib2_memo_cache *c)
+{
+    smtlib2_memo *ret = (smtlib2_memo *)smtlib2_malloc(sizeof(smtlib2_memo));
+    smtlib2_parser_interface *pi = smtlib2_memo_target(p);
+
+    memset(ret, 0, sizeof(smtlib2_memo));
+    ret->cache_ = c;
+    ret->dag_ = smtlib2_termdag_new();
+    ret->terms_ = smtlib2_hashtable_new(NULL, NULL);
+    ret->sorts_ = smtlib2_hashtable_new(NULL, NULL);
+    smtlib2_pmap_init(&(ret->term_names_), NULL, NULL, NULL,
+                      smtlib2_memo_free_name);
+    smtlib2_pmap_init(&(ret->sort_names_), NULL, NULL, NULL,
+                      smtlib2_memo_free_name);
+    smtlib2_pmap_init(&(ret->outer_sort_names_), NULL, NULL, NULL,
+                      smtlib2_memo_free_name);
+    ret->decls_ = smtlib2_vector_new();
+    ret->lexical_ = smtlib2_vector_new();
+    ret->assertions_ = smtlib2_vector_new();
+    ret->levels_ = smtlib2_vector_new();
+    ret->stack_ = smtlib2_vector_new();
+    ret->scratch_ = smtlib2_vector_new();
+
+    ret->orig_ = *pi;
+    SMTLIB2_MEMO_HOOK(pi, set_logic);
+    SMTLIB2_MEMO_HOOK(pi, declare_sort);
+    SMTLIB2_MEMO_HOOK(pi, define_sort);
+    SMTLIB2_MEMO_HOOK(pi, declare_function);
+    SMTLIB2_MEMO_HOOK(pi, declare_variable);
+    SMTLIB2_MEMO_HOOK(pi, define_function);
+    SMTLIB2_MEMO_HOOK(pi, push);
+    SMTLIB2_MEMO_HOOK(pi, pop);
+    SMTLIB2_MEMO_HOOK(pi, reset_assertions);
+    SMTLIB2_MEMO_HOOK(pi, reset);
+    SMTLIB2_MEMO_HOOK(pi, assert_formula);
+    SMTLIB2_MEMO_HOOK(pi, assert_lazy_formula);
+    SMTLIB2_MEMO_HOOK(pi, check_sat);
+    SMTLIB2_MEMO_HOOK(pi, get_assignment);
+    SMTLIB2_MEMO_HOOK(pi, get_unsat_core);
+    SMTLIB2_MEMO_HOOK(pi, get_proof);
+    SMTLIB2_MEMO_HOOK(pi, get_value);
+    SMTLIB2_MEMO_HOOK(pi, handle_error);
+    SMTLIB2_MEMO_HOOK(pi, push_let_scope);
+    SMTLIB2_MEMO_HOOK(pi, pop_let_scope);
+    SMTLIB2_MEMO_HOOK(pi, push_quantifier_scope);
+    SMTLIB2_MEMO_HOOK(pi, pop_quantifier_scope);
+    SMTLIB2_MEMO_HOOK(pi, push_sort_param_scope);
+    SMTLIB2_MEMO_HOOK(pi, pop_sort_param_scope);
+    SMTLIB2_MEMO_HOOK(pi, make_term);
+    SMTLIB2_MEMO_HOOK(pi, make_number_term);
+    SMTLIB2_MEMO_HOOK(pi, make_forall_term);
+    SMTLIB2_MEMO_HOOK(pi, make_exists_term);
+    SMTLIB2_MEMO_HOOK(pi, annotate_term);
+    SMTLIB2_MEMO_HOOK(pi, define_let_binding);
+    SMTLIB2_MEMO_HOOK(pi, make_sort);
+    SMTLIB2_MEMO_HOOK(pi, make_parametric_sort);
+    SMTLIB2_MEMO_HOOK(pi, make_function_sort);
+
+    return ret;
+}
+
+
+void smtlib2_memo_delete(smtlib2_memo *m, struct smtlib2_abstract_parser *p)
+{
+    size_t i;
+
+    *smtlib2_memo_target(p) = m->orig_;
+
+    smtlib2_memo_clear_levels(m);
+    smtlib2_vector_delete(m->levels_);
+    smtlib2_pmap_deinit(&(m->term_names_));
+    smtlib2_pmap_deinit(&(m->sort_names_));
+    smtlib2_pmap_deinit(&(m->outer_sort_names_));
+    for (i = 0; i < smtlib2_vector_size(m->decls_); ++i) {
+        smtlib2_memo_decl *d = (smtlib2_memo_decl *)smtlib2_vector_at(
+            m->decls_, i);
+        smtlib2_free(d->params_);
+        smtlib2_free(d);
+    }
+    smtlib2_vector_delete(m->decls_);
+    smtlib2_vector_delete(m->lexical_);
+    smtlib2_vector_delete(m->assertions_);
+    smtlib2_vector_delete(m->stack_);
+    smtlib2_vector_delete(m->scratch_);
+    smtlib2_hashtable_delete(m->terms_, NULL, NULL);
+    smtlib2_hashtable_delete(m->sorts_, NULL, NULL);
+    smtlib2_termdag_delete(m->dag_);
+    smtlib2_free(m->term_info_);
+    smtlib2_free(m->sort_info_);
+    smtlib2_free(m->symbol_info_);
+    smtlib2_free(m);
+}
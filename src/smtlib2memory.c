@@ -0,0 +1,200 @@
+/* -*- C -*-
+ *
+ * Memory accounting: live and peak bytes per subsystem
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2memory.h"
+#include <stdlib.h>
+
+
+static const char *smtlib2_memory_tag_names[SMTLIB2_MEM_TAG_COUNT] = {
+    "backend",
+    "tokens",
+    "grammar",
+    "bindings",
+    "let-bindings",
+    "symbol-handlers",
+    "term-params",
+    "response"
+};
+
+#ifdef SMTLIB2_THREAD_LOCAL
+static SMTLIB2_THREAD_LOCAL smtlib2_memory_tag smtlib2_current_tag =
+    SMTLIB2_MEM_BACKEND;
+#else
+static smtlib2_memory_tag smtlib2_current_tag = SMTLIB2_MEM_BACKEND;
+#endif
+
+
+const char *smtlib2_memory_tag_name(smtlib2_memory_tag t)
+{
+    return smtlib2_memory_tag_names[t];
+}
+
+
+smtlib2_memory_tag smtlib2_set_memory_tag(smtlib2_memory_tag t)
+{
+    smtlib2_memory_tag ret = smtlib2_current_tag;
+    smtlib2_current_tag = t;
+    return ret;
+}
+
+
+void smtlib2_memory_report_print(const smtlib2_memory_report *r, FILE *out)
+{
+    int i;
+
+    fprintf(out, ";; %-26s %12s %12s\n", "memory", "live(KB)", "peak(KB)");
+    for (i = 0; i < SMTLIB2_MEM_TAG_COUNT; ++i) {
+        fprintf(out, ";; %-26s %12.1f %12.1f\n", smtlib2_memory_tag_names[i],
+                r->live_[i] / 1024.0, r->peak_[i] / 1024.0);
+    }
+    fprintf(out, ";; %-26s %12.1f %12.1f\n", "total",
+            r->total_live_ / 1024.0, r->total_peak_ / 1024.0);
+}
+
+
+/*
+ * The header of a block, padded to keep the alignment of malloc
+ */
+typedef struct smtlib2_memory_header {
+    size_t size_;
+    size_t tag_;
+} smtlib2_memory_header;
+
+#define SMTLIB2_MEMORY_HEADER 16
+#define HEADER(ptr) \
+    ((smtlib2_memory_header *)((char *)(ptr) - SMTLIB2_MEMORY_HEADER))
+
+struct smtlib2_memory_accounting {
+    smtlib2_allocator allocator_;
+    smtlib2_allocator *base_;
+    smtlib2_memory_report report_;
+};
+
+
+static void smtlib2_memory_grow(smtlib2_memory_report *r, size_t tag,
+                                size_t size)
+{
+    r->live_[tag] += size;
+    if (r->live_[tag] > r->peak_[tag]) {
+        r->peak_[tag] = r->live_[tag];
+    }
+    r->total_live_ += size;
+    if (r->total_live_ > r->total_peak_) {
+        r->total_peak_ = r->total_live_;
+    }
+}
+
+
+static void *smtlib2_memory_alloc(void *user_data, size_t size)
+{
+    smtlib2_memory_accounting *a = (smtlib2_memory_accounting *)user_data;
+    smtlib2_memory_header *h = (smtlib2_memory_header *)a->base_->alloc(
+        a->base_->user_data, SMTLIB2_MEMORY_HEADER + size);
+    if (!h) {
+        return NULL;
+    }
+    h->size_ = size;
+    h->tag_ = smtlib2_current_tag;
+    smtlib2_memory_grow(&(a->report_), h->tag_, size);
+    return (char *)h + SMTLIB2_MEMORY_HEADER;
+}
+
+
+static void *smtlib2_memory_realloc(void *user_data, void *ptr, size_t size)
+{
+    smtlib2_memory_accounting *a = (smtlib2_memory_accounting *)user_data;
+    smtlib2_memory_header *h;
+    size_t old;
+
+    if (!ptr) {
+        return smtlib2_memory_alloc(user_data, size);
+    }
+    old = HEADER(ptr)->size_;
+    h = (smtlib2_memory_header *)a->base_->realloc(
+        a->base_->user_data, HEADER(ptr), SMTLIB2_MEMORY_HEADER + size);
+    if (!h) {
+        return NULL;
+    }
+    h->size_ = size;
+    a->report_.live_[h->tag_] -= old;
+    a->report_.total_live_ -= old;
+    smtlib2_memory_grow(&(a->report_), h->tag_, size);
+    return (char *)h + SMTLIB2_MEMORY_HEADER;
+}
+
+
+static void smtlib2_memory_free(void *user_data, void *ptr)
+{
+    smtlib2_memory_accounting *a = (smtlib2_memory_accounting *)user_data;
+    smtlib2_memory_header *h = HEADER(ptr);
+
+    a->report_.live_[h->tag_] -= h->size_;
+    a->report_.total_live_ -= h->size_;
+    a->base_->free(a->base_->user_data, h);
+}
+
+
+smtlib2_memory_accounting *smtlib2_memory_accounting_new(
+    smtlib2_allocator *base)
+{
+    smtlib2_memory_accounting *ret =
+        (smtlib2_memory_accounting *)calloc(1,
+                                            sizeof(smtlib2_memory_accounting));
+    ret->allocator_.alloc = smtlib2_memory_alloc;
+    ret->allocator_.realloc = smtlib2_memory_realloc;
+    ret->allocator_.free = smtlib2_memory_free;
+    ret->allocator_.user_data = ret;
+    ret->base_ = base ? base : smtlib2_default_allocator();
+    return ret;
+}
+
+
+void smtlib2_memory_accounting_delete(smtlib2_memory_accounting *a)
+{
+    free(a);
+}
+
+
+smtlib2_allocator *smtlib2_memory_accounting_allocator(
+    smtlib2_memory_accounting *a)
+{
+    return &(a->allocator_);
+}
+
+
+smtlib2_memory_accounting *smtlib2_memory_accounting_of(smtlib2_allocator *a)
+{
+    if (a && a->alloc == smtlib2_memory_alloc) {
+        return (smtlib2_memory_accounting *)a->user_data;
+    }
+    return NULL;
+}
+
+
+void smtlib2_memory_accounting_report(smtlib2_memory_accounting *a,
+                                      smtlib2_memory_report *out)
+{
+    *out = a->report_;
+}
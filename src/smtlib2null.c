@@ -0,0 +1,226 @@
+/* -*- C -*-
+ *
+ * Null backend for the SMT-LIB v2 parser, accepting everything and doing nothing
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2null.h"
+#include <stdlib.h>
+
+
+/* the value of all the sorts and terms */
+static char smtlib2_null_dummy;
+#define SMTLIB2_NULL_VALUE ((void *)&smtlib2_null_dummy)
+
+
+static void smtlib2_null_parser_success(smtlib2_parser_interface *p)
+{
+}
+
+static void smtlib2_null_parser_declare_sort(smtlib2_parser_interface *p,
+                                             const char *sortname, int arity)
+{
+}
+
+static void smtlib2_null_parser_define_sort(smtlib2_parser_interface *p,
+                                            const char *sortname,
+                                            smtlib2_vector *params,
+                                            smtlib2_sort sort)
+{
+}
+
+static void smtlib2_null_parser_declare_function(smtlib2_parser_interface *p,
+                                                 const char *name,
+                                                 smtlib2_sort sort)
+{
+}
+
+static void smtlib2_null_parser_define_function(smtlib2_parser_interface *p,
+                                                const char *name,
+                                                smtlib2_vector *params,
+                                                smtlib2_sort sort,
+                                                smtlib2_term term)
+{
+}
+
+static void smtlib2_null_parser_scope(smtlib2_parser_interface *p, int n)
+{
+}
+
+static void smtlib2_null_parser_assert_formula(smtlib2_parser_interface *p,
+                                               smtlib2_term term)
+{
+}
+
+static void smtlib2_null_parser_check_sat(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        ap->status_ = SMTLIB2_STATUS_UNKNOWN;
+        ap->response_ = SMTLIB2_RESPONSE_STATUS;
+    }
+}
+
+static void smtlib2_null_parser_unsupported(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        ap->response_ = SMTLIB2_RESPONSE_UNSUPPORTED;
+    }
+}
+
+static void smtlib2_null_parser_get_value(smtlib2_parser_interface *p,
+                                          smtlib2_vector *terms)
+{
+    smtlib2_null_parser_unsupported(p);
+}
+
+static smtlib2_term smtlib2_null_parser_make_quantifier(
+    smtlib2_parser_interface *p, smtlib2_term term)
+{
+    return SMTLIB2_NULL_VALUE;
+}
+
+static smtlib2_term smtlib2_null_parser_pop_quantifier_scope(
+    smtlib2_parser_interface *p)
+{
+    return NULL;
+}
+
+static void smtlib2_null_parser_declare_variable(smtlib2_parser_interface *p,
+                                                 const char *name,
+                                                 smtlib2_sort sort)
+{
+}
+
+static smtlib2_sort smtlib2_null_parser_make_sort(smtlib2_parser_interface *p,
+                                                  const char *sortname,
+                                                  smtlib2_vector *index)
+{
+    return SMTLIB2_NULL_VALUE;
+}
+
+static smtlib2_sort smtlib2_null_parser_make_sort_from_list(
+    smtlib2_parser_interface *p, smtlib2_vector *tps)
+{
+    return SMTLIB2_NULL_VALUE;
+}
+
+static smtlib2_sort smtlib2_null_parser_make_parametric_sort(
+    smtlib2_parser_interface *p, const char *name, smtlib2_vector *tps)
+{
+    return SMTLIB2_NULL_VALUE;
+}
+
+static smtlib2_term smtlib2_null_parser_mk_function(smtlib2_context ctx,
+                                                    const char *symbol,
+                                                    smtlib2_sort sort,
+                                                    smtlib2_vector *index,
+                                                    smtlib2_vector *args)
+{
+    return SMTLIB2_NULL_VALUE;
+}
+
+static smtlib2_term smtlib2_null_parser_mk_number(smtlib2_context ctx,
+                                                  const char *rep,
+                                                  unsigned int width,
+                                                  unsigned int base)
+{
+    return SMTLIB2_NULL_VALUE;
+}
+
+
+smtlib2_parser_interface *SMTLIB2_PARSER_INTERFACE_NULL(smtlib2_null_parser *p)
+{
+    return &(p->parent_.parent_);
+}
+
+
+smtlib2_null_parser *smtlib2_null_parser_new(void)
+{
+    smtlib2_null_parser *ret =
+        (smtlib2_null_parser *)smtlib2_malloc(sizeof(smtlib2_null_parser));
+    smtlib2_null_parser_init(ret, (smtlib2_context)ret);
+    return ret;
+}
+
+
+void smtlib2_null_parser_init(smtlib2_null_parser *p, smtlib2_context ctx)
+{
+    smtlib2_parser_interface *pi;
+    smtlib2_term_parser *tp;
+
+    smtlib2_abstract_parser_init((smtlib2_abstract_parser *)p, ctx);
+
+    pi = SMTLIB2_PARSER_INTERFACE_NULL(p);
+    pi->declare_sort = smtlib2_null_parser_declare_sort;
+    pi->define_sort = smtlib2_null_parser_define_sort;
+    pi->declare_function = smtlib2_null_parser_declare_function;
+    pi->declare_variable = smtlib2_null_parser_declare_variable;
+    pi->define_function = smtlib2_null_parser_define_function;
+    pi->push = smtlib2_null_parser_scope;
+    pi->pop = smtlib2_null_parser_scope;
+    pi->assert_formula = smtlib2_null_parser_assert_formula;
+    pi->check_sat = smtlib2_null_parser_check_sat;
+    pi->get_assertions = smtlib2_null_parser_unsupported;
+    pi->get_unsat_core = smtlib2_null_parser_unsupported;
+    pi->get_proof = smtlib2_null_parser_unsupported;
+    pi->get_assignment = smtlib2_null_parser_unsupported;
+    pi->get_value = smtlib2_null_parser_get_value;
+    pi->push_quantifier_scope = smtlib2_null_parser_success;
+    pi->pop_quantifier_scope = smtlib2_null_parser_pop_quantifier_scope;
+    pi->make_forall_term = smtlib2_null_parser_make_quantifier;
+    pi->make_exists_term = smtlib2_null_parser_make_quantifier;
+    pi->make_sort = smtlib2_null_parser_make_sort;
+    pi->make_parametric_sort = smtlib2_null_parser_make_parametric_sort;
+    pi->make_function_sort = smtlib2_null_parser_make_sort_from_list;
+
+    tp = p->parent_.termparser_;
+    smtlib2_term_parser_set_function_handler(tp,
+                                             smtlib2_null_parser_mk_function);
+    smtlib2_term_parser_set_number_handler(tp, smtlib2_null_parser_mk_number);
+}
+
+
+smtlib2_null_parser *smtlib2_null_parser_new_with_allocator(
+    smtlib2_allocator *a)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(a);
+    smtlib2_null_parser *ret = smtlib2_null_parser_new();
+    smtlib2_set_allocator(prev);
+    return ret;
+}
+
+
+void smtlib2_null_parser_deinit(smtlib2_null_parser *p)
+{
+    smtlib2_abstract_parser_deinit(&(p->parent_));
+}
+
+
+void smtlib2_null_parser_delete(smtlib2_null_parser *p)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->parent_.allocator_);
+    smtlib2_null_parser_deinit(p);
+    smtlib2_free(p);
+    smtlib2_set_allocator(prev);
+}
@@ -0,0 +1,518 @@
+/* -*- C -*-
+ *
+ * Persistent hash maps
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2pmap.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+
+#define SMTLIB2_PMAP_BITS 5
+#define SMTLIB2_PMAP_MASK ((1U << SMTLIB2_PMAP_BITS) - 1)
+
+
+/* a key with its value, shared by all the copies of the map */
+typedef struct smtlib2_pmap_entry {
+    uint32_t refs_;
+    uint32_t hash_;
+    intptr_t key_;
+    intptr_t val_;
+} smtlib2_pmap_entry;
+
+/**
+ * A node of the trie. The slots are indexed by 5 bits of the hash of the
+ * keys, starting from the least significant ones at the root, and only the
+ * used ones are stored. A slot holds an entry or a child node. Keys whose
+ * hashes are equal end up in a collision node, which is just a list of
+ * entries
+ */
+struct smtlib2_pmap_node {
+    uint32_t refs_;
+    uint32_t bitmap_;   /* the used slots, 0 for a collision node */
+    uint32_t leafmap_;  /* the used slots holding an entry, or the number of
+                         * entries of a collision node */
+    void *slots_[1];
+};
+
+
+#if defined(__GNUC__)
+#  define INCREF(x) __atomic_add_fetch(&((x)->refs_), 1, __ATOMIC_RELAXED)
+#  define DECREF(x) __atomic_sub_fetch(&((x)->refs_), 1, __ATOMIC_ACQ_REL)
+#  define REFS(x) __atomic_load_n(&((x)->refs_), __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER)
+#  define INCREF(x) InterlockedIncrement((LONG volatile *)&((x)->refs_))
+#  define DECREF(x) InterlockedDecrement((LONG volatile *)&((x)->refs_))
+#  define REFS(x) ((x)->refs_)
+#else
+/* no atomics, the copies of a map must all be used by the same thread */
+#  define INCREF(x) (++(x)->refs_)
+#  define DECREF(x) (--(x)->refs_)
+#  define REFS(x) ((x)->refs_)
+#endif
+
+#define IS_COLLISION(n) ((n)->bitmap_ == 0)
+#define NUM_SLOTS(n) \
+    (IS_COLLISION(n) ? (n)->leafmap_ : popcount((n)->bitmap_))
+
+
+static uint32_t identity_hashfun(intptr_t key);
+static bool identity_eqfun(intptr_t k1, intptr_t k2);
+
+
+static uint32_t popcount(uint32_t x)
+{
+    x = x - ((x >> 1) & 0x55555555U);
+    x = (x & 0x33333333U) + ((x >> 2) & 0x33333333U);
+    x = (x + (x >> 4)) & 0x0f0f0f0fU;
+    return (x * 0x01010101U) >> 24;
+}
+
+
+static smtlib2_pmap_node *node_alloc(uint32_t bitmap, uint32_t leafmap,
+                                     uint32_t nslots)
+{
+    smtlib2_pmap_node *ret = (smtlib2_pmap_node *)smtlib2_malloc(
+        sizeof(smtlib2_pmap_node) +
+        sizeof(void *) * (nslots ? nslots - 1 : 0));
+    ret->refs_ = 1;
+    ret->bitmap_ = bitmap;
+    ret->leafmap_ = leafmap;
+    return ret;
+}
+
+
+static smtlib2_pmap_entry *entry_new(uint32_t hash, intptr_t key,
+                                     intptr_t val)
+{
+    smtlib2_pmap_entry *ret =
+        (smtlib2_pmap_entry *)smtlib2_malloc(sizeof(smtlib2_pmap_entry));
+    ret->refs_ = 1;
+    ret->hash_ = hash;
+    ret->key_ = key;
+    ret->val_ = val;
+    return ret;
+}
+
+
+static void entry_release(const smtlib2_pmap *m, smtlib2_pmap_entry *e)
+{
+    if (DECREF(e) == 0) {
+        if (m->fk_) {
+            m->fk_(e->key_);
+        }
+        if (m->fv_) {
+            m->fv_(e->val_);
+        }
+        smtlib2_free(e);
+    }
+}
+
+
+/* calls f_entry or f_node on each slot of n, according to its contents */
+#define FOR_SLOTS(m, n, f_entry, f_node)                                 \
+    do {                                                                \
+        uint32_t i_, b_ = (n)->bitmap_;                                 \
+        for (i_ = 0; i_ < NUM_SLOTS(n); ++i_) {                         \
+            bool entry_ = IS_COLLISION(n) ||                            \
+                ((n)->leafmap_ & b_ & (~b_ + 1));                       \
+            b_ &= b_ - 1;                                               \
+            if (entry_) {                                               \
+                f_entry(m, (smtlib2_pmap_entry *)(n)->slots_[i_]);      \
+            } else {                                                    \
+                f_node(m, (smtlib2_pmap_node *)(n)->slots_[i_]);        \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define RETAIN(m, x) INCREF(x)
+
+
+static void node_release(const smtlib2_pmap *m, smtlib2_pmap_node *n)
+{
+    if (n && DECREF(n) == 0) {
+        FOR_SLOTS(m, n, entry_release, node_release);
+        smtlib2_free(n);
+    }
+}
+
+
+/* returns a node equal to n that can be updated in place, consuming the
+ * reference to n */
+static smtlib2_pmap_node *node_unique(const smtlib2_pmap *m,
+                                      smtlib2_pmap_node *n)
+{
+    smtlib2_pmap_node *ret;
+    uint32_t k;
+
+    if (REFS(n) == 1) {
+        return n;
+    }
+    k = NUM_SLOTS(n);
+    ret = node_alloc(n->bitmap_, n->leafmap_, k);
+    memcpy(ret->slots_, n->slots_, sizeof(void *) * k);
+    FOR_SLOTS(m, n, RETAIN, RETAIN);
+    node_release(m, n);
+    return ret;
+}
+
+
+/* returns a node like n with an uninitialized slot inserted at position
+ * pos, consuming the reference to n. The bitmaps are left to the caller */
+static smtlib2_pmap_node *node_grow(const smtlib2_pmap *m,
+                                    smtlib2_pmap_node *n, uint32_t pos)
+{
+    uint32_t k = NUM_SLOTS(n);
+    smtlib2_pmap_node *ret = node_alloc(n->bitmap_, n->leafmap_, k + 1);
+
+    memcpy(ret->slots_, n->slots_, sizeof(void *) * pos);
+    memcpy(ret->slots_ + pos + 1, n->slots_ + pos,
+           sizeof(void *) * (k - pos));
+    if (REFS(n) == 1) {
+        /* the slots are moved to the new node */
+        smtlib2_free(n);
+    } else {
+        FOR_SLOTS(m, n, RETAIN, RETAIN);
+        node_release(m, n);
+    }
+    return ret;
+}
+
+
+/* removes the slot at position pos of n, which must be unique (see
+ * node_unique) and whose slot has already been released. Returns NULL if n
+ * is left empty. The bitmaps are left to the caller */
+static smtlib2_pmap_node *node_shrink(smtlib2_pmap_node *n, uint32_t pos)
+{
+    uint32_t k = NUM_SLOTS(n);
+    if (k == 1) {
+        smtlib2_free(n);
+        return NULL;
+    }
+    memmove(n->slots_ + pos, n->slots_ + pos + 1,
+            sizeof(void *) * (k - pos - 1));
+    return n;
+}
+
+
+/* the hash of the keys in a slot */
+static uint32_t slot_hash(void *slot, bool is_entry)
+{
+    if (is_entry) {
+        return ((smtlib2_pmap_entry *)slot)->hash_;
+    } else {
+        /* a collision node */
+        return ((smtlib2_pmap_entry *)
+                ((smtlib2_pmap_node *)slot)->slots_[0])->hash_;
+    }
+}
+
+
+/* a node with the given entry, and the given entry or collision node, which
+ * have different hashes, at the given depth */
+static smtlib2_pmap_node *merge(smtlib2_pmap_entry *e, void *other,
+                                bool other_is_entry, uint32_t shift)
+{
+    uint32_t h1 = e->hash_, h2 = slot_hash(other, other_is_entry);
+    uint32_t i1 = (h1 >> shift) & SMTLIB2_PMAP_MASK;
+    uint32_t i2 = (h2 >> shift) & SMTLIB2_PMAP_MASK;
+    smtlib2_pmap_node *ret;
+
+    assert(h1 != h2 && shift < 32);
+    if (i1 == i2) {
+        ret = node_alloc(1U << i1, 0, 1);
+        ret->slots_[0] = merge(e, other, other_is_entry,
+                               shift + SMTLIB2_PMAP_BITS);
+    } else {
+        ret = node_alloc((1U << i1) | (1U << i2),
+                         (1U << i1) | (other_is_entry ? (1U << i2) : 0), 2);
+        ret->slots_[i1 < i2 ? 0 : 1] = e;
+        ret->slots_[i1 < i2 ? 1 : 0] = other;
+    }
+    return ret;
+}
+
+
+static bool find(const smtlib2_pmap *m, intptr_t key, uint32_t hash,
+                 smtlib2_pmap_entry **out)
+{
+    smtlib2_pmap_node *n = m->root_;
+    uint32_t shift = 0;
+
+    while (n) {
+        uint32_t bit, pos;
+        if (IS_COLLISION(n)) {
+            for (pos = 0; pos < n->leafmap_; ++pos) {
+                smtlib2_pmap_entry *e = (smtlib2_pmap_entry *)n->slots_[pos];
+                if (e->hash_ == hash && m->eqf_(e->key_, key)) {
+                    *out = e;
+                    return true;
+                }
+            }
+            return false;
+        }
+        bit = 1U << ((hash >> shift) & SMTLIB2_PMAP_MASK);
+        if (!(n->bitmap_ & bit)) {
+            return false;
+        }
+        pos = popcount(n->bitmap_ & (bit - 1));
+        if (n->leafmap_ & bit) {
+            smtlib2_pmap_entry *e = (smtlib2_pmap_entry *)n->slots_[pos];
+            if (e->hash_ == hash && m->eqf_(e->key_, key)) {
+                *out = e;
+                return true;
+            }
+            return false;
+        }
+        n = (smtlib2_pmap_node *)n->slots_[pos];
+        shift += SMTLIB2_PMAP_BITS;
+    }
+    return false;
+}
+
+
+/* inserts the entry, replacing the one with the same key if any, at the
+ * given depth. Consumes the reference to n (which may be NULL), and returns
+ * the new node */
+static smtlib2_pmap_node *insert(const smtlib2_pmap *m, smtlib2_pmap_node *n,
+                                 smtlib2_pmap_entry *e, uint32_t shift,
+                                 bool *replaced)
+{
+    uint32_t bit, pos;
+
+    if (!n) {
+        n = node_alloc(1U << (e->hash_ & SMTLIB2_PMAP_MASK),
+                       1U << (e->hash_ & SMTLIB2_PMAP_MASK), 1);
+        n->slots_[0] = e;
+        return n;
+    }
+    if (IS_COLLISION(n)) {
+        /* reached only with the same hash (see below) */
+        for (pos = 0; pos < n->leafmap_; ++pos) {
+            smtlib2_pmap_entry *old = (smtlib2_pmap_entry *)n->slots_[pos];
+            if (m->eqf_(old->key_, e->key_)) {
+                n = node_unique(m, n);
+                entry_release(m, (smtlib2_pmap_entry *)n->slots_[pos]);
+                n->slots_[pos] = e;
+                *replaced = true;
+                return n;
+            }
+        }
+        n = node_grow(m, n, n->leafmap_);
+        n->slots_[n->leafmap_++] = e;
+        return n;
+    }
+
+    bit = 1U << ((e->hash_ >> shift) & SMTLIB2_PMAP_MASK);
+    pos = popcount(n->bitmap_ & (bit - 1));
+    if (!(n->bitmap_ & bit)) {
+        n = node_grow(m, n, pos);
+        n->bitmap_ |= bit;
+        n->leafmap_ |= bit;
+        n->slots_[pos] = e;
+        return n;
+    }
+
+    n = node_unique(m, n);
+    if (n->leafmap_ & bit) {
+        smtlib2_pmap_entry *old = (smtlib2_pmap_entry *)n->slots_[pos];
+        if (old->hash_ != e->hash_) {
+            n->slots_[pos] = merge(e, old, true, shift + SMTLIB2_PMAP_BITS);
+            n->leafmap_ &= ~bit;
+        } else if (m->eqf_(old->key_, e->key_)) {
+            entry_release(m, old);
+            n->slots_[pos] = e;
+            *replaced = true;
+        } else {
+            smtlib2_pmap_node *c = node_alloc(0, 2, 2);
+            c->slots_[0] = old;
+            c->slots_[1] = e;
+            n->slots_[pos] = c;
+            n->leafmap_ &= ~bit;
+        }
+    } else {
+        smtlib2_pmap_node *c = (smtlib2_pmap_node *)n->slots_[pos];
+        if (IS_COLLISION(c) && slot_hash(c, false) != e->hash_) {
+            n->slots_[pos] = merge(e, c, false, shift + SMTLIB2_PMAP_BITS);
+        } else {
+            n->slots_[pos] = insert(m, c, e, shift + SMTLIB2_PMAP_BITS,
+                                    replaced);
+        }
+    }
+    return n;
+}
+
+
+/* removes the entry with the given key, which must be in the trie rooted at
+ * n. Consumes the reference to n, and returns the new node, or NULL if it
+ * is empty. Nodes left with a single entry are replaced by the entry in
+ * their parent */
+static smtlib2_pmap_node *erase(const smtlib2_pmap *m, smtlib2_pmap_node *n,
+                                intptr_t key, uint32_t hash, uint32_t shift)
+{
+    uint32_t bit, pos;
+
+    n = node_unique(m, n);
+    if (IS_COLLISION(n)) {
+        for (pos = 0; !m->eqf_(((smtlib2_pmap_entry *)
+                                n->slots_[pos])->key_, key); ++pos) {
+        }
+        entry_release(m, (smtlib2_pmap_entry *)n->slots_[pos]);
+        n = node_shrink(n, pos);
+        if (n) {
+            --n->leafmap_;
+        }
+        return n;
+    }
+
+    bit = 1U << ((hash >> shift) & SMTLIB2_PMAP_MASK);
+    pos = popcount(n->bitmap_ & (bit - 1));
+    if (n->leafmap_ & bit) {
+        entry_release(m, (smtlib2_pmap_entry *)n->slots_[pos]);
+    } else {
+        smtlib2_pmap_node *c =
+            erase(m, (smtlib2_pmap_node *)n->slots_[pos], key, hash,
+                  shift + SMTLIB2_PMAP_BITS);
+        if (c && NUM_SLOTS(c) == 1 &&
+            (IS_COLLISION(c) || c->leafmap_ != 0)) {
+            /* pulls up the last entry of the child */
+            smtlib2_pmap_entry *e = (smtlib2_pmap_entry *)c->slots_[0];
+            INCREF(e);
+            node_release(m, c);
+            n->slots_[pos] = e;
+            n->leafmap_ |= bit;
+            return n;
+        } else if (c) {
+            n->slots_[pos] = c;
+            return n;
+        }
+        /* the child is gone, and so is its slot */
+    }
+    n = node_shrink(n, pos);
+    if (n) {
+        n->bitmap_ &= ~bit;
+        n->leafmap_ &= ~bit;
+    }
+    return n;
+}
+
+
+void smtlib2_pmap_init(smtlib2_pmap *m, smtlib2_hashfun hf, smtlib2_eqfun ef,
+                       smtlib2_freefun fk, smtlib2_freefun fv)
+{
+    m->root_ = NULL;
+    m->size_ = 0;
+    m->hf_ = hf ? hf : identity_hashfun;
+    m->eqf_ = ef ? ef : identity_eqfun;
+    m->fk_ = fk;
+    m->fv_ = fv;
+}
+
+
+void smtlib2_pmap_deinit(smtlib2_pmap *m)
+{
+    node_release(m, m->root_);
+    m->root_ = NULL;
+    m->size_ = 0;
+}
+
+
+void smtlib2_pmap_assign(smtlib2_pmap *dest, const smtlib2_pmap *src)
+{
+    if (src->root_) {
+        INCREF(src->root_);
+    }
+    node_release(dest, dest->root_);
+    dest->root_ = src->root_;
+    dest->size_ = src->size_;
+}
+
+
+void smtlib2_pmap_set(smtlib2_pmap *m, intptr_t key, intptr_t val)
+{
+    bool replaced = false;
+    smtlib2_pmap_entry *e = entry_new(m->hf_(key), key, val);
+
+    m->root_ = insert(m, m->root_, e, 0, &replaced);
+    if (!replaced) {
+        ++m->size_;
+    }
+}
+
+
+bool smtlib2_pmap_find_key_value(const smtlib2_pmap *m, intptr_t key,
+                                 intptr_t *out_key, intptr_t *out_val)
+{
+    smtlib2_pmap_entry *e;
+
+    if (!m->root_ || !find(m, key, m->hf_(key), &e)) {
+        return false;
+    }
+    if (out_key) {
+        *out_key = e->key_;
+    }
+    if (out_val) {
+        *out_val = e->val_;
+    }
+    return true;
+}
+
+
+bool smtlib2_pmap_erase(smtlib2_pmap *m, intptr_t key)
+{
+    uint32_t h;
+    smtlib2_pmap_entry *e;
+
+    if (!m->root_) {
+        return false;
+    }
+    h = m->hf_(key);
+    if (!find(m, key, h, &e)) {
+        return false;
+    }
+    m->root_ = erase(m, m->root_, key, h, 0);
+    --m->size_;
+    return true;
+}
+
+
+static uint32_t identity_hashfun(intptr_t key)
+{
+    /* the keys are often pointers or small indices, whose low bits would
+     * make the top levels of the trie very unbalanced: mix them first */
+    uint64_t x = (uint64_t)key;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+
+static bool identity_eqfun(intptr_t k1, intptr_t k2)
+{
+    return k1 == k2;
+}
@@ -0,0 +1,286 @@
+/* -*- C -*-
+ *
+ * Execution of the commands of a backend on a thread of its own
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2queue.h"
+#include "smtparser/smtlib2binary.h"
+#include "smtparser/smtlib2scanner.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SMTLIB2_HAVE_PTHREADS
+#include <pthread.h>
+
+/* how far (in bytes of records) the parser can get ahead of the backend */
+#define SMTLIB2_QUEUE_MAX_PENDING (1 << 24)
+
+/* the records of a command, and its error if the parser found one. Items
+ * are passed between threads, so they are allocated with malloc directly */
+typedef struct smtlib2_queue_item {
+    struct smtlib2_queue_item *next_;
+    char *errmsg_;
+    bool respond_;   /* no command was recorded, but a response is due */
+    size_t size_;
+    char data_[];
+} smtlib2_queue_item;
+
+
+typedef struct smtlib2_queue {
+    pthread_mutex_t lock_;
+    pthread_cond_t changed_;
+    smtlib2_queue_item *head_;
+    smtlib2_queue_item *tail_;
+    size_t pending_;      /* bytes in the queue */
+    size_t pushed_;
+    size_t done_;         /* items executed (or discarded) by the backend */
+    bool closed_;         /* the parser is done */
+    bool stopped_;        /* the backend is done, e.g. after an exit */
+    smtlib2_abstract_parser *backend_;
+} smtlib2_queue;
+
+
+/* returns false if the backend does not take commands anymore */
+static bool smtlib2_queue_push(smtlib2_queue *q, smtlib2_charbuf *records,
+                               const char *errmsg, bool respond, bool wait)
+{
+    size_t size = SMTLIB2_VECTOR_SIZE(records);
+    smtlib2_queue_item *item;
+    bool ret;
+
+    item = (smtlib2_queue_item *)malloc(sizeof(smtlib2_queue_item) + size);
+    item->next_ = NULL;
+    item->errmsg_ = errmsg ? strcpy((char *)malloc(strlen(errmsg) + 1),
+                                    errmsg) : NULL;
+    item->respond_ = respond;
+    item->size_ = size;
+    memcpy(item->data_, smtlib2_charbuf_array(records), size);
+
+    pthread_mutex_lock(&(q->lock_));
+    while (q->pending_ > SMTLIB2_QUEUE_MAX_PENDING && !q->stopped_) {
+        pthread_cond_wait(&(q->changed_), &(q->lock_));
+    }
+    if (q->tail_) {
+        q->tail_->next_ = item;
+    } else {
+        q->head_ = item;
+    }
+    q->tail_ = item;
+    q->pending_ += size;
+    ++q->pushed_;
+    pthread_cond_broadcast(&(q->changed_));
+    while (wait && q->done_ < q->pushed_) {
+        pthread_cond_wait(&(q->changed_), &(q->lock_));
+    }
+    ret = !q->stopped_;
+    pthread_mutex_unlock(&(q->lock_));
+    return ret;
+}
+
+
+/* NULL once the parser is done and the queue is empty */
+static smtlib2_queue_item *smtlib2_queue_pop(smtlib2_queue *q)
+{
+    smtlib2_queue_item *ret;
+
+    pthread_mutex_lock(&(q->lock_));
+    while (!q->head_ && !q->closed_) {
+        pthread_cond_wait(&(q->changed_), &(q->lock_));
+    }
+    ret = q->head_;
+    if (ret) {
+        q->head_ = ret->next_;
+        if (!q->head_) {
+            q->tail_ = NULL;
+        }
+        q->pending_ -= ret->size_;
+    }
+    pthread_mutex_unlock(&(q->lock_));
+    return ret;
+}
+
+
+static void smtlib2_queue_done(smtlib2_queue *q, smtlib2_queue_item *item,
+                               bool stopped)
+{
+    pthread_mutex_lock(&(q->lock_));
+    ++q->done_;
+    q->stopped_ = q->stopped_ || stopped;
+    pthread_cond_broadcast(&(q->changed_));
+    pthread_mutex_unlock(&(q->lock_));
+
+    if (item->errmsg_) {
+        free(item->errmsg_);
+    }
+    free(item);
+}
+
+
+/* the backend thread: replays the commands as they come, until the end of
+ * the script or an exit */
+static void *smtlib2_queue_backend(void *data)
+{
+    smtlib2_queue *q = (smtlib2_queue *)data;
+    smtlib2_abstract_parser *p = q->backend_;
+    smtlib2_parser_interface *pi = SMTLIB2_PARSER_INTERFACE(p);
+    smtlib2_binary_reader *r;
+    smtlib2_queue_item *item;
+    bool stopped = false;
+
+    smtlib2_set_allocator(p->allocator_);
+    r = smtlib2_binary_reader_new_incremental();
+
+    while ((item = smtlib2_queue_pop(q)) != NULL) {
+        if (!stopped) {
+            smtlib2_binary_reader_append(r, item->data_, item->size_);
+            if (!smtlib2_abstract_parser_replay(p, r)) {
+                fprintf(p->errstream_, "(error \"%s\")\n",
+                        smtlib2_binary_reader_get_error_msg(r));
+                stopped = true;
+            } else if ((item->errmsg_ || item->respond_) && !p->exiting_) {
+                if (item->errmsg_) {
+                    pi->handle_error(pi, item->errmsg_);
+                }
+                smtlib2_abstract_parser_print_response(p);
+                smtlib2_abstract_parser_reset_response(p);
+            }
+            stopped = stopped || p->exiting_;
+        }
+        smtlib2_queue_done(q, item, stopped);
+    }
+
+    smtlib2_binary_reader_delete(r);
+    /* the scanners used by the backend for parsing terms */
+    smtlib2_scanner_pool_clear();
+    return NULL;
+}
+
+
+/* returns false if the backend thread can't be started, without reading
+ * the stream */
+static bool smtlib2_queue_run(smtlib2_abstract_parser *backend,
+                              smtlib2_stream *stream, bool interactive)
+{
+    smtlib2_queue q;
+    pthread_t thread;
+    smtlib2_binary_writer *w = smtlib2_binary_writer_new(NULL);
+    smtlib2_abstract_parser *wp = &(w->parent_);
+    smtlib2_scanner *scanner;
+
+    pthread_mutex_init(&(q.lock_), NULL);
+    pthread_cond_init(&(q.changed_), NULL);
+    q.head_ = NULL;
+    q.tail_ = NULL;
+    q.pending_ = 0;
+    q.pushed_ = 0;
+    q.done_ = 0;
+    q.closed_ = false;
+    q.stopped_ = false;
+    q.backend_ = backend;
+
+    if (pthread_create(&thread, NULL, smtlib2_queue_backend, &q) != 0) {
+        pthread_cond_destroy(&(q.changed_));
+        pthread_mutex_destroy(&(q.lock_));
+        smtlib2_binary_writer_delete(w);
+        return false;
+    }
+
+    /* the records are passed to the queue, the file header is not needed */
+    smtlib2_charbuf_resize(w->buf_, 0);
+    scanner = smtlib2_scanner_acquire(stream);
+    if (backend->pipelined_) {
+        smtlib2_scanner_start_pipeline(scanner);
+    }
+    smtlib2_abstract_parser_reset_response(wp);
+
+    /* as in smtlib2_abstract_parser_parse, but instead of printing the
+     * responses of the writer, the commands are queued */
+    while (!smtlib2_scanner_at_end(scanner)) {
+        size_t commands = w->emitted_commands_;
+        bool complete, error, respond;
+        smtlib2_parse(scanner, SMTLIB2_PARSER_INTERFACE_BINARY_WRITER(w));
+        /* a complete command is answered once: by the replay of its record,
+         * or else with the error of the writer or the current response of
+         * the backend */
+        complete = !smtlib2_scanner_at_end(scanner) && !wp->exiting_;
+        error = complete && wp->response_ == SMTLIB2_RESPONSE_ERROR;
+        respond = complete && !error && w->emitted_commands_ == commands;
+        if (SMTLIB2_VECTOR_SIZE(w->buf_) > 0 || error || respond) {
+            if (!smtlib2_queue_push(&q, w->buf_, error ? wp->errmsg_ : NULL,
+                                    respond, interactive)) {
+                break;
+            }
+            smtlib2_charbuf_resize(w->buf_, 0);
+        }
+        smtlib2_abstract_parser_reset_response(wp);
+        if (wp->exiting_) {
+            break;
+        }
+    }
+    smtlib2_scanner_release(scanner);
+
+    pthread_mutex_lock(&(q.lock_));
+    q.closed_ = true;
+    pthread_cond_broadcast(&(q.changed_));
+    pthread_mutex_unlock(&(q.lock_));
+    pthread_join(thread, NULL);
+
+    pthread_cond_destroy(&(q.changed_));
+    pthread_mutex_destroy(&(q.lock_));
+    smtlib2_binary_writer_delete(w);
+    return true;
+}
+
+#endif /* SMTLIB2_HAVE_PTHREADS */
+
+
+void smtlib2_queue_parse(smtlib2_abstract_parser *backend, FILE *src,
+                         bool interactive)
+{
+#ifdef SMTLIB2_HAVE_PTHREADS
+    smtlib2_fstream *stream = smtlib2_fstream_new(src);
+    bool ok = smtlib2_queue_run(backend, (smtlib2_stream *)stream,
+                                interactive);
+    smtlib2_fstream_delete(stream);
+    if (ok) {
+        return;
+    }
+#endif
+    (void)interactive;
+    smtlib2_abstract_parser_parse(backend, src);
+}
+
+
+void smtlib2_queue_parse_buffer(smtlib2_abstract_parser *backend,
+                                const char *data, size_t size)
+{
+#ifdef SMTLIB2_HAVE_PTHREADS
+    smtlib2_mstream *stream = smtlib2_mstream_new(data, size);
+    bool ok = smtlib2_queue_run(backend, (smtlib2_stream *)stream, false);
+    smtlib2_mstream_delete(stream);
+    if (ok) {
+        return;
+    }
+#endif
+    smtlib2_abstract_parser_parse_buffer(backend, data, size);
+}
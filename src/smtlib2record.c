@@ -0,0 +1,1322 @@
+/* -*- C -*-
+ *
+ * Recording of the callbacks of a parser, and replay into a backend
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "smtparser/smtlib2record.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2binary.h"
+#include "smtparser/smtlib2hashtable.h"
+#include "smtparser/smtlib2charbuf.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char smtlib2_record_magic[7] = { 'S','M','T','2','R','E','C' };
+
+#define SMTLIB2_RECORD_FLUSH_SIZE (1 << 16)
+
+typedef enum {
+    SMTLIB2_REC_STRING = 1,
+    SMTLIB2_REC_END,
+    SMTLIB2_REC_SET_LOGIC,
+    SMTLIB2_REC_DECLARE_SORT,
+    SMTLIB2_REC_DEFINE_SORT,
+    SMTLIB2_REC_DECLARE_FUNCTION,
+    SMTLIB2_REC_DECLARE_VARIABLE,
+    SMTLIB2_REC_DEFINE_FUNCTION,
+    SMTLIB2_REC_PUSH,
+    SMTLIB2_REC_POP,
+    SMTLIB2_REC_RESET_ASSERTIONS,
+    SMTLIB2_REC_RESET,
+    SMTLIB2_REC_ASSERT_FORMULA,
+    SMTLIB2_REC_ASSERT_LAZY_FORMULA,
+    SMTLIB2_REC_CHECK_SAT,
+    SMTLIB2_REC_GET_ASSIGNMENT,
+    SMTLIB2_REC_GET_ASSERTIONS,
+    SMTLIB2_REC_GET_UNSAT_CORE,
+    SMTLIB2_REC_GET_PROOF,
+    SMTLIB2_REC_SET_STR_OPTION,
+    SMTLIB2_REC_SET_INT_OPTION,
+    SMTLIB2_REC_SET_RAT_OPTION,
+    SMTLIB2_REC_GET_INFO,
+    SMTLIB2_REC_SET_INFO,
+    SMTLIB2_REC_GET_VALUE,
+    SMTLIB2_REC_EXIT,
+    SMTLIB2_REC_HANDLE_ERROR,
+    SMTLIB2_REC_SET_INTERNAL_PARSED_TERMS,
+    SMTLIB2_REC_PUSH_LET_SCOPE,
+    SMTLIB2_REC_POP_LET_SCOPE,
+    SMTLIB2_REC_PUSH_QUANTIFIER_SCOPE,
+    SMTLIB2_REC_POP_QUANTIFIER_SCOPE,
+    SMTLIB2_REC_PUSH_SORT_PARAM_SCOPE,
+    SMTLIB2_REC_POP_SORT_PARAM_SCOPE,
+    SMTLIB2_REC_MAKE_TERM,
+    SMTLIB2_REC_MAKE_NUMBER_TERM,
+    SMTLIB2_REC_MAKE_FORALL_TERM,
+    SMTLIB2_REC_MAKE_EXISTS_TERM,
+    SMTLIB2_REC_ANNOTATE_TERM,
+    SMTLIB2_REC_DEFINE_LET_BINDING,
+    SMTLIB2_REC_MAKE_SORT,
+    SMTLIB2_REC_MAKE_PARAMETRIC_SORT,
+    SMTLIB2_REC_MAKE_FUNCTION_SORT
+} smtlib2_record_opcode;
+
+
+/*----------------------------------------------------------------------------
+ * recorder
+ *----------------------------------------------------------------------------*/
+
+struct smtlib2_recorder {
+    smtlib2_parser_interface orig_;
+    FILE *out_;
+    smtlib2_charbuf *buf_;
+    smtlib2_hashtable *strings_;  /* string -> id */
+    smtlib2_hashtable *sorts_;    /* handle -> id */
+    smtlib2_hashtable *terms_;    /* handle -> id */
+    uint64_t num_sorts_;
+    uint64_t num_terms_;
+    /* the callbacks being run: only those called with depth_ == 0 come from
+     * the parser */
+    int depth_;
+};
+
+
+static void put_byte(smtlib2_recorder *r, int b)
+{
+    smtlib2_charbuf_push(r->buf_, (char)b);
+}
+
+
+static void put_uint(smtlib2_recorder *r, uint64_t n)
+{
+    smtlib2_binary_put_uint(r->buf_, n);
+}
+
+
+static void put_int(smtlib2_recorder *r, int64_t n)
+{
+    smtlib2_binary_put_int(r->buf_, n);
+}
+
+
+/* the id of the string, interning it (with a STRING record) if needed. This
+ * must be called before the opcode of the record using it is emitted */
+static uint64_t string_id(smtlib2_recorder *r, const char *s)
+{
+    intptr_t id;
+    size_t n;
+
+    if (!s) {
+        return 0;
+    }
+    if (smtlib2_hashtable_find(r->strings_, (intptr_t)s, &id)) {
+        return (uint64_t)id;
+    }
+    id = (intptr_t)smtlib2_hashtable_size(r->strings_) + 1;
+    smtlib2_hashtable_set(r->strings_, (intptr_t)smtlib2_strdup(s), id);
+
+    n = strlen(s);
+    put_byte(r, SMTLIB2_REC_STRING);
+    put_uint(r, n);
+    smtlib2_charbuf_reserve(r->buf_, SMTLIB2_VECTOR_SIZE(r->buf_) + n + 1);
+    memcpy(smtlib2_charbuf_array(r->buf_) + SMTLIB2_VECTOR_SIZE(r->buf_),
+           s, n + 1);
+    SMTLIB2_VECTOR_SIZE(r->buf_) += n + 1;
+    return (uint64_t)id;
+}
+
+
+static void put_handle(smtlib2_hashtable *ids, smtlib2_recorder *r,
+                       intptr_t h)
+{
+    intptr_t id = 0;
+    if (h) {
+        smtlib2_hashtable_find(ids, h, &id);
+    }
+    put_uint(r, (uint64_t)id);
+}
+
+
+static void put_handles(smtlib2_hashtable *ids, smtlib2_recorder *r,
+                        smtlib2_vector *v)
+{
+    size_t i, n;
+    if (!v) {
+        put_uint(r, 0);
+        return;
+    }
+    n = smtlib2_vector_size(v);
+    put_uint(r, (uint64_t)n + 1);
+    for (i = 0; i < n; ++i) {
+        put_handle(ids, r, smtlib2_vector_at(v, i));
+    }
+}
+
+
+static void put_ints(smtlib2_recorder *r, smtlib2_vector *v)
+{
+    size_t i, n;
+    if (!v) {
+        put_uint(r, 0);
+        return;
+    }
+    n = smtlib2_vector_size(v);
+    put_uint(r, (uint64_t)n + 1);
+    for (i = 0; i < n; ++i) {
+        put_int(r, (int64_t)smtlib2_vector_at(v, i));
+    }
+}
+
+
+/* the id of a handle returned by the backend, numbered on first sight */
+static void put_result(smtlib2_hashtable *ids, uint64_t *count,
+                       smtlib2_recorder *r, intptr_t h)
+{
+    intptr_t id = 0;
+    if (h && !smtlib2_hashtable_find(ids, h, &id)) {
+        id = (intptr_t)++(*count);
+        smtlib2_hashtable_set(ids, h, id);
+    }
+    put_uint(r, (uint64_t)id);
+}
+
+
+/* the strings of a lazy term must be interned before the opcode */
+static void put_lazy_term(smtlib2_recorder *r, uint64_t text,
+                          smtlib2_lazy_term *t)
+{
+    put_uint(r, text);
+    put_uint(r, t->offset_);
+    put_int(r, t->line_);
+}
+
+
+/* the wrappers of the callbacks. "p" is always the first parameter */
+#define SMTLIB2_RECORD_BEGIN                                             \
+    smtlib2_abstract_parser *ap_ = (smtlib2_abstract_parser *)p;         \
+    smtlib2_recorder *r_ = ap_->recorder_;                               \
+    bool rec_ = (r_->depth_++ == 0)
+
+#define SMTLIB2_RECORD_END --r_->depth_
+
+#define SMTLIB2_RECORD_NULLARY(name, op)                                 \
+    static void smtlib2_record_##name(smtlib2_parser_interface *p)       \
+    {                                                                    \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            put_byte(r_, op);                                            \
+        }                                                                \
+        r_->orig_.name(p);                                               \
+        SMTLIB2_RECORD_END;                                              \
+    }
+
+typedef smtlib2_parser_interface pi_t;
+
+SMTLIB2_RECORD_NULLARY(reset_assertions, SMTLIB2_REC_RESET_ASSERTIONS)
+SMTLIB2_RECORD_NULLARY(reset, SMTLIB2_REC_RESET)
+SMTLIB2_RECORD_NULLARY(check_sat, SMTLIB2_REC_CHECK_SAT)
+SMTLIB2_RECORD_NULLARY(get_assignment, SMTLIB2_REC_GET_ASSIGNMENT)
+SMTLIB2_RECORD_NULLARY(get_assertions, SMTLIB2_REC_GET_ASSERTIONS)
+SMTLIB2_RECORD_NULLARY(get_unsat_core, SMTLIB2_REC_GET_UNSAT_CORE)
+SMTLIB2_RECORD_NULLARY(get_proof, SMTLIB2_REC_GET_PROOF)
+SMTLIB2_RECORD_NULLARY(exit, SMTLIB2_REC_EXIT)
+SMTLIB2_RECORD_NULLARY(push_let_scope, SMTLIB2_REC_PUSH_LET_SCOPE)
+SMTLIB2_RECORD_NULLARY(push_quantifier_scope,
+                       SMTLIB2_REC_PUSH_QUANTIFIER_SCOPE)
+SMTLIB2_RECORD_NULLARY(push_sort_param_scope,
+                       SMTLIB2_REC_PUSH_SORT_PARAM_SCOPE)
+SMTLIB2_RECORD_NULLARY(pop_sort_param_scope,
+                       SMTLIB2_REC_POP_SORT_PARAM_SCOPE)
+
+
+/* callbacks taking a string and returning nothing */
+#define SMTLIB2_RECORD_STRING(name, op)                                  \
+    static void smtlib2_record_##name(pi_t *p, const char *s)            \
+    {                                                                    \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            uint64_t id = string_id(r_, s);                              \
+            put_byte(r_, op);                                            \
+            put_uint(r_, id);                                            \
+        }                                                                \
+        r_->orig_.name(p, s);                                            \
+        SMTLIB2_RECORD_END;                                              \
+    }
+
+SMTLIB2_RECORD_STRING(set_logic, SMTLIB2_REC_SET_LOGIC)
+SMTLIB2_RECORD_STRING(get_info, SMTLIB2_REC_GET_INFO)
+SMTLIB2_RECORD_STRING(handle_error, SMTLIB2_REC_HANDLE_ERROR)
+
+
+/* callbacks taking two strings */
+#define SMTLIB2_RECORD_STRING2(name, op)                                 \
+    static void smtlib2_record_##name(pi_t *p, const char *s1,           \
+                                      const char *s2)                    \
+    {                                                                    \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            uint64_t id1 = string_id(r_, s1), id2 = string_id(r_, s2);   \
+            put_byte(r_, op);                                            \
+            put_uint(r_, id1);                                           \
+            put_uint(r_, id2);                                           \
+        }                                                                \
+        r_->orig_.name(p, s1, s2);                                       \
+        SMTLIB2_RECORD_END;                                              \
+    }
+
+SMTLIB2_RECORD_STRING2(set_str_option, SMTLIB2_REC_SET_STR_OPTION)
+SMTLIB2_RECORD_STRING2(set_info, SMTLIB2_REC_SET_INFO)
+
+
+/* callbacks taking an integer */
+#define SMTLIB2_RECORD_INT(name, op)                                     \
+    static void smtlib2_record_##name(pi_t *p, int n)                    \
+    {                                                                    \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            put_byte(r_, op);                                            \
+            put_int(r_, n);                                              \
+        }                                                                \
+        r_->orig_.name(p, n);                                            \
+        SMTLIB2_RECORD_END;                                              \
+    }
+
+SMTLIB2_RECORD_INT(push, SMTLIB2_REC_PUSH)
+SMTLIB2_RECORD_INT(pop, SMTLIB2_REC_POP)
+
+
+/* callbacks taking a string and a sort */
+#define SMTLIB2_RECORD_DECLARE(name, op)                                 \
+    static void smtlib2_record_##name(pi_t *p, const char *s,            \
+                                      smtlib2_sort sort)                 \
+    {                                                                    \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            uint64_t id = string_id(r_, s);                              \
+            put_byte(r_, op);                                            \
+            put_uint(r_, id);                                            \
+            put_handle(r_->sorts_, r_, (intptr_t)sort);                  \
+        }                                                                \
+        r_->orig_.name(p, s, sort);                                      \
+        SMTLIB2_RECORD_END;                                              \
+    }
+
+SMTLIB2_RECORD_DECLARE(declare_function, SMTLIB2_REC_DECLARE_FUNCTION)
+SMTLIB2_RECORD_DECLARE(declare_variable, SMTLIB2_REC_DECLARE_VARIABLE)
+
+
+/* callbacks taking a term and returning a term */
+#define SMTLIB2_RECORD_TERM_TERM(name, op)                               \
+    static smtlib2_term smtlib2_record_##name(pi_t *p, smtlib2_term t)   \
+    {                                                                    \
+        smtlib2_term ret;                                                \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            put_byte(r_, op);                                            \
+            put_handle(r_->terms_, r_, (intptr_t)t);                     \
+        }                                                                \
+        ret = r_->orig_.name(p, t);                                      \
+        if (rec_) {                                                      \
+            put_result(r_->terms_, &(r_->num_terms_), r_, (intptr_t)ret);\
+        }                                                                \
+        SMTLIB2_RECORD_END;                                              \
+        return ret;                                                      \
+    }
+
+SMTLIB2_RECORD_TERM_TERM(make_forall_term, SMTLIB2_REC_MAKE_FORALL_TERM)
+SMTLIB2_RECORD_TERM_TERM(make_exists_term, SMTLIB2_REC_MAKE_EXISTS_TERM)
+
+
+/* callbacks closing a scope, and returning a term */
+#define SMTLIB2_RECORD_POP_SCOPE(name, op)                               \
+    static smtlib2_term smtlib2_record_##name(pi_t *p)                   \
+    {                                                                    \
+        smtlib2_term ret;                                                \
+        SMTLIB2_RECORD_BEGIN;                                            \
+        if (rec_) {                                                      \
+            put_byte(r_, op);                                            \
+        }                                                                \
+        ret = r_->orig_.name(p);                                         \
+        if (rec_) {                                                      \
+            put_result(r_->terms_, &(r_->num_terms_), r_, (intptr_t)ret);\
+        }                                                                \
+        SMTLIB2_RECORD_END;                                              \
+        return ret;                                                      \
+    }
+
+SMTLIB2_RECORD_POP_SCOPE(pop_let_scope, SMTLIB2_REC_POP_LET_SCOPE)
+SMTLIB2_RECORD_POP_SCOPE(pop_quantifier_scope,
+                         SMTLIB2_REC_POP_QUANTIFIER_SCOPE)
+
+
+static void smtlib2_record_declare_sort(pi_t *p, const char *name, int arity)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, name);
+        put_byte(r_, SMTLIB2_REC_DECLARE_SORT);
+        put_uint(r_, id);
+        put_int(r_, arity);
+    }
+    r_->orig_.declare_sort(p, name, arity);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_define_sort(pi_t *p, const char *name,
+                                       smtlib2_vector *params,
+                                       smtlib2_sort sort)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, name);
+        put_byte(r_, SMTLIB2_REC_DEFINE_SORT);
+        put_uint(r_, id);
+        put_handles(r_->sorts_, r_, params);
+        put_handle(r_->sorts_, r_, (intptr_t)sort);
+    }
+    r_->orig_.define_sort(p, name, params, sort);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_define_function(pi_t *p, const char *name,
+                                           smtlib2_vector *params,
+                                           smtlib2_sort sort,
+                                           smtlib2_term term)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, name);
+        put_byte(r_, SMTLIB2_REC_DEFINE_FUNCTION);
+        put_uint(r_, id);
+        put_handles(r_->terms_, r_, params);
+        put_handle(r_->sorts_, r_, (intptr_t)sort);
+        put_handle(r_->terms_, r_, (intptr_t)term);
+    }
+    r_->orig_.define_function(p, name, params, sort, term);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_assert_formula(pi_t *p, smtlib2_term term)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        put_byte(r_, SMTLIB2_REC_ASSERT_FORMULA);
+        put_handle(r_->terms_, r_, (intptr_t)term);
+    }
+    r_->orig_.assert_formula(p, term);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_assert_lazy_formula(pi_t *p,
+                                               smtlib2_lazy_term *term)
+{
+    SMTLIB2_RECORD_BEGIN;
+    /* the callback takes ownership of the term */
+    if (rec_) {
+        uint64_t id = string_id(r_, term->text_);
+        put_byte(r_, SMTLIB2_REC_ASSERT_LAZY_FORMULA);
+        put_lazy_term(r_, id, term);
+    }
+    r_->orig_.assert_lazy_formula(p, term);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_set_int_option(pi_t *p, const char *keyword,
+                                          int value)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, keyword);
+        put_byte(r_, SMTLIB2_REC_SET_INT_OPTION);
+        put_uint(r_, id);
+        put_int(r_, value);
+    }
+    r_->orig_.set_int_option(p, keyword, value);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_set_rat_option(pi_t *p, const char *keyword,
+                                          double value)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t bits;
+        int i;
+        uint64_t id = string_id(r_, keyword);
+        memcpy(&bits, &value, sizeof(bits));
+        put_byte(r_, SMTLIB2_REC_SET_RAT_OPTION);
+        put_uint(r_, id);
+        for (i = 0; i < 8; ++i) {
+            put_byte(r_, (int)((bits >> (8 * i)) & 0xff));
+        }
+    }
+    r_->orig_.set_rat_option(p, keyword, value);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_get_value(pi_t *p, smtlib2_vector *terms)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        size_t i, n = smtlib2_vector_size(terms);
+        for (i = 0; i < n; ++i) {
+            string_id(r_, ((smtlib2_lazy_term *)
+                           smtlib2_vector_at(terms, i))->text_);
+        }
+        put_byte(r_, SMTLIB2_REC_GET_VALUE);
+        put_uint(r_, n);
+        for (i = 0; i < n; ++i) {
+            smtlib2_lazy_term *t =
+                (smtlib2_lazy_term *)smtlib2_vector_at(terms, i);
+            put_lazy_term(r_, string_id(r_, t->text_), t);
+        }
+    }
+    r_->orig_.get_value(p, terms);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_set_internal_parsed_terms(pi_t *p,
+                                                     smtlib2_vector *terms)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        put_byte(r_, SMTLIB2_REC_SET_INTERNAL_PARSED_TERMS);
+        put_handles(r_->terms_, r_, terms);
+    }
+    r_->orig_.set_internal_parsed_terms(p, terms);
+    SMTLIB2_RECORD_END;
+}
+
+
+static smtlib2_term smtlib2_record_make_term(pi_t *p, const char *symbol,
+                                             smtlib2_sort sort,
+                                             smtlib2_vector *index,
+                                             smtlib2_vector *args)
+{
+    smtlib2_term ret;
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, symbol);
+        put_byte(r_, SMTLIB2_REC_MAKE_TERM);
+        put_uint(r_, id);
+        put_handle(r_->sorts_, r_, (intptr_t)sort);
+        put_ints(r_, index);
+        put_handles(r_->terms_, r_, args);
+    }
+    ret = r_->orig_.make_term(p, symbol, sort, index, args);
+    if (rec_) {
+        put_result(r_->terms_, &(r_->num_terms_), r_, (intptr_t)ret);
+    }
+    SMTLIB2_RECORD_END;
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_record_make_number_term(pi_t *p,
+                                                    const char *numval,
+                                                    int width, int base)
+{
+    smtlib2_term ret;
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, numval);
+        put_byte(r_, SMTLIB2_REC_MAKE_NUMBER_TERM);
+        put_uint(r_, id);
+        put_int(r_, width);
+        put_int(r_, base);
+    }
+    ret = r_->orig_.make_number_term(p, numval, width, base);
+    if (rec_) {
+        put_result(r_->terms_, &(r_->num_terms_), r_, (intptr_t)ret);
+    }
+    SMTLIB2_RECORD_END;
+    return ret;
+}
+
+
+static void smtlib2_record_annotate_term(pi_t *p, smtlib2_term term,
+                                         smtlib2_vector *annotations)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        size_t i, n = smtlib2_vector_size(annotations);
+        for (i = 0; i < n; ++i) {
+            char **a = (char **)smtlib2_vector_at(annotations, i);
+            string_id(r_, a[0]);
+            string_id(r_, a[1]);
+        }
+        put_byte(r_, SMTLIB2_REC_ANNOTATE_TERM);
+        put_handle(r_->terms_, r_, (intptr_t)term);
+        put_uint(r_, n);
+        for (i = 0; i < n; ++i) {
+            char **a = (char **)smtlib2_vector_at(annotations, i);
+            put_uint(r_, string_id(r_, a[0]));
+            put_uint(r_, string_id(r_, a[1]));
+        }
+    }
+    r_->orig_.annotate_term(p, term, annotations);
+    SMTLIB2_RECORD_END;
+}
+
+
+static void smtlib2_record_define_let_binding(pi_t *p, const char *symbol,
+                                              smtlib2_term term)
+{
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, symbol);
+        put_byte(r_, SMTLIB2_REC_DEFINE_LET_BINDING);
+        put_uint(r_, id);
+        put_handle(r_->terms_, r_, (intptr_t)term);
+    }
+    r_->orig_.define_let_binding(p, symbol, term);
+    SMTLIB2_RECORD_END;
+}
+
+
+static smtlib2_sort smtlib2_record_make_sort(pi_t *p, const char *sortname,
+                                             smtlib2_vector *index)
+{
+    smtlib2_sort ret;
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, sortname);
+        put_byte(r_, SMTLIB2_REC_MAKE_SORT);
+        put_uint(r_, id);
+        put_ints(r_, index);
+    }
+    ret = r_->orig_.make_sort(p, sortname, index);
+    if (rec_) {
+        put_result(r_->sorts_, &(r_->num_sorts_), r_, (intptr_t)ret);
+    }
+    SMTLIB2_RECORD_END;
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_record_make_parametric_sort(pi_t *p,
+                                                        const char *name,
+                                                        smtlib2_vector *tps)
+{
+    smtlib2_sort ret;
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        uint64_t id = string_id(r_, name);
+        put_byte(r_, SMTLIB2_REC_MAKE_PARAMETRIC_SORT);
+        put_uint(r_, id);
+        put_handles(r_->sorts_, r_, tps);
+    }
+    ret = r_->orig_.make_parametric_sort(p, name, tps);
+    if (rec_) {
+        put_result(r_->sorts_, &(r_->num_sorts_), r_, (intptr_t)ret);
+    }
+    SMTLIB2_RECORD_END;
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_record_make_function_sort(pi_t *p,
+                                                      smtlib2_vector *tps)
+{
+    smtlib2_sort ret;
+    SMTLIB2_RECORD_BEGIN;
+    if (rec_) {
+        put_byte(r_, SMTLIB2_REC_MAKE_FUNCTION_SORT);
+        put_handles(r_->sorts_, r_, tps);
+    }
+    ret = r_->orig_.make_function_sort(p, tps);
+    if (rec_) {
+        put_result(r_->sorts_, &(r_->num_sorts_), r_, (intptr_t)ret);
+    }
+    SMTLIB2_RECORD_END;
+    return ret;
+}
+
+
+/* the callbacks are installed where the statistics (if any) pass the calls
+ * to the backend */
+static smtlib2_parser_interface *smtlib2_recorder_target(
+    struct smtlib2_abstract_parser *p)
+{
+    if (p->stats_) {
+        return smtlib2_parser_stats_wrapped(p->stats_);
+    }
+    return SMTLIB2_PARSER_INTERFACE(p);
+}
+
+
+#define SMTLIB2_RECORD_HOOK(pi, name) \
+    if ((pi)->name) (pi)->name = smtlib2_record_##name
+
+
+smtlib2_recorder *smtlib2_recorder_new(struct smtlib2_abstract_parser *p,
+                                       FILE *out)
+{
+    smtlib2_recorder *ret =
+        (smtlib2_recorder *)smtlib2_malloc(sizeof(smtlib2_recorder));
+    smtlib2_parser_interface *pi = smtlib2_recorder_target(p);
+
+    ret->out_ = out;
+    ret->buf_ = smtlib2_charbuf_new();
+    ret->strings_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
+                                          smtlib2_eqfun_str);
+    ret->sorts_ = smtlib2_hashtable_new(NULL, NULL);
+    ret->terms_ = smtlib2_hashtable_new(NULL, NULL);
+    ret->num_sorts_ = 0;
+    ret->num_terms_ = 0;
+    ret->depth_ = 0;
+
+    smtlib2_charbuf_reserve(ret->buf_, SMTLIB2_RECORD_FLUSH_SIZE);
+    smtlib2_charbuf_push_str(ret->buf_, "SMT2REC");
+    put_byte(ret, SMTLIB2_RECORD_VERSION);
+
+    ret->orig_ = *pi;
+    SMTLIB2_RECORD_HOOK(pi, set_logic);
+    SMTLIB2_RECORD_HOOK(pi, declare_sort);
+    SMTLIB2_RECORD_HOOK(pi, define_sort);
+    SMTLIB2_RECORD_HOOK(pi, declare_function);
+    SMTLIB2_RECORD_HOOK(pi, declare_variable);
+    SMTLIB2_RECORD_HOOK(pi, define_function);
+    SMTLIB2_RECORD_HOOK(pi, push);
+    SMTLIB2_RECORD_HOOK(pi, pop);
+    SMTLIB2_RECORD_HOOK(pi, reset_assertions);
+    SMTLIB2_RECORD_HOOK(pi, reset);
+    SMTLIB2_RECORD_HOOK(pi, assert_formula);
+    SMTLIB2_RECORD_HOOK(pi, assert_lazy_formula);
+    SMTLIB2_RECORD_HOOK(pi, check_sat);
+    SMTLIB2_RECORD_HOOK(pi, get_assignment);
+    SMTLIB2_RECORD_HOOK(pi, get_assertions);
+    SMTLIB2_RECORD_HOOK(pi, get_unsat_core);
+    SMTLIB2_RECORD_HOOK(pi, get_proof);
+    SMTLIB2_RECORD_HOOK(pi, set_str_option);
+    SMTLIB2_RECORD_HOOK(pi, set_int_option);
+    SMTLIB2_RECORD_HOOK(pi, set_rat_option);
+    SMTLIB2_RECORD_HOOK(pi, get_info);
+    SMTLIB2_RECORD_HOOK(pi, set_info);
+    SMTLIB2_RECORD_HOOK(pi, get_value);
+    SMTLIB2_RECORD_HOOK(pi, exit);
+    SMTLIB2_RECORD_HOOK(pi, handle_error);
+    SMTLIB2_RECORD_HOOK(pi, set_internal_parsed_terms);
+    SMTLIB2_RECORD_HOOK(pi, push_let_scope);
+    SMTLIB2_RECORD_HOOK(pi, pop_let_scope);
+    SMTLIB2_RECORD_HOOK(pi, push_quantifier_scope);
+    SMTLIB2_RECORD_HOOK(pi, pop_quantifier_scope);
+    SMTLIB2_RECORD_HOOK(pi, push_sort_param_scope);
+    SMTLIB2_RECORD_HOOK(pi, pop_sort_param_scope);
+    SMTLIB2_RECORD_HOOK(pi, make_term);
+    SMTLIB2_RECORD_HOOK(pi, make_number_term);
+    SMTLIB2_RECORD_HOOK(pi, make_forall_term);
+    SMTLIB2_RECORD_HOOK(pi, make_exists_term);
+    SMTLIB2_RECORD_HOOK(pi, annotate_term);
+    SMTLIB2_RECORD_HOOK(pi, define_let_binding);
+    SMTLIB2_RECORD_HOOK(pi, make_sort);
+    SMTLIB2_RECORD_HOOK(pi, make_parametric_sort);
+    SMTLIB2_RECORD_HOOK(pi, make_function_sort);
+
+    return ret;
+}
+
+
+void smtlib2_recorder_end_command(smtlib2_recorder *r)
+{
+    put_byte(r, SMTLIB2_REC_END);
+    if (SMTLIB2_VECTOR_SIZE(r->buf_) >= SMTLIB2_RECORD_FLUSH_SIZE) {
+        smtlib2_recorder_flush(r);
+    }
+}
+
+
+bool smtlib2_recorder_flush(smtlib2_recorder *r)
+{
+    size_t n = SMTLIB2_VECTOR_SIZE(r->buf_);
+    bool ok = true;
+    if (n > 0) {
+        ok = fwrite(smtlib2_charbuf_array(r->buf_), 1, n, r->out_) == n;
+        smtlib2_charbuf_resize(r->buf_, 0);
+    }
+    return fflush(r->out_) == 0 && ok;
+}
+
+
+smtlib2_parser_interface *smtlib2_recorder_wrapped(smtlib2_recorder *r)
+{
+    return &(r->orig_);
+}
+
+
+void smtlib2_recorder_delete(smtlib2_recorder *r,
+                             struct smtlib2_abstract_parser *p)
+{
+    *smtlib2_recorder_target(p) = r->orig_;
+
+    smtlib2_recorder_flush(r);
+    smtlib2_hashtable_delete(r->terms_, NULL, NULL);
+    smtlib2_hashtable_delete(r->sorts_, NULL, NULL);
+    smtlib2_hashtable_delete(r->strings_, (smtlib2_freefun)smtlib2_free,
+                             NULL);
+    smtlib2_charbuf_delete(r->buf_);
+    smtlib2_free(r);
+}
+
+
+/*----------------------------------------------------------------------------
+ * replay
+ *----------------------------------------------------------------------------*/
+
+struct smtlib2_recording {
+    const unsigned char *data_;
+    size_t size_;
+    size_t pos_;
+    bool mapped_;
+    /* indexed by id, with a NULL entry for 0. They are made by every replay,
+     * with the allocator current then */
+    smtlib2_vector *strings_;
+    smtlib2_vector *sorts_;   /* the handles of the backend */
+    smtlib2_vector *terms_;
+    char *errmsg_;
+};
+
+
+static smtlib2_recording *smtlib2_recording_init(const unsigned char *data,
+                                                 size_t size, bool mapped)
+{
+    smtlib2_recording *ret;
+
+    if (size < sizeof(smtlib2_record_magic) + 1 ||
+        memcmp(data, smtlib2_record_magic, sizeof(smtlib2_record_magic)) != 0 ||
+        data[sizeof(smtlib2_record_magic)] != SMTLIB2_RECORD_VERSION) {
+        return NULL;
+    }
+
+    ret = (smtlib2_recording *)smtlib2_malloc(sizeof(smtlib2_recording));
+    ret->data_ = data;
+    ret->size_ = size;
+    ret->pos_ = 0;
+    ret->mapped_ = mapped;
+    ret->strings_ = NULL;
+    ret->sorts_ = NULL;
+    ret->terms_ = NULL;
+    ret->errmsg_ = NULL;
+
+    return ret;
+}
+
+
+smtlib2_recording *smtlib2_recording_new(const char *filename)
+{
+    smtlib2_recording *ret = NULL;
+    size_t size;
+    const char *data = smtlib2_map_file(filename, &size);
+    if (data) {
+        ret = smtlib2_recording_init((const unsigned char *)data, size, true);
+        if (!ret) {
+            smtlib2_unmap_file(data, size);
+        }
+    }
+    return ret;
+}
+
+
+smtlib2_recording *smtlib2_recording_new_from_memory(const char *data,
+                                                     size_t size)
+{
+    return smtlib2_recording_init((const unsigned char *)data, size, false);
+}
+
+
+void smtlib2_recording_delete(smtlib2_recording *r)
+{
+    if (r->mapped_) {
+        smtlib2_unmap_file((const char *)r->data_, r->size_);
+    }
+    if (r->errmsg_) {
+        smtlib2_free(r->errmsg_);
+    }
+    smtlib2_free(r);
+}
+
+
+const char *smtlib2_recording_get_error_msg(smtlib2_recording *r)
+{
+    return r->errmsg_;
+}
+
+
+static bool format_error(smtlib2_recording *r, const char *msg)
+{
+    if (!r->errmsg_) {
+        r->errmsg_ = smtlib2_sprintf("corrupted recording: %s", msg);
+    }
+    return false;
+}
+
+
+static bool get_uint(smtlib2_recording *r, uint64_t *out)
+{
+    if (!smtlib2_binary_get_uint(r->data_, r->size_, &(r->pos_), out)) {
+        return format_error(r, "truncated or malformed number");
+    }
+    return true;
+}
+
+
+static bool get_int(smtlib2_recording *r, int *out)
+{
+    int64_t n;
+    if (!smtlib2_binary_get_int(r->data_, r->size_, &(r->pos_), &n)) {
+        return format_error(r, "truncated or malformed number");
+    }
+    *out = (int)n;
+    return true;
+}
+
+
+/* handles and strings: "table" has an entry for every id seen so far */
+static bool get_entry(smtlib2_recording *r, smtlib2_vector *table,
+                      intptr_t *out)
+{
+    uint64_t id;
+    if (!get_uint(r, &id)) {
+        return false;
+    }
+    if (id >= smtlib2_vector_size(table)) {
+        return format_error(r, "reference to an undefined entry");
+    }
+    *out = smtlib2_vector_at(table, id);
+    return true;
+}
+
+
+static bool get_string(smtlib2_recording *r, const char **out)
+{
+    return get_entry(r, r->strings_, (intptr_t *)out);
+}
+
+
+static bool get_handles(smtlib2_recording *r, smtlib2_vector *table,
+                        smtlib2_vector *tmp, smtlib2_vector **out)
+{
+    uint64_t i, n;
+    intptr_t h;
+    smtlib2_vector_resize(tmp, 0);
+    *out = NULL;
+    if (!get_uint(r, &n)) {
+        return false;
+    }
+    if (n-- == 0) {
+        return true;
+    }
+    for (i = 0; i < n; ++i) {
+        if (!get_entry(r, table, &h)) {
+            return false;
+        }
+        smtlib2_vector_push(tmp, h);
+    }
+    *out = tmp;
+    return true;
+}
+
+
+static bool get_ints(smtlib2_recording *r, smtlib2_vector *tmp,
+                     smtlib2_vector **out)
+{
+    uint64_t i, n;
+    int v;
+    smtlib2_vector_resize(tmp, 0);
+    *out = NULL;
+    if (!get_uint(r, &n)) {
+        return false;
+    }
+    if (n-- == 0) {
+        return true;
+    }
+    for (i = 0; i < n; ++i) {
+        if (!get_int(r, &v)) {
+            return false;
+        }
+        smtlib2_vector_push(tmp, (intptr_t)v);
+    }
+    *out = tmp;
+    return true;
+}
+
+
+/* stores the handle returned by the backend under the recorded id */
+static bool set_result(smtlib2_recording *r, smtlib2_vector *table,
+                       intptr_t h)
+{
+    uint64_t id;
+    if (!get_uint(r, &id)) {
+        return false;
+    }
+    if (id == smtlib2_vector_size(table)) {
+        smtlib2_vector_push(table, h);
+    } else if (id > smtlib2_vector_size(table)) {
+        return format_error(r, "ids out of sequence");
+    } else if (id > 0) {
+        smtlib2_vector_at(table, id) = h;
+    }
+    return true;
+}
+
+
+static bool get_lazy_term(smtlib2_recording *r, smtlib2_lazy_term **out)
+{
+    const char *text;
+    uint64_t offset;
+    int line;
+    if (!get_string(r, &text) || !get_uint(r, &offset) ||
+        !get_int(r, &line)) {
+        return false;
+    }
+    if (!text) {
+        return format_error(r, "missing term text");
+    }
+    *out = smtlib2_lazy_term_new(smtlib2_strdup(text), strlen(text),
+                                 (size_t)offset, line);
+    return true;
+}
+
+
+static bool replay(smtlib2_recording *r, smtlib2_parser_interface *pi,
+                   smtlib2_abstract_parser *ap)
+{
+    smtlib2_vector *tmp1 = smtlib2_vector_new();
+    smtlib2_vector *tmp2 = smtlib2_vector_new();
+    bool ok = true;
+    bool pending = false; /* calls read since the last END record */
+
+    r->pos_ = sizeof(smtlib2_record_magic) + 1;
+    if (r->errmsg_) {
+        smtlib2_free(r->errmsg_);
+        r->errmsg_ = NULL;
+    }
+    r->strings_ = smtlib2_vector_new();
+    r->sorts_ = smtlib2_vector_new();
+    r->terms_ = smtlib2_vector_new();
+    smtlib2_vector_push(r->strings_, 0);
+    smtlib2_vector_push(r->sorts_, 0);
+    smtlib2_vector_push(r->terms_, 0);
+
+    while (ok && r->pos_ < r->size_) {
+        int op = r->data_[r->pos_++];
+        const char *s1, *s2;
+        smtlib2_vector *v1, *v2;
+        intptr_t h1, h2;
+        uint64_t u, i;
+        int n1, n2;
+        smtlib2_lazy_term *lt;
+
+        switch (op) {
+        case SMTLIB2_REC_STRING:
+            if (!get_uint(r, &u)) {
+                ok = false;
+            } else if (u >= r->size_ - r->pos_ ||
+                       r->data_[r->pos_ + u] != '\0') {
+                ok = format_error(r, "malformed string");
+            } else {
+                smtlib2_vector_push(r->strings_,
+                                    (intptr_t)(r->data_ + r->pos_));
+                r->pos_ += u + 1;
+            }
+            break;
+        case SMTLIB2_REC_END:
+            pending = false;
+            if (ap) {
+                smtlib2_abstract_parser_print_response(ap);
+                smtlib2_abstract_parser_reset_response(ap);
+                if (ap->recorder_) {
+                    smtlib2_recorder_end_command(ap->recorder_);
+                }
+            }
+            break;
+        case SMTLIB2_REC_SET_LOGIC:
+            if ((ok = get_string(r, &s1))) {
+                pi->set_logic(pi, s1);
+            }
+            break;
+        case SMTLIB2_REC_DECLARE_SORT:
+            if ((ok = get_string(r, &s1) && get_int(r, &n1))) {
+                pi->declare_sort(pi, s1, n1);
+            }
+            break;
+        case SMTLIB2_REC_DEFINE_SORT:
+            if ((ok = get_string(r, &s1) &&
+                 get_handles(r, r->sorts_, tmp1, &v1) &&
+                 get_entry(r, r->sorts_, &h1))) {
+                pi->define_sort(pi, s1, v1, (smtlib2_sort)h1);
+            }
+            break;
+        case SMTLIB2_REC_DECLARE_FUNCTION:
+        case SMTLIB2_REC_DECLARE_VARIABLE:
+            if ((ok = get_string(r, &s1) && get_entry(r, r->sorts_, &h1))) {
+                if (op == SMTLIB2_REC_DECLARE_FUNCTION) {
+                    pi->declare_function(pi, s1, (smtlib2_sort)h1);
+                } else {
+                    pi->declare_variable(pi, s1, (smtlib2_sort)h1);
+                }
+            }
+            break;
+        case SMTLIB2_REC_DEFINE_FUNCTION:
+            if ((ok = get_string(r, &s1) &&
+                 get_handles(r, r->terms_, tmp1, &v1) &&
+                 get_entry(r, r->sorts_, &h1) &&
+                 get_entry(r, r->terms_, &h2))) {
+                pi->define_function(pi, s1, v1, (smtlib2_sort)h1,
+                                    (smtlib2_term)h2);
+            }
+            break;
+        case SMTLIB2_REC_PUSH:
+        case SMTLIB2_REC_POP:
+            if ((ok = get_int(r, &n1))) {
+                if (op == SMTLIB2_REC_PUSH) {
+                    pi->push(pi, n1);
+                } else {
+                    pi->pop(pi, n1);
+                }
+            }
+            break;
+        case SMTLIB2_REC_RESET_ASSERTIONS: pi->reset_assertions(pi); break;
+        case SMTLIB2_REC_RESET: pi->reset(pi); break;
+        case SMTLIB2_REC_ASSERT_FORMULA:
+            if ((ok = get_entry(r, r->terms_, &h1))) {
+                pi->assert_formula(pi, (smtlib2_term)h1);
+            }
+            break;
+        case SMTLIB2_REC_ASSERT_LAZY_FORMULA:
+            /* the callback takes ownership of the term */
+            if ((ok = get_lazy_term(r, &lt))) {
+                pi->assert_lazy_formula(pi, lt);
+            }
+            break;
+        case SMTLIB2_REC_CHECK_SAT: pi->check_sat(pi); break;
+        case SMTLIB2_REC_GET_ASSIGNMENT: pi->get_assignment(pi); break;
+        case SMTLIB2_REC_GET_ASSERTIONS: pi->get_assertions(pi); break;
+        case SMTLIB2_REC_GET_UNSAT_CORE: pi->get_unsat_core(pi); break;
+        case SMTLIB2_REC_GET_PROOF: pi->get_proof(pi); break;
+        case SMTLIB2_REC_SET_STR_OPTION:
+            if ((ok = get_string(r, &s1) && get_string(r, &s2))) {
+                pi->set_str_option(pi, s1, s2);
+            }
+            break;
+        case SMTLIB2_REC_SET_INT_OPTION:
+            if ((ok = get_string(r, &s1) && get_int(r, &n1))) {
+                pi->set_int_option(pi, s1, n1);
+            }
+            break;
+        case SMTLIB2_REC_SET_RAT_OPTION:
+            if ((ok = get_string(r, &s1))) {
+                uint64_t bits = 0;
+                double d;
+                if (r->size_ - r->pos_ < 8) {
+                    ok = format_error(r, "truncated option value");
+                    break;
+                }
+                for (i = 0; i < 8; ++i) {
+                    bits |= ((uint64_t)r->data_[r->pos_++]) << (8 * i);
+                }
+                memcpy(&d, &bits, sizeof(d));
+                pi->set_rat_option(pi, s1, d);
+            }
+            break;
+        case SMTLIB2_REC_GET_INFO:
+            if ((ok = get_string(r, &s1))) {
+                pi->get_info(pi, s1);
+            }
+            break;
+        case SMTLIB2_REC_SET_INFO:
+            if ((ok = get_string(r, &s1) && get_string(r, &s2))) {
+                pi->set_info(pi, s1, s2);
+            }
+            break;
+        case SMTLIB2_REC_GET_VALUE:
+            smtlib2_vector_resize(tmp1, 0);
+            if ((ok = get_uint(r, &u))) {
+                for (i = 0; ok && i < u; ++i) {
+                    if ((ok = get_lazy_term(r, &lt))) {
+                        smtlib2_vector_push(tmp1, (intptr_t)lt);
+                    }
+                }
+                if (ok) {
+                    pi->get_value(pi, tmp1);
+                }
+                for (i = 0; i < smtlib2_vector_size(tmp1); ++i) {
+                    smtlib2_lazy_term_delete(
+                        (smtlib2_lazy_term *)smtlib2_vector_at(tmp1, i));
+                }
+            }
+            break;
+        case SMTLIB2_REC_EXIT:
+            pi->exit(pi);
+            break;
+        case SMTLIB2_REC_HANDLE_ERROR:
+            if ((ok = get_string(r, &s1))) {
+                pi->handle_error(pi, s1);
+            }
+            break;
+        case SMTLIB2_REC_SET_INTERNAL_PARSED_TERMS:
+            if ((ok = get_handles(r, r->terms_, tmp1, &v1))) {
+                pi->set_internal_parsed_terms(pi, v1);
+            }
+            break;
+        case SMTLIB2_REC_PUSH_LET_SCOPE: pi->push_let_scope(pi); break;
+        case SMTLIB2_REC_POP_LET_SCOPE:
+            ok = set_result(r, r->terms_, (intptr_t)pi->pop_let_scope(pi));
+            break;
+        case SMTLIB2_REC_PUSH_QUANTIFIER_SCOPE:
+            pi->push_quantifier_scope(pi);
+            break;
+        case SMTLIB2_REC_POP_QUANTIFIER_SCOPE:
+            ok = set_result(r, r->terms_,
+                            (intptr_t)pi->pop_quantifier_scope(pi));
+            break;
+        case SMTLIB2_REC_PUSH_SORT_PARAM_SCOPE:
+            pi->push_sort_param_scope(pi);
+            break;
+        case SMTLIB2_REC_POP_SORT_PARAM_SCOPE:
+            pi->pop_sort_param_scope(pi);
+            break;
+        case SMTLIB2_REC_MAKE_TERM:
+            if ((ok = get_string(r, &s1) && get_entry(r, r->sorts_, &h1) &&
+                 get_ints(r, tmp1, &v1) &&
+                 get_handles(r, r->terms_, tmp2, &v2))) {
+                ok = set_result(r, r->terms_, (intptr_t)pi->make_term(
+                                    pi, s1, (smtlib2_sort)h1, v1, v2));
+            }
+            break;
+        case SMTLIB2_REC_MAKE_NUMBER_TERM:
+            if ((ok = get_string(r, &s1) && get_int(r, &n1) &&
+                 get_int(r, &n2))) {
+                ok = set_result(r, r->terms_, (intptr_t)pi->make_number_term(
+                                    pi, s1, n1, n2));
+            }
+            break;
+        case SMTLIB2_REC_MAKE_FORALL_TERM:
+        case SMTLIB2_REC_MAKE_EXISTS_TERM:
+            if ((ok = get_entry(r, r->terms_, &h1))) {
+                smtlib2_term t = op == SMTLIB2_REC_MAKE_FORALL_TERM ?
+                    pi->make_forall_term(pi, (smtlib2_term)h1) :
+                    pi->make_exists_term(pi, (smtlib2_term)h1);
+                ok = set_result(r, r->terms_, (intptr_t)t);
+            }
+            break;
+        case SMTLIB2_REC_ANNOTATE_TERM:
+            if (!get_entry(r, r->terms_, &h1) || !get_uint(r, &u)) {
+                ok = false;
+                break;
+            }
+            if (u > r->size_ - r->pos_) {
+                ok = format_error(r, "too many annotations");
+                break;
+            }
+            {
+                char **pairs =
+                    (char **)smtlib2_malloc(sizeof(char *) * 2 * (u+1));
+                smtlib2_vector_resize(tmp1, 0);
+                for (i = 0; ok && i < u; ++i) {
+                    ok = get_string(r, &s1) && get_string(r, &s2);
+                    pairs[2*i] = (char *)s1;
+                    pairs[2*i+1] = (char *)s2;
+                    smtlib2_vector_push(tmp1, (intptr_t)&pairs[2*i]);
+                }
+                if (ok) {
+                    pi->annotate_term(pi, (smtlib2_term)h1, tmp1);
+                }
+                smtlib2_free(pairs);
+            }
+            break;
+        case SMTLIB2_REC_DEFINE_LET_BINDING:
+            if ((ok = get_string(r, &s1) && get_entry(r, r->terms_, &h1))) {
+                pi->define_let_binding(pi, s1, (smtlib2_term)h1);
+            }
+            break;
+        case SMTLIB2_REC_MAKE_SORT:
+            if ((ok = get_string(r, &s1) && get_ints(r, tmp1, &v1))) {
+                ok = set_result(r, r->sorts_, (intptr_t)pi->make_sort(
+                                    pi, s1, v1));
+            }
+            break;
+        case SMTLIB2_REC_MAKE_PARAMETRIC_SORT:
+            if ((ok = get_string(r, &s1) &&
+                 get_handles(r, r->sorts_, tmp1, &v1))) {
+                ok = set_result(r, r->sorts_,
+                                (intptr_t)pi->make_parametric_sort(
+                                    pi, s1, v1));
+            }
+            break;
+        case SMTLIB2_REC_MAKE_FUNCTION_SORT:
+            if ((ok = get_handles(r, r->sorts_, tmp1, &v1))) {
+                ok = set_result(r, r->sorts_,
+                                (intptr_t)pi->make_function_sort(pi, v1));
+            }
+            break;
+        default:
+            ok = format_error(r, "unknown record");
+        }
+
+        if (op != SMTLIB2_REC_STRING && op != SMTLIB2_REC_END) {
+            pending = true;
+        }
+        if (ap && ap->exiting_) {
+            break;
+        }
+    }
+    if (ok && pending && !(ap && ap->exiting_)) {
+        ok = format_error(r, "truncated command");
+    }
+
+    smtlib2_vector_delete(r->terms_);
+    smtlib2_vector_delete(r->sorts_);
+    smtlib2_vector_delete(r->strings_);
+    r->terms_ = r->sorts_ = r->strings_ = NULL;
+    smtlib2_vector_delete(tmp2);
+    smtlib2_vector_delete(tmp1);
+    return ok;
+}
+
+
+bool smtlib2_recording_replay(smtlib2_recording *r,
+                              smtlib2_parser_interface *parser)
+{
+    return replay(r, parser, NULL);
+}
+
+
+bool smtlib2_abstract_parser_replay_recording(
+    struct smtlib2_abstract_parser *p, smtlib2_recording *r)
+{
+    bool ret;
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+    smtlib2_abstract_parser_reset_response(p);
+    ret = replay(r, SMTLIB2_PARSER_INTERFACE(p), p);
+    smtlib2_abstract_parser_reset_response(p);
+    smtlib2_set_allocator(prev);
+    return ret;
+}
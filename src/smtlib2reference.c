@@ -0,0 +1,927 @@
+/* -*- C -*-
+ *
+ * Reference backend for the SMT-LIB v2 parser, with no solver behind it
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2reference.h"
+#include "smtparser/smtlib2handlertable.h"
+#include "smtparser/smtlib2snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static void smtlib2_reference_parser_declare_sort(smtlib2_parser_interface *p,
+                                                  const char *sortname,
+                                                  int arity);
+static void smtlib2_reference_parser_define_sort(smtlib2_parser_interface *p,
+                                                 const char *sortname,
+                                                 smtlib2_vector *params,
+                                                 smtlib2_sort sort);
+static void smtlib2_reference_parser_declare_function(
+                                                    smtlib2_parser_interface *p,
+                                                    const char *name,
+                                                    smtlib2_sort sort);
+static void smtlib2_reference_parser_declare_variable(
+                                                    smtlib2_parser_interface *p,
+                                                    const char *name,
+                                                    smtlib2_sort sort);
+static void smtlib2_reference_parser_define_function(
+                                                    smtlib2_parser_interface *p,
+                                                    const char *name,
+                                                    smtlib2_vector *params,
+                                                    smtlib2_sort sort,
+                                                    smtlib2_term term);
+static void smtlib2_reference_parser_assert_formula(smtlib2_parser_interface *p,
+                                                    smtlib2_term term);
+static void smtlib2_reference_parser_check_sat(smtlib2_parser_interface *p);
+static void smtlib2_reference_parser_unsupported(smtlib2_parser_interface *p);
+static void smtlib2_reference_parser_get_value(smtlib2_parser_interface *p,
+                                               smtlib2_vector *terms);
+static void smtlib2_reference_parser_push_quantifier_scope(
+                                                   smtlib2_parser_interface *p);
+static smtlib2_term smtlib2_reference_parser_pop_quantifier_scope(
+                                                   smtlib2_parser_interface *p);
+static smtlib2_term smtlib2_reference_parser_make_forall_term(
+                                                   smtlib2_parser_interface *p,
+                                                   smtlib2_term term);
+static smtlib2_term smtlib2_reference_parser_make_exists_term(
+                                                   smtlib2_parser_interface *p,
+                                                   smtlib2_term term);
+static void smtlib2_reference_parser_annotate_term(smtlib2_parser_interface *p,
+                                                   smtlib2_term term,
+                                                   smtlib2_vector *annotations);
+static smtlib2_sort smtlib2_reference_parser_make_sort(
+                                                    smtlib2_parser_interface *p,
+                                                    const char *sortname,
+                                                    smtlib2_vector *index);
+static smtlib2_sort smtlib2_reference_parser_make_parametric_sort(
+                                                    smtlib2_parser_interface *p,
+                                                    const char *name,
+                                                    smtlib2_vector *tps);
+static smtlib2_sort smtlib2_reference_parser_make_function_sort(
+                                                    smtlib2_parser_interface *p,
+                                                    smtlib2_vector *tps);
+
+static smtlib2_term smtlib2_reference_parser_mk_function(smtlib2_context ctx,
+                                                         const char *symbol,
+                                                         smtlib2_sort sort,
+                                                         smtlib2_vector *index,
+                                                         smtlib2_vector *args);
+static smtlib2_term smtlib2_reference_parser_mk_builtin(smtlib2_context ctx,
+                                                        const char *symbol,
+                                                        smtlib2_sort sort,
+                                                        smtlib2_vector *index,
+                                                        smtlib2_vector *args);
+static smtlib2_term smtlib2_reference_parser_mk_number(smtlib2_context ctx,
+                                                       const char *rep,
+                                                       unsigned int width,
+                                                       unsigned int base);
+static void smtlib2_reference_parser_free_sort_def(intptr_t d);
+static void smtlib2_reference_parser_push_sort_param_scope(
+    smtlib2_parser_interface *p);
+
+static void *smtlib2_reference_parser_save(smtlib2_abstract_parser *p);
+static smtlib2_abstract_parser *smtlib2_reference_parser_restore(void *state);
+static void smtlib2_reference_parser_release(void *state);
+
+
+/* a define-sort, possibly with parameters */
+typedef struct smtlib2_reference_sort_def {
+    size_t nparams_;
+    smtlib2_dag_sort **params_;
+    smtlib2_dag_sort *body_;
+} smtlib2_reference_sort_def;
+
+
+/* the builtin sorts, with their arity (-1 for indexed sorts) */
+static const struct {
+    const char *name;
+    int arity;
+} smtlib2_reference_builtin_sorts[] = {
+    { "Bool", 0 },
+    { "Int", 0 },
+    { "Real", 0 },
+    { "BitVec", -1 },
+    { "Array", 2 },
+    { NULL, 0 }
+};
+
+/* the builtin function symbols of the core, arithmetic, array and bit-vector
+ * theories. They are not type-checked. The table of their handlers is built
+ * once, and shared by all the instances */
+#define B(s) { s, smtlib2_reference_parser_mk_builtin }
+static const smtlib2_handler_entry smtlib2_reference_builtin_functions[] = {
+    B("true"), B("false"), B("not"), B("=>"), B("and"), B("or"), B("xor"),
+    B("="), B("distinct"), B("ite"), B("+"), B("-"), B("*"), B("/"), B("div"),
+    B("mod"), B("abs"), B("<="), B("<"), B(">="), B(">"), B("to_real"),
+    B("to_int"), B("is_int"), B("select"), B("store"), B("concat"),
+    B("extract"), B("repeat"), B("zero_extend"), B("sign_extend"),
+    B("rotate_left"), B("rotate_right"), B("bvnot"), B("bvand"), B("bvor"),
+    B("bvneg"), B("bvadd"), B("bvmul"), B("bvudiv"), B("bvurem"), B("bvshl"),
+    B("bvlshr"), B("bvult"), B("bvnand"), B("bvnor"), B("bvxor"), B("bvxnor"),
+    B("bvcomp"), B("bvsub"), B("bvsdiv"), B("bvsrem"), B("bvsmod"),
+    B("bvashr"), B("bvule"), B("bvugt"), B("bvuge"), B("bvslt"), B("bvsle"),
+    B("bvsgt"), B("bvsge")
+};
+#undef B
+static smtlib2_handler_table *smtlib2_reference_builtin_table = NULL;
+
+static const smtlib2_snapshot_backend smtlib2_reference_snapshot_backend = {
+    smtlib2_reference_parser_save,
+    smtlib2_reference_parser_restore,
+    smtlib2_reference_parser_release
+};
+
+
+/* the state of the parser saved in a snapshot */
+typedef struct smtlib2_reference_state {
+    smtlib2_termdag *dag_; /* frozen */
+    smtlib2_pmap sorts_;
+    smtlib2_pmap sort_defs_;
+    smtlib2_pmap functions_;
+    smtlib2_pmap named_terms_;
+    smtlib2_pmap assertions_;
+} smtlib2_reference_state;
+
+
+#define REFERENCE(p) ((smtlib2_reference_parser *)(p))
+#define REFERENCE_OK(p) \
+    (((smtlib2_abstract_parser *)(p))->response_ != SMTLIB2_RESPONSE_ERROR)
+
+
+smtlib2_parser_interface *SMTLIB2_PARSER_INTERFACE_REFERENCE(
+    smtlib2_reference_parser *p)
+{
+    return &(p->parent_.parent_);
+}
+
+
+smtlib2_reference_parser *smtlib2_reference_parser_new(void)
+{
+    smtlib2_reference_parser *ret =
+        (smtlib2_reference_parser *)smtlib2_malloc(
+            sizeof(smtlib2_reference_parser));
+    smtlib2_parser_interface *pi;
+    smtlib2_term_parser *tp;
+    int i;
+
+    smtlib2_abstract_parser_init((smtlib2_abstract_parser *)ret,
+                                 (smtlib2_context)ret);
+    ret->dag_ = smtlib2_termdag_new();
+    smtlib2_pmap_init(&(ret->sorts_), NULL, NULL, NULL, NULL);
+    smtlib2_pmap_init(&(ret->sort_defs_), NULL, NULL, NULL,
+                      smtlib2_reference_parser_free_sort_def);
+    smtlib2_pmap_init(&(ret->functions_), NULL, NULL, NULL, NULL);
+    smtlib2_pmap_init(&(ret->named_terms_), NULL, NULL, NULL, NULL);
+    ret->bound_vars_ = smtlib2_vector_new();
+    smtlib2_pmap_init(&(ret->assertions_), NULL, NULL, NULL, NULL);
+    smtlib2_pmap_init(&(ret->param_sorts_), NULL, NULL, NULL, NULL);
+    ret->param_mark_ = 0;
+    smtlib2_abstract_parser_add_scoped_map(&(ret->parent_), &(ret->sorts_));
+    smtlib2_abstract_parser_add_scoped_map(&(ret->parent_),
+                                           &(ret->sort_defs_));
+    smtlib2_abstract_parser_add_scoped_map(&(ret->parent_),
+                                           &(ret->functions_));
+    smtlib2_abstract_parser_add_scoped_map(&(ret->parent_),
+                                           &(ret->named_terms_));
+    smtlib2_abstract_parser_add_scoped_map(&(ret->parent_),
+                                           &(ret->assertions_));
+
+    for (i = 0; smtlib2_reference_builtin_sorts[i].name; ++i) {
+        smtlib2_pmap_set(
+            &(ret->sorts_),
+            (intptr_t)smtlib2_termdag_intern(
+                ret->dag_, smtlib2_reference_builtin_sorts[i].name),
+            smtlib2_reference_builtin_sorts[i].arity);
+    }
+
+    pi = SMTLIB2_PARSER_INTERFACE_REFERENCE(ret);
+    pi->declare_sort = smtlib2_reference_parser_declare_sort;
+    pi->define_sort = smtlib2_reference_parser_define_sort;
+    pi->push_sort_param_scope = smtlib2_reference_parser_push_sort_param_scope;
+    pi->declare_function = smtlib2_reference_parser_declare_function;
+    pi->declare_variable = smtlib2_reference_parser_declare_variable;
+    pi->define_function = smtlib2_reference_parser_define_function;
+    pi->assert_formula = smtlib2_reference_parser_assert_formula;
+    pi->check_sat = smtlib2_reference_parser_check_sat;
+    pi->get_assertions = smtlib2_reference_parser_unsupported;
+    pi->get_unsat_core = smtlib2_reference_parser_unsupported;
+    pi->get_proof = smtlib2_reference_parser_unsupported;
+    pi->get_assignment = smtlib2_reference_parser_unsupported;
+    pi->get_value = smtlib2_reference_parser_get_value;
+    pi->push_quantifier_scope = smtlib2_reference_parser_push_quantifier_scope;
+    pi->pop_quantifier_scope = smtlib2_reference_parser_pop_quantifier_scope;
+    pi->make_forall_term = smtlib2_reference_parser_make_forall_term;
+    pi->make_exists_term = smtlib2_reference_parser_make_exists_term;
+    pi->annotate_term = smtlib2_reference_parser_annotate_term;
+    pi->make_sort = smtlib2_reference_parser_make_sort;
+    pi->make_parametric_sort = smtlib2_reference_parser_make_parametric_sort;
+    pi->make_function_sort = smtlib2_reference_parser_make_function_sort;
+
+    tp = ret->parent_.termparser_;
+    smtlib2_term_parser_set_function_handler(
+        tp, smtlib2_reference_parser_mk_function);
+    smtlib2_term_parser_set_number_handler(
+        tp, smtlib2_reference_parser_mk_number);
+    smtlib2_term_parser_set_handler_table(
+        tp, smtlib2_handler_table_once(
+            &smtlib2_reference_builtin_table,
+            smtlib2_reference_builtin_functions,
+            sizeof(smtlib2_reference_builtin_functions) /
+            sizeof(smtlib2_reference_builtin_functions[0])));
+
+    smtlib2_abstract_parser_set_info(pi, ":name", "\"smtparser-reference\"");
+    ret->parent_.snapshot_backend_ = &smtlib2_reference_snapshot_backend;
+
+    return ret;
+}
+
+
+static void smtlib2_reference_parser_free_sort_def(intptr_t d)
+{
+    smtlib2_reference_sort_def *def = (smtlib2_reference_sort_def *)d;
+    smtlib2_free(def->params_);
+    smtlib2_free(def);
+}
+
+
+smtlib2_reference_parser *smtlib2_reference_parser_new_with_allocator(
+    smtlib2_allocator *a)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(a);
+    smtlib2_reference_parser *ret = smtlib2_reference_parser_new();
+    smtlib2_set_allocator(prev);
+    return ret;
+}
+
+
+void smtlib2_reference_parser_delete(smtlib2_reference_parser *p)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->parent_.allocator_);
+    smtlib2_pmap_deinit(&(p->sorts_));
+    smtlib2_pmap_deinit(&(p->sort_defs_));
+    smtlib2_pmap_deinit(&(p->functions_));
+    smtlib2_pmap_deinit(&(p->named_terms_));
+    smtlib2_vector_delete(p->bound_vars_);
+    smtlib2_pmap_deinit(&(p->assertions_));
+    smtlib2_pmap_deinit(&(p->param_sorts_));
+    smtlib2_termdag_delete(p->dag_);
+    smtlib2_abstract_parser_deinit(&(p->parent_));
+    smtlib2_free(p);
+    smtlib2_set_allocator(prev);
+}
+
+
+static void smtlib2_reference_parser_error(smtlib2_parser_interface *p,
+                                           char *msg)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        ap->response_ = SMTLIB2_RESPONSE_ERROR;
+        ap->errmsg_ = msg;
+    } else {
+        smtlib2_free(msg);
+    }
+}
+
+
+/* the undo actions of the entries of the tables, recorded in the trail of
+ * the parser unless they are restored by persistent scopes (see
+ * smtlib2_abstract_parser_record_map_undo) */
+static void smtlib2_reference_parser_undo_sort(smtlib2_abstract_parser *p,
+                                               intptr_t s)
+{
+    smtlib2_pmap_erase(&(REFERENCE(p)->sorts_), s);
+}
+
+
+static void smtlib2_reference_parser_undo_sort_def(smtlib2_abstract_parser *p,
+                                                   intptr_t s)
+{
+    smtlib2_pmap_erase(&(REFERENCE(p)->sort_defs_), s);
+}
+
+
+static void smtlib2_reference_parser_undo_function(smtlib2_abstract_parser *p,
+                                                   intptr_t s)
+{
+    smtlib2_pmap_erase(&(REFERENCE(p)->functions_), s);
+}
+
+
+static void smtlib2_reference_parser_undo_named(smtlib2_abstract_parser *p,
+                                                intptr_t s)
+{
+    smtlib2_pmap_erase(&(REFERENCE(p)->named_terms_), s);
+}
+
+
+/* the assertions are undone one at a time, the last one first */
+static void smtlib2_reference_parser_undo_assert(smtlib2_abstract_parser *p,
+                                                 intptr_t unused)
+{
+    smtlib2_pmap *a = &(REFERENCE(p)->assertions_);
+    smtlib2_pmap_erase(a, (intptr_t)(smtlib2_pmap_size(a) - 1));
+}
+
+
+/* true if the given symbol is already used for a function or a named term */
+static bool smtlib2_reference_parser_is_declared(smtlib2_reference_parser *p,
+                                                 smtlib2_dag_symbol *s)
+{
+    return smtlib2_pmap_find(&(p->functions_), (intptr_t)s, NULL) ||
+        smtlib2_pmap_find(&(p->named_terms_), (intptr_t)s, NULL);
+}
+
+
+static void smtlib2_reference_parser_declare_sort(smtlib2_parser_interface *p,
+                                                  const char *sortname,
+                                                  int arity)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+
+    if (REFERENCE_OK(p)) {
+        smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, sortname);
+        if (smtlib2_pmap_find(&(rp->sorts_), (intptr_t)s, NULL) ||
+            smtlib2_pmap_find(&(rp->sort_defs_), (intptr_t)s, NULL)) {
+            smtlib2_reference_parser_error(
+                p, smtlib2_sprintf("sort `%s' already declared", sortname));
+        } else {
+            smtlib2_pmap_set(&(rp->sorts_), (intptr_t)s, arity);
+            smtlib2_abstract_parser_record_map_undo(
+                &(rp->parent_), smtlib2_reference_parser_undo_sort,
+                (intptr_t)s);
+        }
+    }
+}
+
+
+static void smtlib2_reference_parser_define_sort(smtlib2_parser_interface *p,
+                                                 const char *sortname,
+                                                 smtlib2_vector *params,
+                                                 smtlib2_sort sort)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    size_t i, n = params ? smtlib2_vector_size(params) : 0;
+    smtlib2_dag_symbol *s;
+
+    /* the parameters were declared as sorts right before the definition,
+     * forget them now */
+    if (n > 0) {
+        smtlib2_abstract_parser_undo_to(&(rp->parent_), rp->param_mark_);
+        smtlib2_pmap_assign(&(rp->sorts_), &(rp->param_sorts_));
+        smtlib2_pmap_deinit(&(rp->param_sorts_));
+        smtlib2_pmap_init(&(rp->param_sorts_), NULL, NULL, NULL, NULL);
+    }
+
+    if (!REFERENCE_OK(p) || !sort) {
+        return;
+    }
+    s = smtlib2_termdag_intern(rp->dag_, sortname);
+    if (smtlib2_pmap_find(&(rp->sorts_), (intptr_t)s, NULL) ||
+        smtlib2_pmap_find(&(rp->sort_defs_), (intptr_t)s, NULL)) {
+        smtlib2_reference_parser_error(
+            p, smtlib2_sprintf("sort `%s' already declared", sortname));
+    } else {
+        smtlib2_reference_sort_def *def =
+            (smtlib2_reference_sort_def *)smtlib2_malloc(
+                sizeof(smtlib2_reference_sort_def));
+        def->nparams_ = n;
+        def->params_ = (smtlib2_dag_sort **)smtlib2_malloc(
+            sizeof(smtlib2_dag_sort *) * (n ? n : 1));
+        for (i = 0; i < n; ++i) {
+            def->params_[i] = (smtlib2_dag_sort *)smtlib2_vector_at(params, i);
+        }
+        def->body_ = (smtlib2_dag_sort *)sort;
+        smtlib2_pmap_set(&(rp->sort_defs_), (intptr_t)s, (intptr_t)def);
+        smtlib2_abstract_parser_record_map_undo(
+            &(rp->parent_), smtlib2_reference_parser_undo_sort_def,
+            (intptr_t)s);
+    }
+}
+
+
+static void smtlib2_reference_parser_push_sort_param_scope(
+    smtlib2_parser_interface *p)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    rp->param_mark_ = smtlib2_abstract_parser_trail_size(&(rp->parent_));
+    smtlib2_pmap_assign(&(rp->param_sorts_), &(rp->sorts_));
+}
+
+
+static void smtlib2_reference_parser_declare_function(
+    smtlib2_parser_interface *p, const char *name, smtlib2_sort sort)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+
+    if (REFERENCE_OK(p) && sort) {
+        smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, name);
+        if (smtlib2_reference_parser_is_declared(rp, s)) {
+            smtlib2_reference_parser_error(
+                p, smtlib2_sprintf("symbol `%s' already declared", name));
+        } else {
+            smtlib2_pmap_set(&(rp->functions_), (intptr_t)s, (intptr_t)sort);
+            smtlib2_abstract_parser_record_map_undo(
+                &(rp->parent_), smtlib2_reference_parser_undo_function,
+                (intptr_t)s);
+        }
+    }
+}
+
+
+static void smtlib2_reference_parser_declare_variable(
+    smtlib2_parser_interface *p, const char *name, smtlib2_sort sort)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+
+    if (REFERENCE_OK(p)) {
+        smtlib2_dag_term *v = smtlib2_termdag_mk_term(
+            rp->dag_, SMTLIB2_DAG_TERM_VAR,
+            smtlib2_termdag_intern(rp->dag_, name), (smtlib2_dag_sort *)sort,
+            0, NULL, 0, NULL);
+        smtlib2_vector_push(rp->bound_vars_, (intptr_t)v);
+    }
+}
+
+
+static void smtlib2_reference_parser_define_function(
+    smtlib2_parser_interface *p, const char *name, smtlib2_vector *params,
+    smtlib2_sort sort, smtlib2_term term)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, name);
+
+    if (REFERENCE_OK(p) && smtlib2_reference_parser_is_declared(rp, s)) {
+        smtlib2_reference_parser_error(
+            p, smtlib2_sprintf("symbol `%s' already declared", name));
+        return;
+    }
+    if (params && smtlib2_vector_size(params) > 0) {
+        /* the term parser can't expand macros with parameters, so these are
+         * kept as uninterpreted functions */
+        size_t i, n = smtlib2_vector_size(params);
+        smtlib2_dag_sort **tps;
+        smtlib2_dag_sort *tp;
+
+        if (!REFERENCE_OK(p) || !sort || !term) {
+            return;
+        }
+        tps = (smtlib2_dag_sort **)smtlib2_malloc(
+            sizeof(smtlib2_dag_sort *) * (n+1));
+        for (i = 0; i < n; ++i) {
+            smtlib2_dag_term *v =
+                (smtlib2_dag_term *)smtlib2_vector_at(params, i);
+            if (!v) {
+                smtlib2_free(tps);
+                return;
+            }
+            tps[i] = v->sort_;
+        }
+        tps[n] = (smtlib2_dag_sort *)sort;
+        tp = smtlib2_termdag_mk_sort(rp->dag_, SMTLIB2_DAG_SORT_FUNCTION, NULL,
+                                     0, NULL, n+1, tps);
+        smtlib2_free(tps);
+        smtlib2_pmap_set(&(rp->functions_), (intptr_t)s, (intptr_t)tp);
+        smtlib2_abstract_parser_record_map_undo(
+            &(rp->parent_), smtlib2_reference_parser_undo_function,
+            (intptr_t)s);
+        rp->parent_.response_ = SMTLIB2_RESPONSE_SUCCESS;
+        return;
+    }
+    smtlib2_abstract_parser_define_function(p, name, params, sort, term);
+}
+
+
+static void smtlib2_reference_parser_assert_formula(smtlib2_parser_interface *p,
+                                                    smtlib2_term term)
+{
+    if (REFERENCE_OK(p) && term) {
+        smtlib2_pmap *a = &(REFERENCE(p)->assertions_);
+        smtlib2_pmap_set(a, (intptr_t)smtlib2_pmap_size(a), (intptr_t)term);
+        smtlib2_abstract_parser_record_map_undo(
+            (smtlib2_abstract_parser *)p,
+            smtlib2_reference_parser_undo_assert, 0);
+    }
+}
+
+
+static void smtlib2_reference_parser_check_sat(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+
+    if (REFERENCE_OK(p)) {
+        ap->status_ = SMTLIB2_STATUS_UNKNOWN;
+        ap->response_ = SMTLIB2_RESPONSE_STATUS;
+    }
+}
+
+
+static void smtlib2_reference_parser_unsupported(smtlib2_parser_interface *p)
+{
+    if (REFERENCE_OK(p)) {
+        ((smtlib2_abstract_parser *)p)->response_ =
+            SMTLIB2_RESPONSE_UNSUPPORTED;
+    }
+}
+
+
+static void smtlib2_reference_parser_get_value(smtlib2_parser_interface *p,
+                                               smtlib2_vector *terms)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+
+    if (REFERENCE_OK(p)) {
+        /* the terms are still parsed (and checked), but there is no model */
+        smtlib2_vector *parsed = smtlib2_vector_new();
+        if (smtlib2_abstract_parser_force_terms(ap, terms, parsed)) {
+            ap->response_ = SMTLIB2_RESPONSE_UNSUPPORTED;
+        }
+        smtlib2_vector_delete(parsed);
+    }
+}
+
+
+static void smtlib2_reference_parser_push_quantifier_scope(
+    smtlib2_parser_interface *p)
+{
+    smtlib2_vector_push(REFERENCE(p)->bound_vars_, (intptr_t)NULL);
+}
+
+
+static smtlib2_term smtlib2_reference_parser_pop_quantifier_scope(
+    smtlib2_parser_interface *p)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    while (smtlib2_vector_size(rp->bound_vars_) > 0 &&
+           smtlib2_vector_last(rp->bound_vars_) != (intptr_t)NULL) {
+        smtlib2_vector_pop(rp->bound_vars_);
+    }
+    if (smtlib2_vector_size(rp->bound_vars_) > 0) {
+        smtlib2_vector_pop(rp->bound_vars_);
+    }
+    return NULL;
+}
+
+
+static smtlib2_term smtlib2_reference_parser_make_quantifier(
+    smtlib2_reference_parser *rp, smtlib2_dag_term_kind kind,
+    smtlib2_term body)
+{
+    size_t begin, n;
+    smtlib2_dag_term *ret;
+
+    if (!body) {
+        return NULL;
+    }
+    n = smtlib2_vector_size(rp->bound_vars_);
+    begin = n;
+    while (begin > 0 && smtlib2_vector_at(rp->bound_vars_, begin-1)) {
+        --begin;
+    }
+    /* the variables of the innermost scope, followed by the body */
+    smtlib2_vector_push(rp->bound_vars_, (intptr_t)body);
+    ret = smtlib2_termdag_mk_term(
+        rp->dag_, kind, NULL, NULL, 0, NULL, n - begin + 1,
+        (smtlib2_dag_term **)&(smtlib2_vector_at(rp->bound_vars_, begin)));
+    smtlib2_vector_pop(rp->bound_vars_);
+    return ret;
+}
+
+
+static smtlib2_term smtlib2_reference_parser_make_forall_term(
+    smtlib2_parser_interface *p, smtlib2_term term)
+{
+    return smtlib2_reference_parser_make_quantifier(
+        REFERENCE(p), SMTLIB2_DAG_TERM_FORALL, term);
+}
+
+
+static smtlib2_term smtlib2_reference_parser_make_exists_term(
+    smtlib2_parser_interface *p, smtlib2_term term)
+{
+    return smtlib2_reference_parser_make_quantifier(
+        REFERENCE(p), SMTLIB2_DAG_TERM_EXISTS, term);
+}
+
+
+static void smtlib2_reference_parser_annotate_term(smtlib2_parser_interface *p,
+                                                   smtlib2_term term,
+                                                   smtlib2_vector *annotations)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    size_t i;
+
+    if (!REFERENCE_OK(p) || !term) {
+        return;
+    }
+    for (i = 0; i < smtlib2_vector_size(annotations); ++i) {
+        char **an = (char **)smtlib2_vector_at(annotations, i);
+        if (strcmp(an[0], ":named") == 0) {
+            smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, an[1]);
+            if (smtlib2_reference_parser_is_declared(rp, s)) {
+                smtlib2_reference_parser_error(
+                    p, smtlib2_sprintf("symbol `%s' already declared", an[1]));
+                return;
+            }
+            smtlib2_pmap_set(&(rp->named_terms_), (intptr_t)s,
+                                  (intptr_t)term);
+            smtlib2_abstract_parser_record_map_undo(
+                &(rp->parent_), smtlib2_reference_parser_undo_named,
+                (intptr_t)s);
+        }
+    }
+}
+
+
+/* replaces the parameters of a sort definition with the given sorts */
+static smtlib2_dag_sort *smtlib2_reference_parser_instantiate(
+    smtlib2_reference_parser *rp, smtlib2_reference_sort_def *def,
+    smtlib2_dag_sort *s, smtlib2_dag_sort **actuals)
+{
+    smtlib2_dag_sort **args;
+    smtlib2_dag_sort *ret;
+    size_t i;
+
+    for (i = 0; i < def->nparams_; ++i) {
+        if (s == def->params_[i]) {
+            return actuals[i];
+        }
+    }
+    if (s->nargs_ == 0) {
+        return s;
+    }
+    args = (smtlib2_dag_sort **)smtlib2_malloc(
+        sizeof(smtlib2_dag_sort *) * s->nargs_);
+    for (i = 0; i < s->nargs_; ++i) {
+        args[i] = smtlib2_reference_parser_instantiate(rp, def, s->args_[i],
+                                                       actuals);
+    }
+    ret = smtlib2_termdag_mk_sort(rp->dag_, s->kind_, s->name_, s->nidx_,
+                                  s->idx_, s->nargs_, args);
+    smtlib2_free(args);
+    return ret;
+}
+
+
+static smtlib2_sort smtlib2_reference_parser_make_sort(
+    smtlib2_parser_interface *p, const char *sortname, smtlib2_vector *index)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, sortname);
+    size_t nidx = index ? smtlib2_vector_size(index) : 0;
+    intptr_t v;
+
+    if (smtlib2_pmap_find(&(rp->sort_defs_), (intptr_t)s, &v)) {
+        smtlib2_reference_sort_def *def = (smtlib2_reference_sort_def *)v;
+        if (def->nparams_ == 0 && nidx == 0) {
+            return def->body_;
+        }
+    } else if (smtlib2_pmap_find(&(rp->sorts_), (intptr_t)s, &v)) {
+        if ((v == -1 && nidx == 1) || (v == 0 && nidx == 0)) {
+            return smtlib2_termdag_mk_sort(
+                rp->dag_, SMTLIB2_DAG_SORT_BASIC, s, nidx,
+                index ? smtlib2_vector_array(index) : NULL, 0, NULL);
+        }
+    } else {
+        smtlib2_reference_parser_error(
+            p, smtlib2_sprintf("unknown sort `%s'", sortname));
+        return NULL;
+    }
+    smtlib2_reference_parser_error(
+        p, smtlib2_sprintf("wrong number of arguments for sort `%s'",
+                           sortname));
+    return NULL;
+}
+
+
+static smtlib2_sort smtlib2_reference_parser_make_parametric_sort(
+    smtlib2_parser_interface *p, const char *name, smtlib2_vector *tps)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, name);
+    size_t i, n = smtlib2_vector_size(tps);
+    smtlib2_dag_sort **args = (smtlib2_dag_sort **)smtlib2_vector_array(tps);
+    intptr_t v;
+
+    for (i = 0; i < n; ++i) {
+        if (!args[i]) {
+            return NULL;
+        }
+    }
+    if (smtlib2_pmap_find(&(rp->sort_defs_), (intptr_t)s, &v)) {
+        smtlib2_reference_sort_def *def = (smtlib2_reference_sort_def *)v;
+        if (def->nparams_ == n) {
+            return smtlib2_reference_parser_instantiate(rp, def, def->body_,
+                                                        args);
+        }
+    } else if (smtlib2_pmap_find(&(rp->sorts_), (intptr_t)s, &v)) {
+        if (v == (intptr_t)n) {
+            return smtlib2_termdag_mk_sort(rp->dag_,
+                                           SMTLIB2_DAG_SORT_PARAMETRIC, s,
+                                           0, NULL, n, args);
+        }
+    } else {
+        smtlib2_reference_parser_error(
+            p, smtlib2_sprintf("unknown sort `%s'", name));
+        return NULL;
+    }
+    smtlib2_reference_parser_error(
+        p, smtlib2_sprintf("wrong number of arguments for sort `%s'", name));
+    return NULL;
+}
+
+
+static smtlib2_sort smtlib2_reference_parser_make_function_sort(
+    smtlib2_parser_interface *p, smtlib2_vector *tps)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    size_t i;
+
+    for (i = 0; i < smtlib2_vector_size(tps); ++i) {
+        if (!smtlib2_vector_at(tps, i)) {
+            return NULL;
+        }
+    }
+    return smtlib2_termdag_mk_sort(
+        rp->dag_, SMTLIB2_DAG_SORT_FUNCTION, NULL, 0, NULL,
+        smtlib2_vector_size(tps),
+        (smtlib2_dag_sort **)smtlib2_vector_array(tps));
+}
+
+
+static smtlib2_dag_term *smtlib2_reference_parser_mk_app(
+    smtlib2_reference_parser *rp, smtlib2_dag_symbol *s, smtlib2_sort sort,
+    smtlib2_vector *index, smtlib2_vector *args)
+{
+    size_t i;
+
+    if (args) {
+        for (i = 0; i < smtlib2_vector_size(args); ++i) {
+            if (!smtlib2_vector_at(args, i)) {
+                return NULL;
+            }
+        }
+    }
+    return smtlib2_termdag_mk_term(
+        rp->dag_, SMTLIB2_DAG_TERM_APP, s, (smtlib2_dag_sort *)sort,
+        index ? smtlib2_vector_size(index) : 0,
+        index ? smtlib2_vector_array(index) : NULL,
+        args ? smtlib2_vector_size(args) : 0,
+        args ? (smtlib2_dag_term **)smtlib2_vector_array(args) : NULL);
+}
+
+
+static smtlib2_term smtlib2_reference_parser_mk_function(smtlib2_context ctx,
+                                                         const char *symbol,
+                                                         smtlib2_sort sort,
+                                                         smtlib2_vector *index,
+                                                         smtlib2_vector *args)
+{
+    smtlib2_reference_parser *rp = REFERENCE(ctx);
+    smtlib2_dag_symbol *s = smtlib2_termdag_intern(rp->dag_, symbol);
+    size_t nargs = args ? smtlib2_vector_size(args) : 0;
+    intptr_t v;
+
+    if (!index && !args) {
+        /* references to bound variables, innermost scope first */
+        size_t i = smtlib2_vector_size(rp->bound_vars_);
+        while (i-- > 0) {
+            smtlib2_dag_term *t =
+                (smtlib2_dag_term *)smtlib2_vector_at(rp->bound_vars_, i);
+            if (t && t->symbol_ == s) {
+                return t;
+            }
+        }
+        if (smtlib2_pmap_find(&(rp->named_terms_), (intptr_t)s, &v)) {
+            return (smtlib2_term)v;
+        }
+    }
+    if (smtlib2_pmap_find(&(rp->functions_), (intptr_t)s, &v)) {
+        smtlib2_dag_sort *tp = (smtlib2_dag_sort *)v;
+        size_t arity =
+            tp->kind_ == SMTLIB2_DAG_SORT_FUNCTION ? tp->nargs_ - 1 : 0;
+        if (arity == nargs && !index) {
+            return smtlib2_reference_parser_mk_app(rp, s, sort, NULL, args);
+        }
+    }
+    /* unknown symbol, or wrong number of arguments */
+    return NULL;
+}
+
+
+static smtlib2_term smtlib2_reference_parser_mk_builtin(smtlib2_context ctx,
+                                                        const char *symbol,
+                                                        smtlib2_sort sort,
+                                                        smtlib2_vector *index,
+                                                        smtlib2_vector *args)
+{
+    smtlib2_reference_parser *rp = REFERENCE(ctx);
+    return smtlib2_reference_parser_mk_app(
+        rp, smtlib2_termdag_intern(rp->dag_, symbol), sort, index, args);
+}
+
+
+static smtlib2_term smtlib2_reference_parser_mk_number(smtlib2_context ctx,
+                                                       const char *rep,
+                                                       unsigned int width,
+                                                       unsigned int base)
+{
+    smtlib2_reference_parser *rp = REFERENCE(ctx);
+    intptr_t idx[2];
+
+    idx[0] = width;
+    idx[1] = base;
+    return smtlib2_termdag_mk_term(rp->dag_, SMTLIB2_DAG_TERM_NUMBER,
+                                   smtlib2_termdag_intern(rp->dag_, rep), NULL,
+                                   2, idx, 0, NULL);
+}
+
+
+static void smtlib2_reference_state_init(smtlib2_reference_state *s)
+{
+    smtlib2_pmap_init(&(s->sorts_), NULL, NULL, NULL, NULL);
+    smtlib2_pmap_init(&(s->sort_defs_), NULL, NULL, NULL,
+                      smtlib2_reference_parser_free_sort_def);
+    smtlib2_pmap_init(&(s->functions_), NULL, NULL, NULL, NULL);
+    smtlib2_pmap_init(&(s->named_terms_), NULL, NULL, NULL, NULL);
+    smtlib2_pmap_init(&(s->assertions_), NULL, NULL, NULL, NULL);
+}
+
+
+static void *smtlib2_reference_parser_save(smtlib2_abstract_parser *p)
+{
+    smtlib2_reference_parser *rp = REFERENCE(p);
+    smtlib2_reference_state *ret =
+        (smtlib2_reference_state *)smtlib2_malloc(
+            sizeof(smtlib2_reference_state));
+
+    /* freeze the DAG, and continue on a new layer. If the current layer is
+     * still empty (e.g. after a previous snapshot), its base is shared
+     * instead, so that repeated snapshots don't pile up layers */
+    if (!smtlib2_termdag_base(rp->dag_) ||
+        !smtlib2_termdag_is_empty(rp->dag_)) {
+        smtlib2_termdag *base = rp->dag_;
+        rp->dag_ = smtlib2_termdag_new_layer(base);
+        smtlib2_termdag_delete(base);
+    }
+    ret->dag_ = smtlib2_termdag_retain(smtlib2_termdag_base(rp->dag_));
+
+    smtlib2_reference_state_init(ret);
+    smtlib2_pmap_assign(&(ret->sorts_), &(rp->sorts_));
+    smtlib2_pmap_assign(&(ret->sort_defs_), &(rp->sort_defs_));
+    smtlib2_pmap_assign(&(ret->functions_), &(rp->functions_));
+    smtlib2_pmap_assign(&(ret->named_terms_), &(rp->named_terms_));
+    smtlib2_pmap_assign(&(ret->assertions_), &(rp->assertions_));
+    return ret;
+}
+
+
+static smtlib2_abstract_parser *smtlib2_reference_parser_restore(void *state)
+{
+    smtlib2_reference_state *s = (smtlib2_reference_state *)state;
+    smtlib2_reference_parser *ret = smtlib2_reference_parser_new();
+
+    smtlib2_pmap_assign(&(ret->sorts_), &(s->sorts_));
+    smtlib2_pmap_assign(&(ret->sort_defs_), &(s->sort_defs_));
+    smtlib2_pmap_assign(&(ret->functions_), &(s->functions_));
+    smtlib2_pmap_assign(&(ret->named_terms_), &(s->named_terms_));
+    smtlib2_pmap_assign(&(ret->assertions_), &(s->assertions_));
+    smtlib2_termdag_delete(ret->dag_);
+    ret->dag_ = smtlib2_termdag_new_layer(s->dag_);
+    return &(ret->parent_);
+}
+
+
+static void smtlib2_reference_parser_release(void *state)
+{
+    smtlib2_reference_state *s = (smtlib2_reference_state *)state;
+
+    smtlib2_pmap_deinit(&(s->sorts_));
+    smtlib2_pmap_deinit(&(s->sort_defs_));
+    smtlib2_pmap_deinit(&(s->functions_));
+    smtlib2_pmap_deinit(&(s->named_terms_));
+    smtlib2_pmap_deinit(&(s->assertions_));
+    smtlib2_termdag_delete(s->dag_);
+    smtlib2_free(s);
+}
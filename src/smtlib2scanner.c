@@ -25,7 +25,12 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
-#include "smtparser/smtlib2scanner.h"
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "smtparser/smtlib2scanner_private.h"
+#include "smtparser/smtlib2memory.h"
 #include "smtlib2bisonparser.h"
 
 /* This is a flex bug.
@@ -37,30 +42,258 @@ not the header*/
 
 #include <stdlib.h>
 
+/* the lexer thread needs pthreads and the atomic builtins of GCC (or
+ * clang) */
+#if defined(SMTLIB2_HAVE_PTHREADS) && defined(__GNUC__)
+#  define SMTLIB2_PIPELINE
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
 extern int smtlib2_parser_parse(yyscan_t scanner, smtlib2_parser_interface *p);
+extern int smtlib2_parser_lex(YYSTYPE *lval, YYLTYPE *lloc, yyscan_t scanner);
+extern void smtlib2_lexer_reset(yyscan_t scanner);
+
+/* the scanner pool is per-thread, so it is available only if the compiler
+ * supports thread-local storage */
+#if defined(SMTLIB2_SCANNER_POOL) && !defined(SMTLIB2_THREAD_LOCAL)
+#  undef SMTLIB2_SCANNER_POOL
+#endif
+
+#ifdef SMTLIB2_SCANNER_POOL
+#define SMTLIB2_SCANNER_POOL_SIZE 8
+static SMTLIB2_THREAD_LOCAL smtlib2_scanner *
+    smtlib2_scanner_pool[SMTLIB2_SCANNER_POOL_SIZE];
+static SMTLIB2_THREAD_LOCAL int smtlib2_scanner_pool_size = 0;
+#endif
+
+
+static void smtlib2_token_free(int tok, YYSTYPE *val)
+{
+    switch (tok) {
+    case BINCONSTANT: case HEXCONSTANT: case RATCONSTANT:
+    case BVCONSTANT: case NUMERAL: case SYMBOL: case KEYWORD: case STRING:
+        smtlib2_free(val->string);
+        break;
+    case LAZY_TERM:
+        smtlib2_lazy_term_delete(val->lazyterm);
+        break;
+    }
+}
+
+
+#ifdef SMTLIB2_PIPELINE
+
+#define SMTLIB2_TOKEN_RING_SIZE 1024 /* must be a power of two */
+#define SMTLIB2_TOKEN_RING_SPINS 64  /* busy waits before yielding */
 
+/* a token read by the lexer thread, with the position after it */
+typedef struct smtlib2_token {
+    int tok_;
+    YYSTYPE val_;
+    YYLTYPE loc_;
+    size_t offset_;
+    int line_;
+} smtlib2_token;
 
-struct smtlib2_scanner {
-    yyscan_t flex_scanner_;
-    smtlib2_stream *stream_;
+/**
+ * A bounded queue of tokens, with the lexer thread as the only producer and
+ * the parser as the only consumer. Each side owns one index, and keeps the
+ * last value it read of the other one, so that the index of the other side
+ * is loaded (and its cache line moved) only when the ring looks full or
+ * empty. The fields of the two sides are kept on separate cache lines
+ */
+struct smtlib2_token_ring {
+    /* lexer thread */
+    size_t tail_;
+    size_t cached_head_;
+    char pad_[64];
+    /* parser */
+    size_t head_;
+    size_t cached_tail_;
+    bool end_;           /* the end of the input was taken */
+    size_t offset_;      /* position after the last token taken */
+    int line_;
+    int stop_;           /* asks the lexer thread to stop */
+    pthread_t thread_;
+    smtlib2_token tokens_[SMTLIB2_TOKEN_RING_SIZE];
 };
 
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+
+static void smtlib2_token_ring_wait(int *spins)
+{
+    if (++(*spins) > SMTLIB2_TOKEN_RING_SPINS) {
+        sched_yield();
+    }
+}
+
+
+/* the lexer thread: fills the ring until the end of the input, or until it
+ * is asked to stop */
+static void *smtlib2_token_ring_run(void *data)
+{
+    smtlib2_scanner *s = (smtlib2_scanner *)data;
+    struct smtlib2_token_ring *r = s->ring_;
+    smtlib2_token *t;
+    size_t tail;
+    int spins;
+
+    smtlib2_set_allocator(s->allocator_);
+    smtlib2_set_memory_tag(SMTLIB2_MEM_TOKENS);
+
+    for (tail = r->tail_; !LOAD(r->stop_); ++tail) {
+        spins = 0;
+        while (tail - r->cached_head_ == SMTLIB2_TOKEN_RING_SIZE) {
+            r->cached_head_ = LOAD(r->head_);
+            if (tail - r->cached_head_ == SMTLIB2_TOKEN_RING_SIZE) {
+                if (LOAD(r->stop_)) {
+                    return NULL;
+                }
+                smtlib2_token_ring_wait(&spins);
+            }
+        }
+        t = &(r->tokens_[tail & (SMTLIB2_TOKEN_RING_SIZE - 1)]);
+        t->tok_ = smtlib2_parser_lex(&(t->val_), &(t->loc_),
+                                     s->flex_scanner_);
+        t->offset_ = s->offset_;
+        t->line_ = smtlib2_parser_get_lineno(s->flex_scanner_);
+        STORE(r->tail_, tail + 1);
+        if (t->tok_ <= 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+
+static int smtlib2_token_ring_pop(struct smtlib2_token_ring *r,
+                                  YYSTYPE *lval, YYLTYPE *lloc)
+{
+    size_t head = r->head_;
+    smtlib2_token *t;
+    int tok, spins = 0;
+
+    if (r->end_) {
+        /* the lexer thread is done */
+        return 0;
+    }
+    while (head == r->cached_tail_) {
+        r->cached_tail_ = LOAD(r->tail_);
+        if (head == r->cached_tail_) {
+            smtlib2_token_ring_wait(&spins);
+        }
+    }
+    t = &(r->tokens_[head & (SMTLIB2_TOKEN_RING_SIZE - 1)]);
+    tok = t->tok_;
+    *lval = t->val_;
+    *lloc = t->loc_;
+    r->offset_ = t->offset_;
+    r->line_ = t->line_;
+    if (tok <= 0) {
+        r->end_ = true;
+    }
+    /* the slot can be reused from now on */
+    STORE(r->head_, head + 1);
+    return tok;
+}
+
+#endif /* SMTLIB2_PIPELINE */
+
 
 smtlib2_scanner *smtlib2_scanner_new(smtlib2_stream *source)
 {
-    smtlib2_scanner *ret = (smtlib2_scanner *)malloc(sizeof(smtlib2_scanner));
-    smtlib2_parser_lex_init(&(ret->flex_scanner_));
+    smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_TOKENS);
+    smtlib2_scanner *ret =
+        (smtlib2_scanner *)smtlib2_malloc(sizeof(smtlib2_scanner));
+    ret->allocator_ = smtlib2_get_allocator();
+    /* the extra data is needed already by the first allocation of flex */
+    smtlib2_parser_lex_init_extra(ret, &(ret->flex_scanner_));
+    ret->lazy_asserts_ = false;
     ret->stream_ = source;
-    smtlib2_parser_set_extra(source, ret->flex_scanner_);
+    ret->offset_ = 0;
+    ret->start_token_ = 0;
+    ret->lazy_depth_ = 0;
+    ret->lazy_offset_ = 0;
+    ret->lazy_line_ = 0;
+    ret->lazy_list_ = false;
+    ret->command_ = NULL;
+    ret->ring_ = NULL;
+    smtlib2_set_memory_tag(tag);
 
     return ret;
 }
 
 
+void smtlib2_scanner_reset(smtlib2_scanner *s, smtlib2_stream *source)
+{
+    smtlib2_scanner_stop_pipeline(s);
+    smtlib2_lexer_reset(s->flex_scanner_);
+    s->stream_ = source;
+    s->offset_ = 0;
+    s->start_token_ = 0;
+    s->lazy_depth_ = 0;
+    s->lazy_offset_ = 0;
+    s->lazy_line_ = 0;
+    s->lazy_list_ = false;
+}
+
+
+smtlib2_scanner *smtlib2_scanner_acquire(smtlib2_stream *source)
+{
+#ifdef SMTLIB2_SCANNER_POOL
+    /* only scanners using the default allocator are pooled, as the memory of
+     * other allocators might go away */
+    if (smtlib2_scanner_pool_size > 0 &&
+        smtlib2_get_allocator() == smtlib2_default_allocator()) {
+        smtlib2_scanner *ret =
+            smtlib2_scanner_pool[--smtlib2_scanner_pool_size];
+        smtlib2_scanner_reset(ret, source);
+        return ret;
+    }
+#endif
+    return smtlib2_scanner_new(source);
+}
+
+
+void smtlib2_scanner_release(smtlib2_scanner *s)
+{
+    smtlib2_scanner_stop_pipeline(s);
+#ifdef SMTLIB2_SCANNER_POOL
+    if (smtlib2_scanner_pool_size < SMTLIB2_SCANNER_POOL_SIZE &&
+        s->allocator_ == smtlib2_default_allocator()) {
+        s->stream_ = NULL;
+        s->lazy_asserts_ = false;
+        smtlib2_scanner_pool[smtlib2_scanner_pool_size++] = s;
+        return;
+    }
+#endif
+    smtlib2_scanner_delete(s);
+}
+
+
+void smtlib2_scanner_pool_clear(void)
+{
+#ifdef SMTLIB2_SCANNER_POOL
+    while (smtlib2_scanner_pool_size > 0) {
+        smtlib2_scanner_delete(
+            smtlib2_scanner_pool[--smtlib2_scanner_pool_size]);
+    }
+#endif
+}
+
+
 void smtlib2_scanner_delete(smtlib2_scanner *s)
 {
+    smtlib2_allocator *prev;
+
+    smtlib2_scanner_stop_pipeline(s);
+    prev = smtlib2_set_allocator(s->allocator_);
     smtlib2_parser_lex_destroy(s->flex_scanner_);
-    free(s);
+    smtlib2_free(s);
+    smtlib2_set_allocator(prev);
 }
 
 
@@ -68,3 +301,159 @@ void smtlib2_parse(smtlib2_scanner *scanner, smtlib2_parser_interface *parser)
 {
     smtlib2_parser_parse(scanner->flex_scanner_, parser);
 }
+
+
+void smtlib2_parse_terms(smtlib2_scanner *scanner,
+                         smtlib2_parser_interface *parser)
+{
+    smtlib2_scanner_reset(scanner, scanner->stream_);
+    scanner->start_token_ = TK_START_TERMS;
+    smtlib2_parser_parse(scanner->flex_scanner_, parser);
+}
+
+
+void smtlib2_scanner_set_lazy_asserts(smtlib2_scanner *s, bool yes)
+{
+    s->lazy_asserts_ = yes;
+}
+
+
+void smtlib2_scanner_track_command(smtlib2_scanner *s,
+                                   smtlib2_command_info *info)
+{
+    if (info) {
+        info->offset_ = 0;
+        info->line_ = 0;
+        info->name_ = NULL;
+        info->tokens_ = 0;
+        info->start_ = 0;
+        info->lex_ticks_ = 0;
+        info->traced_ = false;
+    }
+    s->command_ = info;
+}
+
+
+size_t smtlib2_scanner_count_tokens(smtlib2_scanner *s)
+{
+    size_t ret = 0;
+    YYSTYPE val;
+    YYLTYPE loc;
+    int tok;
+    smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_TOKENS);
+
+    while ((tok = smtlib2_parser_lex(&val, &loc, s->flex_scanner_)) != 0) {
+        smtlib2_token_free(tok, &val);
+        ++ret;
+    }
+    smtlib2_set_memory_tag(tag);
+    return ret;
+}
+
+
+bool smtlib2_scanner_start_pipeline(smtlib2_scanner *s)
+{
+#ifdef SMTLIB2_PIPELINE
+    struct smtlib2_token_ring *r;
+    smtlib2_allocator *prev;
+    smtlib2_memory_tag tag;
+
+    if (s->ring_) {
+        return true;
+    }
+    if (s->allocator_ != smtlib2_default_allocator()) {
+        return false;
+    }
+    prev = smtlib2_set_allocator(s->allocator_);
+    tag = smtlib2_set_memory_tag(SMTLIB2_MEM_TOKENS);
+    r = (struct smtlib2_token_ring *)smtlib2_malloc(
+        sizeof(struct smtlib2_token_ring));
+    smtlib2_set_memory_tag(tag);
+    r->tail_ = 0;
+    r->cached_head_ = 0;
+    r->head_ = 0;
+    r->cached_tail_ = 0;
+    r->end_ = false;
+    r->offset_ = s->offset_;
+    r->line_ = smtlib2_parser_get_lineno(s->flex_scanner_);
+    r->stop_ = 0;
+    s->ring_ = r;
+    if (pthread_create(&(r->thread_), NULL, smtlib2_token_ring_run, s) != 0) {
+        s->ring_ = NULL;
+        smtlib2_free(r);
+        smtlib2_set_allocator(prev);
+        return false;
+    }
+    smtlib2_set_allocator(prev);
+    return true;
+#else
+    (void)s;
+    return false;
+#endif
+}
+
+
+void smtlib2_scanner_stop_pipeline(smtlib2_scanner *s)
+{
+#ifdef SMTLIB2_PIPELINE
+    struct smtlib2_token_ring *r = s->ring_;
+    smtlib2_allocator *prev;
+    size_t head;
+
+    if (!r) {
+        return;
+    }
+    STORE(r->stop_, 1);
+    pthread_join(r->thread_, NULL);
+
+    /* the tokens not taken by the parser */
+    prev = smtlib2_set_allocator(s->allocator_);
+    for (head = r->head_; head != r->tail_; ++head) {
+        smtlib2_token *t = &(r->tokens_[head & (SMTLIB2_TOKEN_RING_SIZE - 1)]);
+        smtlib2_token_free(t->tok_, &(t->val_));
+    }
+    s->ring_ = NULL;
+    smtlib2_free(r);
+    smtlib2_set_allocator(prev);
+#else
+    (void)s;
+#endif
+}
+
+
+bool smtlib2_scanner_at_end(smtlib2_scanner *s)
+{
+#ifdef SMTLIB2_PIPELINE
+    if (s->ring_) {
+        return s->ring_->end_;
+    }
+#endif
+    return smtlib2_stream_eof(s->stream_);
+}
+
+
+int smtlib2_scanner_lex(YYSTYPE *lval, YYLTYPE *lloc, yyscan_t scanner)
+{
+#ifdef SMTLIB2_PIPELINE
+    smtlib2_scanner *s = (smtlib2_scanner *)smtlib2_parser_get_extra(scanner);
+    if (s->ring_) {
+        return smtlib2_token_ring_pop(s->ring_, lval, lloc);
+    }
+#endif
+    return smtlib2_parser_lex(lval, lloc, scanner);
+}
+
+
+void smtlib2_scanner_token_position(smtlib2_scanner *s, size_t *offset,
+                                    int *line)
+{
+#ifdef SMTLIB2_PIPELINE
+    if (s->ring_) {
+        *offset = s->ring_->offset_;
+        *line = s->ring_->line_;
+        return;
+    }
+#endif
+    *offset = s->offset_;
+    *line = smtlib2_parser_get_lineno(s->flex_scanner_);
+}
@@ -0,0 +1,444 @@
+/* -*- C -*-
+ *
+ * Cone-of-influence slicing of the queries of a script
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2slicer.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SLICER(p) ((smtlib2_slicer *)(p))
+#define SLICER_NONE ((size_t)-1)
+
+/* the value of the sorts made while slicing: only their names matter */
+static char smtlib2_slicer_dummy;
+
+
+static smtlib2_sort smtlib2_slicer_make_sort(smtlib2_parser_interface *p,
+                                             const char *sortname,
+                                             smtlib2_vector *index);
+static smtlib2_sort smtlib2_slicer_make_parametric_sort(
+    smtlib2_parser_interface *p, const char *name, smtlib2_vector *tps);
+static smtlib2_term smtlib2_slicer_mk_function(smtlib2_context ctx,
+                                               const char *symbol,
+                                               smtlib2_sort sort,
+                                               smtlib2_vector *index,
+                                               smtlib2_vector *args);
+static void smtlib2_slicer_annotate_term(smtlib2_parser_interface *p,
+                                         smtlib2_term term,
+                                         smtlib2_vector *annotations);
+static void smtlib2_slicer_get_value(smtlib2_parser_interface *p,
+                                     smtlib2_vector *terms);
+
+
+smtlib2_slicer *smtlib2_slicer_new(void)
+{
+    smtlib2_slicer *ret =
+        (smtlib2_slicer *)smtlib2_malloc(sizeof(smtlib2_slicer));
+    smtlib2_abstract_parser *ap = &(ret->parent_.parent_.parent_);
+    smtlib2_parser_interface *pi = &(ap->parent_);
+
+    smtlib2_splitter_init(&(ret->parent_), (smtlib2_context)ret);
+    /* the terms are needed, to see the symbols they refer to */
+    smtlib2_abstract_parser_set_lazy_asserts(ap, false);
+    ret->goal_ = false;
+    ret->functions_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
+                                            smtlib2_eqfun_str);
+    ret->sorts_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
+                                        smtlib2_eqfun_str);
+    ret->num_symbols_ = 0;
+    ret->uses_ = smtlib2_vector_new();
+    ret->offsets_ = smtlib2_vector_new();
+    ret->seen_ = smtlib2_vector_new();
+    ret->defined_ = smtlib2_vector_new();
+    ret->labels_ = smtlib2_vector_new();
+    ret->num_dropped_[0] = ret->num_dropped_[1] = 0;
+
+    pi->make_sort = smtlib2_slicer_make_sort;
+    pi->make_parametric_sort = smtlib2_slicer_make_parametric_sort;
+    pi->annotate_term = smtlib2_slicer_annotate_term;
+    ret->get_value_ = pi->get_value;
+    pi->get_value = smtlib2_slicer_get_value;
+    smtlib2_term_parser_set_function_handler(ap->termparser_,
+                                             smtlib2_slicer_mk_function);
+
+    return ret;
+}
+
+
+void smtlib2_slicer_delete(smtlib2_slicer *sl)
+{
+    smtlib2_allocator *prev =
+        smtlib2_set_allocator(sl->parent_.parent_.parent_.allocator_);
+
+    smtlib2_vector_delete(sl->labels_);
+    smtlib2_vector_delete(sl->defined_);
+    smtlib2_vector_delete(sl->seen_);
+    smtlib2_vector_delete(sl->offsets_);
+    smtlib2_vector_delete(sl->uses_);
+    smtlib2_hashtable_delete(sl->sorts_, (smtlib2_freefun)smtlib2_free, NULL);
+    smtlib2_hashtable_delete(sl->functions_, (smtlib2_freefun)smtlib2_free,
+                             NULL);
+    smtlib2_splitter_deinit(&(sl->parent_));
+    smtlib2_free(sl);
+    smtlib2_set_allocator(prev);
+}
+
+
+void smtlib2_slicer_set_goal(smtlib2_slicer *sl, bool yes)
+{
+    sl->goal_ = yes;
+}
+
+
+size_t smtlib2_slicer_num_dropped_declarations(smtlib2_slicer *sl)
+{
+    return sl->num_dropped_[0];
+}
+
+
+size_t smtlib2_slicer_num_dropped_asserts(smtlib2_slicer *sl)
+{
+    return sl->num_dropped_[1];
+}
+
+
+/* the id of the given symbol, in the given table */
+static size_t smtlib2_slicer_intern(smtlib2_slicer *sl, smtlib2_hashtable *t,
+                                    const char *symbol, size_t len)
+{
+    char *key = (char *)smtlib2_malloc(len + 1);
+    intptr_t v;
+
+    memcpy(key, symbol, len);
+    key[len] = '\0';
+    if (smtlib2_hashtable_find(t, (intptr_t)key, &v)) {
+        smtlib2_free(key);
+        return (size_t)v;
+    }
+    smtlib2_hashtable_set(t, (intptr_t)key, (intptr_t)sl->num_symbols_);
+    smtlib2_vector_push(sl->seen_, 0);
+    smtlib2_vector_push(sl->labels_, 0);
+    return sl->num_symbols_++;
+}
+
+
+/* records that the current command refers to the given symbol, and
+ * returns its id */
+static size_t smtlib2_slicer_use(smtlib2_slicer *sl, smtlib2_hashtable *t,
+                                 const char *symbol)
+{
+    size_t c = sl->parent_.current_;
+    size_t id = smtlib2_slicer_intern(sl, t, symbol, strlen(symbol));
+
+    while (smtlib2_vector_size(sl->offsets_) <= c) {
+        smtlib2_vector_push(sl->offsets_, smtlib2_vector_size(sl->uses_));
+    }
+    if ((size_t)smtlib2_vector_at(sl->seen_, id) != c+1) {
+        smtlib2_vector_at(sl->seen_, id) = (intptr_t)(c+1);
+        smtlib2_vector_push(sl->uses_, (intptr_t)id);
+    }
+    return id;
+}
+
+
+static smtlib2_sort smtlib2_slicer_make_sort(smtlib2_parser_interface *p,
+                                             const char *sortname,
+                                             smtlib2_vector *index)
+{
+    smtlib2_slicer_use(SLICER(p), SLICER(p)->sorts_, sortname);
+    return &smtlib2_slicer_dummy;
+}
+
+
+static smtlib2_sort smtlib2_slicer_make_parametric_sort(
+    smtlib2_parser_interface *p, const char *name, smtlib2_vector *tps)
+{
+    smtlib2_slicer_use(SLICER(p), SLICER(p)->sorts_, name);
+    return &smtlib2_slicer_dummy;
+}
+
+
+static smtlib2_term smtlib2_slicer_mk_function(smtlib2_context ctx,
+                                               const char *symbol,
+                                               smtlib2_sort sort,
+                                               smtlib2_vector *index,
+                                               smtlib2_vector *args)
+{
+    smtlib2_slicer_use(SLICER(ctx), SLICER(ctx)->functions_, symbol);
+    return &smtlib2_slicer_dummy;
+}
+
+
+/* a :named label is a symbol of the assert that introduces it, so that the
+ * asserts referring to the label pull that one into the cone */
+static void smtlib2_slicer_annotate_term(smtlib2_parser_interface *p,
+                                         smtlib2_term term,
+                                         smtlib2_vector *annotations)
+{
+    size_t i;
+
+    for (i = 0; i < smtlib2_vector_size(annotations); ++i) {
+        char **an = (char **)smtlib2_vector_at(annotations, i);
+        if (strcmp(an[0], ":named") == 0 && an[1]) {
+            size_t id =
+                smtlib2_slicer_use(SLICER(p), SLICER(p)->functions_, an[1]);
+            smtlib2_vector_at(SLICER(p)->labels_, id) = 1;
+        }
+    }
+}
+
+
+static void smtlib2_slicer_get_value(smtlib2_parser_interface *p,
+                                     smtlib2_vector *terms)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+    smtlib2_vector *values = smtlib2_vector_new();
+
+    /* the values are not needed, only the symbols seen while parsing */
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        smtlib2_abstract_parser_force_terms(ap, terms, values);
+    }
+    smtlib2_vector_delete(values);
+    SLICER(p)->get_value_(p, terms);
+}
+
+
+/* records the symbol introduced by each declaration or definition, which
+ * comes right after the name of the command */
+static void smtlib2_slicer_find_definitions(smtlib2_slicer *sl)
+{
+    smtlib2_command_index *idx = sl->parent_.index_;
+    const char *data = smtlib2_command_index_data(idx);
+    size_t i, n = smtlib2_command_index_size(idx);
+
+    smtlib2_vector_reserve(sl->defined_, n);
+    for (i = 0; i < n; ++i) {
+        smtlib2_hashtable *t = NULL;
+        size_t b, e, end = smtlib2_command_index_end(idx, i);
+        intptr_t def = 0;
+
+        switch (smtlib2_command_index_kind(idx, i)) {
+        case SMTLIB2_COMMAND_DECLARE_FUN:
+        case SMTLIB2_COMMAND_DEFINE_FUN:
+            t = sl->functions_;
+            break;
+        case SMTLIB2_COMMAND_DECLARE_SORT:
+        case SMTLIB2_COMMAND_DEFINE_SORT:
+            t = sl->sorts_;
+            break;
+        default:
+            break;
+        }
+        if (t) {
+            /* skip the opening parenthesis and the name of the command */
+            b = smtlib2_command_index_begin(idx, i) + 1;
+            b = smtlib2_skip_blanks(data, b, end);
+            b = smtlib2_skip_blanks(data, smtlib2_skip_sexpr(data, b, end),
+                                    end);
+            e = smtlib2_skip_sexpr(data, b, end);
+            if (e - b >= 2 && data[b] == '|' && data[e-1] == '|') {
+                ++b;
+                --e;
+            }
+            if (e > b) {
+                def = 1 + smtlib2_slicer_intern(sl, t, data + b, e - b);
+            }
+        }
+        smtlib2_vector_push(sl->defined_, def);
+    }
+    while (smtlib2_vector_size(sl->offsets_) <= n) {
+        smtlib2_vector_push(sl->offsets_, smtlib2_vector_size(sl->uses_));
+    }
+}
+
+
+/* the scratch space of the slicing of a query. The per-symbol arrays are
+ * valid only where their gen_ entry is the number of the current query, so
+ * that they are never cleared */
+typedef struct smtlib2_slicer_scratch {
+    size_t *mark_;       /* the symbol is in the cone */
+    size_t *def_gen_;
+    size_t *def_head_;   /* the first command of the query introducing the
+                          * symbol (as a position in the query) */
+    size_t *use_gen_;
+    size_t *use_head_;   /* the first entry of asserts_ for the symbol */
+    size_t *def_next_;   /* per position, the next one with the same symbol */
+    bool *kept_;
+    smtlib2_vector *asserts_; /* position and next entry, pairwise */
+    smtlib2_vector *todo_;    /* the symbols entering the cone */
+} smtlib2_slicer_scratch;
+
+
+/* adds the command at the given position of the query to the slice */
+static void smtlib2_slicer_keep(smtlib2_slicer *sl, smtlib2_slicer_scratch *w,
+                                smtlib2_vector *q, size_t pos, size_t gen)
+{
+    size_t c = (size_t)smtlib2_vector_at(q, pos);
+    size_t i, e = (size_t)smtlib2_vector_at(sl->offsets_, c+1);
+
+    w->kept_[pos] = true;
+    for (i = (size_t)smtlib2_vector_at(sl->offsets_, c); i < e; ++i) {
+        size_t u = (size_t)smtlib2_vector_at(sl->uses_, i);
+        if (w->mark_[u] != gen) {
+            w->mark_[u] = gen;
+            smtlib2_vector_push(w->todo_, (intptr_t)u);
+        }
+    }
+}
+
+
+static void smtlib2_slicer_slice_query(smtlib2_slicer *sl,
+                                       smtlib2_slicer_scratch *w,
+                                       smtlib2_vector *q, size_t gen)
+{
+    smtlib2_command_index *idx = sl->parent_.index_;
+    size_t pos, n = smtlib2_vector_size(q), goal = SLICER_NONE, kept = 0;
+
+    w->def_next_ = (size_t *)smtlib2_malloc(sizeof(size_t) * (n+1));
+    w->kept_ = (bool *)smtlib2_malloc(sizeof(bool) * (n+1));
+    smtlib2_vector_resize(w->asserts_, 0);
+    smtlib2_vector_resize(w->todo_, 0);
+
+    for (pos = 0; pos < n; ++pos) {
+        size_t c = (size_t)smtlib2_vector_at(q, pos);
+        size_t d = (size_t)smtlib2_vector_at(sl->defined_, c);
+
+        w->kept_[pos] = false;
+        if (d) {
+            --d;
+            w->def_next_[pos] = w->def_gen_[d] == gen ? w->def_head_[d] :
+                SLICER_NONE;
+            w->def_head_[d] = pos;
+            w->def_gen_[d] = gen;
+        } else if (smtlib2_command_index_kind(idx, c) ==
+                   SMTLIB2_COMMAND_ASSERT && sl->goal_) {
+            size_t i, e = (size_t)smtlib2_vector_at(sl->offsets_, c+1);
+            goal = pos;
+            for (i = (size_t)smtlib2_vector_at(sl->offsets_, c); i < e; ++i) {
+                size_t u = (size_t)smtlib2_vector_at(sl->uses_, i);
+                /* the declarations come first, so the symbols of the query
+                 * are already known here */
+                if (w->def_gen_[u] != gen &&
+                    !smtlib2_vector_at(sl->labels_, u)) {
+                    continue;
+                }
+                smtlib2_vector_push(w->asserts_, (intptr_t)pos);
+                smtlib2_vector_push(w->asserts_, w->use_gen_[u] == gen ?
+                                    (intptr_t)w->use_head_[u] :
+                                    (intptr_t)SLICER_NONE);
+                w->use_head_[u] = smtlib2_vector_size(w->asserts_) - 2;
+                w->use_gen_[u] = gen;
+            }
+        }
+    }
+
+    /* the roots */
+    for (pos = 0; pos < n; ++pos) {
+        size_t c = (size_t)smtlib2_vector_at(q, pos);
+        if (!smtlib2_vector_at(sl->defined_, c) &&
+            (!sl->goal_ || smtlib2_command_index_kind(idx, c) !=
+             SMTLIB2_COMMAND_ASSERT)) {
+            smtlib2_slicer_keep(sl, w, q, pos, gen);
+        }
+    }
+    if (goal != SLICER_NONE) {
+        smtlib2_slicer_keep(sl, w, q, goal, gen);
+    }
+
+    /* the cone */
+    while (smtlib2_vector_size(w->todo_) > 0) {
+        size_t u = (size_t)smtlib2_vector_last(w->todo_);
+        smtlib2_vector_pop(w->todo_);
+        if (w->def_gen_[u] == gen) {
+            for (pos = w->def_head_[u]; pos != SLICER_NONE;
+                 pos = w->def_next_[pos]) {
+                if (!w->kept_[pos]) {
+                    smtlib2_slicer_keep(sl, w, q, pos, gen);
+                }
+            }
+        }
+        if (sl->goal_ && w->use_gen_[u] == gen) {
+            size_t a;
+            for (a = w->use_head_[u]; a != SLICER_NONE;
+                 a = (size_t)smtlib2_vector_at(w->asserts_, a+1)) {
+                pos = (size_t)smtlib2_vector_at(w->asserts_, a);
+                if (!w->kept_[pos]) {
+                    smtlib2_slicer_keep(sl, w, q, pos, gen);
+                }
+            }
+        }
+    }
+
+    for (pos = 0; pos < n; ++pos) {
+        intptr_t c = smtlib2_vector_at(q, pos);
+        if (w->kept_[pos]) {
+            smtlib2_vector_at(q, kept++) = c;
+        } else if (smtlib2_vector_at(sl->defined_, c)) {
+            ++sl->num_dropped_[0];
+        } else {
+            ++sl->num_dropped_[1];
+        }
+    }
+    smtlib2_vector_resize(q, kept);
+
+    smtlib2_free(w->kept_);
+    smtlib2_free(w->def_next_);
+}
+
+
+void smtlib2_slicer_parse(smtlib2_slicer *sl, smtlib2_command_index *idx)
+{
+    smtlib2_splitter *s = &(sl->parent_);
+    smtlib2_slicer_scratch w;
+    size_t i, m;
+
+    smtlib2_splitter_parse(s, idx);
+    smtlib2_slicer_find_definitions(sl);
+
+    m = sl->num_symbols_ + 1;
+    w.mark_ = (size_t *)smtlib2_malloc(sizeof(size_t) * m);
+    w.def_gen_ = (size_t *)smtlib2_malloc(sizeof(size_t) * m);
+    w.def_head_ = (size_t *)smtlib2_malloc(sizeof(size_t) * m);
+    w.use_gen_ = (size_t *)smtlib2_malloc(sizeof(size_t) * m);
+    w.use_head_ = (size_t *)smtlib2_malloc(sizeof(size_t) * m);
+    for (i = 0; i < m; ++i) {
+        w.mark_[i] = w.def_gen_[i] = w.use_gen_[i] = 0;
+    }
+    w.asserts_ = smtlib2_vector_new();
+    w.todo_ = smtlib2_vector_new();
+
+    for (i = 0; i < smtlib2_splitter_num_queries(s); ++i) {
+        smtlib2_slicer_slice_query(
+            sl, &w, (smtlib2_vector *)smtlib2_vector_at(s->queries_, i), i+1);
+    }
+
+    smtlib2_vector_delete(w.todo_);
+    smtlib2_vector_delete(w.asserts_);
+    smtlib2_free(w.use_head_);
+    smtlib2_free(w.use_gen_);
+    smtlib2_free(w.def_head_);
+    smtlib2_free(w.def_gen_);
+    smtlib2_free(w.mark_);
+}
@@ -0,0 +1,200 @@
+/* -*- C -*-
+ *
+ * Snapshots of SMT-LIB v2 parsers, cloned in O(1)
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2snapshot.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2termparser.h"
+#include "smtparser/smtlib2allocator.h"
+
+
+struct smtlib2_snapshot {
+    const smtlib2_snapshot_backend *backend_;
+    void *state_;
+    smtlib2_pmap bindings_;
+    smtlib2_pmap term_params_;
+    smtlib2_vector *info_; /* keyword, value pairs */
+    smtlib2_vector *undo_trail_;
+    smtlib2_vector *undo_levels_;
+    bool persistent_scopes_;
+    smtlib2_vector *scope_roots_;
+    FILE *outstream_;
+    FILE *errstream_;
+    bool print_success_;
+    bool set_logic_ok_;
+    smtlib2_status status_;
+    bool lazy_asserts_;
+    bool pipelined_;
+    int fork_join_threads_;
+};
+
+
+/* appends the elements of src to dst */
+static void smtlib2_snapshot_copy(smtlib2_vector *dst, smtlib2_vector *src)
+{
+    size_t i;
+    for (i = 0; i < smtlib2_vector_size(src); ++i) {
+        smtlib2_vector_push(dst, smtlib2_vector_at(src, i));
+    }
+}
+
+
+/* appends copies of the persistent maps in src to dst */
+static void smtlib2_snapshot_copy_maps(smtlib2_vector *dst,
+                                       smtlib2_vector *src)
+{
+    size_t i;
+    for (i = 0; i < smtlib2_vector_size(src); ++i) {
+        smtlib2_pmap *m = (smtlib2_pmap *)smtlib2_vector_at(src, i);
+        smtlib2_pmap *c = (smtlib2_pmap *)smtlib2_malloc(sizeof(smtlib2_pmap));
+        smtlib2_pmap_init(c, m->hf_, m->eqf_, m->fk_, m->fv_);
+        smtlib2_pmap_assign(c, m);
+        smtlib2_vector_push(dst, (intptr_t)c);
+    }
+}
+
+
+smtlib2_snapshot *smtlib2_parser_snapshot(smtlib2_abstract_parser *p)
+{
+    smtlib2_snapshot *ret;
+    smtlib2_term_parser *tp = p->termparser_;
+    smtlib2_allocator *prev;
+    smtlib2_vector *keys;
+    size_t i;
+
+    if (!p->snapshot_backend_ ||
+        p->allocator_ != smtlib2_default_allocator()) {
+        return NULL;
+    }
+    prev = smtlib2_set_allocator(p->allocator_);
+
+    ret = (smtlib2_snapshot *)smtlib2_malloc(sizeof(smtlib2_snapshot));
+    ret->backend_ = p->snapshot_backend_;
+    ret->state_ = ret->backend_->save(p);
+    smtlib2_pmap_init(&(ret->bindings_), tp->bindings_.hf_,
+                      tp->bindings_.eqf_, tp->bindings_.fk_,
+                      tp->bindings_.fv_);
+    smtlib2_pmap_assign(&(ret->bindings_), &(tp->bindings_));
+    smtlib2_pmap_init(&(ret->term_params_), tp->term_params_.hf_,
+                      tp->term_params_.eqf_, tp->term_params_.fk_,
+                      tp->term_params_.fv_);
+    smtlib2_pmap_assign(&(ret->term_params_), &(tp->term_params_));
+
+    ret->info_ = smtlib2_vector_new();
+    keys = smtlib2_hashtable_keys(p->info_);
+    for (i = 0; i < smtlib2_vector_size(keys); ++i) {
+        intptr_t k = smtlib2_vector_at(keys, i);
+        smtlib2_vector_push(ret->info_, (intptr_t)smtlib2_strdup((char *)k));
+        smtlib2_vector_push(
+            ret->info_,
+            (intptr_t)smtlib2_strdup(
+                (char *)smtlib2_hashtable_get(p->info_, k)));
+    }
+    smtlib2_vector_delete(keys);
+
+    /* the data of the undo actions are symbols and keys of the shared state,
+     * valid in the clones as well */
+    ret->undo_trail_ = smtlib2_vector_new();
+    smtlib2_snapshot_copy(ret->undo_trail_, p->undo_trail_);
+    ret->undo_levels_ = smtlib2_vector_new();
+    smtlib2_snapshot_copy(ret->undo_levels_, p->undo_levels_);
+    ret->persistent_scopes_ = p->persistent_scopes_;
+    ret->scope_roots_ = smtlib2_vector_new();
+    smtlib2_snapshot_copy_maps(ret->scope_roots_, p->scope_roots_);
+
+    ret->outstream_ = p->outstream_;
+    ret->errstream_ = p->errstream_;
+    ret->print_success_ = p->print_success_;
+    ret->set_logic_ok_ = p->set_logic_ok_;
+    ret->status_ = p->status_;
+    ret->lazy_asserts_ = p->lazy_asserts_;
+    ret->pipelined_ = p->pipelined_;
+    ret->fork_join_threads_ = p->fork_join_threads_;
+
+    smtlib2_set_allocator(prev);
+    return ret;
+}
+
+
+smtlib2_abstract_parser *smtlib2_parser_clone(smtlib2_snapshot *s)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(
+        smtlib2_default_allocator());
+    smtlib2_abstract_parser *ret = s->backend_->restore(s->state_);
+    smtlib2_term_parser *tp = ret->termparser_;
+    size_t i;
+
+    smtlib2_pmap_assign(&(tp->bindings_), &(s->bindings_));
+    smtlib2_pmap_assign(&(tp->term_params_), &(s->term_params_));
+    for (i = 0; i < smtlib2_vector_size(s->info_); i += 2) {
+        smtlib2_abstract_parser_set_info(
+            SMTLIB2_PARSER_INTERFACE(ret),
+            (const char *)smtlib2_vector_at(s->info_, i),
+            (const char *)smtlib2_vector_at(s->info_, i+1));
+    }
+    smtlib2_snapshot_copy(ret->undo_trail_, s->undo_trail_);
+    smtlib2_snapshot_copy(ret->undo_levels_, s->undo_levels_);
+    /* the clone registers the same maps as the original */
+    ret->persistent_scopes_ = s->persistent_scopes_;
+    smtlib2_snapshot_copy_maps(ret->scope_roots_, s->scope_roots_);
+    ret->outstream_ = s->outstream_;
+    ret->errstream_ = s->errstream_;
+    ret->print_success_ = s->print_success_;
+    ret->set_logic_ok_ = s->set_logic_ok_;
+    ret->status_ = s->status_;
+    ret->lazy_asserts_ = s->lazy_asserts_;
+    ret->pipelined_ = s->pipelined_;
+    ret->fork_join_threads_ = s->fork_join_threads_;
+    smtlib2_abstract_parser_reset_response(ret);
+
+    smtlib2_set_allocator(prev);
+    return ret;
+}
+
+
+void smtlib2_snapshot_delete(smtlib2_snapshot *s)
+{
+    smtlib2_allocator *prev = smtlib2_set_allocator(
+        smtlib2_default_allocator());
+    size_t i;
+
+    s->backend_->release(s->state_);
+    smtlib2_pmap_deinit(&(s->bindings_));
+    smtlib2_pmap_deinit(&(s->term_params_));
+    for (i = 0; i < smtlib2_vector_size(s->info_); ++i) {
+        smtlib2_free((char *)smtlib2_vector_at(s->info_, i));
+    }
+    smtlib2_vector_delete(s->info_);
+    smtlib2_vector_delete(s->undo_trail_);
+    smtlib2_vector_delete(s->undo_levels_);
+    for (i = 0; i < smtlib2_vector_size(s->scope_roots_); ++i) {
+        smtlib2_pmap *c = (smtlib2_pmap *)smtlib2_vector_at(s->scope_roots_, i);
+        smtlib2_pmap_deinit(c);
+        smtlib2_free(c);
+    }
+    smtlib2_vector_delete(s->scope_roots_);
+    smtlib2_free(s);
+
+    smtlib2_set_allocator(prev);
+}
@@ -0,0 +1,504 @@
+/* -*- C -*-
+ *
+ * Splitting of incremental scripts into independent queries
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2splitter.h"
+#include "smtparser/smtlib2lazyterm.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SMTLIB2_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+
+#define SPLITTER(p) ((smtlib2_splitter *)(p))
+#define SPLITTER_OK(p) \
+    (((smtlib2_abstract_parser *)(p))->response_ != SMTLIB2_RESPONSE_ERROR)
+
+
+static void smtlib2_splitter_set_logic(smtlib2_parser_interface *p,
+                                       const char *logic);
+static void smtlib2_splitter_declare_sort(smtlib2_parser_interface *p,
+                                          const char *sortname, int arity);
+static void smtlib2_splitter_define_sort(smtlib2_parser_interface *p,
+                                         const char *sortname,
+                                         smtlib2_vector *params,
+                                         smtlib2_sort sort);
+static void smtlib2_splitter_declare_function(smtlib2_parser_interface *p,
+                                              const char *name,
+                                              smtlib2_sort sort);
+static void smtlib2_splitter_define_function(smtlib2_parser_interface *p,
+                                             const char *name,
+                                             smtlib2_vector *params,
+                                             smtlib2_sort sort,
+                                             smtlib2_term term);
+static void smtlib2_splitter_push(smtlib2_parser_interface *p, int n);
+static void smtlib2_splitter_pop(smtlib2_parser_interface *p, int n);
+static void smtlib2_splitter_reset_assertions(smtlib2_parser_interface *p);
+static void smtlib2_splitter_reset(smtlib2_parser_interface *p);
+static void smtlib2_splitter_assert_formula(smtlib2_parser_interface *p,
+                                            smtlib2_term term);
+static void smtlib2_splitter_assert_lazy_formula(smtlib2_parser_interface *p,
+                                                 smtlib2_lazy_term *term);
+static void smtlib2_splitter_check_sat(smtlib2_parser_interface *p);
+static void smtlib2_splitter_get_query_info(smtlib2_parser_interface *p);
+static void smtlib2_splitter_get_value(smtlib2_parser_interface *p,
+                                       smtlib2_vector *terms);
+static void smtlib2_splitter_set_str_option(smtlib2_parser_interface *p,
+                                            const char *keyword,
+                                            const char *value);
+static void smtlib2_splitter_set_int_option(smtlib2_parser_interface *p,
+                                            const char *keyword, int value);
+static void smtlib2_splitter_set_rat_option(smtlib2_parser_interface *p,
+                                            const char *keyword, double value);
+static void smtlib2_splitter_get_info(smtlib2_parser_interface *p,
+                                      const char *keyword);
+static void smtlib2_splitter_set_info(smtlib2_parser_interface *p,
+                                      const char *keyword, const char *value);
+
+
+smtlib2_splitter *smtlib2_splitter_new(void)
+{
+    smtlib2_splitter *ret =
+        (smtlib2_splitter *)smtlib2_malloc(sizeof(smtlib2_splitter));
+    smtlib2_splitter_init(ret, (smtlib2_context)ret);
+    return ret;
+}
+
+
+void smtlib2_splitter_init(smtlib2_splitter *s, smtlib2_context ctx)
+{
+    smtlib2_parser_interface *pi;
+
+    smtlib2_null_parser_init(&(s->parent_), ctx);
+    s->parent_.parent_.print_success_ = false;
+    smtlib2_abstract_parser_set_lazy_asserts(&(s->parent_.parent_), true);
+    s->index_ = NULL;
+    s->current_ = 0;
+    s->header_ = smtlib2_vector_new();
+    s->stack_ = smtlib2_vector_new();
+    s->levels_ = smtlib2_vector_new();
+    s->queries_ = smtlib2_vector_new();
+    s->attach_ = false;
+
+    pi = SMTLIB2_PARSER_INTERFACE_NULL(&(s->parent_));
+    pi->set_logic = smtlib2_splitter_set_logic;
+    pi->declare_sort = smtlib2_splitter_declare_sort;
+    pi->define_sort = smtlib2_splitter_define_sort;
+    pi->declare_function = smtlib2_splitter_declare_function;
+    pi->define_function = smtlib2_splitter_define_function;
+    pi->push = smtlib2_splitter_push;
+    pi->pop = smtlib2_splitter_pop;
+    pi->reset_assertions = smtlib2_splitter_reset_assertions;
+    pi->reset = smtlib2_splitter_reset;
+    pi->assert_formula = smtlib2_splitter_assert_formula;
+    pi->assert_lazy_formula = smtlib2_splitter_assert_lazy_formula;
+    pi->check_sat = smtlib2_splitter_check_sat;
+    pi->get_assertions = smtlib2_splitter_get_query_info;
+    pi->get_unsat_core = smtlib2_splitter_get_query_info;
+    pi->get_proof = smtlib2_splitter_get_query_info;
+    pi->get_assignment = smtlib2_splitter_get_query_info;
+    pi->get_value = smtlib2_splitter_get_value;
+    pi->set_str_option = smtlib2_splitter_set_str_option;
+    pi->set_int_option = smtlib2_splitter_set_int_option;
+    pi->set_rat_option = smtlib2_splitter_set_rat_option;
+    pi->get_info = smtlib2_splitter_get_info;
+    pi->set_info = smtlib2_splitter_set_info;
+}
+
+
+void smtlib2_splitter_deinit(smtlib2_splitter *s)
+{
+    size_t i;
+
+    for (i = 0; i < smtlib2_vector_size(s->queries_); ++i) {
+        smtlib2_vector_delete(
+            (smtlib2_vector *)smtlib2_vector_at(s->queries_, i));
+    }
+    smtlib2_vector_delete(s->queries_);
+    smtlib2_vector_delete(s->levels_);
+    smtlib2_vector_delete(s->stack_);
+    smtlib2_vector_delete(s->header_);
+    smtlib2_null_parser_deinit(&(s->parent_));
+}
+
+
+void smtlib2_splitter_delete(smtlib2_splitter *s)
+{
+    smtlib2_allocator *prev =
+        smtlib2_set_allocator(s->parent_.parent_.allocator_);
+    smtlib2_splitter_deinit(s);
+    smtlib2_free(s);
+    smtlib2_set_allocator(prev);
+}
+
+
+void smtlib2_splitter_parse(smtlib2_splitter *s, smtlib2_command_index *idx)
+{
+    smtlib2_abstract_parser *p = &(s->parent_.parent_);
+    size_t i, n = smtlib2_command_index_size(idx);
+
+    s->index_ = idx;
+    for (i = 0; i < n && !p->exiting_; ++i) {
+        s->current_ = i;
+        smtlib2_abstract_parser_parse_commands(p, idx, i, i+1);
+    }
+}
+
+
+size_t smtlib2_splitter_num_queries(smtlib2_splitter *s)
+{
+    return smtlib2_vector_size(s->queries_);
+}
+
+
+bool smtlib2_splitter_print_query(smtlib2_splitter *s, size_t i, FILE *out)
+{
+    smtlib2_vector *q = (smtlib2_vector *)smtlib2_vector_at(s->queries_, i);
+    const char *data = smtlib2_command_index_data(s->index_);
+    size_t j;
+
+    for (j = 0; j < smtlib2_vector_size(q); ++j) {
+        size_t c = (size_t)smtlib2_vector_at(q, j);
+        size_t b = smtlib2_command_index_begin(s->index_, c);
+        size_t e = smtlib2_command_index_end(s->index_, c);
+        fwrite(data + b, 1, e - b, out);
+        fputc('\n', out);
+    }
+    fputs("(exit)\n", out);
+    return !ferror(out);
+}
+
+
+/* writes the query of the given check-sat, returns false on I/O errors */
+static bool smtlib2_splitter_write_query(smtlib2_splitter *s,
+                                         const char *prefix, size_t i)
+{
+    char *name = smtlib2_sprintf("%s%04lu.smt2", prefix, (unsigned long)(i+1));
+    FILE *out = fopen(name, "w");
+    bool ok = false;
+
+    if (out) {
+        ok = smtlib2_splitter_print_query(s, i, out);
+        ok = (fclose(out) == 0) && ok;
+    }
+    smtlib2_free(name);
+    return ok;
+}
+
+
+#ifdef SMTLIB2_HAVE_PTHREADS
+
+typedef struct smtlib2_splitter_writers {
+    pthread_mutex_t lock_;
+    smtlib2_splitter *splitter_;
+    const char *prefix_;
+    size_t next_;     /* the next query to write */
+    size_t failed_;
+} smtlib2_splitter_writers;
+
+
+static void *smtlib2_splitter_writer(void *data)
+{
+    smtlib2_splitter_writers *w = (smtlib2_splitter_writers *)data;
+    size_t n = smtlib2_splitter_num_queries(w->splitter_);
+
+    for (;;) {
+        size_t i;
+        bool ok;
+
+        pthread_mutex_lock(&(w->lock_));
+        i = w->next_++;
+        pthread_mutex_unlock(&(w->lock_));
+        if (i >= n) {
+            break;
+        }
+        ok = smtlib2_splitter_write_query(w->splitter_, w->prefix_, i);
+        if (!ok) {
+            pthread_mutex_lock(&(w->lock_));
+            ++w->failed_;
+            pthread_mutex_unlock(&(w->lock_));
+        }
+    }
+    return NULL;
+}
+
+#endif /* SMTLIB2_HAVE_PTHREADS */
+
+
+size_t smtlib2_splitter_write(smtlib2_splitter *s, const char *prefix,
+                              int nthreads)
+{
+    size_t i, failed = 0;
+
+#ifdef SMTLIB2_HAVE_PTHREADS
+    if (nthreads > 1) {
+        smtlib2_splitter_writers w;
+        pthread_t *threads =
+            (pthread_t *)smtlib2_malloc(sizeof(pthread_t) * nthreads);
+        int started;
+
+        pthread_mutex_init(&(w.lock_), NULL);
+        w.splitter_ = s;
+        w.prefix_ = prefix;
+        w.next_ = 0;
+        w.failed_ = 0;
+        for (started = 0; started < nthreads; ++started) {
+            if (pthread_create(&(threads[started]), NULL,
+                               smtlib2_splitter_writer, &w) != 0) {
+                break;
+            }
+        }
+        if (started == 0) {
+            /* no threads: the calling thread does all the writing */
+            smtlib2_splitter_writer(&w);
+        }
+        while (started-- > 0) {
+            pthread_join(threads[started], NULL);
+        }
+        pthread_mutex_destroy(&(w.lock_));
+        smtlib2_free(threads);
+        return w.failed_;
+    }
+#endif
+    (void)nthreads;
+    for (i = 0; i < smtlib2_splitter_num_queries(s); ++i) {
+        if (!smtlib2_splitter_write_query(s, prefix, i)) {
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+
+/* records the current command in the header of the queries */
+static void smtlib2_splitter_record_header(smtlib2_parser_interface *p)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    if (SPLITTER_OK(p)) {
+        smtlib2_vector_push(s->header_, (intptr_t)s->current_);
+        s->attach_ = false;
+    }
+}
+
+
+/* records the current command in the assertion stack */
+static void smtlib2_splitter_record(smtlib2_parser_interface *p)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    if (SPLITTER_OK(p)) {
+        smtlib2_vector_push(s->stack_, (intptr_t)s->current_);
+        s->attach_ = false;
+    }
+}
+
+
+static void smtlib2_splitter_set_logic(smtlib2_parser_interface *p,
+                                       const char *logic)
+{
+    smtlib2_abstract_parser_set_logic(p, logic);
+    smtlib2_splitter_record_header(p);
+}
+
+
+static void smtlib2_splitter_declare_sort(smtlib2_parser_interface *p,
+                                          const char *sortname, int arity)
+{
+    smtlib2_splitter_record(p);
+}
+
+
+static void smtlib2_splitter_define_sort(smtlib2_parser_interface *p,
+                                         const char *sortname,
+                                         smtlib2_vector *params,
+                                         smtlib2_sort sort)
+{
+    smtlib2_splitter_record(p);
+}
+
+
+static void smtlib2_splitter_declare_function(smtlib2_parser_interface *p,
+                                              const char *name,
+                                              smtlib2_sort sort)
+{
+    smtlib2_splitter_record(p);
+}
+
+
+static void smtlib2_splitter_define_function(smtlib2_parser_interface *p,
+                                             const char *name,
+                                             smtlib2_vector *params,
+                                             smtlib2_sort sort,
+                                             smtlib2_term term)
+{
+    smtlib2_splitter_record(p);
+}
+
+
+static void smtlib2_splitter_push(smtlib2_parser_interface *p, int n)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    if (SPLITTER_OK(p)) {
+        while (n-- > 0) {
+            smtlib2_vector_push(s->levels_, smtlib2_vector_size(s->stack_));
+        }
+        s->attach_ = false;
+    }
+}
+
+
+static void smtlib2_splitter_pop(smtlib2_parser_interface *p, int n)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+    size_t levels = smtlib2_vector_size(s->levels_);
+
+    if (SPLITTER_OK(p)) {
+        if (n < 0 || (size_t)n > levels) {
+            ap->response_ = SMTLIB2_RESPONSE_ERROR;
+            ap->errmsg_ = smtlib2_sprintf("can't pop %d levels", n);
+        } else if (n > 0) {
+            smtlib2_vector_resize(
+                s->stack_,
+                (size_t)smtlib2_vector_at(s->levels_, levels - n));
+            smtlib2_vector_resize(s->levels_, levels - n);
+            s->attach_ = false;
+        }
+    }
+}
+
+
+static void smtlib2_splitter_reset_assertions(smtlib2_parser_interface *p)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    if (SPLITTER_OK(p)) {
+        smtlib2_vector_clear(s->stack_);
+        smtlib2_vector_clear(s->levels_);
+        s->attach_ = false;
+    }
+}
+
+
+static void smtlib2_splitter_reset(smtlib2_parser_interface *p)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    smtlib2_splitter_reset_assertions(p);
+    if (SPLITTER_OK(p)) {
+        /* a new set-logic is allowed after a reset */
+        smtlib2_abstract_parser_reset(p);
+        smtlib2_vector_clear(s->header_);
+    }
+}
+
+
+static void smtlib2_splitter_assert_formula(smtlib2_parser_interface *p,
+                                            smtlib2_term term)
+{
+    smtlib2_splitter_record(p);
+}
+
+
+static void smtlib2_splitter_assert_lazy_formula(smtlib2_parser_interface *p,
+                                                 smtlib2_lazy_term *term)
+{
+    /* the term is printed back from the source, it is never needed */
+    smtlib2_lazy_term_delete(term);
+    smtlib2_splitter_record(p);
+}
+
+
+static void smtlib2_splitter_check_sat(smtlib2_parser_interface *p)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    if (SPLITTER_OK(p)) {
+        smtlib2_vector *q = smtlib2_vector_new();
+        size_t i;
+        smtlib2_vector_reserve(q, smtlib2_vector_size(s->header_) +
+                               smtlib2_vector_size(s->stack_) + 1);
+        for (i = 0; i < smtlib2_vector_size(s->header_); ++i) {
+            smtlib2_vector_push(q, smtlib2_vector_at(s->header_, i));
+        }
+        for (i = 0; i < smtlib2_vector_size(s->stack_); ++i) {
+            smtlib2_vector_push(q, smtlib2_vector_at(s->stack_, i));
+        }
+        smtlib2_vector_push(q, (intptr_t)s->current_);
+        smtlib2_vector_push(s->queries_, (intptr_t)q);
+        s->attach_ = true;
+    }
+}
+
+
+/* the commands asking about the result of a check-sat are kept with it */
+static void smtlib2_splitter_get_query_info(smtlib2_parser_interface *p)
+{
+    smtlib2_splitter *s = SPLITTER(p);
+    if (SPLITTER_OK(p) && s->attach_) {
+        smtlib2_vector_push(
+            (smtlib2_vector *)smtlib2_vector_last(s->queries_),
+            (intptr_t)s->current_);
+    }
+}
+
+
+static void smtlib2_splitter_get_value(smtlib2_parser_interface *p,
+                                       smtlib2_vector *terms)
+{
+    smtlib2_splitter_get_query_info(p);
+}
+
+
+static void smtlib2_splitter_set_str_option(smtlib2_parser_interface *p,
+                                            const char *keyword,
+                                            const char *value)
+{
+    smtlib2_splitter_record_header(p);
+}
+
+
+static void smtlib2_splitter_set_int_option(smtlib2_parser_interface *p,
+                                            const char *keyword, int value)
+{
+    smtlib2_splitter_record_header(p);
+}
+
+
+static void smtlib2_splitter_set_rat_option(smtlib2_parser_interface *p,
+                                            const char *keyword, double value)
+{
+    smtlib2_splitter_record_header(p);
+}
+
+
+static void smtlib2_splitter_get_info(smtlib2_parser_interface *p,
+                                      const char *keyword)
+{
+}
+
+
+static void smtlib2_splitter_set_info(smtlib2_parser_interface *p,
+                                      const char *keyword, const char *value)
+{
+    smtlib2_splitter_record_header(p);
+}
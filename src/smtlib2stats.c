@@ -0,0 +1,627 @@
+/* -*- C -*-
+ *
+ * Instrumentation of the parser callbacks: counters and latency histograms
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "smtparser/smtlib2stats.h"
+#include "smtparser/smtlib2abstractparser_private.h"
+#include "smtparser/smtlib2trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#  include <x86intrin.h>
+#  define SMTLIB2_TICKS_RDTSC
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#  define SMTLIB2_TICKS_RDTSC
+#elif defined(__GNUC__) && defined(__aarch64__)
+#  define SMTLIB2_TICKS_CNTVCT
+#endif
+
+
+/* wall-clock time in seconds */
+static double smtlib2_stats_now(void)
+{
+#if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+smtlib2_ticks smtlib2_ticks_now(void)
+{
+#if defined(SMTLIB2_TICKS_RDTSC)
+    return (smtlib2_ticks)__rdtsc();
+#elif defined(SMTLIB2_TICKS_CNTVCT)
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return (smtlib2_ticks)(smtlib2_stats_now() * 1e9);
+#endif
+}
+
+
+double smtlib2_ticks_calibrate(void)
+{
+#if defined(SMTLIB2_TICKS_RDTSC) || defined(SMTLIB2_TICKS_CNTVCT)
+    double start = smtlib2_stats_now(), elapsed;
+    smtlib2_ticks t = smtlib2_ticks_now();
+    do {
+        elapsed = smtlib2_stats_now() - start;
+    } while (elapsed < 0.001);
+    t = smtlib2_ticks_now() - t;
+    return t ? elapsed * 1e9 / t : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+
+/*
+ * Histograms
+ */
+
+#define SUB_BITS SMTLIB2_HISTOGRAM_SUB_BITS
+#define SUB_COUNT (1 << SUB_BITS)
+
+static int smtlib2_histogram_log2(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int ret = 0;
+    while (v >>= 1) {
+        ++ret;
+    }
+    return ret;
+#endif
+}
+
+
+/* values below SUB_COUNT get a bucket each, the others are bucketed by their
+ * most significant bit and the SUB_BITS bits following it */
+static size_t smtlib2_histogram_index(uint64_t v)
+{
+    int e;
+    if (v < SUB_COUNT) {
+        return (size_t)v;
+    }
+    e = smtlib2_histogram_log2(v);
+    return ((size_t)(e - SUB_BITS + 1) << SUB_BITS) +
+        (size_t)((v >> (e - SUB_BITS)) & (SUB_COUNT - 1));
+}
+
+
+/* the largest value that falls in the given bucket */
+static uint64_t smtlib2_histogram_bucket_max(size_t idx)
+{
+    int e;
+    uint64_t lo;
+    if (idx < SUB_COUNT) {
+        return idx;
+    }
+    e = (int)(idx >> SUB_BITS) + SUB_BITS - 1;
+    lo = (uint64_t)(SUB_COUNT + (idx & (SUB_COUNT - 1))) << (e - SUB_BITS);
+    return lo + (((uint64_t)1 << (e - SUB_BITS)) - 1);
+}
+
+
+void smtlib2_histogram_init(smtlib2_histogram *h)
+{
+    h->count_ = 0;
+    h->sum_ = 0;
+    h->min_ = 0;
+    h->max_ = 0;
+    h->buckets_ = NULL;
+}
+
+
+void smtlib2_histogram_deinit(smtlib2_histogram *h)
+{
+    smtlib2_free(h->buckets_);
+    h->buckets_ = NULL;
+}
+
+
+void smtlib2_histogram_record(smtlib2_histogram *h, uint64_t value)
+{
+    if (!h->buckets_) {
+        size_t sz = sizeof(uint64_t) * SMTLIB2_HISTOGRAM_BUCKETS;
+        h->buckets_ = (uint64_t *)smtlib2_malloc(sz);
+        memset(h->buckets_, 0, sz);
+        h->min_ = value;
+    }
+    ++h->buckets_[smtlib2_histogram_index(value)];
+    if (value < h->min_) {
+        h->min_ = value;
+    }
+    if (value > h->max_) {
+        h->max_ = value;
+    }
+    ++h->count_;
+    h->sum_ += value;
+}
+
+
+uint64_t smtlib2_histogram_percentile(const smtlib2_histogram *h, double q)
+{
+    uint64_t target, seen = 0;
+    size_t i;
+
+    if (!h->count_) {
+        return 0;
+    }
+    target = (uint64_t)(q * h->count_ + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    for (i = 0; i < SMTLIB2_HISTOGRAM_BUCKETS; ++i) {
+        seen += h->buckets_[i];
+        if (seen >= target) {
+            uint64_t v = smtlib2_histogram_bucket_max(i);
+            if (v > h->max_) v = h->max_;
+            if (v < h->min_) v = h->min_;
+            return v;
+        }
+    }
+    return h->max_;
+}
+
+
+/*
+ * Parser statistics
+ */
+
+static const char *smtlib2_stat_names[SMTLIB2_STAT_COUNT] = {
+    ":set-logic",
+    ":declare-sort",
+    ":define-sort",
+    ":declare-fun",
+    ":declare-variable",
+    ":define-fun",
+    ":push",
+    ":pop",
+    ":reset-assertions",
+    ":reset",
+    ":assert",
+    ":assert-lazy",
+    ":check-sat",
+    ":get-assignment",
+    ":get-assertions",
+    ":get-unsat-core",
+    ":get-proof",
+    ":set-option-str",
+    ":set-option-int",
+    ":set-option-rat",
+    ":get-info",
+    ":set-info",
+    ":get-value",
+    ":exit",
+    ":handle-error",
+    ":set-internal-parsed-terms",
+    ":push-let-scope",
+    ":pop-let-scope",
+    ":push-quantifier-scope",
+    ":pop-quantifier-scope",
+    ":push-sort-param-scope",
+    ":pop-sort-param-scope",
+    ":make-term",
+    ":make-number-term",
+    ":make-forall-term",
+    ":make-exists-term",
+    ":annotate-term",
+    ":define-let-binding",
+    ":make-sort",
+    ":make-parametric-sort",
+    ":make-function-sort",
+    ":symbol-lookup"
+};
+
+
+struct smtlib2_parser_stats {
+    smtlib2_parser_interface orig_;  /* the wrapped callbacks */
+    smtlib2_histogram hist_[SMTLIB2_STAT_COUNT];
+    /* for converting ticks to time */
+    smtlib2_ticks start_ticks_;
+    double start_time_;
+    smtlib2_vector *report_;  /* strings of the last report */
+};
+
+
+const char *smtlib2_stat_name(smtlib2_stat which)
+{
+    return smtlib2_stat_names[which];
+}
+
+
+/* starts timing a callback, opening its span if the parser is traced */
+static smtlib2_ticks smtlib2_parser_stats_begin(smtlib2_abstract_parser *p,
+                                                smtlib2_stat which)
+{
+    if (p->tracer_) {
+        smtlib2_tracer_begin(p->tracer_, smtlib2_stat_names[which] + 1,
+                             "backend", smtlib2_ticks_now());
+    }
+    return smtlib2_ticks_now();
+}
+
+
+/* the first sample of a histogram allocates it: this must be done with the
+ * allocator of the parser, which is not necessarily the current one if a
+ * callback is invoked directly */
+static void smtlib2_parser_stats_end(smtlib2_abstract_parser *p,
+                                     smtlib2_parser_stats *s,
+                                     smtlib2_stat which,
+                                     smtlib2_ticks start)
+{
+    smtlib2_ticks now = smtlib2_ticks_now();
+    smtlib2_histogram *h = &(s->hist_[which]);
+    if (h->buckets_) {
+        smtlib2_histogram_record(h, now - start);
+    } else {
+        smtlib2_allocator *prev = smtlib2_set_allocator(p->allocator_);
+        smtlib2_histogram_record(h, now - start);
+        smtlib2_set_allocator(prev);
+    }
+    if (p->tracer_) {
+        smtlib2_tracer_end(p->tracer_, now);
+    }
+}
+
+
+/* the wrappers of the callbacks. "p" is always the first parameter */
+#define SMTLIB2_STATS_BEGIN(which)                                       \
+    smtlib2_abstract_parser *ap_ = (smtlib2_abstract_parser *)p;         \
+    smtlib2_parser_stats *s_ = ap_->stats_;                              \
+    smtlib2_ticks t_ = smtlib2_parser_stats_begin(ap_, which)
+
+#define SMTLIB2_STATS_END(which)                                         \
+    smtlib2_parser_stats_end(ap_, s_, which, t_)
+
+#define SMTLIB2_STATS_WRAP(name, which, params, args)                    \
+    static void smtlib2_stats_##name params                              \
+    {                                                                    \
+        SMTLIB2_STATS_BEGIN(which);                                      \
+        s_->orig_.name args;                                             \
+        SMTLIB2_STATS_END(which);                                        \
+    }
+
+#define SMTLIB2_STATS_WRAP_RET(type, name, which, params, args)          \
+    static type smtlib2_stats_##name params                              \
+    {                                                                    \
+        type ret;                                                        \
+        SMTLIB2_STATS_BEGIN(which);                                      \
+        ret = s_->orig_.name args;                                       \
+        SMTLIB2_STATS_END(which);                                        \
+        return ret;                                                      \
+    }
+
+typedef smtlib2_parser_interface pi_t;
+
+SMTLIB2_STATS_WRAP(set_logic, SMTLIB2_STAT_SET_LOGIC,
+                   (pi_t *p, const char *logic), (p, logic))
+SMTLIB2_STATS_WRAP(declare_sort, SMTLIB2_STAT_DECLARE_SORT,
+                   (pi_t *p, const char *name, int arity), (p, name, arity))
+SMTLIB2_STATS_WRAP(define_sort, SMTLIB2_STAT_DEFINE_SORT,
+                   (pi_t *p, const char *name, smtlib2_vector *params,
+                    smtlib2_sort sort),
+                   (p, name, params, sort))
+SMTLIB2_STATS_WRAP(declare_function, SMTLIB2_STAT_DECLARE_FUNCTION,
+                   (pi_t *p, const char *name, smtlib2_sort sort),
+                   (p, name, sort))
+SMTLIB2_STATS_WRAP(declare_variable, SMTLIB2_STAT_DECLARE_VARIABLE,
+                   (pi_t *p, const char *name, smtlib2_sort sort),
+                   (p, name, sort))
+SMTLIB2_STATS_WRAP(define_function, SMTLIB2_STAT_DEFINE_FUNCTION,
+                   (pi_t *p, const char *name, smtlib2_vector *params,
+                    smtlib2_sort sort, smtlib2_term term),
+                   (p, name, params, sort, term))
+SMTLIB2_STATS_WRAP(push, SMTLIB2_STAT_PUSH, (pi_t *p, int n), (p, n))
+SMTLIB2_STATS_WRAP(pop, SMTLIB2_STAT_POP, (pi_t *p, int n), (p, n))
+SMTLIB2_STATS_WRAP(reset_assertions, SMTLIB2_STAT_RESET_ASSERTIONS,
+                   (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(reset, SMTLIB2_STAT_RESET, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(assert_formula, SMTLIB2_STAT_ASSERT_FORMULA,
+                   (pi_t *p, smtlib2_term term), (p, term))
+SMTLIB2_STATS_WRAP(assert_lazy_formula, SMTLIB2_STAT_ASSERT_LAZY_FORMULA,
+                   (pi_t *p, smtlib2_lazy_term *term), (p, term))
+SMTLIB2_STATS_WRAP(check_sat, SMTLIB2_STAT_CHECK_SAT, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(get_assignment, SMTLIB2_STAT_GET_ASSIGNMENT,
+                   (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(get_assertions, SMTLIB2_STAT_GET_ASSERTIONS,
+                   (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(get_unsat_core, SMTLIB2_STAT_GET_UNSAT_CORE,
+                   (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(get_proof, SMTLIB2_STAT_GET_PROOF, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(set_str_option, SMTLIB2_STAT_SET_STR_OPTION,
+                   (pi_t *p, const char *keyword, const char *value),
+                   (p, keyword, value))
+SMTLIB2_STATS_WRAP(set_int_option, SMTLIB2_STAT_SET_INT_OPTION,
+                   (pi_t *p, const char *keyword, int value),
+                   (p, keyword, value))
+SMTLIB2_STATS_WRAP(set_rat_option, SMTLIB2_STAT_SET_RAT_OPTION,
+                   (pi_t *p, const char *keyword, double value),
+                   (p, keyword, value))
+SMTLIB2_STATS_WRAP(get_info, SMTLIB2_STAT_GET_INFO,
+                   (pi_t *p, const char *keyword), (p, keyword))
+SMTLIB2_STATS_WRAP(set_info, SMTLIB2_STAT_SET_INFO,
+                   (pi_t *p, const char *keyword, const char *value),
+                   (p, keyword, value))
+SMTLIB2_STATS_WRAP(get_value, SMTLIB2_STAT_GET_VALUE,
+                   (pi_t *p, smtlib2_vector *terms), (p, terms))
+SMTLIB2_STATS_WRAP(exit, SMTLIB2_STAT_EXIT, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(handle_error, SMTLIB2_STAT_HANDLE_ERROR,
+                   (pi_t *p, const char *msg), (p, msg))
+SMTLIB2_STATS_WRAP(set_internal_parsed_terms,
+                   SMTLIB2_STAT_SET_INTERNAL_PARSED_TERMS,
+                   (pi_t *p, smtlib2_vector *terms), (p, terms))
+SMTLIB2_STATS_WRAP(push_let_scope, SMTLIB2_STAT_PUSH_LET_SCOPE,
+                   (pi_t *p), (p))
+SMTLIB2_STATS_WRAP_RET(smtlib2_term, pop_let_scope,
+                       SMTLIB2_STAT_POP_LET_SCOPE, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(push_quantifier_scope, SMTLIB2_STAT_PUSH_QUANTIFIER_SCOPE,
+                   (pi_t *p), (p))
+SMTLIB2_STATS_WRAP_RET(smtlib2_term, pop_quantifier_scope,
+                       SMTLIB2_STAT_POP_QUANTIFIER_SCOPE, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(push_sort_param_scope,
+                   SMTLIB2_STAT_PUSH_SORT_PARAM_SCOPE, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP(pop_sort_param_scope,
+                   SMTLIB2_STAT_POP_SORT_PARAM_SCOPE, (pi_t *p), (p))
+SMTLIB2_STATS_WRAP_RET(smtlib2_term, make_term, SMTLIB2_STAT_MAKE_TERM,
+                       (pi_t *p, const char *symbol, smtlib2_sort sort,
+                        smtlib2_vector *index, smtlib2_vector *args),
+                       (p, symbol, sort, index, args))
+SMTLIB2_STATS_WRAP_RET(smtlib2_term, make_number_term,
+                       SMTLIB2_STAT_MAKE_NUMBER_TERM,
+                       (pi_t *p, const char *numval, int width, int base),
+                       (p, numval, width, base))
+SMTLIB2_STATS_WRAP_RET(smtlib2_term, make_forall_term,
+                       SMTLIB2_STAT_MAKE_FORALL_TERM,
+                       (pi_t *p, smtlib2_term term), (p, term))
+SMTLIB2_STATS_WRAP_RET(smtlib2_term, make_exists_term,
+                       SMTLIB2_STAT_MAKE_EXISTS_TERM,
+                       (pi_t *p, smtlib2_term term), (p, term))
+SMTLIB2_STATS_WRAP(annotate_term, SMTLIB2_STAT_ANNOTATE_TERM,
+                   (pi_t *p, smtlib2_term term, smtlib2_vector *annotations),
+                   (p, term, annotations))
+SMTLIB2_STATS_WRAP(define_let_binding, SMTLIB2_STAT_DEFINE_LET_BINDING,
+                   (pi_t *p, const char *symbol, smtlib2_term term),
+                   (p, symbol, term))
+SMTLIB2_STATS_WRAP_RET(smtlib2_sort, make_sort, SMTLIB2_STAT_MAKE_SORT,
+                       (pi_t *p, const char *name, smtlib2_vector *index),
+                       (p, name, index))
+SMTLIB2_STATS_WRAP_RET(smtlib2_sort, make_parametric_sort,
+                       SMTLIB2_STAT_MAKE_PARAMETRIC_SORT,
+                       (pi_t *p, const char *name, smtlib2_vector *tps),
+                       (p, name, tps))
+SMTLIB2_STATS_WRAP_RET(smtlib2_sort, make_function_sort,
+                       SMTLIB2_STAT_MAKE_FUNCTION_SORT,
+                       (pi_t *p, smtlib2_vector *tps), (p, tps))
+
+
+#define SMTLIB2_STATS_HOOK(pi, name) \
+    if ((pi)->name) (pi)->name = smtlib2_stats_##name
+
+
+smtlib2_parser_stats *smtlib2_parser_stats_new(
+    struct smtlib2_abstract_parser *p)
+{
+    smtlib2_parser_stats *ret =
+        (smtlib2_parser_stats *)smtlib2_malloc(sizeof(smtlib2_parser_stats));
+    smtlib2_parser_interface *pi = SMTLIB2_PARSER_INTERFACE(p);
+    int i;
+
+    for (i = 0; i < SMTLIB2_STAT_COUNT; ++i) {
+        smtlib2_histogram_init(&(ret->hist_[i]));
+    }
+    ret->start_ticks_ = smtlib2_ticks_now();
+    ret->start_time_ = smtlib2_stats_now();
+    ret->report_ = smtlib2_vector_new();
+
+    ret->orig_ = *pi;
+    SMTLIB2_STATS_HOOK(pi, set_logic);
+    SMTLIB2_STATS_HOOK(pi, declare_sort);
+    SMTLIB2_STATS_HOOK(pi, define_sort);
+    SMTLIB2_STATS_HOOK(pi, declare_function);
+    SMTLIB2_STATS_HOOK(pi, declare_variable);
+    SMTLIB2_STATS_HOOK(pi, define_function);
+    SMTLIB2_STATS_HOOK(pi, push);
+    SMTLIB2_STATS_HOOK(pi, pop);
+    SMTLIB2_STATS_HOOK(pi, reset_assertions);
+    SMTLIB2_STATS_HOOK(pi, reset);
+    SMTLIB2_STATS_HOOK(pi, assert_formula);
+    SMTLIB2_STATS_HOOK(pi, assert_lazy_formula);
+    SMTLIB2_STATS_HOOK(pi, check_sat);
+    SMTLIB2_STATS_HOOK(pi, get_assignment);
+    SMTLIB2_STATS_HOOK(pi, get_assertions);
+    SMTLIB2_STATS_HOOK(pi, get_unsat_core);
+    SMTLIB2_STATS_HOOK(pi, get_proof);
+    SMTLIB2_STATS_HOOK(pi, set_str_option);
+    SMTLIB2_STATS_HOOK(pi, set_int_option);
+    SMTLIB2_STATS_HOOK(pi, set_rat_option);
+    SMTLIB2_STATS_HOOK(pi, get_info);
+    SMTLIB2_STATS_HOOK(pi, set_info);
+    SMTLIB2_STATS_HOOK(pi, get_value);
+    SMTLIB2_STATS_HOOK(pi, exit);
+    SMTLIB2_STATS_HOOK(pi, handle_error);
+    SMTLIB2_STATS_HOOK(pi, set_internal_parsed_terms);
+    SMTLIB2_STATS_HOOK(pi, push_let_scope);
+    SMTLIB2_STATS_HOOK(pi, pop_let_scope);
+    SMTLIB2_STATS_HOOK(pi, push_quantifier_scope);
+    SMTLIB2_STATS_HOOK(pi, pop_quantifier_scope);
+    SMTLIB2_STATS_HOOK(pi, push_sort_param_scope);
+    SMTLIB2_STATS_HOOK(pi, pop_sort_param_scope);
+    SMTLIB2_STATS_HOOK(pi, make_term);
+    SMTLIB2_STATS_HOOK(pi, make_number_term);
+    SMTLIB2_STATS_HOOK(pi, make_forall_term);
+    SMTLIB2_STATS_HOOK(pi, make_exists_term);
+    SMTLIB2_STATS_HOOK(pi, annotate_term);
+    SMTLIB2_STATS_HOOK(pi, define_let_binding);
+    SMTLIB2_STATS_HOOK(pi, make_sort);
+    SMTLIB2_STATS_HOOK(pi, make_parametric_sort);
+    SMTLIB2_STATS_HOOK(pi, make_function_sort);
+
+    p->termparser_->lookup_stats_ =
+        &(ret->hist_[SMTLIB2_STAT_SYMBOL_LOOKUP]);
+
+    return ret;
+}
+
+
+static void smtlib2_parser_stats_clear_report(smtlib2_parser_stats *s)
+{
+    size_t i;
+    for (i = 0; i < smtlib2_vector_size(s->report_); ++i) {
+        smtlib2_free((char *)smtlib2_vector_at(s->report_, i));
+    }
+    smtlib2_vector_clear(s->report_);
+}
+
+
+void smtlib2_parser_stats_delete(smtlib2_parser_stats *s,
+                                 struct smtlib2_abstract_parser *p)
+{
+    int i;
+
+    *SMTLIB2_PARSER_INTERFACE(p) = s->orig_;
+    p->termparser_->lookup_stats_ = NULL;
+
+    for (i = 0; i < SMTLIB2_STAT_COUNT; ++i) {
+        smtlib2_histogram_deinit(&(s->hist_[i]));
+    }
+    smtlib2_parser_stats_clear_report(s);
+    smtlib2_vector_delete(s->report_);
+    smtlib2_free(s);
+}
+
+
+smtlib2_parser_interface *smtlib2_parser_stats_wrapped(
+    smtlib2_parser_stats *s)
+{
+    return &(s->orig_);
+}
+
+
+void smtlib2_parser_stats_reset(smtlib2_parser_stats *s)
+{
+    int i;
+    for (i = 0; i < SMTLIB2_STAT_COUNT; ++i) {
+        smtlib2_histogram_deinit(&(s->hist_[i]));
+        smtlib2_histogram_init(&(s->hist_[i]));
+    }
+    s->start_ticks_ = smtlib2_ticks_now();
+    s->start_time_ = smtlib2_stats_now();
+}
+
+
+const smtlib2_histogram *smtlib2_parser_stats_get(smtlib2_parser_stats *s,
+                                                  smtlib2_stat which)
+{
+    return &(s->hist_[which]);
+}
+
+
+double smtlib2_parser_stats_ns(smtlib2_parser_stats *s, uint64_t ticks)
+{
+#if defined(SMTLIB2_TICKS_RDTSC) || defined(SMTLIB2_TICKS_CNTVCT)
+    /* the rate of the counter is measured over the lifetime of the stats,
+     * spinning for a millisecond if that is too short */
+    double elapsed = smtlib2_stats_now() - s->start_time_;
+    smtlib2_ticks t;
+    while (elapsed < 0.001) {
+        elapsed = smtlib2_stats_now() - s->start_time_;
+    }
+    t = smtlib2_ticks_now() - s->start_ticks_;
+    return t ? ticks * (elapsed * 1e9 / t) : 0.0;
+#else
+    return (double)ticks;
+#endif
+}
+
+
+void smtlib2_parser_stats_report(smtlib2_parser_stats *s, smtlib2_vector *out)
+{
+    double scale = smtlib2_parser_stats_ns(s, 1000000) / 1000000.0;
+    int i;
+
+    smtlib2_parser_stats_clear_report(s);
+    for (i = 0; i < SMTLIB2_STAT_COUNT; ++i) {
+        const smtlib2_histogram *h = &(s->hist_[i]);
+        char *v;
+        if (!h->count_) {
+            continue;
+        }
+        v = smtlib2_sprintf(
+            "(:count %llu :total-ns %.0f :mean-ns %.0f :p50-ns %.0f "
+            ":p90-ns %.0f :p99-ns %.0f :max-ns %.0f)",
+            (unsigned long long)h->count_, h->sum_ * scale,
+            (double)h->sum_ / h->count_ * scale,
+            smtlib2_histogram_percentile(h, 0.5) * scale,
+            smtlib2_histogram_percentile(h, 0.9) * scale,
+            smtlib2_histogram_percentile(h, 0.99) * scale,
+            h->max_ * scale);
+        smtlib2_vector_push(s->report_, (intptr_t)v);
+        smtlib2_vector_push(out, (intptr_t)smtlib2_stat_names[i]);
+        smtlib2_vector_push(out, (intptr_t)v);
+    }
+}
+
+
+void smtlib2_parser_stats_print(smtlib2_parser_stats *s, FILE *out)
+{
+    double scale = smtlib2_parser_stats_ns(s, 1000000) / 1000000.0;
+    int i;
+
+    fprintf(out, ";; %-26s %10s %12s %10s %10s %10s %10s %12s\n",
+            "callback", "count", "total(ms)", "mean(ns)", "p50(ns)",
+            "p90(ns)", "p99(ns)", "max(ns)");
+    for (i = 0; i < SMTLIB2_STAT_COUNT; ++i) {
+        const smtlib2_histogram *h = &(s->hist_[i]);
+        if (!h->count_) {
+            continue;
+        }
+        fprintf(out, ";; %-26s %10llu %12.3f %10.0f %10.0f %10.0f %10.0f "
+                "%12.0f\n",
+                smtlib2_stat_names[i] + 1, (unsigned long long)h->count_,
+                h->sum_ * scale * 1e-6, (double)h->sum_ / h->count_ * scale,
+                smtlib2_histogram_percentile(h, 0.5) * scale,
+                smtlib2_histogram_percentile(h, 0.9) * scale,
+                smtlib2_histogram_percentile(h, 0.99) * scale,
+                h->max_ * scale);
+    }
+}
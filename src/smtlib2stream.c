@@ -35,11 +35,16 @@ static int smtlib2_sstream_getc(smtlib2_stream *s);
 static int smtlib2_sstream_putc(smtlib2_stream *s, char c);
 static bool smtlib2_sstream_eof(smtlib2_stream *s);
 
+static int smtlib2_mstream_getc(smtlib2_stream *s);
+static int smtlib2_mstream_putc(smtlib2_stream *s, char c);
+static bool smtlib2_mstream_eof(smtlib2_stream *s);
+
 #define SMTLIB2STREAM_PARENT(s) (&(s->parent_))
 
 smtlib2_fstream *smtlib2_fstream_new(FILE *f)
 {
-    smtlib2_fstream *ret = (smtlib2_fstream *)malloc(sizeof(smtlib2_fstream));
+    smtlib2_fstream *ret =
+        (smtlib2_fstream *)smtlib2_malloc(sizeof(smtlib2_fstream));
     (SMTLIB2STREAM_PARENT(ret))->get_char = smtlib2_fstream_getc;
     (SMTLIB2STREAM_PARENT(ret))->put_char = smtlib2_fstream_putc;
     (SMTLIB2STREAM_PARENT(ret))->eof = smtlib2_fstream_eof;
@@ -50,13 +55,14 @@ smtlib2_fstream *smtlib2_fstream_new(FILE *f)
 
 void smtlib2_fstream_delete(smtlib2_fstream *s)
 {
-    free(s);
+    smtlib2_free(s);
 }
 
 
 smtlib2_sstream *smtlib2_sstream_new(smtlib2_charbuf *buf)
 {
-    smtlib2_sstream *ret = (smtlib2_sstream *)malloc(sizeof(smtlib2_sstream));
+    smtlib2_sstream *ret =
+        (smtlib2_sstream *)smtlib2_malloc(sizeof(smtlib2_sstream));
     (SMTLIB2STREAM_PARENT(ret))->get_char = smtlib2_sstream_getc;
     (SMTLIB2STREAM_PARENT(ret))->put_char = smtlib2_sstream_putc;
     (SMTLIB2STREAM_PARENT(ret))->eof = smtlib2_sstream_eof;
@@ -68,7 +74,28 @@ smtlib2_sstream *smtlib2_sstream_new(smtlib2_charbuf *buf)
 
 void smtlib2_sstream_delete(smtlib2_sstream *s)
 {
-    free(s);
+    smtlib2_free(s);
+}
+
+
+smtlib2_mstream *smtlib2_mstream_new(const char *data, size_t size)
+{
+    smtlib2_mstream *ret =
+        (smtlib2_mstream *)smtlib2_malloc(sizeof(smtlib2_mstream));
+    (SMTLIB2STREAM_PARENT(ret))->get_char = smtlib2_mstream_getc;
+    (SMTLIB2STREAM_PARENT(ret))->put_char = smtlib2_mstream_putc;
+    (SMTLIB2STREAM_PARENT(ret))->eof = smtlib2_mstream_eof;
+    ret->data_ = data;
+    ret->size_ = size;
+    ret->nextidx_ = 0;
+    ret->eof_ = false;
+    return ret;
+}
+
+
+void smtlib2_mstream_delete(smtlib2_mstream *s)
+{
+    smtlib2_free(s);
 }
 
 
@@ -117,3 +144,28 @@ static bool smtlib2_sstream_eof(smtlib2_stream *s)
     smtlib2_sstream *stream = (smtlib2_sstream *)s;
     return stream->nextidx_ >= SMTLIB2_VECTOR_SIZE(stream->buf_);
 }
+
+
+static int smtlib2_mstream_getc(smtlib2_stream *s)
+{
+    smtlib2_mstream *stream = (smtlib2_mstream *)s;
+    if (stream->nextidx_ < stream->size_) {
+        return (unsigned char)stream->data_[stream->nextidx_++];
+    } else {
+        stream->eof_ = true;
+        return EOF;
+    }
+}
+
+
+static int smtlib2_mstream_putc(smtlib2_stream *s, char c)
+{
+    return EOF;
+}
+
+
+static bool smtlib2_mstream_eof(smtlib2_stream *s)
+{
+    smtlib2_mstream *stream = (smtlib2_mstream *)s;
+    return stream->eof_;
+}
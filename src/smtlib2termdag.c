@@ -0,0 +1,432 @@
+/* -*- C -*-
+ *
+ * Hash-consed DAG of sorts and terms for the SMT-LIB v2 parser
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2termdag.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef _MSC_VER
+#include <windows.h>
+#endif
+
+
+struct smtlib2_termdag {
+    /* the frozen DAG this one is built on (see smtlib2_termdag_new_layer),
+     * whose nodes are numbered before the ones of this DAG */
+    smtlib2_termdag *base_;
+    uint32_t first_symbol_;
+    uint32_t first_sort_;
+    uint32_t first_term_;
+    uint32_t refs_;
+    bool frozen_;
+    smtlib2_hashtable *symbol_table_;
+    smtlib2_hashtable *sort_table_;
+    smtlib2_hashtable *term_table_;
+    smtlib2_vector *symbols_;
+    smtlib2_vector *sorts_;
+    smtlib2_vector *terms_;
+};
+
+
+static uint32_t mix(uint32_t h, uintptr_t v);
+static uint32_t sort_hash(smtlib2_dag_sort *s);
+static uint32_t term_hash(smtlib2_dag_term *t);
+static uint32_t sort_hashfun(intptr_t s);
+static bool sort_eqfun(intptr_t s1, intptr_t s2);
+static uint32_t term_hashfun(intptr_t t);
+static bool term_eqfun(intptr_t t1, intptr_t t2);
+static void free_node(intptr_t n);
+
+
+#if defined(__GNUC__)
+#  define INCREF(x) __atomic_add_fetch(&((x)->refs_), 1, __ATOMIC_RELAXED)
+#  define DECREF(x) __atomic_sub_fetch(&((x)->refs_), 1, __ATOMIC_ACQ_REL)
+#elif defined(_MSC_VER)
+#  define INCREF(x) InterlockedIncrement((LONG volatile *)&((x)->refs_))
+#  define DECREF(x) InterlockedDecrement((LONG volatile *)&((x)->refs_))
+#else
+/* no atomics, the layers of a DAG must all be used by the same thread */
+#  define INCREF(x) (++(x)->refs_)
+#  define DECREF(x) (--(x)->refs_)
+#endif
+
+
+smtlib2_termdag *smtlib2_termdag_new(void)
+{
+    smtlib2_termdag *ret =
+        (smtlib2_termdag *)smtlib2_malloc(sizeof(smtlib2_termdag));
+    ret->base_ = NULL;
+    ret->first_symbol_ = ret->first_sort_ = ret->first_term_ = 0;
+    ret->refs_ = 1;
+    ret->frozen_ = false;
+    ret->symbol_table_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
+                                               smtlib2_eqfun_str);
+    ret->sort_table_ = smtlib2_hashtable_new(sort_hashfun, sort_eqfun);
+    ret->term_table_ = smtlib2_hashtable_new(term_hashfun, term_eqfun);
+    ret->symbols_ = smtlib2_vector_new();
+    ret->sorts_ = smtlib2_vector_new();
+    ret->terms_ = smtlib2_vector_new();
+
+    return ret;
+}
+
+
+smtlib2_termdag *smtlib2_termdag_new_layer(smtlib2_termdag *base)
+{
+    smtlib2_termdag *ret = smtlib2_termdag_new();
+
+    if (!base->frozen_) {
+        /* a frozen DAG may already be shared with other threads, which only
+         * read it */
+        base->frozen_ = true;
+    }
+    INCREF(base);
+    ret->base_ = base;
+    ret->first_symbol_ = (uint32_t)smtlib2_termdag_num_symbols(base);
+    ret->first_sort_ = (uint32_t)smtlib2_termdag_num_sorts(base);
+    ret->first_term_ = (uint32_t)smtlib2_termdag_num_terms(base);
+    return ret;
+}
+
+
+smtlib2_termdag *smtlib2_termdag_retain(smtlib2_termdag *d)
+{
+    INCREF(d);
+    return d;
+}
+
+
+bool smtlib2_termdag_is_empty(smtlib2_termdag *d)
+{
+    return smtlib2_vector_size(d->symbols_) == 0 &&
+        smtlib2_vector_size(d->sorts_) == 0 &&
+        smtlib2_vector_size(d->terms_) == 0;
+}
+
+
+smtlib2_termdag *smtlib2_termdag_base(smtlib2_termdag *d)
+{
+    return d->base_;
+}
+
+
+void smtlib2_termdag_delete(smtlib2_termdag *d)
+{
+    if (DECREF(d) != 0) {
+        return;
+    }
+    if (d->base_) {
+        smtlib2_termdag_delete(d->base_);
+    }
+    /* all the nodes are owned by the vectors, the tables only index them */
+    smtlib2_hashtable_delete(d->term_table_, NULL, NULL);
+    smtlib2_hashtable_delete(d->sort_table_, NULL, NULL);
+    smtlib2_hashtable_delete(d->symbol_table_, NULL, NULL);
+    while (smtlib2_vector_size(d->terms_) > 0) {
+        free_node(smtlib2_vector_last(d->terms_));
+        smtlib2_vector_pop(d->terms_);
+    }
+    while (smtlib2_vector_size(d->sorts_) > 0) {
+        free_node(smtlib2_vector_last(d->sorts_));
+        smtlib2_vector_pop(d->sorts_);
+    }
+    while (smtlib2_vector_size(d->symbols_) > 0) {
+        free_node(smtlib2_vector_last(d->symbols_));
+        smtlib2_vector_pop(d->symbols_);
+    }
+    smtlib2_vector_delete(d->terms_);
+    smtlib2_vector_delete(d->sorts_);
+    smtlib2_vector_delete(d->symbols_);
+    smtlib2_free(d);
+}
+
+
+smtlib2_dag_symbol *smtlib2_termdag_intern(smtlib2_termdag *d,
+                                           const char *name)
+{
+    smtlib2_termdag *l;
+    intptr_t v;
+
+    for (l = d; l; l = l->base_) {
+        if (smtlib2_hashtable_find(l->symbol_table_, (intptr_t)name, &v)) {
+            return (smtlib2_dag_symbol *)v;
+        }
+    }
+    assert(!d->frozen_);
+    {
+        size_t n = strlen(name);
+        smtlib2_dag_symbol *ret = (smtlib2_dag_symbol *)smtlib2_malloc(
+            sizeof(smtlib2_dag_symbol) + n);
+        memcpy(ret->name_, name, n+1);
+        ret->id_ = d->first_symbol_ +
+            (uint32_t)smtlib2_vector_size(d->symbols_);
+        ret->hash_ = smtlib2_hashfun_str((intptr_t)ret->name_);
+        smtlib2_vector_push(d->symbols_, (intptr_t)ret);
+        smtlib2_hashtable_set(d->symbol_table_, (intptr_t)ret->name_,
+                              (intptr_t)ret);
+        return ret;
+    }
+}
+
+
+smtlib2_dag_sort *smtlib2_termdag_mk_sort(smtlib2_termdag *d,
+                                          smtlib2_dag_sort_kind kind,
+                                          smtlib2_dag_symbol *name,
+                                          size_t nidx, const intptr_t *idx,
+                                          size_t nargs,
+                                          smtlib2_dag_sort **args)
+{
+    smtlib2_dag_sort key;
+    smtlib2_dag_sort *ret;
+    smtlib2_termdag *l;
+    intptr_t v;
+
+    key.kind_ = kind;
+    key.name_ = name;
+    key.nidx_ = nidx;
+    key.idx_ = (intptr_t *)idx;
+    key.nargs_ = nargs;
+    key.args_ = args;
+    key.hash_ = sort_hash(&key);
+
+    for (l = d; l; l = l->base_) {
+        if (smtlib2_hashtable_find(l->sort_table_, (intptr_t)&key, &v)) {
+            return (smtlib2_dag_sort *)v;
+        }
+    }
+    assert(!d->frozen_);
+
+    /* the index and the arguments live in the same block as the node */
+    ret = (smtlib2_dag_sort *)smtlib2_malloc(sizeof(smtlib2_dag_sort) +
+                                     sizeof(intptr_t) * nidx +
+                                     sizeof(smtlib2_dag_sort *) * nargs);
+    *ret = key;
+    ret->id_ = d->first_sort_ + (uint32_t)smtlib2_vector_size(d->sorts_);
+    ret->idx_ = (intptr_t *)(ret + 1);
+    ret->args_ = (smtlib2_dag_sort **)(ret->idx_ + nidx);
+    if (nidx) {
+        memcpy(ret->idx_, idx, sizeof(intptr_t) * nidx);
+    }
+    if (nargs) {
+        memcpy(ret->args_, args, sizeof(smtlib2_dag_sort *) * nargs);
+    }
+    smtlib2_vector_push(d->sorts_, (intptr_t)ret);
+    smtlib2_hashtable_set(d->sort_table_, (intptr_t)ret, (intptr_t)ret);
+
+    return ret;
+}
+
+
+smtlib2_dag_term *smtlib2_termdag_mk_term(smtlib2_termdag *d,
+                                          smtlib2_dag_term_kind kind,
+                                          smtlib2_dag_symbol *symbol,
+                                          smtlib2_dag_sort *sort,
+                                          size_t nidx, const intptr_t *idx,
+                                          size_t nargs,
+                                          smtlib2_dag_term **args)
+{
+    smtlib2_dag_term key;
+    smtlib2_dag_term *ret;
+    smtlib2_termdag *l;
+    intptr_t v;
+
+    key.kind_ = kind;
+    key.symbol_ = symbol;
+    key.sort_ = sort;
+    key.nidx_ = nidx;
+    key.idx_ = (intptr_t *)idx;
+    key.nargs_ = nargs;
+    key.args_ = args;
+    key.hash_ = term_hash(&key);
+
+    for (l = d; l; l = l->base_) {
+        if (smtlib2_hashtable_find(l->term_table_, (intptr_t)&key, &v)) {
+            return (smtlib2_dag_term *)v;
+        }
+    }
+    assert(!d->frozen_);
+
+    ret = (smtlib2_dag_term *)smtlib2_malloc(sizeof(smtlib2_dag_term) +
+                                     sizeof(intptr_t) * nidx +
+                                     sizeof(smtlib2_dag_term *) * nargs);
+    *ret = key;
+    ret->id_ = d->first_term_ + (uint32_t)smtlib2_vector_size(d->terms_);
+    ret->idx_ = (intptr_t *)(ret + 1);
+    ret->args_ = (smtlib2_dag_term **)(ret->idx_ + nidx);
+    if (nidx) {
+        memcpy(ret->idx_, idx, sizeof(intptr_t) * nidx);
+    }
+    if (nargs) {
+        memcpy(ret->args_, args, sizeof(smtlib2_dag_term *) * nargs);
+    }
+    smtlib2_vector_push(d->terms_, (intptr_t)ret);
+    smtlib2_hashtable_set(d->term_table_, (intptr_t)ret, (intptr_t)ret);
+
+    return ret;
+}
+
+
+size_t smtlib2_termdag_num_symbols(smtlib2_termdag *d)
+{
+    return d->first_symbol_ + smtlib2_vector_size(d->symbols_);
+}
+
+
+size_t smtlib2_termdag_num_sorts(smtlib2_termdag *d)
+{
+    return d->first_sort_ + smtlib2_vector_size(d->sorts_);
+}
+
+
+size_t smtlib2_termdag_num_terms(smtlib2_termdag *d)
+{
+    return d->first_term_ + smtlib2_vector_size(d->terms_);
+}
+
+
+smtlib2_dag_symbol *smtlib2_termdag_symbol(smtlib2_termdag *d, uint32_t id)
+{
+    while (id < d->first_symbol_) {
+        d = d->base_;
+    }
+    return (smtlib2_dag_symbol *)smtlib2_vector_at(d->symbols_,
+                                                   id - d->first_symbol_);
+}
+
+
+smtlib2_dag_sort *smtlib2_termdag_sort(smtlib2_termdag *d, uint32_t id)
+{
+    while (id < d->first_sort_) {
+        d = d->base_;
+    }
+    return (smtlib2_dag_sort *)smtlib2_vector_at(d->sorts_,
+                                                 id - d->first_sort_);
+}
+
+
+smtlib2_dag_term *smtlib2_termdag_term(smtlib2_termdag *d, uint32_t id)
+{
+    while (id < d->first_term_) {
+        d = d->base_;
+    }
+    return (smtlib2_dag_term *)smtlib2_vector_at(d->terms_,
+                                                 id - d->first_term_);
+}
+
+
+static uint32_t mix(uint32_t h, uintptr_t v)
+{
+    h ^= (uint32_t)v + 0x9e3779b9U + (h << 6) + (h >> 2);
+    return h;
+}
+
+
+static uint32_t sort_hash(smtlib2_dag_sort *s)
+{
+    size_t i;
+    uint32_t ret = mix((uint32_t)s->kind_, s->name_ ? s->name_->hash_ : 0);
+    for (i = 0; i < s->nidx_; ++i) {
+        ret = mix(ret, (uintptr_t)s->idx_[i]);
+    }
+    for (i = 0; i < s->nargs_; ++i) {
+        ret = mix(ret, s->args_[i]->id_);
+    }
+    return ret;
+}
+
+
+static uint32_t term_hash(smtlib2_dag_term *t)
+{
+    size_t i;
+    uint32_t ret = mix((uint32_t)t->kind_, t->symbol_ ? t->symbol_->hash_ : 0);
+    ret = mix(ret, t->sort_ ? t->sort_->id_ + 1 : 0);
+    for (i = 0; i < t->nidx_; ++i) {
+        ret = mix(ret, (uintptr_t)t->idx_[i]);
+    }
+    for (i = 0; i < t->nargs_; ++i) {
+        ret = mix(ret, t->args_[i]->id_);
+    }
+    return ret;
+}
+
+
+static uint32_t sort_hashfun(intptr_t s)
+{
+    return ((smtlib2_dag_sort *)s)->hash_;
+}
+
+
+static bool sort_eqfun(intptr_t s1, intptr_t s2)
+{
+    smtlib2_dag_sort *a = (smtlib2_dag_sort *)s1;
+    smtlib2_dag_sort *b = (smtlib2_dag_sort *)s2;
+
+    if (a == b) {
+        return true;
+    }
+    if (a->hash_ != b->hash_ || a->kind_ != b->kind_ ||
+        a->name_ != b->name_ || a->nidx_ != b->nidx_ ||
+        a->nargs_ != b->nargs_) {
+        return false;
+    }
+    return (a->nidx_ == 0 ||
+            memcmp(a->idx_, b->idx_, sizeof(intptr_t) * a->nidx_) == 0) &&
+        (a->nargs_ == 0 ||
+         memcmp(a->args_, b->args_,
+                sizeof(smtlib2_dag_sort *) * a->nargs_) == 0);
+}
+
+
+static uint32_t term_hashfun(intptr_t t)
+{
+    return ((smtlib2_dag_term *)t)->hash_;
+}
+
+
+static bool term_eqfun(intptr_t t1, intptr_t t2)
+{
+    smtlib2_dag_term *a = (smtlib2_dag_term *)t1;
+    smtlib2_dag_term *b = (smtlib2_dag_term *)t2;
+
+    if (a == b) {
+        return true;
+    }
+    if (a->hash_ != b->hash_ || a->kind_ != b->kind_ ||
+        a->symbol_ != b->symbol_ || a->sort_ != b->sort_ ||
+        a->nidx_ != b->nidx_ || a->nargs_ != b->nargs_) {
+        return false;
+    }
+    return (a->nidx_ == 0 ||
+            memcmp(a->idx_, b->idx_, sizeof(intptr_t) * a->nidx_) == 0) &&
+        (a->nargs_ == 0 ||
+         memcmp(a->args_, b->args_,
+                sizeof(smtlib2_dag_term *) * a->nargs_) == 0);
+}
+
+
+static void free_node(intptr_t n)
+{
+    smtlib2_free((void *)n);
+}
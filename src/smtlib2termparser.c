@@ -26,6 +26,8 @@
  */
 
 #include "smtparser/smtlib2termparser.h"
+#include "smtparser/smtlib2memory.h"
+#include "smtparser/smtlib2handlertable.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -45,19 +47,27 @@ static smtlib2_vector *smtlib2_term_parser_get_params(smtlib2_term_parser *tp,
 smtlib2_term_parser *smtlib2_term_parser_new(smtlib2_context ctx)
 {
     smtlib2_term_parser *ret =
-        (smtlib2_term_parser *)malloc(sizeof(smtlib2_term_parser));
+        (smtlib2_term_parser *)smtlib2_malloc(sizeof(smtlib2_term_parser));
+    smtlib2_memory_tag tag;
+
     ret->ctx_ = ctx;
+    tag = smtlib2_set_memory_tag(SMTLIB2_MEM_SYMBOL_HANDLERS);
     ret->symbol_handlers_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
                                                   smtlib2_eqfun_str);
+    ret->handler_table_ = NULL;
     ret->function_term_handler_ = NULL;
     ret->number_term_handler_ = NULL;
+    smtlib2_set_memory_tag(SMTLIB2_MEM_LET_BINDINGS);
     ret->let_bindings_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
                                                smtlib2_eqfun_str);
     ret->let_levels_ = smtlib2_vector_new();
-    ret->bindings_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
-                                           smtlib2_eqfun_str);
-    ret->term_params_ = smtlib2_hashtable_new(NULL, NULL);
+    smtlib2_set_memory_tag(tag);
+    smtlib2_pmap_init(&(ret->bindings_), smtlib2_hashfun_str,
+                      smtlib2_eqfun_str, (smtlib2_freefun)smtlib2_free, NULL);
+    smtlib2_pmap_init(&(ret->term_params_), NULL, NULL, NULL,
+                      free_term_params);
     ret->errmsg_ = NULL;
+    ret->lookup_stats_ = NULL;
 
     return ret;
 }
@@ -66,15 +76,16 @@ smtlib2_term_parser *smtlib2_term_parser_new(smtlib2_context ctx)
 void smtlib2_term_parser_delete(smtlib2_term_parser *tp)
 {
     if (tp->errmsg_) {
-        free(tp->errmsg_);
+        smtlib2_free(tp->errmsg_);
     }
-    smtlib2_hashtable_delete(tp->term_params_, NULL, free_term_params);
-    smtlib2_hashtable_delete(tp->bindings_, (smtlib2_freefun)free, NULL);
+    smtlib2_pmap_deinit(&(tp->term_params_));
+    smtlib2_pmap_deinit(&(tp->bindings_));
     smtlib2_vector_delete(tp->let_levels_);
-    smtlib2_hashtable_delete(tp->let_bindings_, (smtlib2_freefun)free,
+    smtlib2_hashtable_delete(tp->let_bindings_, (smtlib2_freefun)smtlib2_free,
                              free_let_bindings);
-    smtlib2_hashtable_delete(tp->symbol_handlers_, (smtlib2_freefun)free, NULL);
-    free(tp);
+    smtlib2_hashtable_delete(tp->symbol_handlers_,
+                             (smtlib2_freefun)smtlib2_free, NULL);
+    smtlib2_free(tp);
 }
 
 
@@ -84,35 +95,49 @@ smtlib2_term smtlib2_term_parser_make_term(smtlib2_term_parser *tp,
                                            smtlib2_vector *index,
                                            smtlib2_vector *args)
 {
-    intptr_t val;
+    intptr_t val = 0;
     smtlib2_term ret = NULL;
-    
+    smtlib2_term def = NULL;
+    smtlib2_vector *params = NULL;
+    smtlib2_ticks start = tp->lookup_stats_ ? smtlib2_ticks_now() : 0;
+
+    /* all the hash lookups are done first, so that they can be timed */
     if (!index) {
-        smtlib2_term def = smtlib2_term_parser_get_binding(tp, symbol);
+        def = smtlib2_term_parser_get_binding(tp, symbol);
         if (def) {
-            smtlib2_vector *params = smtlib2_term_parser_get_params(tp, def);
-            if (params) {
-                smtlib2_term_parser_format_error(
-                    tp, "macros with parameters not supported yet");
-                return NULL;
-            } else {
-                if (args) {
-                    smtlib2_term_parser_format_error(
-                        tp, "wrong number of arguments for symbol `%s'",
-                        symbol);
-                    return NULL;
-                }
-                ret = def;
-            }
-            if (!ret) {
-                smtlib2_term_parser_format_error(
-                    tp, "error in parsing symbol `%s'", symbol);
-            }
-            return ret;
+            params = smtlib2_term_parser_get_params(tp, def);
+        }
+    }
+    if (!def) {
+        /* the handlers of the instance override the shared ones (a NULL
+         * handler hides the shared one) */
+        bool found = smtlib2_hashtable_size(tp->symbol_handlers_) > 0 &&
+            smtlib2_hashtable_find(tp->symbol_handlers_, (intptr_t)symbol,
+                                   &val);
+        if (!found && tp->handler_table_) {
+            val = (intptr_t)smtlib2_handler_table_find(tp->handler_table_,
+                                                       symbol);
+        }
+    }
+    if (tp->lookup_stats_) {
+        smtlib2_histogram_record(tp->lookup_stats_,
+                                 smtlib2_ticks_now() - start);
+    }
+    
+    if (def) {
+        if (params) {
+            smtlib2_term_parser_format_error(
+                tp, "macros with parameters not supported yet");
+            return NULL;
+        } else if (args) {
+            smtlib2_term_parser_format_error(
+                tp, "wrong number of arguments for symbol `%s'", symbol);
+            return NULL;
         }
+        return def;
     }
     
-    if (smtlib2_hashtable_find(tp->symbol_handlers_, (intptr_t)symbol, &val)) {
+    if (val) {
         smtlib2_term_parser_symbolhandler handler =
             (smtlib2_term_parser_symbolhandler)val;
         smtlib2_term ret = handler(tp->ctx_, symbol, sort, index, args);
@@ -156,7 +181,9 @@ smtlib2_term smtlib2_term_parser_make_number_term(smtlib2_term_parser *tp,
 
 void smtlib2_term_parser_push_let_scope(smtlib2_term_parser *tp)
 {
+    smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_LET_BINDINGS);
     smtlib2_vector_push(tp->let_levels_, (intptr_t)NULL);
+    smtlib2_set_memory_tag(tag);
 }
 
 
@@ -185,7 +212,7 @@ void smtlib2_term_parser_pop_let_scope(smtlib2_term_parser *tp)
             smtlib2_vector_delete(vv);
         }
         smtlib2_vector_pop(tp->let_levels_);
-        free(key);
+        smtlib2_free(key);
         key = (char *)smtlib2_vector_last(tp->let_levels_);
     }
     smtlib2_vector_pop(tp->let_levels_);
@@ -200,13 +227,14 @@ void smtlib2_term_parser_define_let_binding(smtlib2_term_parser *tp,
         smtlib2_term_parser_format_error(tp, "parse error");
     } else {
         intptr_t v;
-        if (smtlib2_hashtable_find(tp->bindings_, (intptr_t)symbol, &v)) {
+        if (smtlib2_pmap_find(&(tp->bindings_), (intptr_t)symbol, &v)) {
             smtlib2_term_parser_format_error(tp, "symbol `%s' already defined",
                                              symbol);
         } else {
             int i;
             char *s;
             smtlib2_vector *vv;
+            smtlib2_memory_tag tag;
             
             for (i = smtlib2_vector_size(tp->let_levels_)-1; i >= 0; --i) {
                 const char *s2 =
@@ -221,6 +249,7 @@ void smtlib2_term_parser_define_let_binding(smtlib2_term_parser *tp,
                 }
             }
 
+            tag = smtlib2_set_memory_tag(SMTLIB2_MEM_LET_BINDINGS);
             s = smtlib2_strdup(symbol);
             smtlib2_vector_push(tp->let_levels_, (intptr_t)s);
             vv = (smtlib2_vector *)smtlib2_hashtable_get(
@@ -231,6 +260,7 @@ void smtlib2_term_parser_define_let_binding(smtlib2_term_parser *tp,
                                       (intptr_t)vv);
             }
             smtlib2_vector_push(vv, (intptr_t)term);
+            smtlib2_set_memory_tag(tag);
         }
     }
 }
@@ -245,18 +275,22 @@ void smtlib2_term_parser_define_binding(smtlib2_term_parser *tp,
         smtlib2_term_parser_format_error(tp, "symbol `%s' already defined",
                                          symbol);
     } else {
-        smtlib2_hashtable_set(tp->bindings_, (intptr_t)smtlib2_strdup(symbol),
-                              (intptr_t)term);
+        smtlib2_memory_tag tag = smtlib2_set_memory_tag(SMTLIB2_MEM_BINDINGS);
+        smtlib2_pmap_set(&(tp->bindings_), (intptr_t)smtlib2_strdup(symbol),
+                         (intptr_t)term);
         if (params != NULL) {
             size_t i;
-            smtlib2_vector *p = smtlib2_vector_new();
+            smtlib2_vector *p;
+            smtlib2_set_memory_tag(SMTLIB2_MEM_TERM_PARAMS);
+            p = smtlib2_vector_new();
             smtlib2_vector_reserve(p, smtlib2_vector_size(params));
             for (i = 0; i < smtlib2_vector_size(params); ++i) {
                 smtlib2_vector_push(p, smtlib2_vector_at(params, i));
             }
-            smtlib2_hashtable_set(tp->term_params_, (intptr_t)term,
-                                  (intptr_t)p);
+            smtlib2_pmap_set(&(tp->term_params_), (intptr_t)term,
+                             (intptr_t)p);
         }
+        smtlib2_set_memory_tag(tag);
     }
 }
 
@@ -264,20 +298,14 @@ void smtlib2_term_parser_define_binding(smtlib2_term_parser *tp,
 void smtlib2_term_parser_undefine_binding(smtlib2_term_parser *tp,
                                           const char *symbol)
 {
-    intptr_t k, v;
-    if (!smtlib2_hashtable_find_key_value(tp->bindings_,
-                                          (intptr_t)symbol, &k, &v)) {
+    intptr_t v;
+    if (!smtlib2_pmap_find(&(tp->bindings_), (intptr_t)symbol, &v)) {
         smtlib2_term_parser_format_error(tp, "symbol `%s' is not defined",
                                          symbol);
     } else {
-        smtlib2_term t = (smtlib2_term)v;
-        smtlib2_hashtable_erase(tp->bindings_, (intptr_t)symbol);
-        free((char *)k);
-        if (smtlib2_hashtable_find(tp->term_params_, (intptr_t)t, &v)) {
-            smtlib2_vector *vv = (smtlib2_vector *)v;
-            smtlib2_hashtable_erase(tp->term_params_, (intptr_t)t);
-            smtlib2_vector_delete(vv);
-        }
+        /* this releases the key, which may be symbol itself */
+        smtlib2_pmap_erase(&(tp->bindings_), (intptr_t)symbol);
+        smtlib2_pmap_erase(&(tp->term_params_), v);
     }
 }
 
@@ -286,8 +314,18 @@ void smtlib2_term_parser_set_handler(smtlib2_term_parser *tp,
                                      const char *symbol,
                                      smtlib2_term_parser_symbolhandler handler)
 {
+    smtlib2_memory_tag tag =
+        smtlib2_set_memory_tag(SMTLIB2_MEM_SYMBOL_HANDLERS);
     const char *s = smtlib2_strdup(symbol);
     smtlib2_hashtable_set(tp->symbol_handlers_, (intptr_t)s, (intptr_t)handler);
+    smtlib2_set_memory_tag(tag);
+}
+
+
+void smtlib2_term_parser_set_handler_table(smtlib2_term_parser *tp,
+                                           const smtlib2_handler_table *t)
+{
+    tp->handler_table_ = t;
 }
 
 
@@ -319,6 +357,15 @@ const char *smtlib2_term_parser_get_error_msg(smtlib2_term_parser *tp)
 }
 
 
+void smtlib2_term_parser_clear_error(smtlib2_term_parser *tp)
+{
+    if (tp->errmsg_) {
+        smtlib2_free(tp->errmsg_);
+        tp->errmsg_ = NULL;
+    }
+}
+
+
 static void free_term_params(intptr_t p)
 {
     smtlib2_vector_delete((smtlib2_vector *)p);
@@ -331,7 +378,7 @@ static void free_let_bindings(intptr_t p)
     smtlib2_vector *v = (smtlib2_vector *)p;
 
     for (i = 0; i < smtlib2_vector_size(v); ++i) {
-        free((char *)smtlib2_vector_at(v, i));
+        smtlib2_free((char *)smtlib2_vector_at(v, i));
     }
     smtlib2_vector_delete(v);
 }
@@ -342,7 +389,7 @@ static void smtlib2_term_parser_format_error(smtlib2_term_parser *tp,
 {
     va_list args;
     if (tp->errmsg_) {
-        free(tp->errmsg_);
+        smtlib2_free(tp->errmsg_);
     }
     va_start(args, fmt);
     tp->errmsg_ = smtlib2_vsprintf(fmt, args);
@@ -358,7 +405,7 @@ static smtlib2_term smtlib2_term_parser_get_binding(smtlib2_term_parser *tp,
         smtlib2_vector *vv = (smtlib2_vector *)v;
         assert(smtlib2_vector_size(vv) > 0);
         return (smtlib2_term)smtlib2_vector_last(vv);
-    } else if (smtlib2_hashtable_find(tp->bindings_, (intptr_t)symbol, &v)) {
+    } else if (smtlib2_pmap_find(&(tp->bindings_), (intptr_t)symbol, &v)) {
         return (smtlib2_term)v;
     } else {
         return NULL;
@@ -370,7 +417,7 @@ static smtlib2_vector *smtlib2_term_parser_get_params(smtlib2_term_parser *tp,
                                                       smtlib2_term term)
 {
     intptr_t v;
-    if (smtlib2_hashtable_find(tp->term_params_, (intptr_t)term, &v)) {
+    if (smtlib2_pmap_find(&(tp->term_params_), (intptr_t)term, &v)) {
         return (smtlib2_vector *)v;
     } else {
         return NULL;
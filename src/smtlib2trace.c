@@ -0,0 +1,153 @@
+/* -*- C -*-
+ *
+ * Timeline traces of the parser, in the Chrome trace-event format
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2trace.h"
+#include <string.h>
+
+struct smtlib2_tracer {
+    FILE *out_;
+    bool first_;               /* no event written yet */
+    smtlib2_ticks base_;       /* time 0 of the trace */
+    double ns_per_tick_;
+    smtlib2_command_info *command_;  /* the current command */
+};
+
+
+smtlib2_tracer *smtlib2_tracer_new(FILE *out)
+{
+    smtlib2_tracer *ret =
+        (smtlib2_tracer *)smtlib2_malloc(sizeof(smtlib2_tracer));
+    ret->out_ = out;
+    ret->first_ = true;
+    ret->ns_per_tick_ = smtlib2_ticks_calibrate();
+    ret->base_ = smtlib2_ticks_now();
+    ret->command_ = NULL;
+    fputs("[\n", out);
+    return ret;
+}
+
+
+void smtlib2_tracer_delete(smtlib2_tracer *t)
+{
+    fputs("\n]\n", t->out_);
+    fflush(t->out_);
+    smtlib2_free(t);
+}
+
+
+/* writes the common part of an event, without the closing brace */
+static void smtlib2_tracer_event(smtlib2_tracer *t, char phase,
+                                 const char *name, size_t namelen,
+                                 const char *category, smtlib2_ticks when)
+{
+    double us = when > t->base_ ?
+        (double)(when - t->base_) * t->ns_per_tick_ * 1e-3 : 0.0;
+    fprintf(t->out_, "%s{\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1",
+            t->first_ ? "" : ",\n", phase, us);
+    t->first_ = false;
+    if (name) {
+        size_t i;
+        fputs(",\"name\":\"", t->out_);
+        for (i = 0; i < namelen; ++i) {
+            unsigned char c = (unsigned char)name[i];
+            if (c == '"' || c == '\\') {
+                fputc('\\', t->out_);
+                fputc(c, t->out_);
+            } else if (c >= 0x20) {
+                fputc(c, t->out_);
+            }
+        }
+        fprintf(t->out_, "\",\"cat\":\"%s\"", category);
+    }
+}
+
+
+/* the span of a command is opened only when there is something in it, i.e.
+ * at its first nested span or at its end */
+static void smtlib2_tracer_open_command(smtlib2_tracer *t)
+{
+    smtlib2_command_info *c = t->command_;
+    if (c && !c->traced_ && c->tokens_ > 0) {
+        const char *name = c->name_ ? c->name_ : "command";
+        size_t len = strlen(name);
+        /* the names of bison tokens are quoted */
+        if (len >= 2 && name[0] == '"') {
+            ++name;
+            len -= 2;
+        }
+        smtlib2_tracer_event(t, 'B', name, len, "command", c->start_);
+        fprintf(t->out_, ",\"args\":{\"line\":%d,\"offset\":%lu}}",
+                c->line_, (unsigned long)c->offset_);
+        c->traced_ = true;
+    }
+}
+
+
+smtlib2_command_info *smtlib2_tracer_begin_command(smtlib2_tracer *t,
+                                                   smtlib2_command_info *info)
+{
+    smtlib2_command_info *prev = t->command_;
+    t->command_ = info;
+    return prev;
+}
+
+
+void smtlib2_tracer_end_command(smtlib2_tracer *t,
+                                smtlib2_command_info *prev)
+{
+    smtlib2_command_info *c = t->command_;
+    if (c && c->tokens_ > 0) {
+        smtlib2_tracer_open_command(t);
+        smtlib2_tracer_event(t, 'E', NULL, 0, NULL, smtlib2_ticks_now());
+        fprintf(t->out_, ",\"args\":{\"tokens\":%lu,\"lex_us\":%.3f}}",
+                (unsigned long)c->tokens_,
+                c->lex_ticks_ * t->ns_per_tick_ * 1e-3);
+        /* a trace of a long session is readable up to the last command */
+        fflush(t->out_);
+    }
+    t->command_ = prev;
+}
+
+
+void smtlib2_tracer_begin(smtlib2_tracer *t, const char *name,
+                          const char *category, smtlib2_ticks when)
+{
+    bool opened = t->command_ && !t->command_->traced_;
+    smtlib2_tracer_open_command(t);
+    smtlib2_tracer_event(t, 'B', name, strlen(name), category, when);
+    fputc('}', t->out_);
+    if (opened) {
+        /* if the first callback of a command gets stuck, the trace shows
+         * where */
+        fflush(t->out_);
+    }
+}
+
+
+void smtlib2_tracer_end(smtlib2_tracer *t, smtlib2_ticks when)
+{
+    smtlib2_tracer_event(t, 'E', NULL, 0, NULL, when);
+    fputc('}', t->out_);
+}
@@ -24,17 +24,29 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
  * DEALINGS IN THE SOFTWARE.
  */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "smtparser/smtlib2utils.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
 
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 char *smtlib2_strdup(const char *src)
 {
     size_t n = strlen(src);
-    char *ret = (char *)malloc(n+1);
+    char *ret = (char *)smtlib2_malloc(n+1);
     if (ret) {
         strcpy(ret, src);
     }
@@ -45,7 +57,7 @@ char *smtlib2_strdup(const char *src)
 char *smtlib2_vsprintf(const char *fmt, va_list args)
 {
     size_t size = 256;
-    char *ret = (char *)malloc(size);
+    char *ret = (char *)smtlib2_malloc(size);
     while (ret) {
         int res = vsnprintf(ret, size, fmt, args);
         if (res > -1 && res < size) {
@@ -55,7 +67,7 @@ char *smtlib2_vsprintf(const char *fmt, va_list args)
         } else {
             size *= 2;
         }
-        ret = (char *)realloc(ret, size);
+        ret = (char *)smtlib2_realloc(ret, size);
     }
     return ret;
 }
@@ -70,3 +82,64 @@ char *smtlib2_sprintf(const char *fmt, ...)
     va_end(args);
     return ret;
 }
+
+
+const char *smtlib2_map_file(const char *filename, size_t *size)
+{
+    static const char empty[1] = { '\0' };
+#ifndef _WIN32
+    struct stat st;
+    void *ret = NULL;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) == 0) {
+        if (st.st_size == 0) {
+            ret = (void *)empty;
+        } else {
+            ret = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ret == MAP_FAILED) {
+                ret = NULL;
+            } else {
+                posix_madvise(ret, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+            }
+        }
+        *size = (size_t)st.st_size;
+    }
+    close(fd);
+    return (const char *)ret;
+#else
+    smtlib2_charbuf *buf;
+    char *ret;
+    char tmp[4096];
+    size_t n;
+    FILE *f = fopen(filename, "rb");
+    if (!f) {
+        return NULL;
+    }
+    buf = smtlib2_charbuf_new();
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0) {
+        size_t sz = SMTLIB2_VECTOR_SIZE(buf);
+        smtlib2_charbuf_resize(buf, sz + n);
+        memcpy(smtlib2_charbuf_array(buf) + sz, tmp, n);
+    }
+    fclose(f);
+    *size = SMTLIB2_VECTOR_SIZE(buf);
+    ret = smtlib2_charbuf_array_release(buf);
+    smtlib2_charbuf_delete(buf);
+    return ret ? ret : empty;
+#endif
+}
+
+
+void smtlib2_unmap_file(const char *data, size_t size)
+{
+    if (size > 0) {
+#ifndef _WIN32
+        munmap((void *)data, size);
+#else
+        smtlib2_free((void *)data);
+#endif
+    }
+}
@@ -26,6 +26,7 @@
  */
 
 #include "smtparser/smtlib2yices.h"
+#include "smtparser/smtlib2handlertable.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -60,6 +61,8 @@ static smtlib2_sort smtlib2_yices_parser_make_parametric_sort(
 
 static void smtlib2_yices_parser_push(smtlib2_parser_interface *p, int n);
 static void smtlib2_yices_parser_pop(smtlib2_parser_interface *p, int n);
+static void smtlib2_yices_parser_reset_assertions(smtlib2_parser_interface *p);
+static void smtlib2_yices_parser_reset(smtlib2_parser_interface *p);
 static void smtlib2_yices_parser_assert_formula(smtlib2_parser_interface *p,
                                                 smtlib2_term term);
 static void smtlib2_yices_parser_check_sat(smtlib2_parser_interface *p);
@@ -147,8 +150,67 @@ SMTLIB2_YICES_DECLHANDLER(sign_extend);
 SMTLIB2_YICES_DECLHANDLER(rotate_left);
 SMTLIB2_YICES_DECLHANDLER(rotate_right);
 
-#define SMTLIB2_YICES_SETHANDLER(tp, s, name) \
-    smtlib2_term_parser_set_handler(tp, s, smtlib2_yices_parser_mk_ ## name)
+/* the handlers of the builtin symbols, whose table is built once and shared
+ * by all the instances */
+#define SMTLIB2_YICES_HANDLER(s, name) { s, smtlib2_yices_parser_mk_ ## name }
+
+static const smtlib2_handler_entry smtlib2_yices_handlers[] = {
+    SMTLIB2_YICES_HANDLER("and", and),
+    SMTLIB2_YICES_HANDLER("or", or),
+    SMTLIB2_YICES_HANDLER("not", not),
+    SMTLIB2_YICES_HANDLER("=>", implies),
+    SMTLIB2_YICES_HANDLER("=", eq),
+    SMTLIB2_YICES_HANDLER("+", plus),
+    SMTLIB2_YICES_HANDLER("*", times),
+    SMTLIB2_YICES_HANDLER("-", minus),
+    SMTLIB2_YICES_HANDLER("<=", leq),
+    SMTLIB2_YICES_HANDLER("<", lt),
+    SMTLIB2_YICES_HANDLER(">=", geq),
+    SMTLIB2_YICES_HANDLER(">", gt),
+    SMTLIB2_YICES_HANDLER("ite", ite),
+    SMTLIB2_YICES_HANDLER("/", divide),
+    SMTLIB2_YICES_HANDLER("distinct", distinct),
+    SMTLIB2_YICES_HANDLER("xor", xor),
+    SMTLIB2_YICES_HANDLER("nand", nand),
+    SMTLIB2_YICES_HANDLER("to_real", to_real),
+
+    SMTLIB2_YICES_HANDLER("concat", concat),
+    SMTLIB2_YICES_HANDLER("bvnot", bvnot),
+    SMTLIB2_YICES_HANDLER("bvand", bvand),
+    SMTLIB2_YICES_HANDLER("bvnand", bvnand),
+    SMTLIB2_YICES_HANDLER("bvor", bvor),
+    SMTLIB2_YICES_HANDLER("bvnor", bvnor),
+    SMTLIB2_YICES_HANDLER("bvxor", bvxor),
+    SMTLIB2_YICES_HANDLER("bvxnor", bvxnor),
+    SMTLIB2_YICES_HANDLER("bvult", bvult),
+    SMTLIB2_YICES_HANDLER("bvslt", bvslt),
+    SMTLIB2_YICES_HANDLER("bvule", bvule),
+    SMTLIB2_YICES_HANDLER("bvsle", bvsle),
+    SMTLIB2_YICES_HANDLER("bvugt", bvugt),
+    SMTLIB2_YICES_HANDLER("bvsgt", bvsgt),
+    SMTLIB2_YICES_HANDLER("bvuge", bvuge),
+    SMTLIB2_YICES_HANDLER("bvsge", bvsge),
+    SMTLIB2_YICES_HANDLER("bvcomp", bvcomp),
+    SMTLIB2_YICES_HANDLER("bvneg", bvneg),
+    SMTLIB2_YICES_HANDLER("bvadd", bvadd),
+    SMTLIB2_YICES_HANDLER("bvsub", bvsub),
+    SMTLIB2_YICES_HANDLER("bvmul", bvmul),
+    SMTLIB2_YICES_HANDLER("bvudiv", bvudiv),
+    SMTLIB2_YICES_HANDLER("bvsdiv", bvsdiv),
+    SMTLIB2_YICES_HANDLER("bvsmod", bvsmod),
+    SMTLIB2_YICES_HANDLER("bvurem", bvurem),
+    SMTLIB2_YICES_HANDLER("bvsrem", bvsrem),
+    SMTLIB2_YICES_HANDLER("bvshl", bvshl),
+    SMTLIB2_YICES_HANDLER("bvlshr", bvlshr),
+    SMTLIB2_YICES_HANDLER("bvashr", bvashr),
+    SMTLIB2_YICES_HANDLER("extract", extract),
+    SMTLIB2_YICES_HANDLER("repeat", repeat),
+    SMTLIB2_YICES_HANDLER("zero_extend", zero_extend),
+    SMTLIB2_YICES_HANDLER("sign_extend", sign_extend),
+    SMTLIB2_YICES_HANDLER("rotate_left", rotate_left),
+    SMTLIB2_YICES_HANDLER("rotate_right", rotate_right)
+};
+static smtlib2_handler_table *smtlib2_yices_handler_table = NULL;
 
 
 typedef struct smtlib2_yices_parametric_sort {
@@ -172,7 +234,7 @@ smtlib2_parser_interface * SMTLIB2_PARSER_INTERFACE_YICES(smtlib2_yices_parser *
 smtlib2_yices_parser *smtlib2_yices_parser_new(void)
 {
     smtlib2_yices_parser *ret =
-        (smtlib2_yices_parser *)malloc(sizeof(smtlib2_yices_parser));
+        (smtlib2_yices_parser *)smtlib2_malloc(sizeof(smtlib2_yices_parser));
     smtlib2_parser_interface *pi;
     smtlib2_term_parser *tp;
     
@@ -185,8 +247,6 @@ smtlib2_yices_parser *smtlib2_yices_parser_new(void)
                                                    smtlib2_eqfun_str);
     ret->next_sort_idx_ = 1;
     ret->numbers_ = smtlib2_hashtable_new(NULL, NULL);
-    ret->defines_ = smtlib2_vector_new();
-    ret->defines_sorts_ = smtlib2_vector_new();
     ret->logics_arith_only_ = smtlib2_hashtable_new(smtlib2_hashfun_str,
                                                     smtlib2_eqfun_str);
     smtlib2_hashtable_set(ret->logics_arith_only_, (intptr_t)"QF_LRA", 1);
@@ -207,6 +267,8 @@ smtlib2_yices_parser *smtlib2_yices_parser_new(void)
     pi->define_function = smtlib2_yices_parser_define_function;
     pi->push = smtlib2_yices_parser_push;
     pi->pop = smtlib2_yices_parser_pop;
+    pi->reset_assertions = smtlib2_yices_parser_reset_assertions;
+    pi->reset = smtlib2_yices_parser_reset;
     pi->assert_formula = smtlib2_yices_parser_assert_formula;
     pi->check_sat = smtlib2_yices_parser_check_sat;
     pi->annotate_term = smtlib2_yices_parser_annotate_term;
@@ -225,61 +287,12 @@ smtlib2_yices_parser *smtlib2_yices_parser_new(void)
     smtlib2_term_parser_set_number_handler(tp,
                                            smtlib2_yices_parser_mk_number);
     
-    SMTLIB2_YICES_SETHANDLER(tp, "and", and);
-    SMTLIB2_YICES_SETHANDLER(tp, "or", or);
-    SMTLIB2_YICES_SETHANDLER(tp, "not", not);
-    SMTLIB2_YICES_SETHANDLER(tp, "=>", implies);
-    SMTLIB2_YICES_SETHANDLER(tp, "=", eq);
-    SMTLIB2_YICES_SETHANDLER(tp, "+", plus);
-    SMTLIB2_YICES_SETHANDLER(tp, "*", times);
-    SMTLIB2_YICES_SETHANDLER(tp, "-", minus);
-    SMTLIB2_YICES_SETHANDLER(tp, "<=", leq);
-    SMTLIB2_YICES_SETHANDLER(tp, "<", lt);
-    SMTLIB2_YICES_SETHANDLER(tp, ">=", geq);
-    SMTLIB2_YICES_SETHANDLER(tp, ">", gt);
-    SMTLIB2_YICES_SETHANDLER(tp, "ite", ite);
-    SMTLIB2_YICES_SETHANDLER(tp, "/", divide);
-    SMTLIB2_YICES_SETHANDLER(tp, "distinct", distinct);
-    SMTLIB2_YICES_SETHANDLER(tp, "xor", xor);
-    SMTLIB2_YICES_SETHANDLER(tp, "nand", nand);
-    SMTLIB2_YICES_SETHANDLER(tp, "to_real", to_real);
-
-    SMTLIB2_YICES_SETHANDLER(tp, "concat", concat);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvnot", bvnot);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvand", bvand);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvnand", bvnand);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvor", bvor);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvnor", bvnor);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvxor", bvxor);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvxnor", bvxnor);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvult", bvult);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvslt", bvslt);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvule", bvule);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsle", bvsle);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvugt", bvugt);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsgt", bvsgt);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvuge", bvuge);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsge", bvsge);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvcomp", bvcomp);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvneg", bvneg);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvadd", bvadd);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsub", bvsub);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvmul", bvmul);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvudiv", bvudiv);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsdiv", bvsdiv);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsmod", bvsmod);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvurem", bvurem);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvsrem", bvsrem);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvshl", bvshl);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvlshr", bvlshr);
-    SMTLIB2_YICES_SETHANDLER(tp, "bvashr", bvashr);
-    SMTLIB2_YICES_SETHANDLER(tp, "extract", extract);
-    SMTLIB2_YICES_SETHANDLER(tp, "repeat", repeat);
-    SMTLIB2_YICES_SETHANDLER(tp, "zero_extend", zero_extend);
-    SMTLIB2_YICES_SETHANDLER(tp, "sign_extend", sign_extend);
-    SMTLIB2_YICES_SETHANDLER(tp, "rotate_left", rotate_left);
-    SMTLIB2_YICES_SETHANDLER(tp, "rotate_right", rotate_right);
-    
+    smtlib2_term_parser_set_handler_table(
+        tp, smtlib2_handler_table_once(
+            &smtlib2_yices_handler_table, smtlib2_yices_handlers,
+            sizeof(smtlib2_yices_handlers) /
+            sizeof(smtlib2_yices_handlers[0])));
+
     /* the built-in sorts */
     smtlib2_hashtable_set(ret->sorts_,
                           (intptr_t)smtlib2_yices_parametric_sort_new(
@@ -302,25 +315,57 @@ smtlib2_yices_parser *smtlib2_yices_parser_new(void)
 
 void smtlib2_yices_parser_delete(smtlib2_yices_parser *p)
 {
+    smtlib2_allocator *prev = smtlib2_set_allocator(p->parent_.allocator_);
     size_t i;
+    for (i = 0; i < smtlib2_vector_size(p->names_); ++i) {
+        smtlib2_free((char *)smtlib2_vector_at(p->names_, i));
+    }
     smtlib2_vector_delete(p->names_);
     smtlib2_hashtable_delete(p->assertion_ids_, NULL, NULL);
     smtlib2_hashtable_delete(p->named_terms_, (smtlib2_freefun)NULL, NULL);
     smtlib2_hashtable_delete(p->term_names_, NULL, NULL);
     smtlib2_hashtable_delete(p->logics_arith_only_, NULL, NULL);
-    smtlib2_vector_delete(p->defines_sorts_);
-    for (i = 0; i < smtlib2_vector_size(p->defines_); ++i) {
-        char *s = (char *)smtlib2_vector_at(p->defines_, i);
-        if (s) free(s);
-    }
-    smtlib2_vector_delete(p->defines_);
-    smtlib2_hashtable_delete(p->numbers_, NULL, (smtlib2_freefun)free);
+    smtlib2_hashtable_delete(p->numbers_, NULL,
+                             (smtlib2_freefun)smtlib2_free);
     smtlib2_hashtable_delete(p->parametric_sorts_, NULL, NULL);
     smtlib2_hashtable_delete(
         p->sorts_, (smtlib2_freefun)smtlib2_yices_parametric_sort_delete, NULL);
     smtlib2_abstract_parser_deinit(&(p->parent_));
     yices_del_context(p->ctx_);
-    free(p);
+    smtlib2_free(p);
+    smtlib2_set_allocator(prev);
+}
+
+
+/* the undo actions of the sorts and of the names of terms, recorded in the
+ * trail of the parser (see smtlib2_abstract_parser_record_undo) */
+static void smtlib2_yices_parser_undo_sort(smtlib2_abstract_parser *p,
+                                           intptr_t ps)
+{
+    smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
+    smtlib2_yices_parametric_sort *s = (smtlib2_yices_parametric_sort *)ps;
+    smtlib2_hashtable_erase(yp->sorts_, ps);
+    if (!s->params_) {
+        /* a declared sort: its name is also the key of its arity in
+         * parametric_sorts_, which must go before the name is freed */
+        smtlib2_hashtable_erase(yp->parametric_sorts_, (intptr_t)s->name_);
+    }
+    smtlib2_yices_parametric_sort_delete(s);
+}
+
+
+static void smtlib2_yices_parser_undo_name(smtlib2_abstract_parser *p,
+                                           intptr_t name)
+{
+    smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
+    intptr_t t = smtlib2_hashtable_get(yp->named_terms_, name);
+    smtlib2_hashtable_erase(yp->named_terms_, name);
+    if (t) {
+        smtlib2_hashtable_erase(yp->term_names_, t);
+    }
+    /* the names are undone in the order in which they were recorded */
+    smtlib2_vector_pop(yp->names_);
+    smtlib2_free((char *)name);
 }
 
 
@@ -357,9 +402,8 @@ static void smtlib2_yices_parser_declare_sort(smtlib2_parser_interface *p,
         tp = yices_mk_type(yp->ctx_, s);
         n = smtlib2_yices_parametric_sort_new(sortname, NULL);
         smtlib2_hashtable_set(yp->sorts_, (intptr_t)n, (intptr_t)tp);
-        if (smtlib2_vector_size(yp->defines_sorts_) > 0) {
-            smtlib2_vector_push(yp->defines_sorts_, (intptr_t)n);
-        }
+        smtlib2_abstract_parser_record_undo(
+            ap, smtlib2_yices_parser_undo_sort, (intptr_t)n);
         if (arity > 0) {
             smtlib2_hashtable_set(yp->parametric_sorts_,
                                   (intptr_t)n->name_, (intptr_t)arity);
@@ -392,9 +436,8 @@ static void smtlib2_yices_parser_define_sort(smtlib2_parser_interface *p,
                 smtlib2_yices_parametric_sort_delete(ps);
             } else {
                 smtlib2_hashtable_set(yp->sorts_, (intptr_t)ps, (intptr_t)sort);
-                if (smtlib2_vector_size(yp->defines_sorts_) > 0) {
-                    smtlib2_vector_push(yp->defines_sorts_, (intptr_t)ps);
-                }
+                smtlib2_abstract_parser_record_undo(
+                    ap, smtlib2_yices_parser_undo_sort, (intptr_t)ps);
             }
         }
     }
@@ -428,19 +471,8 @@ static void smtlib2_yices_parser_define_function(smtlib2_parser_interface *p,
                                                  smtlib2_sort sort,
                                                  smtlib2_term term)
 {
-    smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
-    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
-    
+    /* the binding is undone by pop */
     smtlib2_abstract_parser_define_function(p, name, params, sort, term);
-
-    if (ap->response_ != SMTLIB2_RESPONSE_ERROR &&
-        smtlib2_vector_size(yp->defines_) > 0) {
-        smtlib2_term_parser *tp = ap->termparser_;
-        intptr_t k;
-        if (smtlib2_hashtable_find_key(tp->bindings_, (intptr_t)name, &k)) {
-            smtlib2_vector_push(yp->defines_, k);
-        }
-    }
 }
 
 
@@ -548,9 +580,8 @@ static smtlib2_sort smtlib2_yices_parser_make_parametric_sort(
                 sprintf(s, "ytp_%d", yp->next_sort_idx_++);
                 tp = yices_mk_type(yp->ctx_, s);
                 smtlib2_hashtable_set(yp->sorts_, (intptr_t)ps, (intptr_t)tp);
-                if (smtlib2_vector_size(yp->defines_sorts_) > 0) {
-                    smtlib2_vector_push(yp->defines_sorts_, (intptr_t)ps);
-                }
+                smtlib2_abstract_parser_record_undo(
+                    ap, smtlib2_yices_parser_undo_sort, (intptr_t)ps);
                 ret = (smtlib2_sort)tp;
             }
         }
@@ -564,14 +595,11 @@ static void smtlib2_yices_parser_push(smtlib2_parser_interface *p, int n)
     smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
     smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
 
+    smtlib2_abstract_parser_push(p, n);
     if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
         while (n-- > 0) {
-            smtlib2_vector_push(yp->defines_, (intptr_t)NULL);
-            smtlib2_vector_push(yp->defines_sorts_, (intptr_t)NULL);
-            smtlib2_vector_push(yp->names_, (intptr_t)NULL);
             yices_push(yp->ctx_);
         }
-        ap->response_ = SMTLIB2_RESPONSE_SUCCESS;
     }
 }
 
@@ -581,48 +609,37 @@ static void smtlib2_yices_parser_pop(smtlib2_parser_interface *p, int n)
     smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
     smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
 
+    smtlib2_abstract_parser_pop(p, n);
     if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
-        smtlib2_term_parser *tp = ap->termparser_;
         while (n-- > 0) {
-            char *def = (char *)smtlib2_vector_last(yp->defines_);
-            smtlib2_yices_parametric_sort *ps = NULL;
-            
-            while (def != NULL) {
-                smtlib2_term_parser_undefine_binding(tp, def);
-                smtlib2_vector_pop(yp->defines_);
-                def = (char *)smtlib2_vector_last(yp->defines_);
-            }
-            smtlib2_vector_pop(yp->defines_);
-            
-            ps = (smtlib2_yices_parametric_sort *)smtlib2_vector_last(
-                yp->defines_sorts_);
-            while (ps != NULL) {
-                smtlib2_hashtable_erase(yp->sorts_, (intptr_t)ps);
-                smtlib2_vector_pop(yp->defines_sorts_);
-                smtlib2_yices_parametric_sort_delete(ps);
-                ps = (smtlib2_yices_parametric_sort *)smtlib2_vector_last(
-                    yp->defines_sorts_);
-            }
-            smtlib2_vector_pop(yp->defines_sorts_);
-
-            def = (char *)smtlib2_vector_last(yp->names_);
-            while (def != NULL) {
-                intptr_t t = smtlib2_hashtable_get(yp->named_terms_,
-                                                   (intptr_t)def);
-                smtlib2_hashtable_erase(yp->named_terms_, (intptr_t)def);
-                if (t) {
-                    smtlib2_hashtable_erase(yp->term_names_, t);
-                }
-                
-                smtlib2_vector_pop(yp->names_);
-                free(def);
-                def = (char *)smtlib2_vector_last(yp->names_);
-            }
-            smtlib2_vector_pop(yp->names_);
-            
             yices_pop(yp->ctx_);
         }
-        ap->response_ = SMTLIB2_RESPONSE_SUCCESS;
+    }
+}
+
+
+static void smtlib2_yices_parser_reset_assertions(smtlib2_parser_interface *p)
+{
+    smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+
+    smtlib2_abstract_parser_reset_assertions(p);
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        yices_reset(yp->ctx_);
+        smtlib2_hashtable_clear(yp->assertion_ids_, NULL, NULL);
+    }
+}
+
+
+static void smtlib2_yices_parser_reset(smtlib2_parser_interface *p)
+{
+    smtlib2_yices_parser *yp = (smtlib2_yices_parser *)p;
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+
+    smtlib2_abstract_parser_reset(p);
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        yices_reset(yp->ctx_);
+        smtlib2_hashtable_clear(yp->assertion_ids_, NULL, NULL);
     }
 }
 
@@ -690,6 +707,8 @@ static void smtlib2_yices_parser_annotate_term(smtlib2_parser_interface *p,
                 } else {
                     char *n = smtlib2_strdup(an[1]);
                     smtlib2_vector_push(yp->names_, (intptr_t)n);
+                    smtlib2_abstract_parser_record_undo(
+                        ap, smtlib2_yices_parser_undo_name, (intptr_t)n);
                     smtlib2_hashtable_set(yp->named_terms_, (intptr_t)n,
                                           (intptr_t)term);
                     smtlib2_hashtable_set(yp->term_names_, (intptr_t)term,
@@ -786,7 +805,7 @@ static void smtlib2_yices_parser_get_value(smtlib2_parser_interface *p,
         if (yp->produce_models_) {
             size_t i;
             yices_model m;
-            smtlib2_charbuf *buf;
+            smtlib2_vector *parsed;
             mpq_t ratval;
 
             m = yices_get_model(yp->ctx_);
@@ -796,31 +815,9 @@ static void smtlib2_yices_parser_get_value(smtlib2_parser_interface *p,
                 return;
             }
 
-            buf = smtlib2_charbuf_new();
-            smtlib2_charbuf_push_str(buf, "(.internal-parse-terms (");
-            for (i = 0; i < smtlib2_vector_size(terms); ++i) {
-                char *t = (char *)smtlib2_vector_at(terms, i);
-                smtlib2_charbuf_push_str(buf, t);
-                smtlib2_charbuf_push(buf, ' ');
-            }
-            smtlib2_charbuf_push_str(buf, "))");
-            {
-                smtlib2_scanner *scanner;
-                smtlib2_sstream *stream;
-
-                ap->internal_parsed_terms_enabled_ = true;
-                
-                stream = smtlib2_sstream_new(buf);
-                scanner = smtlib2_scanner_new((smtlib2_stream *)stream);
-                
-                smtlib2_parse(scanner, p);
-
-                smtlib2_scanner_delete(scanner);
-                smtlib2_sstream_delete(stream);
-                
-                ap->internal_parsed_terms_enabled_ = false;
-            }
-            if (ap->response_ == SMTLIB2_RESPONSE_ERROR) {
+            parsed = smtlib2_vector_new();
+            if (!smtlib2_abstract_parser_force_terms(ap, terms, parsed)) {
+                smtlib2_vector_delete(parsed);
                 return;
             }
             
@@ -829,7 +826,7 @@ static void smtlib2_yices_parser_get_value(smtlib2_parser_interface *p,
 
             for (i = 0; i < smtlib2_vector_size(terms); ++i) {
                 intptr_t n = smtlib2_vector_at(terms, i);
-                intptr_t t = smtlib2_vector_at(ap->internal_parsed_terms_, i);
+                intptr_t t = smtlib2_vector_at(parsed, i);
 
                 char *vv = NULL;
                 lbool v = yices_evaluate_in_model(m, (yices_expr)t);
@@ -870,7 +867,8 @@ static void smtlib2_yices_parser_get_value(smtlib2_parser_interface *p,
                     }
                 }
                 if (vv) {
-                    char *nn = smtlib2_strdup((char *)n);
+                    char *nn =
+                        smtlib2_strdup(((smtlib2_lazy_term *)n)->text_);
                     smtlib2_vector_push(ap->response_data_, (intptr_t)nn);
                     smtlib2_vector_push(ap->response_data_, (intptr_t)vv);
                 } else {
@@ -881,6 +879,7 @@ static void smtlib2_yices_parser_get_value(smtlib2_parser_interface *p,
                 }
             }
             mpq_clear(ratval);
+            smtlib2_vector_delete(parsed);
         } else {
             ap->response_ = SMTLIB2_RESPONSE_ERROR;
             ap->errmsg_ = smtlib2_strdup(":produce-models option not set");
@@ -904,7 +903,8 @@ static void smtlib2_yices_parser_get_unsat_core(smtlib2_parser_interface *p)
                 ap->errmsg_ = smtlib2_strdup("error computing unsat core");
             } else {
                 unsigned int i;
-                core = (assertion_id *)malloc(sizeof(assertion_id) * n);
+                core = (assertion_id *)smtlib2_malloc(
+                    sizeof(assertion_id) * n);
                 yices_get_unsat_core(yp->ctx_, core);
 
                 ap->response_ = SMTLIB2_RESPONSE_UNSATCORE;
@@ -921,7 +921,7 @@ static void smtlib2_yices_parser_get_unsat_core(smtlib2_parser_interface *p)
                         break;
                     }
                 }
-                free(core);
+                smtlib2_free(core);
             }
         } else {
             ap->response_ = SMTLIB2_RESPONSE_ERROR;
@@ -985,7 +985,7 @@ static smtlib2_term smtlib2_yices_parser_mk_number(smtlib2_context ctx,
     if (width != 0) {
         mpz_t tmp;
         int i;
-        int *bits = malloc(sizeof(int) * width);
+        int *bits = smtlib2_malloc(sizeof(int) * width);
         smtlib2_term ret = NULL;
         mpz_init(tmp);
         mpz_set_str(tmp, rep, base);
@@ -994,7 +994,7 @@ static smtlib2_term smtlib2_yices_parser_mk_number(smtlib2_context ctx,
         }
         mpz_clear(tmp);
         ret = yices_mk_bv_constant_from_array(YCTX(ctx), width, bits);
-        free(bits);
+        smtlib2_free(bits);
         return ret;
     } else if (base != 10) {
         return NULL;
@@ -1143,13 +1143,13 @@ SMTLIB2_YICES_DECLHANDLER(divide)
                                    smtlib2_vector_at(args, 0), &v2)) {
             n = smtlib2_sprintf("%s/%s", (const char *)v2, (const char *)v);
             e = yices_mk_num_from_string(YCTX(ctx), n);
-            free(n);
+            smtlib2_free(n);
             return e;
         } else {
             n = smtlib2_sprintf("1/%s", (const char *)v);
         }
         e = yices_mk_num_from_string(YCTX(ctx), n);
-        free(n);
+        smtlib2_free(n);
         if (e) {
             yices_expr aa[2] = { e, (yices_expr)smtlib2_vector_at(args, 0) };
             return yices_mk_mul(YCTX(ctx), aa, 2);
@@ -1429,7 +1429,7 @@ static smtlib2_yices_parametric_sort *smtlib2_yices_parametric_sort_new(
     const char *name, smtlib2_vector *params)
 {
     smtlib2_yices_parametric_sort *ret =
-        (smtlib2_yices_parametric_sort *)malloc(
+        (smtlib2_yices_parametric_sort *)smtlib2_malloc(
             sizeof(smtlib2_yices_parametric_sort));
     ret->name_ = smtlib2_strdup(name);
     ret->params_ = NULL;
@@ -1447,8 +1447,8 @@ static void smtlib2_yices_parametric_sort_delete(
     if (s->params_) {
         smtlib2_vector_delete(s->params_);
     }
-    free(s->name_);
-    free(s);
+    smtlib2_free(s->name_);
+    smtlib2_free(s);
 }
 
 
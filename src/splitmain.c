@@ -0,0 +1,113 @@
+/* -*- C -*-
+ *
+ * Splitting of an incremental SMT-LIB v2 script into one script per check-sat
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2splitter.h"
+#include "smtparser/smtlib2scanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "USAGE: %s [OPTIONS] INPUT.smt2\n"
+            "  -j N       number of writer threads (default: 4)\n"
+            "  -o PREFIX  prefix of the output files (default: the input "
+            "without\n"
+            "             .smt2, followed by `-')\n"
+            "Writes a standalone script PREFIXnnnn.smt2 for the n-th "
+            "check-sat of the\ninput, with only the declarations, "
+            "definitions and assertions live at\nthat point\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+    int nthreads = 4;
+    const char *input;
+    char *prefix = NULL;
+    smtlib2_command_index *idx;
+    smtlib2_splitter *s;
+    smtlib2_abstract_parser *ap;
+    size_t n, failed;
+    bool errors;
+    int i;
+
+    for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; ++i) {
+        if (i+1 < argc && strcmp(argv[i], "-j") == 0) {
+            nthreads = atoi(argv[++i]);
+        } else if (i+1 < argc && strcmp(argv[i], "-o") == 0) {
+            prefix = smtlib2_strdup(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (i + 1 != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    input = argv[i];
+
+    idx = smtlib2_command_index_new_from_file(input);
+    if (!idx) {
+        fprintf(stderr, "can't open `%s' for reading\n", input);
+        smtlib2_free(prefix);
+        return 1;
+    }
+    if (!prefix) {
+        size_t len = strlen(input);
+        if (len > 5 && strcmp(input + len - 5, ".smt2") == 0) {
+            len -= 5;
+        }
+        prefix = smtlib2_sprintf("%.*s-", (int)len, input);
+    }
+
+    s = smtlib2_splitter_new();
+    ap = &(s->parent_.parent_);
+    /* the responses of the parser, errors included, are diagnostics */
+    ap->outstream_ = stderr;
+    ap->errstream_ = stderr;
+    smtlib2_splitter_parse(s, idx);
+    errors = ap->num_errors_ > 0 || ap->response_ == SMTLIB2_RESPONSE_ERROR;
+    n = smtlib2_splitter_num_queries(s);
+    failed = smtlib2_splitter_write(s, prefix, nthreads);
+    fprintf(stderr, ";; %lu queries written to %s*.smt2", (unsigned long)n,
+            prefix);
+    if (failed) {
+        fprintf(stderr, ", %lu could not be written", (unsigned long)failed);
+    }
+    if (errors) {
+        fprintf(stderr, ", errors while parsing the input");
+    }
+    fprintf(stderr, "\n");
+
+    smtlib2_splitter_delete(s);
+    smtlib2_command_index_delete(idx);
+    smtlib2_free(prefix);
+    smtlib2_scanner_pool_clear();
+    return (failed || errors) ? 1 : 0;
+}
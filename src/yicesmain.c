@@ -23,12 +23,22 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include "smtparser/smtlib2yices.h"
+#include "smtparser/smtlib2driver.h"
 
-int main(void)
+
+static smtlib2_abstract_parser *new_yices(void)
+{
+    return (smtlib2_abstract_parser *)smtlib2_yices_parser_new();
+}
+
+
+static void delete_yices(smtlib2_abstract_parser *p)
 {
-    smtlib2_yices_parser *yp = smtlib2_yices_parser_new();
-    smtlib2_abstract_parser_parse((smtlib2_abstract_parser *)yp, stdin);
-    smtlib2_yices_parser_delete(yp);
+    smtlib2_yices_parser_delete((smtlib2_yices_parser *)p);
+}
 
-    return 0;
+
+int main(int argc, char **argv)
+{
+    return smtlib2_driver_main(argc, argv, new_yices, delete_yices);
 }
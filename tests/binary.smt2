@@ -0,0 +1,17 @@
+(set-logic AUFLIA)
+(declare-sort U 0)
+(define-sort Arr () (Array Int U))
+(declare-fun a () Arr)
+(declare-fun f (U Int) Int)
+(declare-fun p (Int) Bool)
+(define-fun g ((x Int) (y Int)) Int (+ (* 2 x) y))
+(assert (forall ((i Int) (u U)) (=> (p i) (> (f u i) (g i 1)))))
+(assert (let ((e (select a 3)) (k (- 4))) (! (= (f e k) (f e (g k k))) :named eq)))
+(push 1)
+(declare-fun b () Arr)
+(assert (exists ((j Int)) (and (p j) (= (select b j) (select a j)))))
+(check-sat)
+(pop 1)
+(assert (not eq))
+(check-sat)
+(exit)
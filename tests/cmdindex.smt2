@@ -0,0 +1,16 @@
+; parentheses in comments, strings and quoted symbols: (declare-fun c () Int
+(set-logic QF_UFLIA)
+(set-info :source |a quoted symbol with ) and ( and ; in it|)
+(set-info :notes "a string with ) and ; and \" quotes (")
+(declare-fun |x ) y| () Int) ; a trailing comment with a )
+(declare-fun f (Int) Int)
+(assert (> (f |x ) y|) 0)) ; and one with a (
+; (assert false)
+(push 1)
+(assert (! (= |x ) y| 1) :named |n (1|))
+(check-sat)
+(get-assignment)
+(pop 1)
+(set-option :print-success true)
+(check-sat)
+(exit)
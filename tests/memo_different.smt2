@@ -0,0 +1,15 @@
+; memo.smt2 with a different assert, which changes both queries
+(set-logic AUFLIA)
+(declare-sort U 0)
+(declare-fun f (U) Int)
+(declare-fun u () U)
+(declare-fun k () Int)
+(define-fun pos ((i Int)) Bool (> i 0))
+(assert (pos (f u)))
+(assert (forall ((v U)) (< (f v) k)))
+(check-sat)
+(push 1)
+(assert (= k (f u)))
+(check-sat)
+(pop 1)
+(exit)
@@ -0,0 +1,17 @@
+; memo.smt2 with other names, the declarations and asserts in another
+; order, and an unused declaration
+(set-logic AUFLIA)
+(declare-fun limit () Int)
+(declare-sort Elem 0)
+(declare-fun unused () Bool)
+(declare-fun e () Elem)
+(declare-fun weight (Elem) Int)
+(define-fun positive ((n Int)) Bool (> n 0))
+(assert (forall ((x Elem)) (<= (weight x) limit)))
+(assert (positive (weight e)))
+(check-sat)
+(push 1)
+(assert (= limit (weight e)))
+(check-sat)
+(pop 1)
+(exit)
@@ -0,0 +1,34 @@
+(set-logic AUFLIA)
+(declare-fun x () Int)
+(assert (> x 0))
+(push 1)
+(declare-sort U 0)
+(declare-fun f (U) Int)
+(declare-fun u () U)
+(define-sort Arr () (Array Int U))
+(declare-fun a () Arr)
+(assert (! (= (f (select a x)) x) :named fa))
+(push 2)
+(declare-fun y () Int)
+(define-fun g ((i Int)) Int (+ i y))
+(assert (! (< (g x) (f u)) :named lt))
+(push 1)
+(assert (=> lt fa))
+(check-sat)
+(pop 2)
+(declare-fun y () U)
+(assert (= u y))
+(check-sat)
+(pop 1)
+(push 1)
+(pop 1)
+(pop 1)
+(declare-fun f (Int) Bool)
+(assert (f x))
+(declare-sort U 1)
+(declare-fun u () (U Int))
+(push 3)
+(declare-fun v () (U Int))
+(assert (distinct u v))
+(pop 3)
+(check-sat)
@@ -0,0 +1,16 @@
+; the levels popped must not leave anything behind for the next push
+(set-logic QF_LIA)
+(push 1)
+(pop 1)
+(declare-fun x () Int)
+(push 1)
+(pop 1)
+(assert (> x 0))
+(push 2)
+(declare-fun y () Int)
+(pop 1)
+(declare-fun z () Int)
+(push 1)
+(pop 2)
+(assert (< x 1))
+(check-sat)
@@ -0,0 +1,1097 @@
+/* -*- C -*-
+ *
+ * Tests of the parser library, run by ctest (see tests/CMakeLists.txt)
+ *
+ * Copyright (C) 2010 Alberto Griggio
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "smtparser/smtlib2reference.h"
+#include "smtparser/smtlib2binary.h"
+#include "smtparser/smtlib2charbuf.h"
+#include "smtparser/smtlib2cmdindex.h"
+#include "smtparser/smtlib2memo.h"
+#include "smtparser/smtlib2record.h"
+#include "smtparser/smtlib2scanner.h"
+#include "smtparser/smtlib2slicer.h"
+#include "smtparser/smtlib2snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef SMTLIB2_HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+
+/*
+ * Every test is a function taking the arguments that follow its name on the
+ * command line (usually scripts in this directory), which returns false
+ * after reporting the first check that failed on stderr
+ */
+typedef bool (*smtlib2_test)(int argc, char **argv);
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                \
+                    __FILE__, __LINE__, #cond);                         \
+            return false;                                               \
+        }                                                               \
+    } while (0)
+
+/* like CHECK, for two strings, which are printed if they differ */
+#define CHECK_SAME(s1, s2)                                              \
+    do {                                                                \
+        if (strcmp((s1), (s2)) != 0) {                                  \
+            fprintf(stderr, "%s:%d: check failed: %s == %s\n"           \
+                    "--- %s\n%s--- %s\n%s", __FILE__, __LINE__, #s1,    \
+                    #s2, #s1, (s1), #s2, (s2));                         \
+            return false;                                               \
+        }                                                               \
+    } while (0)
+
+
+/* returns the contents of the given file, NUL-terminated */
+static char *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    smtlib2_charbuf *buf;
+    char chunk[4096];
+    size_t n;
+
+    if (!f) {
+        fprintf(stderr, "can't open `%s' for reading\n", path);
+        exit(2);
+    }
+    buf = smtlib2_charbuf_new();
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        size_t i;
+        for (i = 0; i < n; ++i) {
+            smtlib2_charbuf_push(buf, chunk[i]);
+        }
+    }
+    fclose(f);
+    if (size) {
+        *size = SMTLIB2_VECTOR_SIZE(buf);
+    }
+    smtlib2_charbuf_push(buf, '\0');
+    {
+        char *ret = smtlib2_charbuf_array_release(buf);
+        smtlib2_charbuf_delete(buf);
+        return ret;
+    }
+}
+
+
+/* returns what was written to the given temporary file, and closes it */
+static char *read_back(FILE *f, size_t *size)
+{
+    smtlib2_charbuf *buf = smtlib2_charbuf_new();
+    char *ret;
+    int c;
+
+    rewind(f);
+    while ((c = fgetc(f)) != EOF) {
+        smtlib2_charbuf_push(buf, (char)c);
+    }
+    fclose(f);
+    if (size) {
+        *size = SMTLIB2_VECTOR_SIZE(buf);
+    }
+    smtlib2_charbuf_push(buf, '\0');
+    ret = smtlib2_charbuf_array_release(buf);
+    smtlib2_charbuf_delete(buf);
+    return ret;
+}
+
+
+static FILE *new_tmpfile(void)
+{
+    FILE *ret = tmpfile();
+    if (!ret) {
+        fprintf(stderr, "can't create a temporary file\n");
+        exit(2);
+    }
+    return ret;
+}
+
+
+static void print_sort(smtlib2_charbuf *buf, smtlib2_dag_sort *s)
+{
+    size_t i;
+    bool parens;
+
+    if (!s) {
+        smtlib2_charbuf_push_str(buf, "?");
+        return;
+    }
+    parens = s->nidx_ > 0 || s->nargs_ > 0;
+    if (parens) {
+        smtlib2_charbuf_push_str(buf, s->nidx_ ? "(_ " : "(");
+    }
+    smtlib2_charbuf_push_str(buf, s->name_ ? s->name_->name_ : "->");
+    for (i = 0; i < s->nidx_; ++i) {
+        char num[32];
+        sprintf(num, " %ld", (long)s->idx_[i]);
+        smtlib2_charbuf_push_str(buf, num);
+    }
+    for (i = 0; i < s->nargs_; ++i) {
+        smtlib2_charbuf_push(buf, ' ');
+        print_sort(buf, s->args_[i]);
+    }
+    if (parens) {
+        smtlib2_charbuf_push(buf, ')');
+    }
+}
+
+
+static void print_term(smtlib2_charbuf *buf, smtlib2_dag_term *t)
+{
+    size_t i;
+
+    switch (t->kind_) {
+    case SMTLIB2_DAG_TERM_FORALL:
+    case SMTLIB2_DAG_TERM_EXISTS:
+        smtlib2_charbuf_push_str(buf, t->kind_ == SMTLIB2_DAG_TERM_FORALL ?
+                                 "(forall (" : "(exists (");
+        for (i = 0; i + 1 < t->nargs_; ++i) {
+            smtlib2_charbuf_push_str(buf, i ? " (" : "(");
+            print_term(buf, t->args_[i]);
+            smtlib2_charbuf_push(buf, ' ');
+            print_sort(buf, t->args_[i]->sort_);
+            smtlib2_charbuf_push(buf, ')');
+        }
+        smtlib2_charbuf_push_str(buf, ") ");
+        print_term(buf, t->args_[t->nargs_-1]);
+        smtlib2_charbuf_push(buf, ')');
+        return;
+    case SMTLIB2_DAG_TERM_NUMBER:
+    case SMTLIB2_DAG_TERM_VAR:
+        smtlib2_charbuf_push_str(buf, t->symbol_->name_);
+        return;
+    default:
+        break;
+    }
+    if (t->nargs_ > 0) {
+        smtlib2_charbuf_push(buf, '(');
+    }
+    if (t->nidx_ > 0) {
+        smtlib2_charbuf_push_str(buf, "(_ ");
+    }
+    smtlib2_charbuf_push_str(buf, t->symbol_->name_);
+    for (i = 0; i < t->nidx_; ++i) {
+        char num[32];
+        sprintf(num, " %ld", (long)t->idx_[i]);
+        smtlib2_charbuf_push_str(buf, num);
+    }
+    if (t->nidx_ > 0) {
+        smtlib2_charbuf_push(buf, ')');
+    }
+    for (i = 0; i < t->nargs_; ++i) {
+        smtlib2_charbuf_push(buf, ' ');
+        print_term(buf, t->args_[i]);
+    }
+    if (t->nargs_ > 0) {
+        smtlib2_charbuf_push(buf, ')');
+    }
+}
+
+
+static int compare_lines(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+/*
+ * prints the state of a reference backend: its assertions, in order, and
+ * the entries of its tables, sorted, so that two parsers that went through
+ * the same commands in different ways print the same text
+ */
+static void dump_state(smtlib2_reference_parser *rp, FILE *out)
+{
+    smtlib2_vector *lines = smtlib2_vector_new();
+    smtlib2_charbuf *buf;
+    size_t i, n = smtlib2_termdag_num_symbols(rp->dag_);
+
+    for (i = 0; i < smtlib2_pmap_size(&(rp->assertions_)); ++i) {
+        intptr_t t;
+        buf = smtlib2_charbuf_new();
+        smtlib2_charbuf_push_str(buf, "assert ");
+        if (smtlib2_pmap_find(&(rp->assertions_), (intptr_t)i, &t)) {
+            print_term(buf, (smtlib2_dag_term *)t);
+        }
+        smtlib2_charbuf_push(buf, '\0');
+        fprintf(out, "%s\n", smtlib2_charbuf_array(buf));
+        smtlib2_charbuf_delete(buf);
+    }
+    for (i = 0; i < n; ++i) {
+        smtlib2_dag_symbol *s = smtlib2_termdag_symbol(rp->dag_, (uint32_t)i);
+        intptr_t v;
+        if (smtlib2_pmap_find(&(rp->sorts_), (intptr_t)s, &v)) {
+            smtlib2_vector_push(lines, (intptr_t)smtlib2_sprintf(
+                                    "sort %s %ld", s->name_, (long)v));
+        }
+        if (smtlib2_pmap_find(&(rp->sort_defs_), (intptr_t)s, &v)) {
+            smtlib2_vector_push(lines, (intptr_t)smtlib2_sprintf(
+                                    "define-sort %s", s->name_));
+        }
+        if (smtlib2_pmap_find(&(rp->functions_), (intptr_t)s, &v)) {
+            buf = smtlib2_charbuf_new();
+            smtlib2_charbuf_push_str(buf, "fun ");
+            smtlib2_charbuf_push_str(buf, s->name_);
+            smtlib2_charbuf_push(buf, ' ');
+            print_sort(buf, (smtlib2_dag_sort *)v);
+            smtlib2_charbuf_push(buf, '\0');
+            smtlib2_vector_push(lines,
+                                (intptr_t)smtlib2_charbuf_array_release(buf));
+            smtlib2_charbuf_delete(buf);
+        }
+        if (smtlib2_pmap_find(&(rp->named_terms_), (intptr_t)s, &v)) {
+            buf = smtlib2_charbuf_new();
+            smtlib2_charbuf_push_str(buf, "named ");
+            smtlib2_charbuf_push_str(buf, s->name_);
+            smtlib2_charbuf_push(buf, ' ');
+            print_term(buf, (smtlib2_dag_term *)v);
+            smtlib2_charbuf_push(buf, '\0');
+            smtlib2_vector_push(lines,
+                                (intptr_t)smtlib2_charbuf_array_release(buf));
+            smtlib2_charbuf_delete(buf);
+        }
+    }
+    qsort(smtlib2_vector_array(lines), smtlib2_vector_size(lines),
+          sizeof(intptr_t), compare_lines);
+    for (i = 0; i < smtlib2_vector_size(lines); ++i) {
+        fprintf(out, "%s\n", (char *)smtlib2_vector_at(lines, i));
+        smtlib2_free((char *)smtlib2_vector_at(lines, i));
+    }
+    smtlib2_vector_delete(lines);
+}
+
+
+static char *state_of(smtlib2_reference_parser *rp)
+{
+    FILE *out = new_tmpfile();
+    dump_state(rp, out);
+    return read_back(out, NULL);
+}
+
+
+/* a reference backend whose responses go to "out" */
+static smtlib2_reference_parser *new_reference(FILE *out)
+{
+    smtlib2_reference_parser *ret = smtlib2_reference_parser_new();
+    ret->parent_.outstream_ = out;
+    ret->parent_.errstream_ = out;
+    return ret;
+}
+
+
+/* deletes the backend, and returns its responses followed by its state */
+static char *finish_reference(smtlib2_reference_parser *rp, FILE *out)
+{
+    fprintf(out, ";; state\n");
+    dump_state(rp, out);
+    smtlib2_reference_parser_delete(rp);
+    return read_back(out, NULL);
+}
+
+
+/* the responses and final state of the reference backend on a script */
+static char *parse_reference(const char *data, size_t size)
+{
+    FILE *out = new_tmpfile();
+    smtlib2_reference_parser *rp = new_reference(out);
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), data, size);
+    return finish_reference(rp, out);
+}
+
+
+/*
+ * user-026: a binary script, read back and replayed into the reference
+ * backend, gives the same responses and state as parsing the text
+ */
+static bool test_binary(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; ++i) {
+        size_t size, bsize;
+        char *data = read_file(argv[i], &size);
+        char *expected = parse_reference(data, size);
+        FILE *bin = new_tmpfile();
+        smtlib2_binary_writer *w = smtlib2_binary_writer_new(bin);
+        smtlib2_binary_reader *r;
+        smtlib2_reference_parser *rp;
+        FILE *out;
+        char *bdata, *got;
+
+        w->parent_.outstream_ = w->parent_.errstream_ = stderr;
+        smtlib2_abstract_parser_parse_buffer(&(w->parent_), data, size);
+        CHECK(w->parent_.num_errors_ == 0);
+        smtlib2_binary_writer_delete(w);
+        bdata = read_back(bin, &bsize);
+
+        r = smtlib2_binary_reader_new_from_memory(bdata, bsize);
+        CHECK(r != NULL);
+        out = new_tmpfile();
+        rp = new_reference(out);
+        CHECK(smtlib2_abstract_parser_replay(&(rp->parent_), r));
+        got = finish_reference(rp, out);
+        CHECK_SAME(expected, got);
+
+        smtlib2_binary_reader_delete(r);
+        smtlib2_free(got);
+        smtlib2_free(bdata);
+        smtlib2_free(expected);
+        smtlib2_free(data);
+    }
+    return true;
+}
+
+
+/*
+ * user-027: the command index finds the commands of a script in which every
+ * line starting with '(' is a command, whatever parentheses the strings,
+ * quoted symbols and comments contain, and parsing its commands one at a
+ * time gives the same result as parsing the whole script
+ */
+static bool test_cmdindex(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; ++i) {
+        size_t size, pos, n = 0;
+        char *data = read_file(argv[i], &size);
+        char *expected = parse_reference(data, size);
+        smtlib2_command_index *idx = smtlib2_command_index_new(data, size);
+        smtlib2_reference_parser *rp;
+        FILE *out;
+        char *got;
+
+        for (pos = 0; pos < size; pos = strchr(data + pos, '\n') - data + 1) {
+            const char *name;
+            size_t end;
+            if (data[pos] != '(') {
+                continue;
+            }
+            CHECK(n < smtlib2_command_index_size(idx));
+            CHECK(smtlib2_command_index_begin(idx, n) == pos);
+            end = smtlib2_command_index_end(idx, n);
+            CHECK(end == smtlib2_skip_sexpr(data, pos, size));
+            CHECK(data[end-1] == ')');
+            CHECK(memchr(data + pos, '\n', end - pos) == NULL);
+            name = smtlib2_command_kind_name(
+                smtlib2_command_index_kind(idx, n));
+            CHECK(name != NULL);
+            CHECK(strncmp(data + pos + 1, name, strlen(name)) == 0);
+            ++n;
+        }
+        CHECK(n == smtlib2_command_index_size(idx));
+
+        out = new_tmpfile();
+        rp = new_reference(out);
+        for (n = 0; n < smtlib2_command_index_size(idx); ++n) {
+            smtlib2_abstract_parser_parse_commands(&(rp->parent_), idx,
+                                                   n, n+1);
+        }
+        got = finish_reference(rp, out);
+        CHECK_SAME(expected, got);
+
+        smtlib2_command_index_delete(idx);
+        smtlib2_free(got);
+        smtlib2_free(expected);
+        smtlib2_free(data);
+    }
+    return true;
+}
+
+
+/*
+ * user-028: lazy asserts, forced by the default assert_lazy_formula, give
+ * the same responses and state as parsing the asserted terms right away
+ */
+static bool test_lazy(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; ++i) {
+        size_t size;
+        char *data = read_file(argv[i], &size);
+        char *expected = parse_reference(data, size);
+        FILE *out = new_tmpfile();
+        smtlib2_reference_parser *rp = new_reference(out);
+        char *got;
+
+        smtlib2_abstract_parser_set_lazy_asserts(&(rp->parent_), true);
+        smtlib2_abstract_parser_parse_buffer(&(rp->parent_), data, size);
+        got = finish_reference(rp, out);
+        CHECK_SAME(expected, got);
+
+        smtlib2_free(got);
+        smtlib2_free(expected);
+        smtlib2_free(data);
+    }
+    return true;
+}
+
+
+/*
+ * user-030: smtlib2_abstract_parser_parse_terms, called on the term of each
+ * assert of a script right before the command, returns the same (shared)
+ * DAG node that the assert then adds, or fails exactly when the assert does.
+ * Named terms are skipped, since parsing them defines their name. The calls
+ * must not change the responses or the final state
+ */
+static bool test_parse_terms(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < argc; ++i) {
+        size_t size, n;
+        char *data = read_file(argv[i], &size);
+        char *expected = parse_reference(data, size);
+        smtlib2_command_index *idx = smtlib2_command_index_new(data, size);
+        FILE *out = new_tmpfile();
+        smtlib2_reference_parser *rp = new_reference(out);
+        smtlib2_abstract_parser *ap = &(rp->parent_);
+        char *got;
+
+        for (n = 0; n < smtlib2_command_index_size(idx); ++n) {
+            size_t begin = smtlib2_command_index_begin(idx, n);
+            size_t end, before;
+            const char *texts[2];
+            smtlib2_term terms[2];
+            char *text = NULL;
+            bool ok = false;
+
+            if (smtlib2_command_index_kind(idx, n) == SMTLIB2_COMMAND_ASSERT) {
+                begin = smtlib2_skip_blanks(data, begin + strlen("(assert"),
+                                            size);
+                end = smtlib2_skip_sexpr(data, begin, size);
+                text = smtlib2_malloc(end - begin + 1);
+                memcpy(text, data + begin, end - begin);
+                text[end - begin] = '\0';
+            }
+            if (text && strstr(text, ":named") == NULL) {
+                texts[0] = texts[1] = text;
+                ok = smtlib2_abstract_parser_parse_terms(ap, texts, 2, terms);
+                CHECK(ok == (ap->response_ != SMTLIB2_RESPONSE_ERROR));
+                smtlib2_abstract_parser_reset_response(ap);
+            }
+            before = smtlib2_pmap_size(&(rp->assertions_));
+            smtlib2_abstract_parser_parse_commands(ap, idx, n, n+1);
+            if (text && strstr(text, ":named") == NULL) {
+                intptr_t last;
+                CHECK(smtlib2_pmap_size(&(rp->assertions_)) ==
+                      before + (ok ? 1 : 0));
+                if (ok) {
+                    CHECK(smtlib2_pmap_find(&(rp->assertions_),
+                                            (intptr_t)before, &last));
+                    CHECK(terms[0] == (smtlib2_term)last);
+                    CHECK(terms[1] == (smtlib2_term)last);
+                }
+            }
+            smtlib2_free(text);
+        }
+        got = finish_reference(rp, out);
+        CHECK_SAME(expected, got);
+
+        smtlib2_command_index_delete(idx);
+        smtlib2_free(got);
+        smtlib2_free(expected);
+        smtlib2_free(data);
+    }
+    return true;
+}
+
+
+/*
+ * prints the queries of a splitter (or slicer) one after the other, and
+ * checks that each of them can be parsed on its own without errors
+ */
+static bool print_queries(smtlib2_splitter *s, FILE *out)
+{
+    size_t i;
+
+    for (i = 0; i < smtlib2_splitter_num_queries(s); ++i) {
+        FILE *q = new_tmpfile();
+        smtlib2_reference_parser *rp;
+        size_t size;
+        char *text;
+
+        CHECK(smtlib2_splitter_print_query(s, i, q));
+        text = read_back(q, &size);
+        fprintf(out, ";; query %lu\n%s", (unsigned long)(i+1), text);
+
+        /* only the errors are shown */
+        q = new_tmpfile();
+        rp = new_reference(stderr);
+        rp->parent_.outstream_ = q;
+        smtlib2_abstract_parser_parse_buffer(&(rp->parent_), text, size);
+        CHECK(rp->parent_.num_errors_ == 0);
+        CHECK(rp->parent_.response_ != SMTLIB2_RESPONSE_ERROR);
+        smtlib2_reference_parser_delete(rp);
+        fclose(q);
+        smtlib2_free(text);
+    }
+    return true;
+}
+
+
+/*
+ * user-044, user-045: the queries of the script in argv[0], split (with
+ * "split"), sliced (with "slice") or sliced with goals (with "slice_goal"),
+ * are the ones in argv[1]
+ */
+static bool test_split_queries(const char *mode, char **argv)
+{
+    size_t size;
+    char *data = read_file(argv[0], &size);
+    char *expected = read_file(argv[1], NULL);
+    smtlib2_command_index *idx = smtlib2_command_index_new(data, size);
+    FILE *out = new_tmpfile();
+    char *got;
+    bool ok;
+
+    if (strcmp(mode, "split") == 0) {
+        smtlib2_splitter *s = smtlib2_splitter_new();
+        s->parent_.parent_.outstream_ = stderr;
+        s->parent_.parent_.errstream_ = stderr;
+        smtlib2_splitter_parse(s, idx);
+        CHECK(s->parent_.parent_.num_errors_ == 0);
+        ok = print_queries(s, out);
+        smtlib2_splitter_delete(s);
+    } else {
+        smtlib2_slicer *sl = smtlib2_slicer_new();
+        sl->parent_.parent_.parent_.outstream_ = stderr;
+        sl->parent_.parent_.parent_.errstream_ = stderr;
+        smtlib2_slicer_set_goal(sl, strcmp(mode, "slice_goal") == 0);
+        smtlib2_slicer_parse(sl, idx);
+        CHECK(sl->parent_.parent_.parent_.num_errors_ == 0);
+        ok = print_queries(&(sl->parent_), out);
+        smtlib2_slicer_delete(sl);
+    }
+    got = read_back(out, NULL);
+    CHECK(ok);
+    CHECK_SAME(expected, got);
+
+    smtlib2_command_index_delete(idx);
+    smtlib2_free(got);
+    smtlib2_free(expected);
+    smtlib2_free(data);
+    return true;
+}
+
+
+static bool test_split(int argc, char **argv)
+{
+    CHECK(argc == 2);
+    return test_split_queries("split", argv);
+}
+
+
+static bool test_slice(int argc, char **argv)
+{
+    CHECK(argc == 2);
+    return test_split_queries("slice", argv);
+}
+
+
+static bool test_slice_goal(int argc, char **argv)
+{
+    CHECK(argc == 2);
+    return test_split_queries("slice_goal", argv);
+}
+
+
+/*
+ * the responses and final state of the reference backend on the script in
+ * "suffix", after the one in "prefix" (whose responses are dropped)
+ */
+static char *parse_reference_after(const char *prefix, size_t psize,
+                                   const char *suffix, size_t ssize)
+{
+    FILE *sink = new_tmpfile();
+    FILE *out = new_tmpfile();
+    smtlib2_reference_parser *rp = new_reference(sink);
+
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), prefix, psize);
+    rp->parent_.outstream_ = rp->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), suffix, ssize);
+    fclose(sink);
+    return finish_reference(rp, out);
+}
+
+
+/*
+ * user-046: a clone of a snapshot taken after argv[0], continued with
+ * argv[1], ends up like a parser that parses both, while the original and
+ * the other clones are unaffected: they keep the state of the snapshot,
+ * and continue from it in the same way. The last clone is made from the
+ * snapshot before the others diverge, and used after it is deleted
+ */
+static bool test_snapshot(int argc, char **argv)
+{
+    size_t psize, ssize;
+    char *prefix, *suffix, *expected, *before, *got;
+    smtlib2_reference_parser *rp, *clone1, *clone2, *clone3;
+    smtlib2_snapshot *snap;
+    FILE *sink = new_tmpfile();
+    FILE *out;
+
+    CHECK(argc == 2);
+    prefix = read_file(argv[0], &psize);
+    suffix = read_file(argv[1], &ssize);
+    expected = parse_reference_after(prefix, psize, suffix, ssize);
+
+    rp = new_reference(sink);
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), prefix, psize);
+    before = state_of(rp);
+    snap = smtlib2_parser_snapshot(&(rp->parent_));
+    CHECK(snap != NULL);
+    clone1 = (smtlib2_reference_parser *)smtlib2_parser_clone(snap);
+    clone2 = (smtlib2_reference_parser *)smtlib2_parser_clone(snap);
+    clone3 = (smtlib2_reference_parser *)smtlib2_parser_clone(snap);
+    CHECK(clone1 && clone2 && clone3);
+
+    /* the first clone diverges */
+    out = new_tmpfile();
+    clone1->parent_.outstream_ = clone1->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(clone1->parent_), suffix, ssize);
+    got = finish_reference(clone1, out);
+    CHECK_SAME(expected, got);
+    smtlib2_free(got);
+
+    /* neither the original nor the other clones see it */
+    got = state_of(rp);
+    CHECK_SAME(before, got);
+    smtlib2_free(got);
+    got = state_of(clone2);
+    CHECK_SAME(before, got);
+    smtlib2_free(got);
+
+    /* and they continue on their own */
+    out = new_tmpfile();
+    rp->parent_.outstream_ = rp->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), suffix, ssize);
+    got = finish_reference(rp, out);
+    CHECK_SAME(expected, got);
+    smtlib2_free(got);
+
+    out = new_tmpfile();
+    clone2->parent_.outstream_ = clone2->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(clone2->parent_), suffix, ssize);
+    got = finish_reference(clone2, out);
+    CHECK_SAME(expected, got);
+    smtlib2_free(got);
+
+    smtlib2_snapshot_delete(snap);
+    out = new_tmpfile();
+    clone3->parent_.outstream_ = clone3->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(clone3->parent_), suffix, ssize);
+    got = finish_reference(clone3, out);
+    CHECK_SAME(expected, got);
+    smtlib2_free(got);
+
+    fclose(sink);
+    smtlib2_free(before);
+    smtlib2_free(expected);
+    smtlib2_free(suffix);
+    smtlib2_free(prefix);
+    return true;
+}
+
+
+/*
+ * user-047, user-048: parsing the scripts command by command, the state
+ * after every pop is the one before the push of the outermost level it
+ * pops, and the final result is the one of parsing the script at once with
+ * the undo trail. With "persistent", the commands are parsed with
+ * persistent scopes
+ */
+static bool check_scopes(int argc, char **argv, bool persistent)
+{
+    int i;
+
+    for (i = 0; i < argc; ++i) {
+        size_t size, n, j;
+        char *data = read_file(argv[i], &size);
+        char *expected = parse_reference(data, size);
+        smtlib2_command_index *idx = smtlib2_command_index_new(data, size);
+        smtlib2_vector *states = smtlib2_vector_new();
+        FILE *out = new_tmpfile();
+        smtlib2_reference_parser *rp = new_reference(out);
+        char *got;
+
+        smtlib2_abstract_parser_set_persistent_scopes(&(rp->parent_),
+                                                      persistent);
+        for (n = 0; n < smtlib2_command_index_size(idx); ++n) {
+            smtlib2_command_kind kind = smtlib2_command_index_kind(idx, n);
+            const char *cmd = data + smtlib2_command_index_begin(idx, n);
+            long levels = 0;
+
+            if (kind == SMTLIB2_COMMAND_PUSH || kind == SMTLIB2_COMMAND_POP) {
+                levels = strtol(strchr(cmd, ' '), NULL, 10);
+            }
+            if (kind == SMTLIB2_COMMAND_PUSH) {
+                char *state = state_of(rp);
+                for (j = 0; j < (size_t)levels; ++j) {
+                    smtlib2_vector_push(states,
+                                        (intptr_t)smtlib2_strdup(state));
+                }
+                smtlib2_free(state);
+            }
+            smtlib2_abstract_parser_parse_commands(&(rp->parent_), idx,
+                                                   n, n+1);
+            if (kind == SMTLIB2_COMMAND_POP) {
+                CHECK((size_t)levels <= smtlib2_vector_size(states));
+                got = state_of(rp);
+                for (j = 0; j < (size_t)levels; ++j) {
+                    char *state = (char *)smtlib2_vector_last(states);
+                    smtlib2_vector_resize(states,
+                                          smtlib2_vector_size(states) - 1);
+                    if (j + 1 == (size_t)levels) {
+                        CHECK_SAME(state, got);
+                    }
+                    smtlib2_free(state);
+                }
+                smtlib2_free(got);
+            }
+        }
+        got = finish_reference(rp, out);
+        CHECK_SAME(expected, got);
+
+        /* the levels left open */
+        for (j = 0; j < smtlib2_vector_size(states); ++j) {
+            smtlib2_free((char *)smtlib2_vector_at(states, j));
+        }
+        smtlib2_vector_delete(states);
+        smtlib2_command_index_delete(idx);
+        smtlib2_free(got);
+        smtlib2_free(expected);
+        smtlib2_free(data);
+    }
+    return true;
+}
+
+
+static bool test_scopes(int argc, char **argv)
+{
+    return check_scopes(argc, argv, false);
+}
+
+
+static bool test_persistent_scopes(int argc, char **argv)
+{
+    return check_scopes(argc, argv, true);
+}
+
+
+/* removes the "success" lines from the given responses */
+static void drop_success(char *responses)
+{
+    char *src = responses, *dst = responses;
+
+    while (*src) {
+        char *eol = strchr(src, '\n');
+        size_t len = eol ? (size_t)(eol - src) + 1 : strlen(src);
+        if (strncmp(src, "success\n", len) != 0) {
+            memmove(dst, src, len);
+            dst += len;
+        }
+        src += len;
+    }
+    *dst = '\0';
+}
+
+
+/* the check-sats that reached the backend in the memo test */
+static int memo_backend_checks = 0;
+
+/* a backend that answers sat to every check-sat */
+static void memo_check_sat(smtlib2_parser_interface *p)
+{
+    smtlib2_abstract_parser *ap = (smtlib2_abstract_parser *)p;
+    if (ap->response_ != SMTLIB2_RESPONSE_ERROR) {
+        ++memo_backend_checks;
+        ap->status_ = SMTLIB2_STATUS_SAT;
+        ap->response_ = SMTLIB2_RESPONSE_STATUS;
+    }
+}
+
+
+/*
+ * user-049: with a cache shared by the parsers of the scripts, the
+ * check-sats of the script in argv[0] go to the backend, those of argv[1]
+ * (the same queries, renamed and reordered) are answered from the cache
+ * with the same answers, and those of argv[2] (different queries) go to
+ * the backend again
+ */
+static bool test_memo(int argc, char **argv)
+{
+    smtlib2_memo_cache *cache = smtlib2_memo_cache_open(NULL, 0);
+    const smtlib2_memo_stats *stats = smtlib2_memo_cache_get_stats(cache);
+    char *responses[3];
+    uint64_t hits[3];
+    int checks[3];
+    int i;
+
+    CHECK(argc == 3);
+    CHECK(cache != NULL);
+    for (i = 0; i < 3; ++i) {
+        size_t size;
+        char *data = read_file(argv[i], &size);
+        FILE *out = new_tmpfile();
+        smtlib2_reference_parser *rp = new_reference(out);
+
+        SMTLIB2_PARSER_INTERFACE(&(rp->parent_))->check_sat = memo_check_sat;
+        smtlib2_abstract_parser_set_memo(&(rp->parent_), cache);
+        memo_backend_checks = 0;
+        hits[i] = stats->hits_;
+        smtlib2_abstract_parser_parse_buffer(&(rp->parent_), data, size);
+        CHECK(rp->parent_.num_errors_ == 0);
+        checks[i] = memo_backend_checks;
+        hits[i] = stats->hits_ - hits[i];
+        smtlib2_reference_parser_delete(rp);
+        /* the scripts don't have the same number of declarations */
+        responses[i] = read_back(out, NULL);
+        drop_success(responses[i]);
+        smtlib2_free(data);
+    }
+    CHECK(checks[0] == 2 && hits[0] == 0);
+    CHECK(checks[1] == 0 && hits[1] == 2);
+    CHECK(checks[2] == 2 && hits[2] == 0);
+    CHECK_SAME(responses[0], responses[1]);
+    CHECK_SAME(responses[0], responses[2]);
+
+    for (i = 0; i < 3; ++i) {
+        smtlib2_free(responses[i]);
+    }
+    smtlib2_memo_cache_close(cache);
+    return true;
+}
+
+
+/*
+ * user-050: recording the parsing of a script doesn't change its responses
+ * and state; the recording, replayed into a fresh reference backend, gives
+ * the same responses and state; and recording the replay gives the same
+ * recording again, so the backend sees the same stream of callbacks. With
+ * "lazy", the script is parsed with lazy asserts
+ */
+static bool check_record(int argc, char **argv, bool lazy)
+{
+    int i;
+
+    for (i = 0; i < argc; ++i) {
+        size_t size, rsize, rsize2;
+        char *data = read_file(argv[i], &size);
+        FILE *out = new_tmpfile();
+        FILE *rec = new_tmpfile();
+        smtlib2_reference_parser *rp = new_reference(out);
+        smtlib2_recording *r;
+        char *expected, *recorded, *recorded2, *got;
+
+        smtlib2_abstract_parser_set_lazy_asserts(&(rp->parent_), lazy);
+        smtlib2_abstract_parser_set_recording(&(rp->parent_), rec);
+        smtlib2_abstract_parser_parse_buffer(&(rp->parent_), data, size);
+        smtlib2_abstract_parser_set_recording(&(rp->parent_), NULL);
+        expected = finish_reference(rp, out);
+        recorded = read_back(rec, &rsize);
+        got = parse_reference(data, size);
+        CHECK_SAME(got, expected);
+        smtlib2_free(got);
+
+        r = smtlib2_recording_new_from_memory(recorded, rsize);
+        CHECK(r != NULL);
+        out = new_tmpfile();
+        rec = new_tmpfile();
+        rp = new_reference(out);
+        smtlib2_abstract_parser_set_recording(&(rp->parent_), rec);
+        CHECK(smtlib2_abstract_parser_replay_recording(&(rp->parent_), r));
+        smtlib2_abstract_parser_set_recording(&(rp->parent_), NULL);
+        got = finish_reference(rp, out);
+        recorded2 = read_back(rec, &rsize2);
+        CHECK_SAME(expected, got);
+        CHECK(rsize == rsize2 && memcmp(recorded, recorded2, rsize) == 0);
+
+        smtlib2_recording_delete(r);
+        smtlib2_free(recorded2);
+        smtlib2_free(recorded);
+        smtlib2_free(got);
+        smtlib2_free(expected);
+        smtlib2_free(data);
+    }
+    return true;
+}
+
+
+static bool test_record(int argc, char **argv)
+{
+    return check_record(argc, argv, false);
+}
+
+
+static bool test_record_lazy(int argc, char **argv)
+{
+    return check_record(argc, argv, true);
+}
+
+
+#ifdef SMTLIB2_HAVE_PTHREADS
+
+#define SMTLIB2_TEST_NUM_CLONES 8
+
+typedef struct clone_job {
+    smtlib2_reference_parser *parser_;
+    const char *suffix_;
+    size_t size_;
+    char *result_;
+} clone_job;
+
+
+static void *run_clone(void *arg)
+{
+    clone_job *job = (clone_job *)arg;
+    FILE *out = new_tmpfile();
+
+    job->parser_->parent_.outstream_ = out;
+    job->parser_->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(job->parser_->parent_),
+                                         job->suffix_, job->size_);
+    job->result_ = finish_reference(job->parser_, out);
+    smtlib2_scanner_pool_clear();
+    return NULL;
+}
+
+
+/*
+ * user-039: like the snapshot test, with the clones continuing on threads
+ * of their own, at the same time as the original. Meant to be run with
+ * ThreadSanitizer (see SMT_PARSER_TSAN)
+ */
+static bool test_clones(int argc, char **argv)
+{
+    size_t psize, ssize;
+    char *prefix, *suffix, *expected, *got;
+    clone_job jobs[SMTLIB2_TEST_NUM_CLONES];
+    pthread_t threads[SMTLIB2_TEST_NUM_CLONES];
+    smtlib2_reference_parser *rp;
+    smtlib2_snapshot *snap;
+    FILE *sink = new_tmpfile();
+    FILE *out;
+    int i;
+
+    CHECK(argc == 2);
+    prefix = read_file(argv[0], &psize);
+    suffix = read_file(argv[1], &ssize);
+    expected = parse_reference_after(prefix, psize, suffix, ssize);
+
+    rp = new_reference(sink);
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), prefix, psize);
+    snap = smtlib2_parser_snapshot(&(rp->parent_));
+    CHECK(snap != NULL);
+    /* a snapshot is used by one thread at a time, so the clones are made
+     * here */
+    for (i = 0; i < SMTLIB2_TEST_NUM_CLONES; ++i) {
+        jobs[i].parser_ =
+            (smtlib2_reference_parser *)smtlib2_parser_clone(snap);
+        CHECK(jobs[i].parser_ != NULL);
+        jobs[i].suffix_ = suffix;
+        jobs[i].size_ = ssize;
+        jobs[i].result_ = NULL;
+    }
+    smtlib2_snapshot_delete(snap);
+    for (i = 0; i < SMTLIB2_TEST_NUM_CLONES; ++i) {
+        CHECK(pthread_create(&threads[i], NULL, run_clone, &jobs[i]) == 0);
+    }
+
+    out = new_tmpfile();
+    rp->parent_.outstream_ = rp->parent_.errstream_ = out;
+    smtlib2_abstract_parser_parse_buffer(&(rp->parent_), suffix, ssize);
+    got = finish_reference(rp, out);
+
+    for (i = 0; i < SMTLIB2_TEST_NUM_CLONES; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    CHECK_SAME(expected, got);
+    smtlib2_free(got);
+    for (i = 0; i < SMTLIB2_TEST_NUM_CLONES; ++i) {
+        CHECK_SAME(expected, jobs[i].result_);
+        smtlib2_free(jobs[i].result_);
+    }
+
+    fclose(sink);
+    smtlib2_free(expected);
+    smtlib2_free(suffix);
+    smtlib2_free(prefix);
+    return true;
+}
+
+#endif /* SMTLIB2_HAVE_PTHREADS */
+
+
+static const struct {
+    const char *name;
+    smtlib2_test run;
+} smtlib2_tests[] = {
+    { "binary", test_binary },
+    { "cmdindex", test_cmdindex },
+    { "lazy", test_lazy },
+    { "parse_terms", test_parse_terms },
+    { "split", test_split },
+    { "slice", test_slice },
+    { "slice_goal", test_slice_goal },
+    { "snapshot", test_snapshot },
+    { "scopes", test_scopes },
+    { "persistent_scopes", test_persistent_scopes },
+    { "memo", test_memo },
+    { "record", test_record },
+    { "record_lazy", test_record_lazy },
+#ifdef SMTLIB2_HAVE_PTHREADS
+    { "clones", test_clones },
+#endif
+    { NULL, NULL }
+};
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    bool ok;
+
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: %s TEST [ARG ...]\n", argv[0]);
+        return 2;
+    }
+    for (i = 0; smtlib2_tests[i].name; ++i) {
+        if (strcmp(argv[1], smtlib2_tests[i].name) == 0) {
+            break;
+        }
+    }
+    if (!smtlib2_tests[i].name) {
+        fprintf(stderr, "unknown test `%s'\n", argv[1]);
+        return 2;
+    }
+    ok = smtlib2_tests[i].run(argc - 2, argv + 2);
+    smtlib2_scanner_pool_clear();
+    return ok ? 0 : 1;
+}
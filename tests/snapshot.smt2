@@ -0,0 +1,10 @@
+(set-logic AUFLIA)
+(declare-sort U 0)
+(define-sort Arr () (Array Int U))
+(declare-fun a () Arr)
+(declare-fun f (U) Int)
+(define-fun g ((i Int)) Int (f (select a i)))
+(assert (! (> (g 0) 0) :named pos))
+(push 1)
+(declare-fun b () Int)
+(assert (= (g b) (g 1)))
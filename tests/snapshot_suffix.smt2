@@ -0,0 +1,14 @@
+(declare-fun c () Int)
+(assert (< b c))
+(check-sat)
+(pop 1)
+(declare-fun b () U)
+(declare-sort V 1)
+(declare-fun h ((V U)) Int)
+(assert (! (forall ((x (V U))) (> (h x) (f b))) :named hpos))
+(push 1)
+(assert (not pos))
+(check-sat)
+(pop 1)
+(assert (=> hpos pos))
+(check-sat)
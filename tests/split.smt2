@@ -0,0 +1,21 @@
+(set-logic QF_UFLIA)
+(set-option :produce-assignments true)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun z () Int)
+(declare-fun f (Int) Int)
+(assert (> x 0))
+(push 1)
+(assert (! (< (f y) 0) :named neg))
+(declare-fun w () Int)
+(assert (=> neg (= w z)))
+(check-sat)
+(get-assignment)
+(pop 1)
+(assert (< y 5))
+(check-sat)
+(push 1)
+(assert (= (f x) x))
+(check-sat)
+(pop 1)
+(exit)